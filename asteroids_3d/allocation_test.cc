@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "game.h"
+#include "headless_game_controller.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// counts the heap allocations of the whole test program by replacing the global operator new
+// the tests only look at the difference of the counter around the code under test
+
+namespace {
+std::atomic<size_t> no_of_allocations{0};
+}
+
+void * operator new(size_t size) {
+  no_of_allocations++;
+  if (void * pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void * pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+TEST(OBJECT_POOL, ReusesFreedBlocks) {
+  ObjectPool<Debris> pool;
+  void * first = pool.allocate();
+  pool.deallocate(first);
+  EXPECT_EQ(first, pool.allocate());
+  EXPECT_EQ(1u, pool.get_no_of_allocated());
+}
+
+TEST(OBJECT_POOL, ReserveAvoidsAllocations) {
+  ObjectPool<Torpedo, 16> pool;
+  pool.reserve(40);
+  EXPECT_EQ(48u, pool.get_capacity());
+  std::vector<void *> blocks;
+  blocks.reserve(48);
+  size_t before = no_of_allocations;
+  for (int i = 0; i < 48; i++) {
+    blocks.push_back(pool.allocate());
+  }
+  EXPECT_EQ(before, no_of_allocations);
+  for (void * block : blocks) {
+    pool.deallocate(block);
+  }
+  EXPECT_EQ(0u, pool.get_no_of_allocated());
+}
+
+TEST(OBJECT_POOL, GameObjectsUsePools) {
+  size_t living = Torpedo::get_pool().get_no_of_allocated();
+  {
+    std::unique_ptr<Body2df> torpedo = std::make_unique<Torpedo>(Vector2df{10.0f, 10.0f}, 0.0f, Vector2df{0.0f, 0.0f}, nullptr);
+    EXPECT_EQ(living + 1, Torpedo::get_pool().get_no_of_allocated());
+  }
+  EXPECT_EQ(living, Torpedo::get_pool().get_no_of_allocated());
+}
+
+// a tick of a running game creates and deletes torpedoes, debris and asteroids,
+// after the pools and the containers have grown, this must not allocate anymore
+// the containers of the collision candidates reach their largest size within the first minute of the game
+TEST(OBJECT_POOL, SteadyStateTickDoesNotAllocate) {
+  Game game{3u};
+  ScriptedInputSource input{ { {1, GameController::FIRE | GameController::LEFT}, {1, GameController::LEFT} } };
+  HeadlessGameController controller{game, input};
+  for (int i = 0; i < 3600; i++) {
+    controller.do_user_interactions();
+    controller.do_game_events();
+  }
+
+  size_t no_of_torpedoes_fired = 0;
+  size_t before = no_of_allocations;
+  for (int i = 0; i < 1800; i++) {
+    controller.do_user_interactions();
+    for (GameEvent event : game.get_game_events()) {
+      no_of_torpedoes_fired += event == GameEvent::torpedo_fired ? 1 : 0;
+    }
+    controller.do_game_events();
+  }
+  EXPECT_EQ(before, no_of_allocations);
+  EXPECT_LT(50u, no_of_torpedoes_fired);
+}
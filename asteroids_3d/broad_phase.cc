@@ -0,0 +1,14 @@
+#include "broad_phase.h"
+#include "broad_phase.tcc"
+
+template class BruteForceBroadPhase<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class SpatialGridBroadPhase<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class SweepAndPruneBroadPhase<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class AabbTreeBroadPhase<float, 2u, BoundingVolumeCircle<float, 2>>;
+template std::unique_ptr< BroadPhaseStrategy<float, 2u, BoundingVolumeCircle<float, 2>> > make_broad_phase(BroadPhase broad_phase);
+
+template class BruteForceBroadPhase<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class SpatialGridBroadPhase<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class SweepAndPruneBroadPhase<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class AabbTreeBroadPhase<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template std::unique_ptr< BroadPhaseStrategy<float, 2u, BoundingVolumeHyperRectangle<float, 2>> > make_broad_phase(BroadPhase broad_phase);
@@ -0,0 +1,242 @@
+#ifndef BROAD_PHASE_H
+#define BROAD_PHASE_H
+
+#include <vector>
+#include <memory>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "physics.h"
+
+// implementations of BroadPhaseStrategy
+// all strategies find the pairs of bodies whose swept bounds (see Body::get_swept_bounds()) overlap, which
+// strategy is the fastest depends on the number, the sizes and the distribution of the bodies (see physics_benchmark)
+
+
+// tests each body against every other body, fastest for a few dozen bodies
+template<class FLOAT_TYPE, size_t N, class BV>
+class BruteForceBroadPhase : public BroadPhaseStrategy<FLOAT_TYPE, N, BV> {
+  // appends the pairs of the proxies [begin, end) with all proxies following them
+  void find_pairs_of_proxies(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs);
+public:
+  void find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) override;
+
+  void find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                           std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) override;
+};
+
+
+// sorts the bodies into a uniform grid in each tick and only tests bodies in the same or in neighbouring cells
+// the cell size is given by the largest body, so the grid is fast if the bodies have similar sizes
+template<class FLOAT_TYPE, size_t N, class BV>
+class SpatialGridBroadPhase : public BroadPhaseStrategy<FLOAT_TYPE, N, BV> {
+  // (cell key, proxy) pairs sorted by the cell key, kept as member to reuse the allocated memory in each tick
+  std::vector< std::pair<std::uint64_t, size_t> > grid_cells;
+  Vector<FLOAT_TYPE, N> cell_sizes;
+  std::array<std::int64_t, N> cells_per_axis;  // 0 on axes that do not wrap around
+
+  // chooses the cells and sorts the bodies into them
+  void build_grid(Vector<FLOAT_TYPE, N> world_size);
+
+  // appends the pairs of the proxies [begin, end) with the following proxies in the same or in neighbouring cells
+  void find_pairs_of_proxies(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) const;
+public:
+  void find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) override;
+
+  void find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                           std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) override;
+};
+
+
+// keeps the boxes of the bodies sorted by their lower bound on the first axis and sweeps over them in each tick,
+// only boxes overlapping on the first axis are tested on the other axes
+// the bodies move only a little in each tick, so the order of the last tick is restored with an insertion sort
+// in nearly linear time; sweep and prune is fast for bodies of different sizes, unless many of them share the
+// same interval on the first axis
+template<class FLOAT_TYPE, size_t N, class BV>
+class SweepAndPruneBroadPhase : public BroadPhaseStrategy<FLOAT_TYPE, N, BV> {
+  // the swept bounds of a body or of one of its images on the torus
+  struct Box {
+    Vector<FLOAT_TYPE, N> lower;
+    Vector<FLOAT_TYPE, N> upper;
+    size_t proxy;
+    size_t generation;  // boxes of removed proxies are detected by an outdated generation
+    bool is_image;
+  };
+
+  std::vector<Box> boxes;                                 // sorted by lower[0], persistent between ticks
+  std::vector<size_t> generations;                        // of each proxy id, incremented if the id is reused
+  std::vector< std::pair<size_t, size_t> > added_proxies; // (proxy, generation) of the proxies without a box
+
+  // the following vectors are kept as members to reuse the allocated memory in each tick
+  std::vector<Box> added_boxes;
+  std::vector<Box> images;       // sorted by lower[0]
+  std::vector<const Box *> active;  // boxes overlapping the lower bound of the current box on the first axis
+
+  // restores the order of the boxes with an insertion sort and merges the added boxes into them
+  void sort_boxes();
+
+  // updates the boxes of the bodies, sorts them and creates the images of the boxes on the torus
+  void update_boxes(Vector<FLOAT_TYPE, N> world_size);
+
+  // appends the pairs of overlapping boxes, except pairs of two images
+  void sweep(std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs);
+
+  // appends the pairs of the boxes and images [begin, end) (boxes first, then images) with the boxes, whose lower
+  // bounds on the first axis lie within their interval on the first axis, and of boxes with images likewise;
+  // unlike sweep(), the ranges can be scanned independently of each other
+  void scan(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) const;
+public:
+  size_t add(Body<FLOAT_TYPE, N, BV> * body) override;
+
+  void find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) override;
+
+  void find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                           std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) override;
+};
+
+
+// a dynamic bounding volume hierarchy: each leaf stores the box of a body enlarged by a margin (fat box), each inner
+// node the union of the boxes of its two children; the tree is balanced with rotations like an AVL tree
+// a body is only reinserted, if its box left its fat box, so slowly moving bodies do not change the tree
+// the tree is fast for bodies of very different sizes and for clustered bodies
+template<class FLOAT_TYPE, size_t N, class BV>
+class AabbTreeBroadPhase : public BroadPhaseStrategy<FLOAT_TYPE, N, BV> {
+  static constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+  // the fat box of a body is enlarged by this fraction of its extent and twice its displacement on each axis
+  static constexpr FLOAT_TYPE FAT_MARGIN = 0.25;
+
+  struct Node {
+    Vector<FLOAT_TYPE, N> lower;
+    Vector<FLOAT_TYPE, N> upper;
+    size_t parent = NO_NODE;  // next free node, if the node is free
+    size_t child1 = NO_NODE;  // NO_NODE for leaves
+    size_t child2 = NO_NODE;
+    size_t proxy = 0;
+    int height = 0;           // 0 for leaves, -1 for free nodes
+
+    bool is_leaf() const { return child1 == NO_NODE; }
+  };
+
+  std::vector<Node> nodes;
+  size_t root = NO_NODE;
+  size_t free_nodes = NO_NODE;
+  std::vector<size_t> leaves;  // leaf node of each proxy
+
+  // kept as members to reuse the allocated memory in each tick
+  std::vector<size_t> stack;
+  std::vector<size_t> found;
+
+  size_t allocate_node();
+  void free_node(size_t node);
+  void insert_leaf(size_t leaf);
+  void remove_leaf(size_t leaf);
+
+  // rotates the higher child of an unbalanced node up and returns the node that took its place
+  size_t balance(size_t node);
+
+  // balances the given node and its ancestors and updates their boxes and heights
+  void refit(size_t node);
+
+  // sets the fat box of the given leaf, enclosing the swept bounds of the body
+  void fatten(size_t leaf, const Body<FLOAT_TYPE, N, BV> * body);
+
+  // appends all proxies whose fat boxes overlap the given box
+  void query(const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper, std::vector<size_t> & found);
+public:
+  size_t add(Body<FLOAT_TYPE, N, BV> * body) override;
+
+  void remove(size_t proxy) override;
+
+  void find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) override;
+
+  // returns the length of the longest path from the root to a leaf, 0 for an empty tree
+  int get_height() const;
+};
+
+
+// creates the strategy of the given broad phase, BroadPhase::custom is not supported
+template<class FLOAT_TYPE, size_t N, class BV>
+std::unique_ptr< BroadPhaseStrategy<FLOAT_TYPE, N, BV> > make_broad_phase(BroadPhase broad_phase);
+
+
+// returns true iff the boxes overlap on each axis starting with the given axis
+template<class FLOAT_TYPE, size_t N>
+bool overlaps(const Vector<FLOAT_TYPE, N> & lower1, const Vector<FLOAT_TYPE, N> & upper1,
+              const Vector<FLOAT_TYPE, N> & lower2, const Vector<FLOAT_TYPE, N> & upper2, size_t first_axis = 0u) {
+  for (size_t axis = first_axis; axis < N; axis++) {
+    if (upper1[axis] < lower2[axis] || upper2[axis] < lower1[axis]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// enlarges overhang on each toroidal axis to the distance the given box reaches beyond the edges of the world
+template<class FLOAT_TYPE, size_t N>
+void extend_overhang(Vector<FLOAT_TYPE, N> world_size, const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper,
+                     Vector<FLOAT_TYPE, N> & overhang) {
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (world_size[axis] > 0.0) {
+      overhang[axis] = std::max( { overhang[axis], -lower[axis], upper[axis] - world_size[axis] } );
+    }
+  }
+}
+
+// calls image(offset) for each offset, that moves the given box to one of its images on the torus which may
+// overlap a box reaching at most overhang beyond the edges of the world
+// if two boxes overlap on the torus, an image of each of them overlaps the other box (by the choice of overhang),
+// so images only have to be tested against boxes
+template<class FLOAT_TYPE, size_t N, class F>
+void for_each_image_offset(Vector<FLOAT_TYPE, N> world_size, const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper,
+                           Vector<FLOAT_TYPE, N> overhang, F image) {
+  std::array< std::array<FLOAT_TYPE, 3>, N> axis_offsets;
+  std::array<size_t, N> no_of_axis_offsets;
+  size_t no_of_offsets = 1u;
+  for (size_t axis = 0u; axis < N; axis++) {
+    axis_offsets[axis][0] = 0.0;
+    no_of_axis_offsets[axis] = 1u;
+    if (world_size[axis] > 0.0) {
+      if (lower[axis] <= overhang[axis]) {
+        axis_offsets[axis][no_of_axis_offsets[axis]++] = world_size[axis];
+      }
+      if (upper[axis] >= world_size[axis] - overhang[axis]) {
+        axis_offsets[axis][no_of_axis_offsets[axis]++] = -world_size[axis];
+      }
+    }
+    no_of_offsets *= no_of_axis_offsets[axis];
+  }
+  // offset 0 is the box itself
+  for (size_t i = 1u; i < no_of_offsets; i++) {
+    Vector<FLOAT_TYPE, N> offset;
+    for (size_t axis = 0u, digits = i; axis < N; axis++) {
+      offset[axis] = axis_offsets[axis][digits % no_of_axis_offsets[axis]];
+      digits /= no_of_axis_offsets[axis];
+    }
+    image(offset);
+  }
+}
+
+// hashes the coordinates of a grid cell, different cells may share the same key
+template<size_t N>
+std::uint64_t grid_cell_key(const std::array<std::int64_t, N> & cell) {
+  static constexpr std::uint64_t primes[] = { 73856093ULL, 19349663ULL, 83492791ULL, 48611ULL };
+  std::uint64_t key = 0u;
+  for (size_t axis = 0u; axis < N; axis++) {
+    key = key * 0x9E3779B97F4A7C15ULL + static_cast<std::uint64_t>(cell[axis]) * primes[axis % 4];
+  }
+  return key;
+}
+
+
+typedef SweepAndPruneBroadPhase<float, 2u, BoundingVolume2df> SweepAndPruneBroadPhase2df;
+typedef AabbTreeBroadPhase<float, 2u, BoundingVolume2df> AabbTreeBroadPhase2df;
+
+#endif
@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <cmath>
+
+// returns true iff the first box contains the second box
+template<class FLOAT_TYPE, size_t N>
+bool contains(const Vector<FLOAT_TYPE, N> & lower1, const Vector<FLOAT_TYPE, N> & upper1,
+              const Vector<FLOAT_TYPE, N> & lower2, const Vector<FLOAT_TYPE, N> & upper2) {
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (lower2[axis] < lower1[axis] || upper1[axis] < upper2[axis]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// wraps the coordinates of a grid cell around on each axis with a positive number of cells (toroidal axis)
+template<size_t N>
+std::array<std::int64_t, N> wrap_grid_cell(std::array<std::int64_t, N> cell, const std::array<std::int64_t, N> & cells_per_axis) {
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (cells_per_axis[axis] > 0) {
+      cell[axis] %= cells_per_axis[axis];
+      if (cell[axis] < 0) {
+        cell[axis] += cells_per_axis[axis];
+      }
+    }
+  }
+  return cell;
+}
+
+// returns the coordinates of the grid cell containing the given position
+template<class FLOAT_TYPE, size_t N>
+std::array<std::int64_t, N> grid_cell(Vector<FLOAT_TYPE, N> position, Vector<FLOAT_TYPE, N> cell_sizes, const std::array<std::int64_t, N> & cells_per_axis) {
+  std::array<std::int64_t, N> cell;
+  for (size_t axis = 0u; axis < N; axis++) {
+    cell[axis] = static_cast<std::int64_t>( std::floor(position[axis] / cell_sizes[axis]) );
+  }
+  return wrap_grid_cell<N>(cell, cells_per_axis);
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void BruteForceBroadPhase<FLOAT_TYPE, N, BV>::find_pairs(Vector<FLOAT_TYPE, N>,
+                                                         std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  find_pairs_of_proxies(0, this->proxies.size(), pairs);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void BruteForceBroadPhase<FLOAT_TYPE, N, BV>::find_pairs_parallel(Vector<FLOAT_TYPE, N>, ThreadPool & pool,
+                                                                  std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) {
+  pool.run(this->proxies.size(), [this, &thread_pairs](size_t thread, size_t begin, size_t end)
+    { find_pairs_of_proxies(begin, end, thread_pairs[thread]); });
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void BruteForceBroadPhase<FLOAT_TYPE, N, BV>::find_pairs_of_proxies(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  for (size_t i = begin; i < end; i++) {
+    if (this->proxies[i] != nullptr) {
+      for (size_t j = i + 1; j < this->proxies.size(); j++) {
+        if (this->proxies[j] != nullptr) {
+          pairs.push_back( { this->proxies[i], this->proxies[j] } );
+        }
+      }
+    }
+  }
+}
+
+
+// the cell size is the largest collision distance plus twice the displacement of all bodies,
+// so two colliding bodies are always in the same or in neighbouring cells, even if they are swept
+// on a toroidal axis the cells are stretched to divide the world size evenly, and the neighbours of
+// the cells at the edges are the cells at the opposite edge
+template<class FLOAT_TYPE, size_t N, class BV>
+void SpatialGridBroadPhase<FLOAT_TYPE, N, BV>::build_grid(Vector<FLOAT_TYPE, N> world_size) {
+  FLOAT_TYPE cell_size = 0.0;
+  for (auto body : this->proxies) {
+    if (body != nullptr) {
+      cell_size = std::max(cell_size, body->get_bounding_volume().get_collision_distance() + 2 * body->get_displacement().length());
+    }
+  }
+  if ( ! (cell_size > 0.0) ) {
+    cell_size = 1.0;  // only bodies at the same position can collide
+  }
+  for (size_t axis = 0u; axis < N; axis++) {
+    cells_per_axis[axis] = world_size[axis] > 0.0 ? std::max<std::int64_t>(1, static_cast<std::int64_t>(world_size[axis] / cell_size)) : 0;
+    cell_sizes[axis] = cells_per_axis[axis] > 0 ? world_size[axis] / cells_per_axis[axis] : cell_size;
+  }
+
+  grid_cells.clear();
+  for (size_t proxy = 0; proxy < this->proxies.size(); proxy++) {
+    if (this->proxies[proxy] != nullptr) {
+      grid_cells.push_back( { grid_cell_key<N>( grid_cell(this->proxies[proxy]->get_position(), cell_sizes, cells_per_axis) ), proxy } );
+    }
+  }
+  std::sort(grid_cells.begin(), grid_cells.end());
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SpatialGridBroadPhase<FLOAT_TYPE, N, BV>::find_pairs_of_proxies(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) const {
+  size_t no_of_neighbours = 1u;
+  for (size_t axis = 0u; axis < N; axis++) {
+    no_of_neighbours *= 3u;
+  }
+
+  for (size_t proxy = begin; proxy < end; proxy++) {
+    if (this->proxies[proxy] == nullptr) {
+      continue;
+    }
+    std::array<std::int64_t, N> cell = grid_cell(this->proxies[proxy]->get_position(), cell_sizes, cells_per_axis);
+    for (size_t neighbour = 0u; neighbour < no_of_neighbours; neighbour++) {
+      std::array<std::int64_t, N> neighbour_cell = cell;
+      for (size_t axis = 0u, offsets = neighbour; axis < N; axis++, offsets /= 3u) {
+        neighbour_cell[axis] += static_cast<std::int64_t>(offsets % 3u) - 1;
+      }
+      std::uint64_t key = grid_cell_key<N>( wrap_grid_cell<N>(neighbour_cell, cells_per_axis) );
+      auto entry = std::lower_bound(grid_cells.begin(), grid_cells.end(), std::pair<std::uint64_t, size_t>(key, 0u) );
+      // duplicates stem from cells sharing the same key, or from a neighbour wrapped around to the same cell
+      for (; entry != grid_cells.end() && entry->first == key; entry++) {
+        if (entry->second > proxy) {
+          pairs.push_back( { this->proxies[proxy], this->proxies[entry->second] } );
+        }
+      }
+    }
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SpatialGridBroadPhase<FLOAT_TYPE, N, BV>::find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                                                          std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  build_grid(world_size);
+  find_pairs_of_proxies(0, this->proxies.size(), pairs);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SpatialGridBroadPhase<FLOAT_TYPE, N, BV>::find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                                                                   std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) {
+  build_grid(world_size);
+  pool.run(this->proxies.size(), [this, &thread_pairs](size_t thread, size_t begin, size_t end)
+    { find_pairs_of_proxies(begin, end, thread_pairs[thread]); });
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+size_t SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::add(Body<FLOAT_TYPE, N, BV> * body) {
+  size_t proxy = BroadPhaseStrategy<FLOAT_TYPE, N, BV>::add(body);
+  if (proxy >= generations.size()) {
+    generations.resize(proxy + 1, 0u);
+  }
+  generations[proxy]++;
+  added_proxies.push_back( { proxy, generations[proxy] } );
+  return proxy;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::sort_boxes() {
+  for (size_t i = 1; i < boxes.size(); i++) {
+    Box box = boxes[i];
+    size_t j = i;
+    for (; j > 0 && box.lower[0] < boxes[j - 1].lower[0]; j--) {
+      boxes[j] = boxes[j - 1];
+    }
+    boxes[j] = box;
+  }
+
+  // many bodies may be added at once, e.g. at the start of a level
+  auto by_lower_bound = [](const Box & box1, const Box & box2) { return box1.lower[0] < box2.lower[0]; };
+  std::sort(added_boxes.begin(), added_boxes.end(), by_lower_bound);
+  size_t no_of_boxes = boxes.size();
+  boxes.insert(boxes.end(), added_boxes.begin(), added_boxes.end());
+  std::inplace_merge(boxes.begin(), boxes.begin() + no_of_boxes, boxes.end(), by_lower_bound);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::sweep(std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  active.clear();
+  auto box = boxes.begin();
+  auto image = images.begin();
+  while (box != boxes.end() || image != images.end()) {
+    const Box * next;
+    if (image == images.end() || (box != boxes.end() && box->lower[0] <= image->lower[0])) {
+      next = &*box++;
+    } else {
+      next = &*image++;
+    }
+    std::erase_if(active, [next](const Box * other) { return other->upper[0] < next->lower[0]; });
+    for (const Box * other : active) {
+      if ( !(next->is_image && other->is_image) && next->proxy != other->proxy
+           && overlaps<FLOAT_TYPE, N>(next->lower, next->upper, other->lower, other->upper, 1u) ) {
+        pairs.push_back( { this->proxies[other->proxy], this->proxies[next->proxy] } );
+      }
+    }
+    active.push_back(next);
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::scan(size_t begin, size_t end, std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) const {
+  auto lower_bound = [](const std::vector<Box> & sorted_boxes, FLOAT_TYPE lower) {
+    return std::lower_bound(sorted_boxes.begin(), sorted_boxes.end(), lower,
+                            [](const Box & box, FLOAT_TYPE value) { return box.lower[0] < value; });
+  };
+  // appends the pairs of the given box with the boxes starting at other, whose lower bound is within the box
+  auto scan_boxes = [this, &pairs](const Box & box, typename std::vector<Box>::const_iterator other,
+                                   typename std::vector<Box>::const_iterator others_end) {
+    for (; other != others_end && other->lower[0] <= box.upper[0]; other++) {
+      if ( box.proxy != other->proxy && overlaps<FLOAT_TYPE, N>(box.lower, box.upper, other->lower, other->upper, 1u) ) {
+        pairs.push_back( { this->proxies[box.proxy], this->proxies[other->proxy] } );
+      }
+    }
+  };
+  for (size_t i = begin; i < end; i++) {
+    if (i < boxes.size()) {
+      const Box & box = boxes[i];
+      scan_boxes(box, boxes.begin() + i + 1, boxes.end());
+      scan_boxes(box, lower_bound(images, box.lower[0]), images.end());
+    } else {
+      const Box & image = images[i - boxes.size()];
+      scan_boxes(image, lower_bound(boxes, image.lower[0]), boxes.end());
+    }
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::update_boxes(Vector<FLOAT_TYPE, N> world_size) {
+  std::erase_if(boxes, [this](const Box & box)
+    { return this->proxies[box.proxy] == nullptr || box.generation != generations[box.proxy]; });
+  for (Box & box : boxes) {
+    this->proxies[box.proxy]->get_swept_bounds(box.lower, box.upper);
+  }
+  added_boxes.clear();
+  for (auto [proxy, generation] : added_proxies) {
+    if (this->proxies[proxy] != nullptr && generation == generations[proxy]) {
+      Box box{ {}, {}, proxy, generation, false };
+      this->proxies[proxy]->get_swept_bounds(box.lower, box.upper);
+      added_boxes.push_back(box);
+    }
+  }
+  added_proxies.clear();
+  sort_boxes();
+
+  images.clear();
+  Vector<FLOAT_TYPE, N> overhang{};
+  for (const Box & box : boxes) {
+    extend_overhang(world_size, box.lower, box.upper, overhang);
+  }
+  for (const Box & box : boxes) {
+    for_each_image_offset(world_size, box.lower, box.upper, overhang, [this, &box](Vector<FLOAT_TYPE, N> offset)
+      { images.push_back( { box.lower + offset, box.upper + offset, box.proxy, box.generation, true } ); });
+  }
+  std::sort(images.begin(), images.end(), [](const Box & box1, const Box & box2) { return box1.lower[0] < box2.lower[0]; });
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                                                            std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  update_boxes(world_size);
+  sweep(pairs);
+}
+
+// the active list of sweep() depends on all boxes before the current one, so the threads scan instead
+template<class FLOAT_TYPE, size_t N, class BV>
+void SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV>::find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                                                                     std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) {
+  update_boxes(world_size);
+  pool.run(boxes.size() + images.size(), [this, &thread_pairs](size_t thread, size_t begin, size_t end)
+    { scan(begin, end, thread_pairs[thread]); });
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+size_t AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::allocate_node() {
+  if (free_nodes == NO_NODE) {
+    nodes.push_back( Node{} );
+    return nodes.size() - 1;
+  }
+  size_t node = free_nodes;
+  free_nodes = nodes[node].parent;
+  nodes[node] = Node{};
+  return node;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::free_node(size_t node) {
+  nodes[node].parent = free_nodes;
+  nodes[node].height = -1;
+  free_nodes = node;
+}
+
+// the sum of the edge lengths of a box, i.e. half of the perimeter of a rectangle
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE perimeter(const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper) {
+  FLOAT_TYPE sum = 0.0;
+  for (size_t axis = 0u; axis < N; axis++) {
+    sum += upper[axis] - lower[axis];
+  }
+  return sum;
+}
+
+// returns the box enclosing both given boxes
+template<class FLOAT_TYPE, size_t N>
+void enclose(const Vector<FLOAT_TYPE, N> & lower1, const Vector<FLOAT_TYPE, N> & upper1,
+             const Vector<FLOAT_TYPE, N> & lower2, const Vector<FLOAT_TYPE, N> & upper2,
+             Vector<FLOAT_TYPE, N> & lower, Vector<FLOAT_TYPE, N> & upper) {
+  for (size_t axis = 0u; axis < N; axis++) {
+    lower[axis] = std::min(lower1[axis], lower2[axis]);
+    upper[axis] = std::max(upper1[axis], upper2[axis]);
+  }
+}
+
+// the leaf becomes the sibling of the node, whose box grows least in perimeter (surface area heuristic)
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::insert_leaf(size_t leaf) {
+  if (root == NO_NODE) {
+    root = leaf;
+    nodes[leaf].parent = NO_NODE;
+    return;
+  }
+
+  Vector<FLOAT_TYPE, N> lower = nodes[leaf].lower;
+  Vector<FLOAT_TYPE, N> upper = nodes[leaf].upper;
+  Vector<FLOAT_TYPE, N> combined_lower, combined_upper;
+  size_t sibling = root;
+  while ( !nodes[sibling].is_leaf() ) {
+    const Node & node = nodes[sibling];
+    enclose(node.lower, node.upper, lower, upper, combined_lower, combined_upper);
+    FLOAT_TYPE combined_perimeter = perimeter(combined_lower, combined_upper);
+    // cost of a new parent of this node and the leaf, and the minimal cost of pushing the leaf further down
+    FLOAT_TYPE cost = 2 * combined_perimeter;
+    FLOAT_TYPE inheritance_cost = 2 * (combined_perimeter - perimeter(node.lower, node.upper));
+
+    FLOAT_TYPE child_costs[2];
+    size_t children[2] = { node.child1, node.child2 };
+    for (size_t i = 0; i < 2; i++) {
+      const Node & child = nodes[children[i]];
+      enclose(child.lower, child.upper, lower, upper, combined_lower, combined_upper);
+      child_costs[i] = perimeter(combined_lower, combined_upper) + inheritance_cost;
+      if ( !child.is_leaf() ) {
+        child_costs[i] -= perimeter(child.lower, child.upper);
+      }
+    }
+    if (cost < child_costs[0] && cost < child_costs[1]) {
+      break;
+    }
+    sibling = child_costs[0] < child_costs[1] ? children[0] : children[1];
+  }
+
+  size_t old_parent = nodes[sibling].parent;
+  size_t new_parent = allocate_node();
+  nodes[new_parent].parent = old_parent;
+  nodes[new_parent].child1 = sibling;
+  nodes[new_parent].child2 = leaf;
+  nodes[sibling].parent = new_parent;
+  nodes[leaf].parent = new_parent;
+  if (old_parent == NO_NODE) {
+    root = new_parent;
+  } else if (nodes[old_parent].child1 == sibling) {
+    nodes[old_parent].child1 = new_parent;
+  } else {
+    nodes[old_parent].child2 = new_parent;
+  }
+  refit(new_parent);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::remove_leaf(size_t leaf) {
+  if (leaf == root) {
+    root = NO_NODE;
+    return;
+  }
+  size_t parent = nodes[leaf].parent;
+  size_t grand_parent = nodes[parent].parent;
+  size_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+  nodes[sibling].parent = grand_parent;
+  free_node(parent);
+  if (grand_parent == NO_NODE) {
+    root = sibling;
+    return;
+  }
+  if (nodes[grand_parent].child1 == parent) {
+    nodes[grand_parent].child1 = sibling;
+  } else {
+    nodes[grand_parent].child2 = sibling;
+  }
+  refit(grand_parent);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+size_t AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::balance(size_t a) {
+  if (nodes[a].is_leaf() || nodes[a].height < 2) {
+    return a;
+  }
+  size_t b = nodes[a].child1;
+  size_t c = nodes[a].child2;
+  int imbalance = nodes[c].height - nodes[b].height;
+  if (imbalance >= -1 && imbalance <= 1) {
+    return a;
+  }
+
+  // the higher child of a takes the place of a, a becomes its child, and the higher grand child stays below it
+  size_t up = imbalance > 1 ? c : b;
+  size_t stays = imbalance > 1 ? b : c;
+  size_t up_child1 = nodes[up].child1;
+  size_t up_child2 = nodes[up].child2;
+  size_t higher = nodes[up_child1].height > nodes[up_child2].height ? up_child1 : up_child2;
+  size_t lower = higher == up_child1 ? up_child2 : up_child1;
+
+  nodes[up].parent = nodes[a].parent;
+  if (nodes[up].parent == NO_NODE) {
+    root = up;
+  } else if (nodes[nodes[up].parent].child1 == a) {
+    nodes[nodes[up].parent].child1 = up;
+  } else {
+    nodes[nodes[up].parent].child2 = up;
+  }
+  nodes[up].child1 = a;
+  nodes[up].child2 = higher;
+  nodes[a].parent = up;
+  nodes[a].child1 = stays;
+  nodes[a].child2 = lower;
+  nodes[lower].parent = a;
+
+  for (size_t node : { a, up }) {
+    Node & n = nodes[node];
+    enclose(nodes[n.child1].lower, nodes[n.child1].upper, nodes[n.child2].lower, nodes[n.child2].upper, n.lower, n.upper);
+    n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+  }
+  return up;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::refit(size_t node) {
+  while (node != NO_NODE) {
+    node = balance(node);
+    Node & n = nodes[node];
+    enclose(nodes[n.child1].lower, nodes[n.child1].upper, nodes[n.child2].lower, nodes[n.child2].upper, n.lower, n.upper);
+    n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+    node = n.parent;
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::fatten(size_t leaf, const Body<FLOAT_TYPE, N, BV> * body) {
+  Node & node = nodes[leaf];
+  body->get_swept_bounds(node.lower, node.upper);
+  Vector<FLOAT_TYPE, N> displacement = body->get_displacement();
+  for (size_t axis = 0u; axis < N; axis++) {
+    FLOAT_TYPE margin = FAT_MARGIN * (node.upper[axis] - node.lower[axis]) + 2 * std::abs(displacement[axis]);
+    node.lower[axis] -= margin;
+    node.upper[axis] += margin;
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::query(const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper, std::vector<size_t> & found) {
+  if (root == NO_NODE) {
+    return;
+  }
+  stack.clear();
+  stack.push_back(root);
+  while ( !stack.empty() ) {
+    const Node & node = nodes[stack.back()];
+    stack.pop_back();
+    if ( overlaps<FLOAT_TYPE, N>(node.lower, node.upper, lower, upper) ) {
+      if (node.is_leaf()) {
+        found.push_back(node.proxy);
+      } else {
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+      }
+    }
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+size_t AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::add(Body<FLOAT_TYPE, N, BV> * body) {
+  size_t proxy = BroadPhaseStrategy<FLOAT_TYPE, N, BV>::add(body);
+  if (proxy >= leaves.size()) {
+    leaves.resize(proxy + 1, NO_NODE);
+  }
+  size_t leaf = allocate_node();
+  nodes[leaf].proxy = proxy;
+  fatten(leaf, body);
+  insert_leaf(leaf);
+  leaves[proxy] = leaf;
+  return proxy;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::remove(size_t proxy) {
+  remove_leaf(leaves[proxy]);
+  free_node(leaves[proxy]);
+  leaves[proxy] = NO_NODE;
+  BroadPhaseStrategy<FLOAT_TYPE, N, BV>::remove(proxy);
+}
+
+// the tight swept bounds of each body are tested against the fat boxes of the other bodies
+template<class FLOAT_TYPE, size_t N, class BV>
+void AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                                                       std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) {
+  Vector<FLOAT_TYPE, N> lower, upper;
+  Vector<FLOAT_TYPE, N> overhang{};
+  for (size_t proxy = 0; proxy < this->proxies.size(); proxy++) {
+    if (this->proxies[proxy] == nullptr) {
+      continue;
+    }
+    this->proxies[proxy]->get_swept_bounds(lower, upper);
+    extend_overhang(world_size, lower, upper, overhang);
+    size_t leaf = leaves[proxy];
+    if ( !contains<FLOAT_TYPE, N>(nodes[leaf].lower, nodes[leaf].upper, lower, upper) ) {
+      remove_leaf(leaf);
+      fatten(leaf, this->proxies[proxy]);
+      insert_leaf(leaf);
+    }
+  }
+
+  for (size_t proxy = 0; proxy < this->proxies.size(); proxy++) {
+    if (this->proxies[proxy] == nullptr) {
+      continue;
+    }
+    this->proxies[proxy]->get_swept_bounds(lower, upper);
+    found.clear();
+    query(lower, upper, found);
+    for (size_t other : found) {
+      if (other > proxy) {
+        pairs.push_back( { this->proxies[proxy], this->proxies[other] } );
+      }
+    }
+    for_each_image_offset(world_size, lower, upper, overhang, [this, proxy, &lower, &upper, &pairs](Vector<FLOAT_TYPE, N> offset) {
+      found.clear();
+      query(lower + offset, upper + offset, found);
+      for (size_t other : found) {
+        if (other != proxy) {
+          pairs.push_back( { this->proxies[proxy], this->proxies[other] } );
+        }
+      }
+    });
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+int AabbTreeBroadPhase<FLOAT_TYPE, N, BV>::get_height() const {
+  return root == NO_NODE ? 0 : nodes[root].height;
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+std::unique_ptr< BroadPhaseStrategy<FLOAT_TYPE, N, BV> > make_broad_phase(BroadPhase broad_phase) {
+  switch (broad_phase) {
+    case BroadPhase::spatial_grid:
+      return std::make_unique< SpatialGridBroadPhase<FLOAT_TYPE, N, BV> >();
+    case BroadPhase::sweep_and_prune:
+      return std::make_unique< SweepAndPruneBroadPhase<FLOAT_TYPE, N, BV> >();
+    case BroadPhase::aabb_tree:
+      return std::make_unique< AabbTreeBroadPhase<FLOAT_TYPE, N, BV> >();
+    default:
+      return std::make_unique< BruteForceBroadPhase<FLOAT_TYPE, N, BV> >();
+  }
+}
@@ -0,0 +1,26 @@
+#ifndef COUNTER_H
+#define COUNTER_H
+
+// counts down a time in seconds until it reaches zero (or below)
+// header only, so that the game model and physics do not depend on SDL
+class Counter {
+  float time;
+public:
+  Counter(float time = 0.0f) : time(time) { }
+
+  float get_time() const {
+    return time;
+  }
+
+  void set_time(float time) {
+    this->time = time;
+  }
+
+  void tick(float seconds) {
+    if (time > 0.0) {
+      time -= seconds;
+    }
+  }
+};
+
+#endif
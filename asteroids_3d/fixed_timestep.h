@@ -0,0 +1,42 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <algorithm>
+#include <cmath>
+
+// decouples the simulation rate from the frame rate:
+// the real time elapsed during each frame is accumulated and consumed in simulation steps of a fixed step time
+class FixedTimestep {
+  double step_time;
+  int max_steps;
+  double accumulator = 0.0;
+public:
+  // at most max_steps are simulated per frame and the remaining time is dropped,
+  // so slow frames can not cause more and more steps per frame (spiral of death), the game slows down instead
+  FixedTimestep(float step_time = 1.0f / 60.0f, int max_steps = 5) : step_time(step_time), max_steps(max_steps) { }
+
+  // adds the elapsed real time (in seconds) and returns the number of steps to simulate
+  int advance(float elapsed_time) {
+    accumulator += std::max(elapsed_time, 0.0f);
+    int steps = static_cast<int>( std::floor(accumulator / step_time) );
+    if (steps > max_steps) {
+      steps = max_steps;
+      accumulator = std::fmod(accumulator, step_time);
+    } else {
+      accumulator = std::max(accumulator - steps * step_time, 0.0);
+    }
+    return steps;
+  }
+
+  // returns the part of a step time that has elapsed since the last simulated step, in [0, 1]
+  // the renderer interpolates between the previous and the current step with this factor
+  float get_alpha() const {
+    return static_cast<float>( std::min(accumulator / step_time, 1.0) );
+  }
+
+  float get_step_time() const {
+    return static_cast<float>(step_time);
+  }
+};
+
+#endif
@@ -1,54 +1,47 @@
 #include "game.h"
+#include "physics.tcc"
 #include "debug.h"
+#include "trace.h"
 #include <iostream>
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
 
 const int SCREEN_WIDTH = 1024;
 const int SCREEN_HEIGHT = (SCREEN_WIDTH * 3) / 4;
 
-void displacement_fix(Body2df * body, float seconds) {
-  float x = body->get_position()[0];
-  float y = body->get_position()[1];
-  Vector2df new_position = body->get_position();
-  
-  if ( x < 0 ) {
-    new_position[0] = SCREEN_WIDTH;
-  }
-  if ( x > SCREEN_WIDTH ) {
-    new_position[0] = 0;
-  }
-  if ( y < 0 ) {
-    new_position[1] = SCREEN_HEIGHT;
-  }
-  if ( y > SCREEN_HEIGHT ) {
-    new_position[1] = 0;
-  }
-  
-  body->set_position(new_position);
-}
-
-Asteroid::Asteroid(short size)
+Asteroid::Asteroid(short size, RandomStream & random)
   : TypedBody( BodyType::asteroid,
-               Body2df{ BoundingVolume2df{ Vector2df{ 128.0f + 768.0f * dis(gen), 64.0f + 640.0f * dis(gen) }, size * 11.0f },
-                         Vector2df{ 0.5f - dis(gen), 0.5f - dis(gen) },
-                         348.0, 0.0, 0.0, displacement_fix } ),
+               Body2df{ BoundingVolume2df{ Vector2df{ 128.0f + 768.0f * random.uniform(), 64.0f + 640.0f * random.uniform() }, size * 11.0f },
+                         Vector2df{ 0.5f - random.uniform(), 0.5f - random.uniform() },
+                         348.0, 0.0, 0.0 } ),
     size(size),
-    rock_type( std::trunc(4 * dis(gen)) )
+    rock_type( std::trunc(4 * random.uniform()) )
   {
 
     velocity /= velocity.length();
     if (size == 3) { /* 5 - 10 s to cross the screen */
-      velocity *= 768.0f / 10.0f +  768.0f / 10.0f * dis(gen);
+      velocity *= 768.0f / 10.0f +  768.0f / 10.0f * random.uniform();
     } else if (size == 2) { /* 4 - 8s */
-      velocity *= 768.0f / 8.0f +  768.0f / 8.0f * dis(gen);
+      velocity *= 768.0f / 8.0f +  768.0f / 8.0f * random.uniform();
     } else if (size == 1) { /* 3 - 6s */
-      velocity *= 768.0f / 6.0f +  768.0f / 6.0f * dis(gen);
+      velocity *= 768.0f / 6.0f +  768.0f / 6.0f * random.uniform();
     }
 
   }
 
 
-Asteroid::Asteroid(short size, Vector2df position ) : Asteroid(size) {
+Asteroid::Asteroid(short size, short rock_type)
+  : TypedBody( BodyType::asteroid, Body2df{ BoundingVolume2df{ Vector2df{0.0f, 0.0f}, size * 11.0f }, Vector2df{0.0f, 0.0f} } ),
+    size(size),
+    rock_type(rock_type)
+  {
+  }
+
+Asteroid::Asteroid(short size, Vector2df position, RandomStream & random) : Asteroid(size, random) {
   set_position(position);
 }
   
@@ -60,12 +53,12 @@ short Asteroid::get_rock_type() const {
   return rock_type;
 }
 
-bool Spaceship::shoot(Physics2df & physics) {
-  if (shoot_cooldown.get_time() <= 0.0 && ! is_marked_for_deletion() && ! in_hyperspace) {
+bool Spaceship::shoot(GamePhysics & physics) {
+  if (get_age() >= shoot_time && ! is_marked_for_deletion() && ! in_hyperspace) {
     if ( no_of_torpedos < 4 ) {
       std::unique_ptr<Body2df> new_body = std::make_unique<Torpedo>(get_position(), get_angle(), get_velocity(), this);
       physics.add_body(new_body);
-      shoot_cooldown.set_time(0.1);
+      shoot_time = get_age() + 0.1f;
       no_of_torpedos++;
       return true;
     }
@@ -78,12 +71,12 @@ bool Spaceship::contains_torpedo(Torpedo * torpedo) {
 }
 
 bool Spaceship::can_accelerate(float tick_time) {
-  return (accelerate_timer <= 0.0 && ! is_marked_for_deletion() && ! in_hyperspace);
+  return (get_age() >= accelerate_end_time && ! is_marked_for_deletion() && ! in_hyperspace);
 }
 
 void Spaceship::accelerate(float  tick_time) {
   if (can_accelerate(tick_time) ) {
-    accelerate_timer = 0.25f - tick_time;
+    accelerate_end_time = get_age() + 0.25f - tick_time;
     Body2df::accelerate(MAX_SPEED, std::min(0.25f, tick_time) );
   }
 }
@@ -102,7 +95,7 @@ void Spaceship::deaccelerate(float tick_time) {
 }
 
 bool Spaceship::is_accelerating() {
-  return ! is_marked_for_deletion() && ! in_hyperspace && accelerate_timer > 0.0f;
+  return ! is_marked_for_deletion() && ! in_hyperspace && get_age() < accelerate_end_time;
 }
 
 void Spaceship::turn_left(float tick_time) {
@@ -118,22 +111,14 @@ void Spaceship::turn_right(float tick_time) {
 }
 
 void Spaceship::spaceship_fix(Body2df * body, float seconds) {
-  displacement_fix(body, seconds);
   Spaceship * ship = static_cast<Spaceship *>(body);
   ship->pass_time(seconds);
 }
 
+// the ship keeps accelerating during the ticks, that start before the end of the acceleration
 void Spaceship::pass_time(float seconds) {
-  if (hyperspace_delay > 0.0f && in_hyperspace) {
-    hyperspace_delay -= seconds;
-  }
-  shoot_cooldown.tick(seconds);
-  if (accelerate_timer > 0.0) {
+  if (get_age() - seconds < accelerate_end_time) {
     Body2df::accelerate(MAX_SPEED, seconds);
-    accelerate_timer -= seconds;
-  }
-  if (turn_timer > 0.0) {
-    turn_timer -= seconds;
   }
 }
 
@@ -144,18 +129,19 @@ bool Spaceship::is_in_hyperspace() {
 void Spaceship::jump_into_hyperspace(Game & game) {
   if ( ! in_hyperspace && ! is_marked_for_deletion() ) {
     set_velocity({0.0f, 0.0f});
-    set_position({512.0f + 348.0f * (0.5f - dis(gen)) , 368.0f + 256.0f * (0.5f - dis(gen)) });
-    if ( dis(gen) < 0.25f ||  game.no_of_asteroids > (dis(gen) * 15.0f + 4.0f) ) {
+    RandomStream & random = game.random.hyperspace;
+    set_position({512.0f + 348.0f * (0.5f - random.uniform()) , 368.0f + 256.0f * (0.5f - random.uniform()) });
+    if ( random.uniform() < 0.25f ||  game.no_of_asteroids > (random.uniform() * 15.0f + 4.0f) ) {
       game.destroy_spaceship(); 
     } else {
       in_hyperspace = true;
-      hyperspace_delay = HYPERSPACE_DELAY;
+      hyperspace_end_time = get_age() + HYPERSPACE_DELAY;
     }
   }
 }
 
 void Spaceship::jump_out_of_hyperspace(Game & game) {
-  if ( in_hyperspace && hyperspace_delay <= 0.0 && ! is_marked_for_deletion() ) {
+  if ( in_hyperspace && get_age() >= hyperspace_end_time && ! is_marked_for_deletion() ) {
     BoundingVolume2df bounding{ get_position(), 50.0f };
     if  ( game.area_free_of_asteroids( &bounding ) ) {
       in_hyperspace = false;
@@ -172,7 +158,7 @@ void Spaceship::remove(Torpedo *torpedo) {
 
 bool Saucer::shoot(Game & game) {
   float direction_angle;
-  if (shoot_cooldown.get_time() <= 0.0 && ! is_marked_for_deletion()) { 
+  if (get_age() >= shoot_time && ! is_marked_for_deletion()) { 
     std::unique_ptr<Body2df> new_body;   
     if ( no_of_torpedos < 2) {
       if ( size == 0 && precise_shoot_counter <= 0 && game.ship_exists() ) {
@@ -181,13 +167,13 @@ bool Saucer::shoot(Game & game) {
         new_body = std::make_unique<Torpedo>(get_position(), direct_shot.angle(0.0f,1.0f), get_velocity(), this );
         precise_shoot_counter = 6;
       } else {
-        direction_angle = PI * (1.0f - 2.0f * static_cast<float>(dis(gen)));
+        direction_angle = PI * (1.0f - 2.0f * game.random.saucer.uniform());
         new_body = std::make_unique<Torpedo>(get_position(), direction_angle, get_velocity(), this);
         precise_shoot_counter--;
       }
       no_of_torpedos++;
       game.physics.add_body(new_body);
-      shoot_cooldown.set_time(0.75);
+      shoot_time = get_age() + 0.75f;
       return true;
     }
   }
@@ -196,43 +182,38 @@ bool Saucer::shoot(Game & game) {
 
 
 
-void Saucer::change_direction() {
-  if ( change_direction_cooldown.get_time() < 0.0f && ! is_marked_for_deletion()) {
-    float random = dis(gen);
-    if ( random < 0.33 ) {
+void Saucer::change_direction(RandomStream & random) {
+  if ( get_age() > change_direction_time && ! is_marked_for_deletion()) {
+    float direction = random.uniform();
+    if ( direction < 0.33 ) {
       velocity[1] = 0.0f;
-    } else if (random < 0.66) {
+    } else if (direction < 0.66) {
       velocity[1] = 768.0f / 8.0f;
     } else {
       velocity[1] = -768.0f / 8.0f;
     }
-    change_direction_cooldown.set_time(1.0f);
+    change_direction_time = get_age() + 1.0f;
   }
 }
 
-void Saucer::pass_time(float seconds, Game & game) {
-  if (shoot_cooldown.get_time() > 0.0) {
-    shoot_cooldown.tick(seconds);
-  } else if ( shoot(game) ) {
+void Saucer::pass_time(Game & game) {
+  if ( shoot(game) ) {
     game.game_events.push_back(GameEvent::torpedo_fired);
   }
-  change_direction_cooldown.tick(seconds);
-  if (change_direction_cooldown.get_time() < 0.0) {
-    change_direction();
-  }
+  change_direction(game.random.saucer);
 }
 
 
-
-void Game::saucer_fix(Body2df * body, float seconds) {
+// the fix is called before the physics wraps the position around the torus,
+// so a saucer leaving the screen on the left or the right side is removed instead of wrapped
+void Game::saucer_fix(Body2df * body, float) {
   Saucer * saucer = static_cast<Saucer *>(body);
   float x = saucer->get_position()[0];
   
   if ( x > SCREEN_WIDTH || x < 0.0f ) {
     remove(saucer);    
   } else {
-    displacement_fix(body, seconds);
-    saucer->pass_time(seconds, *this);
+    saucer->pass_time(*this);
   }
 
 }
@@ -249,28 +230,35 @@ void Saucer::remove(Torpedo *torpedo) {
 }
 
 
-Game::Game() {
+// the playfield is a torus, bodies leaving the screen on one side enter it on the opposite side
+Game::Game(std::uint64_t seed) : random(seed) {
+  physics.set_world_size( Vector2df{ static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT) } );
 }
 
 void Game::spawn_asteroids() {
   no_of_asteroids = current_no_of_asteroids;
+  // the border and the position on it of all asteroids are drawn in one batch
+  std::array<float, 3 * MAXIMUM_ASTEROIDS_SPAWNING> randoms;
+  random.asteroid_spawn.fill( std::span<float>(randoms).first(3 * no_of_asteroids) );
   for (size_t i = 0; i < no_of_asteroids; i++) {
     Vector2df position = {0, 0};
-    float random = dis(gen);
-    if ( random < 0.25 ) {
-      position[0] = 128.0f * dis(gen);
-      position[1] = 768.0f * dis(gen);
-    } else if ( random < 0.5) {
-      position[0] = 1024.0f - 128.0f * dis(gen);
-      position[1] = 768.0f * dis(gen);
-    } else if ( random < 0.75 ) {
-      position[0] = 1024.0f * dis(gen);
-      position[1] = 98.0f * dis(gen);
+    float border = randoms[3 * i];
+    float x = randoms[3 * i + 1];
+    float y = randoms[3 * i + 2];
+    if ( border < 0.25 ) {
+      position[0] = 128.0f * x;
+      position[1] = 768.0f * y;
+    } else if ( border < 0.5) {
+      position[0] = 1024.0f - 128.0f * x;
+      position[1] = 768.0f * y;
+    } else if ( border < 0.75 ) {
+      position[0] = 1024.0f * x;
+      position[1] = 98.0f * y;
     } else {
-      position[0] = 1024.0f * dis(gen);
-      position[1] = 768.0f - 98.0f * dis(gen);      
+      position[0] = 1024.0f * x;
+      position[1] = 768.0f - 98.0f * y;      
     }
-    std::unique_ptr<Body2df> new_body = std::make_unique<Asteroid>(3, position);    
+    std::unique_ptr<Body2df> new_body = std::make_unique<Asteroid>(3, position, random.asteroid_spawn);    
     physics.add_body(new_body);
   }
   if (current_no_of_asteroids < MAXIMUM_ASTEROIDS_SPAWNING - 1) {
@@ -278,13 +266,25 @@ void Game::spawn_asteroids() {
   } else if (current_no_of_asteroids == MAXIMUM_ASTEROIDS_SPAWNING - 1) {
     current_no_of_asteroids = MAXIMUM_ASTEROIDS_SPAWNING;
   }
-  new_asteroids_spawn_timer = ASTEROID_SPAWN_TIME;
-  saucer_timer = SAUCER_SPAWN_TIME;
+  new_asteroids_due = false;
+  start_timer(saucer_timer, saucer_due, SAUCER_SPAWN_TIME);
   time_since_start_of_level = 0.0;
   game_events.push_back(GameEvent::next_level_started);
 }
 
-Physics2df & Game::get_physics() {
+void Game::start_timer(size_t & timer, bool & due, float seconds) {
+  if (timer != GamePhysics::NO_TIMER) {
+    physics.cancel_timer(timer);
+  }
+  due = false;
+  schedule_timer(timer, due, physics.get_time() + seconds);
+}
+
+void Game::schedule_timer(size_t & timer, bool & due, SimulationTime deadline) {
+  timer = physics.add_timer(deadline, [&timer, &due]() { timer = GamePhysics::NO_TIMER; due = true; });
+}
+
+GamePhysics & Game::get_physics() {
   return physics;
 }
 
@@ -311,11 +311,11 @@ void Game::destroy_asteroid(Asteroid * asteroid) {
   if (asteroid->get_size() > 1) {
     if (no_of_asteroids < 26) {
       no_of_asteroids++;
-      new_body = std::make_unique<Asteroid>(asteroid->get_size() - 1, asteroid->get_position() );
+      new_body = std::make_unique<Asteroid>(asteroid->get_size() - 1, asteroid->get_position(), random.asteroid_split );
       physics.add_body( new_body );
     }
     asteroid->mark_for_deletion();
-    new_body = std::make_unique<Asteroid>(asteroid->get_size() - 1, asteroid->get_position() );
+    new_body = std::make_unique<Asteroid>(asteroid->get_size() - 1, asteroid->get_position(), random.asteroid_split );
     physics.add_body( new_body );
   } else {
     asteroid->mark_for_deletion();
@@ -328,14 +328,15 @@ void Game::destroy_spaceship() {
     std::unique_ptr<Body2df> new_body = std::make_unique<SpaceshipDebris>(ship->get_position() );  
     physics.add_body( new_body );
     ship->mark_for_deletion();
+    release_torpedoes(ship);
     no_of_ships--;
-    ship_spawn_timer = SHIP_SPAWN_TIME;
+    start_timer(ship_spawn_timer, ship_spawn_due, SHIP_SPAWN_TIME);
     ship = nullptr;
     game_events.push_back(GameEvent::ship_destroyed);
   }
 }
 
-void Game::asteroid_hits_spaceship(Asteroid * asteroid) {
+void Game::spaceship_hits_asteroid(Spaceship *, Asteroid * asteroid) {
   if ( ship_exists() && ! ship->is_in_hyperspace() ) {
     destroy_spaceship();
     destroy_asteroid(asteroid);
@@ -353,7 +354,8 @@ void Game::add_score(long long points) {
 void Game::torpedo_hits_asteroid(Torpedo * torpedo, Asteroid * asteroid) {
   destroy_asteroid(asteroid);
   torpedo->mark_for_deletion();
-  if( ship == torpedo->get_origin() ) {
+  // the torpedoes of a destroyed ship have lost their origin, they must not score while no ship exists
+  if( ship != nullptr && ship == torpedo->get_origin() ) {
     switch ( asteroid->get_size() ) {
       case 1: add_score(POINTS_SMALL_ASTEROID);
               break;
@@ -377,7 +379,7 @@ void Game::destroy_saucer(Saucer * saucer) {
   remove(saucer);
 }
 
-void Game::spaceship_hits_saucer(Saucer * saucer) {
+void Game::spaceship_hits_saucer(Spaceship *, Saucer * saucer) {
   destroy_spaceship();
   destroy_saucer(saucer);  
 }
@@ -392,6 +394,18 @@ void Game::torpedo_hits_saucer(Torpedo * torpedo, Saucer * saucer) {
   destroy_saucer(saucer);
 }
 
+void Game::torpedo_hits_spaceship(Torpedo * torpedo, Spaceship *) {
+  if (! ship->is_in_hyperspace() ) {
+    torpedo->mark_for_deletion();
+    destroy_spaceship();
+  }
+}
+
+void Game::saucer_hits_asteroid(Saucer * saucer, Asteroid * asteroid) {
+  destroy_saucer(saucer);
+  destroy_asteroid(asteroid);
+}
+
 Spaceship * Game::get_ship() {
   return ship;
 }
@@ -423,41 +437,35 @@ void Game::hyperspace() {
 
 void Game::remove(Saucer * saucer) {
   saucer->mark_for_deletion();
+  release_torpedoes(saucer);
   this->saucer = nullptr;
-  saucer_timer = SAUCER_SPAWN_TIME;
+  start_timer(saucer_timer, saucer_due, SAUCER_SPAWN_TIME);
 }
 
 void Game::tick(float tick_time) {
   debug(3, "tick() entry...");
-  physics.tick(tick_time);  // collisions are handled during tick
+  trace_zone("Game::tick");
+  physics.tick(tick_time);  // collisions and expired timers are handled during tick
 
   time_since_start_of_level += tick_time;
-  saucer_timer -= tick_time;
   
   if ( ship_exists() && ship->is_in_hyperspace()) {
     ship->jump_out_of_hyperspace(*this);
   }
 
-  if (ship_spawn_timer > 0) {
-    ship_spawn_timer -= tick_time;
-  }
-  
-  
   if (no_of_asteroids == 0 && ! saucer_exists() ) {
-    if (new_asteroids_spawn_timer == 3.0f) {
-      game_events.push_back(GameEvent::end_of_level);
-    }
-    if (new_asteroids_spawn_timer > 0.0f) {
-      new_asteroids_spawn_timer -= tick_time;
-    } else {
+    if (new_asteroids_due) {
       spawn_asteroids();
+    } else if (new_asteroids_spawn_timer == GamePhysics::NO_TIMER) {
+      game_events.push_back(GameEvent::end_of_level);
+      start_timer(new_asteroids_spawn_timer, new_asteroids_due, ASTEROID_SPAWN_TIME);
     }
   }
 
-  if (saucer_timer < 0.0 && ! saucer_exists() && no_of_asteroids > 0) {
+  if (saucer_due && ! saucer_exists() && no_of_asteroids > 0) {
     new_saucer();
   }
-  if ( no_of_ships > 0 && ! ship_exists() && ship_spawn_timer <= 0.0 ) {
+  if ( no_of_ships > 0 && ! ship_exists() && ship_spawn_due ) {
     spawn_ship();
   }
   
@@ -481,19 +489,19 @@ void Game::new_saucer() {
     if ( time_since_start_of_level > 35.0f || score >= 30000LL) {
       type = 0;
     }
-    Vector2df position = { 10.0,   dis(gen) * (SCREEN_HEIGHT / 10 + (6 * SCREEN_HEIGHT) / 8)  };
+    Vector2df position = { 10.0,   random.saucer.uniform() * (SCREEN_HEIGHT / 10 + (6 * SCREEN_HEIGHT) / 8)  };
     Vector2df velocity = { 1024.0f / 8.0f, 0.0 };
     BoundingVolume2df body{position, 10.0f};
     if ( area_free_of_asteroids(&body) ) {
-      if ( dis(gen) > 0.5 ) {
+      if ( random.saucer.uniform() > 0.5 ) {
         position[0] = SCREEN_WIDTH - 10.0;
         velocity[0] = -velocity[0];
       }
-      std::unique_ptr<Body2df> new_body = std::make_unique<Saucer>( type, position, [&] (Body2df * body, float time)-> void { this->saucer_fix(body, time); });    
+      std::unique_ptr<Body2df> new_body = std::make_unique<Saucer>( type, position );    
       saucer = static_cast<Saucer *>(new_body.get());
       saucer->set_velocity(velocity);
       physics.add_body( new_body );
-      saucer_timer = 5.0;
+      start_timer(saucer_timer, saucer_due, 5.0f);
     }
   }
 }
@@ -527,82 +535,364 @@ std::vector<GameEvent> & Game::get_game_events() {
 void Game::resolve_collision(Body2df *body1, Body2df *body2) {
   TypedBody *typed_body1 = static_cast<TypedBody *>(body1);
   TypedBody *typed_body2 = static_cast<TypedBody *>(body2);
-  Asteroid *asteroid;
-  
-  if (typed_body2->get_type() == BodyType::spaceship) {
-    std::swap(typed_body1, typed_body2);
-  }
-  BodyType t1 = typed_body1->get_type();
-  BodyType t2 = typed_body2->get_type();
-  if (t1 == BodyType::spaceship) {
-    if (t2 == BodyType::asteroid) {
-      asteroid = static_cast<Asteroid *>(typed_body2);
-      asteroid_hits_spaceship(asteroid);
-    } else if (t2 == BodyType::saucer) {
-      spaceship_hits_saucer(static_cast<Saucer *>(typed_body2));
-    }
+  CollisionHandler handler = collision_handlers[static_cast<size_t>(typed_body1->get_type())][static_cast<size_t>(typed_body2->get_type())];
+  if (handler != nullptr) {
+    (this->*handler)(typed_body1, typed_body2);
   }
-  if (t2 == BodyType::torpedo) {
-    std::swap(typed_body1, typed_body2);
-    std::swap(t1, t2);
-  } 
-  
-  if (t1 == BodyType::torpedo) {
-    Torpedo * torpedo = static_cast<Torpedo *>(typed_body1);
-    if (t2 == BodyType::asteroid) {
-      asteroid = static_cast<Asteroid *>(typed_body2);
-      torpedo_hits_asteroid(torpedo, asteroid);
-    } else if (t2 == BodyType::spaceship) {
-      if (! ship->is_in_hyperspace() ) {
-        torpedo->mark_for_deletion();
-        destroy_spaceship();
-      }
-    } else if (t2 == BodyType::saucer) {
-      torpedo_hits_saucer(torpedo, static_cast<Saucer *>(typed_body2));
-    }
-  }
-   
-  if (t2 == BodyType::saucer) {
-    std::swap(typed_body1, typed_body2);
-    std::swap(t1, t2);
-  }
-
-  if (t1 == BodyType::saucer) {
-    if (t2 == BodyType::asteroid) {
-      destroy_saucer(static_cast<Saucer *>(typed_body1));
-      destroy_asteroid(static_cast<Asteroid *>(typed_body2));
-    }
-  }    
 }
-  
+
+// the filters of the bodies (see collision_mask()) already reject the pairs without a handler, before the
+// physics tests their bounding volumes
 bool Game::check_collision(Body2df *body1, Body2df *body2) {
   TypedBody *typed_body1 = static_cast<TypedBody *>(body1);
   TypedBody *typed_body2 = static_cast<TypedBody *>(body2);
-  bool torpedo = typed_body1->get_type() == BodyType::torpedo
-                  || typed_body2->get_type() == BodyType::torpedo;
-  bool asteroid = typed_body1->get_type() == BodyType::asteroid
-                  || typed_body2->get_type() == BodyType::asteroid;
-  bool spaceship = typed_body1->get_type() == BodyType::spaceship
-                  || typed_body2->get_type() == BodyType::spaceship;
-  bool saucer = typed_body1->get_type() == BodyType::saucer
-                  || typed_body2->get_type() == BodyType::saucer;
-  return ( torpedo && (asteroid || spaceship || saucer ) )
-       || (asteroid && (saucer || spaceship) )
-       || (saucer && spaceship);  
+  return collision_handlers[static_cast<size_t>(typed_body1->get_type())][static_cast<size_t>(typed_body2->get_type())] != nullptr;
+}
+
+template<class T1, class T2, void (Game::*HANDLER)(T1 *, T2 *)>
+constexpr void Game::add_collision_handler(CollisionHandlers & handlers, BodyType type1, BodyType type2) {
+  handlers[static_cast<size_t>(type1)][static_cast<size_t>(type2)] = &Game::call_collision_handler<T1, T2, HANDLER, false>;
+  handlers[static_cast<size_t>(type2)][static_cast<size_t>(type1)] = &Game::call_collision_handler<T1, T2, HANDLER, true>;
+}
+
+template<class T1, class T2, void (Game::*HANDLER)(T1 *, T2 *), bool SWAP>
+void Game::call_collision_handler(TypedBody * body1, TypedBody * body2) {
+  if (SWAP) {
+    std::swap(body1, body2);
+  }
+  (this->*HANDLER)(static_cast<T1 *>(body1), static_cast<T2 *>(body2));
+}
+
+constexpr Game::CollisionHandlers Game::create_collision_handlers() {
+  CollisionHandlers handlers{};
+  add_collision_handler<Spaceship, Asteroid, &Game::spaceship_hits_asteroid>(handlers, BodyType::spaceship, BodyType::asteroid);
+  add_collision_handler<Spaceship, Saucer, &Game::spaceship_hits_saucer>(handlers, BodyType::spaceship, BodyType::saucer);
+  add_collision_handler<Torpedo, Asteroid, &Game::torpedo_hits_asteroid>(handlers, BodyType::torpedo, BodyType::asteroid);
+  add_collision_handler<Torpedo, Spaceship, &Game::torpedo_hits_spaceship>(handlers, BodyType::torpedo, BodyType::spaceship);
+  add_collision_handler<Torpedo, Saucer, &Game::torpedo_hits_saucer>(handlers, BodyType::torpedo, BodyType::saucer);
+  add_collision_handler<Saucer, Asteroid, &Game::saucer_hits_asteroid>(handlers, BodyType::saucer, BodyType::asteroid);
+  return handlers;
 }
 
+constexpr Game::CollisionHandlers Game::collision_handlers = Game::create_collision_handlers();
+
 void Game::resolve_deleted_bodies(Body2df *body1) {
   TypedBody *typed_body1 = static_cast<TypedBody *>(body1);
   if (typed_body1->get_type() == BodyType::torpedo) {
     Torpedo * torpedo = static_cast<Torpedo *>(typed_body1);
     TypedBody * origin = torpedo->get_origin();
+    if (origin == nullptr) {
+      return;
+    }
     if (origin->get_type() == BodyType::saucer) {
       Saucer * saucer = static_cast<Saucer *>(origin);
       saucer->remove(torpedo);
     } else if (origin->get_type() == BodyType::spaceship) {
-      ship->remove(torpedo);
+      static_cast<Spaceship *>(origin)->remove(torpedo);
     }
   }
 }
 
+void Game::release_torpedoes(TypedBody * origin) {
+  for (auto * bodies : { &physics.get_bodies(), &physics.get_bodies_to_add() }) {
+    for (auto & body : *bodies) {
+      TypedBody * typed_body = static_cast<TypedBody *>(body.get());
+      if (typed_body->get_type() == BodyType::torpedo && static_cast<Torpedo *>(typed_body)->get_origin() == origin) {
+        static_cast<Torpedo *>(typed_body)->set_origin(nullptr);
+      }
+    }
+  }
+}
+
+namespace {
+
+// the records of a snapshot are copied into the buffer as they are in memory; they are zeroed before they are
+// filled member by member, so their padding bytes are zero and equal games give equal snapshots
+constexpr std::uint32_t SNAPSHOT_MAGIC = 0x41534E50u;  // "ASNP"
+constexpr std::uint32_t NO_INDEX = UINT32_MAX;
+
+struct GameRecord {
+  std::uint32_t magic;
+  std::uint32_t size_of_records;  // detects snapshots of other builds
+  std::uint32_t no_of_bodies;
+  std::uint32_t no_of_bodies_to_add;
+  std::uint32_t no_of_recently_added_bodies;
+  std::uint32_t no_of_game_events;
+  std::uint64_t no_of_ticks;
+  SimulationTime time;
+  float tick_time;
+  float time_since_start_of_level;
+  SimulationTime timer_deadlines[3];  // saucer, ship spawn and asteroid spawn timer, NaN if the timer is not running
+  bool dues[3];
+  short no_of_ships;
+  long long score;
+  std::uint64_t current_no_of_asteroids;
+  std::uint64_t no_of_asteroids;
+  std::uint32_t ship;        // index of the body, NO_INDEX for nullptr
+  std::uint32_t saucer;
+  GameRandom random;
+};
+
+static_assert(std::has_unique_object_representations_v<GameRandom>);  // copied as a whole
+
+// the bodies to add follow the bodies, their indices continue the indices of the bodies
+struct BodyRecord {
+  Body2df::State body{ BoundingVolume2df{ Vector2df{0.0f, 0.0f}, 0.0f }, Vector2df{0.0f, 0.0f}, Vector2df{0.0f, 0.0f},
+                       0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0u, 0u, false };  // filled by Body::get_state()
+  BodyType type = BodyType::asteroid;
+  short size = 0;                    // asteroid and saucer
+  short rock_type = 0;               // asteroid
+  char precise_shoot_counter = 0;    // saucer
+  bool in_hyperspace = false;        // spaceship
+  std::uint32_t origin = NO_INDEX;   // index of the origin of a torpedo
+  std::uint64_t no_of_torpedos = 0;  // spaceship and saucer
+  float times[3] = { };              // cooldowns of a spaceship or saucer
+};
+
+constexpr std::uint32_t SIZE_OF_RECORDS = sizeof(GameRecord) + (sizeof(BodyRecord) << 16);
+
+template<class T>
+void append(std::vector<std::uint8_t> & buffer, const T & value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  size_t size = buffer.size();
+  buffer.resize(size + sizeof(T));
+  std::memcpy(buffer.data() + size, &value, sizeof(T));
+}
+
+template<class T>
+T read(std::span<const std::uint8_t> & snapshot) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (snapshot.size() < sizeof(T)) {
+    throw std::invalid_argument("snapshot is truncated");
+  }
+  std::array<std::uint8_t, sizeof(T)> bytes;
+  std::memcpy(bytes.data(), snapshot.data(), sizeof(T));
+  snapshot = snapshot.subspan(sizeof(T));
+  return std::bit_cast<T>(bytes);
+}
+
+}
+
+void Game::snapshot(std::vector<std::uint8_t> & buffer) const {
+  const auto & bodies = physics.get_bodies();
+  const auto & bodies_to_add = physics.get_bodies_to_add();
+  const auto & recently_added_bodies = physics.get_recently_added_bodies();
+  // the index of a body is only looked up for the few pointers between the bodies
+  auto index_of = [&](const Body2df * body) -> std::uint32_t {
+    for (size_t i = 0; body != nullptr && i < bodies.size() + bodies_to_add.size(); i++) {
+      if ( (i < bodies.size() ? bodies[i] : bodies_to_add[i - bodies.size()]).get() == body ) {
+        return static_cast<std::uint32_t>(i);
+      }
+    }
+    return NO_INDEX;
+  };
+
+  GameRecord game{};
+  std::memset(static_cast<void *>(&game), 0, sizeof(game));
+  game.magic = SNAPSHOT_MAGIC;
+  game.size_of_records = SIZE_OF_RECORDS;
+  game.no_of_bodies = bodies.size();
+  game.no_of_bodies_to_add = bodies_to_add.size();
+  game.no_of_recently_added_bodies = recently_added_bodies.size();
+  game.no_of_game_events = game_events.size();
+  game.no_of_ticks = physics.get_no_of_ticks();
+  game.time = physics.get_time();
+  game.tick_time = physics.get_tick_time();
+  game.time_since_start_of_level = time_since_start_of_level;
+  const size_t timers[3] = { saucer_timer, ship_spawn_timer, new_asteroids_spawn_timer };
+  for (size_t i = 0; i < 3; i++) {
+    game.timer_deadlines[i] = timers[i] != GamePhysics::NO_TIMER ? physics.get_timer_deadline(timers[i]) : NAN;
+  }
+  game.dues[0] = saucer_due;
+  game.dues[1] = ship_spawn_due;
+  game.dues[2] = new_asteroids_due;
+  game.no_of_ships = no_of_ships;
+  game.score = score;
+  game.current_no_of_asteroids = current_no_of_asteroids;
+  game.no_of_asteroids = no_of_asteroids;
+  game.ship = index_of(ship);
+  game.saucer = index_of(saucer);
+  game.random = random;
+
+  buffer.clear();
+  append(buffer, game);
+  for (size_t i = 0; i < bodies.size() + bodies_to_add.size(); i++) {
+    TypedBody * body = static_cast<TypedBody *>( (i < bodies.size() ? bodies[i] : bodies_to_add[i - bodies.size()]).get() );
+    BodyRecord record{};
+    std::memset(static_cast<void *>(&record), 0, sizeof(record));
+    body->get_state(record.body);
+    record.type = body->get_type();
+    record.origin = NO_INDEX;
+    switch (body->get_type()) {
+      case BodyType::asteroid: {
+        Asteroid * asteroid = static_cast<Asteroid *>(body);
+        record.size = asteroid->size;
+        record.rock_type = asteroid->rock_type;
+        break;
+      }
+      case BodyType::torpedo:
+        record.origin = index_of( static_cast<Torpedo *>(body)->get_origin() );
+        break;
+      case BodyType::spaceship: {
+        Spaceship * spaceship = static_cast<Spaceship *>(body);
+        record.in_hyperspace = spaceship->in_hyperspace;
+        record.no_of_torpedos = spaceship->no_of_torpedos;
+        record.times[0] = spaceship->shoot_time;
+        record.times[1] = spaceship->accelerate_end_time;
+        record.times[2] = spaceship->hyperspace_end_time;
+        break;
+      }
+      case BodyType::saucer: {
+        Saucer * saucer = static_cast<Saucer *>(body);
+        record.size = saucer->size;
+        record.precise_shoot_counter = saucer->precise_shoot_counter;
+        record.no_of_torpedos = saucer->no_of_torpedos;
+        record.times[0] = saucer->shoot_time;
+        record.times[1] = saucer->change_direction_time;
+        break;
+      }
+      case BodyType::spaceship_debris:
+      case BodyType::debris:
+        break;
+    }
+    append(buffer, record);
+  }
+  for (Body2df * body : recently_added_bodies) {
+    append(buffer, index_of(body));
+  }
+  for (GameEvent event : game_events) {
+    append(buffer, event);
+  }
+}
+
+void Game::restore(std::span<const std::uint8_t> snapshot) {
+  GameRecord game = read<GameRecord>(snapshot);
+  if (game.magic != SNAPSHOT_MAGIC || game.size_of_records != SIZE_OF_RECORDS) {
+    throw std::invalid_argument("snapshot was not taken by this build of the game");
+  }
+  size_t no_of_records = size_t(game.no_of_bodies) + game.no_of_bodies_to_add;
+  if (snapshot.size() != no_of_records * sizeof(BodyRecord) + game.no_of_recently_added_bodies * sizeof(std::uint32_t)
+                          + game.no_of_game_events * sizeof(GameEvent)) {
+    throw std::invalid_argument("snapshot is truncated");
+  }
+
+  std::vector< std::unique_ptr<Body2df> > bodies;
+  std::vector< std::unique_ptr<Body2df> > bodies_to_add;
+  std::vector<TypedBody *> typed_bodies;
+  std::vector<std::uint32_t> origins;
+  for (size_t i = 0; i < no_of_records; i++) {
+    BodyRecord record = read<BodyRecord>(snapshot);
+    std::unique_ptr<Body2df> body;
+    switch (record.type) {
+      case BodyType::asteroid:
+        body = std::unique_ptr<Asteroid>( new Asteroid(record.size, record.rock_type) );
+        break;
+      case BodyType::torpedo:
+        body = std::make_unique<Torpedo>();
+        break;
+      case BodyType::spaceship: {
+        std::unique_ptr<Spaceship> spaceship = std::make_unique<Spaceship>( Vector2df{0.0f, 0.0f} );
+        spaceship->in_hyperspace = record.in_hyperspace;
+        spaceship->no_of_torpedos = record.no_of_torpedos;
+        spaceship->shoot_time = record.times[0];
+        spaceship->accelerate_end_time = record.times[1];
+        spaceship->hyperspace_end_time = record.times[2];
+        body = std::move(spaceship);
+        break;
+      }
+      case BodyType::saucer: {
+        std::unique_ptr<Saucer> saucer = std::make_unique<Saucer>(record.size);
+        saucer->precise_shoot_counter = record.precise_shoot_counter;
+        saucer->no_of_torpedos = record.no_of_torpedos;
+        saucer->shoot_time = record.times[0];
+        saucer->change_direction_time = record.times[1];
+        body = std::move(saucer);
+        break;
+      }
+      case BodyType::spaceship_debris:
+        body = std::make_unique<SpaceshipDebris>();
+        break;
+      case BodyType::debris:
+        body = std::make_unique<Debris>();
+        break;
+      default:
+        throw std::invalid_argument("snapshot contains an unknown body type");
+    }
+    body->set_state(record.body);
+    typed_bodies.push_back( static_cast<TypedBody *>(body.get()) );
+    origins.push_back(record.origin);
+    (i < game.no_of_bodies ? bodies : bodies_to_add).push_back( std::move(body) );
+  }
+  auto body_at = [&](std::uint32_t index) -> TypedBody * {
+    if (index == NO_INDEX) {
+      return nullptr;
+    }
+    if (index >= typed_bodies.size()) {
+      throw std::invalid_argument("snapshot contains an invalid body index");
+    }
+    return typed_bodies[index];
+  };
+  for (size_t i = 0; i < no_of_records; i++) {
+    if (typed_bodies[i]->get_type() == BodyType::torpedo) {
+      static_cast<Torpedo *>(typed_bodies[i])->set_origin( body_at(origins[i]) );
+    }
+  }
+  std::vector<size_t> recently_added;
+  for (size_t i = 0; i < game.no_of_recently_added_bodies; i++) {
+    std::uint32_t index = read<std::uint32_t>(snapshot);
+    if (index >= game.no_of_bodies) {
+      throw std::invalid_argument("snapshot contains an invalid body index");
+    }
+    recently_added.push_back(index);
+  }
+  game_events.clear();
+  for (size_t i = 0; i < game.no_of_game_events; i++) {
+    game_events.push_back( read<GameEvent>(snapshot) );
+  }
+  ship = static_cast<Spaceship *>( body_at(game.ship) );
+  saucer = static_cast<Saucer *>( body_at(game.saucer) );
+
+  // restoring the physics cancels the timers of the game
+  physics.restore(game.time, game.tick_time, game.no_of_ticks, bodies, bodies_to_add, recently_added);
+  size_t * timers[3] = { &saucer_timer, &ship_spawn_timer, &new_asteroids_spawn_timer };
+  bool * dues[3] = { &saucer_due, &ship_spawn_due, &new_asteroids_due };
+  for (size_t i = 0; i < 3; i++) {
+    *timers[i] = GamePhysics::NO_TIMER;
+    *dues[i] = game.dues[i];
+    if ( ! std::isnan(game.timer_deadlines[i]) ) {
+      schedule_timer(*timers[i], *dues[i], game.timer_deadlines[i]);
+    }
+  }
+  time_since_start_of_level = game.time_since_start_of_level;
+  no_of_ships = game.no_of_ships;
+  score = game.score;
+  current_no_of_asteroids = game.current_no_of_asteroids;
+  no_of_asteroids = game.no_of_asteroids;
+  random = game.random;
+}
+
   
+
+
+bool GamePhysicsPolicy::check_collision(Body2df * body1, Body2df * body2) {
+  return game->check_collision(body1, body2);
+}
+
+void GamePhysicsPolicy::resolve_collision(Body2df * body1, Body2df * body2) {
+  game->resolve_collision(body1, body2);
+}
+
+void GamePhysicsPolicy::resolve_deleted_body(Body2df * body) {
+  game->resolve_deleted_bodies(body);
+}
+
+void GamePhysicsPolicy::fix(Body2df * body, float seconds) {
+  TypedBody * typed_body = static_cast<TypedBody *>(body);
+  if (typed_body->get_type() == BodyType::spaceship) {
+    Spaceship::spaceship_fix(body, seconds);
+  } else if (typed_body->get_type() == BodyType::saucer) {
+    game->saucer_fix(body, seconds);
+  }
+}
+
+template class Physics<float, 2u, BoundingVolume2df, GamePhysicsPolicy>;
@@ -4,14 +4,30 @@
 #include <vector>  
 #include <utility>
 #include <array>
-#include <random>
 #include <memory>
-#include "timer.h"
+#include <cstdint>
+#include <span>
+#include "object_pool.h"
 #include "physics.h" 
+#include "random.h"
 
 // all different types of object used in this Asteroid-Game
 // for each type there will be a corresponding class
 enum class BodyType : short { spaceship, asteroid, torpedo, saucer, spaceship_debris, debris };
+constexpr size_t NO_OF_BODY_TYPES = 6;
+
+// the collision category of the bodies of a type (see Body::set_collision_filter())
+constexpr std::uint32_t collision_category(BodyType type) {
+  return 1u << static_cast<short>(type);
+}
+
+// the categories the bodies of a type collide with: the spaceship, the asteroids, the torpedoes and the saucers
+// collide with each other but not with bodies of their own type, the debris does not collide at all
+constexpr std::uint32_t collision_mask(BodyType type) {
+  constexpr std::uint32_t colliding = collision_category(BodyType::spaceship) | collision_category(BodyType::asteroid)
+                                      | collision_category(BodyType::torpedo) | collision_category(BodyType::saucer);
+  return (colliding & collision_category(type)) != 0u ? colliding & ~collision_category(type) : 0u;
+}
 
 // these games events are generated during each tick and can, for instance, be used to
 // generate special view or sound effects
@@ -23,38 +39,72 @@ enum class GameEvent : short { small_asteroid_destroyed, medium_asteroid_destroy
 
 class Game;
 
-void displacement_fix(Body2df * body, float seconds = 1.0);
+// the collision logic of the Game, resolved at compile time by the Physics of the Game (see Physics)
+// the policy steers the spaceship and the saucer after their movement, the other bodies need no fix
+class GamePhysicsPolicy {
+  Game * game;
+public:
+  explicit GamePhysicsPolicy(Game * game) : game(game) { }
+
+  bool check_collision(Body2df * body1, Body2df * body2);
+
+  void resolve_collision(Body2df * body1, Body2df * body2);
+
+  void resolve_deleted_body(Body2df * body);
+
+  void fix(Body2df * body, float seconds);
+};
+
+// instantiated in game.cc
+typedef Physics<float, 2u, BoundingVolume2df, GamePhysicsPolicy> GamePhysics;
 
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_real_distribution<float> dis(0.0, 0.99);
+// the random numbers of a Game, drawn from independent streams of its seed (see RandomStream),
+// so the numbers drawn for one purpose do not depend on how many numbers have been drawn for the others
+struct GameRandom {
+  RandomStream asteroid_spawn;
+  RandomStream asteroid_split;
+  RandomStream saucer;
+  RandomStream hyperspace;
+
+  GameRandom() : GameRandom(0u) { }
+
+  explicit GameRandom(std::uint64_t seed)
+    : asteroid_spawn(seed, 0u), asteroid_split(seed, 1u), saucer(seed, 2u), hyperspace(seed, 3u) { }
+};
 
 // the base class of all game objects
+// the short-lived game objects (torpedoes, debris, ...) are created and deleted often, so each subclass
+// allocates its objects from its own ObjectPool (see PoolAllocated)
 class TypedBody : public Body2df {
 protected:
   BodyType type;
 public:
-  TypedBody(BodyType type, Body2df body) : Body2df(body), type(type) { }
+  TypedBody(BodyType type, Body2df body) : Body2df(body), type(type) {
+    set_collision_filter(collision_category(type), collision_mask(type));
+  }
 
   BodyType get_type() {
     return type;
   }
 };
 
-class Asteroid : public TypedBody {
+class Asteroid : public TypedBody, public PoolAllocated<Asteroid> {
 short size; // 3 = big, 2 = medium, 1 = small
 short rock_type; // one of the four different rock types
+  // an asteroid restored from a snapshot, without drawing random numbers
+  Asteroid(short size, short rock_type);
 public:
-  Asteroid(short size = 3);
+  Asteroid(short size, RandomStream & random);
 
-  Asteroid(short size, Vector2df position );
+  Asteroid(short size, Vector2df position, RandomStream & random);
   
   short get_size() const;
   
   short get_rock_type() const;
+  friend class Game;
 };
 
-class Torpedo : public TypedBody {
+class Torpedo : public TypedBody, public PoolAllocated<Torpedo> {
 static constexpr float MAX_SPEED = 768.0f;
 TypedBody * origin;
 public:
@@ -70,7 +120,7 @@ public:
     : TypedBody(BodyType::torpedo, 
                 Body2df{ BoundingVolume2df{position + 14.0f * Vector2df( angle ), 1.0},
                          velocity + 1.1f * MAX_SPEED / 2.0f * Vector2df( angle ),
-                         MAX_SPEED, 0.0f, angle, displacement_fix} ) 
+                         MAX_SPEED, 0.0f, angle} ) 
     { set_time_to_delete(1.2f);
       this->origin = origin; 
     }
@@ -84,12 +134,13 @@ public:
   }
 };
 
-class Spaceship : public TypedBody {
+class Spaceship : public TypedBody, public PoolAllocated<Spaceship> {
   static constexpr float HYPERSPACE_DELAY = 1.0f;
-  Counter shoot_cooldown;
-  float accelerate_timer = 0.0f;
-  float turn_timer = 0.0f;
-  float hyperspace_delay = 0.0f;
+  // ages of the spaceship (see Body::get_age()), when it may shoot again, when it stops accelerating
+  // and when it may leave the hyperspace
+  float shoot_time = 0.0f;
+  float accelerate_end_time = 0.0f;
+  float hyperspace_end_time = 0.0f;
   bool in_hyperspace = false;
   size_t no_of_torpedos = 0;
 public:
@@ -98,11 +149,11 @@ public:
   Spaceship(Vector2df position)
     : TypedBody(BodyType::spaceship,
                 Body2df{ BoundingVolume2df{position, 10.0f},
-                         Vector2df{0.0f, 0.0f}, MAX_SPEED, 0.0f, 0.0f, spaceship_fix} )
+                         Vector2df{0.0f, 0.0f}, MAX_SPEED, 0.0f, 0.0f} )
     {
     }
   bool contains_torpedo(Torpedo * torpedo);
-  bool shoot(Physics2df & physics);
+  bool shoot(GamePhysics & physics);
   bool is_in_hyperspace();
   void pass_time(float seconds);
   bool can_accelerate(float seconds);
@@ -114,56 +165,59 @@ public:
   void jump_into_hyperspace(Game & game);
   void jump_out_of_hyperspace(Game & game);
   void remove(Torpedo *torpedo);
+  friend class Game;
 };
 
 
 
-class SpaceshipDebris : public TypedBody {
+class SpaceshipDebris : public TypedBody, public PoolAllocated<SpaceshipDebris> {
 public:
   static constexpr float TIME_TO_DELETE = 3.0;
   SpaceshipDebris(Vector2df position = Vector2df{0.0, 0.0}, float angle = 0.0)
     : TypedBody(BodyType::spaceship_debris,
                 Body2df{ BoundingVolume2df{position, 0.0},
-                         Vector2df{0.0, 0.0}, 384.0, 0.0, angle, displacement_fix} )
+                         Vector2df{0.0, 0.0}, 384.0, 0.0, angle} )
   {
     set_time_to_delete(TIME_TO_DELETE);
   }
 };
 
 
-class Saucer : public TypedBody {
-  Counter shoot_cooldown{1.0f};
-  Counter change_direction_cooldown{4.0f};
+class Saucer : public TypedBody, public PoolAllocated<Saucer> {
+  // ages of the saucer (see Body::get_age()), when it may shoot and change its direction again
+  float shoot_time = 1.0f;
+  float change_direction_time = 4.0f;
   short size; // 0 = small, 1 = big
   char precise_shoot_counter = 0; // every sixth torpedo of a small saucer shoots in direction to the spaceship
   size_t no_of_torpedos = 0;
 public:
-  Saucer(short size = 1, Vector2df position = Vector2df{0.0, 0.0}, std::function<void(Body2df *, float)> saucer_fix = displacement_fix)
+  Saucer(short size = 1, Vector2df position = Vector2df{0.0, 0.0})
     : TypedBody(BodyType::saucer,
                 Body2df{ BoundingVolume2df{position, static_cast<float>(size == 1 ? 15 : 7) },
-                         Vector2df{0.0, 0.0}, 200.0, 0.0, 0.0, saucer_fix} ) 
+                         Vector2df{0.0, 0.0}, 200.0, 0.0, 0.0} ) 
     {
       this->size = size;
       if (size == 0) {
-        shoot_cooldown.set_time(0.6);
+        shoot_time = 0.6f;
       }
     }
   bool shoot(Game & game);
-  void change_direction();
-  void pass_time(float seconds, Game & game);
+  void change_direction(RandomStream & random);
+  void pass_time(Game & game);
   short get_size() const;
   void remove(Torpedo *torpedo);
+  friend class Game;
 };
 
 
 // asteroid or saucer debris
-class Debris : public TypedBody {
+class Debris : public TypedBody, public PoolAllocated<Debris> {
 public:
   static constexpr float TIME_TO_DELETE = 0.6f;
   Debris(Vector2df position = Vector2df{0.0, 0.0}, float angle = 0.0f)
     : TypedBody( BodyType::debris,
                  Body2df{ BoundingVolume2df{position, 0.0f},
-                          Vector2df{0.0, 0.0}, 0.0f, 0.0f, angle, displacement_fix })
+                          Vector2df{0.0, 0.0}, 0.0f, 0.0f, angle })
   {
     set_time_to_delete(TIME_TO_DELETE);
   }
@@ -187,10 +241,8 @@ class Game {
   static constexpr short NO_OF_ASTEROIDS_AT_START = 4;
   static constexpr short MAXIMUM_ASTEROIDS_SPAWNING = 11;
   void saucer_fix(Body2df * body, float seconds);
-  Physics2df physics{ [&](Body2df * b1, Body2df * b2) -> bool { return this->check_collision(b1, b2); },
-                      [&](Body2df * b1, Body2df * b2) -> void { this->resolve_collision(b1, b2); },
-                      [&](Body2df * b1) -> void { this->resolve_deleted_bodies(b1); }
-                    };
+  GamePhysics physics{ GamePhysicsPolicy(this) };
+  GameRandom random;
   Spaceship * ship = nullptr;
   Saucer * saucer = nullptr;
   std::vector<GameEvent> game_events;
@@ -207,20 +259,58 @@ class Game {
   void spawn_asteroids();
   void destroy_spaceship();
   void destroy_saucer(Saucer *saucer);
-  void asteroid_hits_spaceship(Asteroid * asteroid);
+  void spaceship_hits_asteroid(Spaceship * spaceship, Asteroid * asteroid);
   void torpedo_hits_asteroid(Torpedo * torpedo, Asteroid * asteroid);
-  void spaceship_hits_saucer(Saucer * saucer);
+  void spaceship_hits_saucer(Spaceship * spaceship, Saucer * saucer);
   void torpedo_hits_saucer(Torpedo * torpedo, Saucer * saucer);
+  void torpedo_hits_spaceship(Torpedo * torpedo, Spaceship * spaceship);
+  void saucer_hits_asteroid(Saucer * saucer, Asteroid * asteroid);
+
+  // collision_handlers[type1][type2] resolves the collision of a body of type1 with a body of type2,
+  // nullptr if bodies of these types do not collide
+  typedef void (Game::*CollisionHandler)(TypedBody * body1, TypedBody * body2);
+  typedef std::array< std::array<CollisionHandler, NO_OF_BODY_TYPES>, NO_OF_BODY_TYPES> CollisionHandlers;
+  static const CollisionHandlers collision_handlers;
+  static constexpr CollisionHandlers create_collision_handlers();
+
+  // registers HANDLER for the collisions of bodies of type1 (class T1) with bodies of type2 (class T2) in both orders
+  template<class T1, class T2, void (Game::*HANDLER)(T1 *, T2 *)>
+  static constexpr void add_collision_handler(CollisionHandlers & handlers, BodyType type1, BodyType type2);
+
+  // calls HANDLER with the bodies cast to their classes, swapped if SWAP is true
+  template<class T1, class T2, void (Game::*HANDLER)(T1 *, T2 *), bool SWAP>
+  void call_collision_handler(TypedBody * body1, TypedBody * body2);
   float time_since_start_of_level = 0.0;
-  float saucer_timer = SHIP_SPAWN_TIME;
-  float ship_spawn_timer = 0.0;
-  float new_asteroids_spawn_timer = 0.0;
+  // the spawn timers are timers of the physics (see Physics::add_timer()), which only set their flags when they expire,
+  // so the game reacts to them at the usual point of its tick
+  size_t saucer_timer = GamePhysics::NO_TIMER;
+  size_t ship_spawn_timer = GamePhysics::NO_TIMER;
+  size_t new_asteroids_spawn_timer = GamePhysics::NO_TIMER;
+  bool saucer_due = false;
+  bool ship_spawn_due = true;
+  bool new_asteroids_due = true;
+  // restarts the timer, so it sets the flag after the given seconds
+  void start_timer(size_t & timer, bool & due, float seconds);
+  void schedule_timer(size_t & timer, bool & due, SimulationTime deadline);
+  // clears the origin of the torpedoes of a spaceship or saucer, that is going to be deleted,
+  // so no torpedo refers to a deleted body
+  void release_torpedoes(TypedBody * origin);
   void new_saucer();
   void add_score(long long points);
   bool area_free_of_asteroids(BoundingVolume2df * bounding);
   void remove(Saucer * saucer);
 public:
-  Game();
+  // a game created with the same seed behaves identically for the same inputs
+  explicit Game(std::uint64_t seed = 0u);
+
+  // writes the complete state of the game (bodies, timers, score, random number generator, ...) into the buffer,
+  // the pointers between the bodies are written as their indices, so the buffer can be copied and stored;
+  // a snapshot can only be restored by the same build of the game, for the bodies are copied as they are in memory
+  void snapshot(std::vector<std::uint8_t> & buffer) const;
+
+  // replaces the state of the game by a snapshot, the game continues exactly like the game the snapshot was taken of
+  // throws std::invalid_argument, if the snapshot is truncated or was not taken by this build
+  void restore(std::span<const std::uint8_t> snapshot);
   void tick(float tick_time);
   void ship_shoots();
   void hyperspace();
@@ -231,10 +321,11 @@ public:
   bool ship_exists() const;
   bool saucer_exists() const;
   Spaceship * get_ship();
-  Physics2df & get_physics();
+  GamePhysics & get_physics();
   std::vector<GameEvent> & get_game_events();  
   friend class Saucer;
   friend class Spaceship;
+  friend class GamePhysicsPolicy;
 };
 
 
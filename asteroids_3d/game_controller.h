@@ -2,13 +2,44 @@
 #define GAME_CONTROLLER_H
 
 #include "game.h"
+#include <cstdint>
+
+// the buttons pressed during one tick, a combination (bitwise or) of the GameController's input bits
+typedef std::uint8_t Input;
 
 class GameController {
 protected:
   Game & game;
   bool quit = false;
 public:
+  static constexpr Input LEFT = 1u;
+  static constexpr Input RIGHT = 2u;
+  static constexpr Input THRUST = 4u;
+  static constexpr Input FIRE = 8u;
+  static constexpr Input HYPERSPACE = 16u;
+
   GameController(Game & game) : game(game) {  }
+
+  // applies the buttons pressed during one tick to the ship
+  void apply_input(Input input, float tick_time) {
+    if ( game.ship_exists() ) {
+      if ( input & LEFT ) {
+        game.get_ship()->turn_left(tick_time);
+      }
+      if ( input & RIGHT ) {
+        game.get_ship()->turn_right(tick_time);
+      }
+      if ( input & THRUST ) {
+        game.accelerate_ship(tick_time);
+      }
+      if ( input & FIRE ) {
+        game.ship_shoots();
+      }
+      if ( input & HYPERSPACE ) {
+        game.hyperspace();
+      }
+    }
+  }
   
   virtual void do_user_interactions() = 0;
   
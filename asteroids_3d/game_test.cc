@@ -1,5 +1,13 @@
 #include "game.h"
+#include "headless_game_controller.h"
+#include "replay.h"
+#include "fixed_timestep.h"
 #include "gtest/gtest.h"
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 
 namespace {
@@ -22,6 +30,23 @@ TEST(SPACESHIP, HalfTurn) {
 }
   
   
+TEST(TYPED_BODY, CollisionFilterOfTypes) {
+  const BodyType types[] = { BodyType::spaceship, BodyType::asteroid, BodyType::torpedo, BodyType::saucer,
+                             BodyType::spaceship_debris, BodyType::debris };
+  for (BodyType type1 : types) {
+    for (BodyType type2 : types) {
+      TypedBody body1{ type1, Body2df{ BoundingVolume2df{ Vector2df{0.0f, 0.0f}, 1.0f }, Vector2df{0.0f, 0.0f} } };
+      TypedBody body2{ type2, Body2df{ BoundingVolume2df{ Vector2df{0.0f, 0.0f}, 1.0f }, Vector2df{0.0f, 0.0f} } };
+      // torpedoes hit everything but torpedoes and debris, asteroids hit saucers and the spaceship, saucers hit the spaceship
+      auto is_one_of = [&](BodyType type) { return type1 == type || type2 == type; };
+      bool collides = ( is_one_of(BodyType::torpedo) && (is_one_of(BodyType::asteroid) || is_one_of(BodyType::spaceship) || is_one_of(BodyType::saucer)) )
+                      || ( is_one_of(BodyType::asteroid) && (is_one_of(BodyType::saucer) || is_one_of(BodyType::spaceship)) )
+                      || ( is_one_of(BodyType::saucer) && is_one_of(BodyType::spaceship) );
+      EXPECT_EQ(collides, body1.can_collide(body2)) << static_cast<int>(type1) << " " << static_cast<int>(type2);
+    }
+  }
+}
+
 TEST(GAME, GetInitalScore) {
   Game game{}; 
   
@@ -42,6 +67,28 @@ TEST(GAME, InitalObjectsCreated) {
   ASSERT_EQ(5, game.get_physics().get_bodies().size());
 }
 
+TEST(GAME, SeedDeterminesAsteroids) {
+  auto asteroid_positions = [](std::uint64_t seed) {
+    Game game{seed};
+    game.tick(0.05f);
+    game.tick(0.05f);
+    std::vector<float> positions;
+    for (auto & body : game.get_physics().get_bodies()) {
+      if ( static_cast<TypedBody *>(body.get())->get_type() == BodyType::asteroid ) {
+        positions.push_back( body->get_position()[0] );
+        positions.push_back( body->get_position()[1] );
+      }
+    }
+    return positions;
+  };
+  std::vector<float> positions = asteroid_positions(5u);
+  std::vector<float> other_positions = asteroid_positions(6u);
+  ASSERT_EQ(8u, positions.size());
+  ASSERT_EQ(8u, other_positions.size());
+  EXPECT_EQ(positions, asteroid_positions(5u));
+  EXPECT_NE(positions, other_positions);
+}
+
 TEST(GAME, ShipShoots) {
   Game game{}; 
   
@@ -58,4 +105,374 @@ TEST(GAME, ShipShoots) {
 }
 
 
-}
\ No newline at end of file
+// adds a resting asteroid at the given position, which is hit in the next tick
+void add_asteroid(Game & game, short size, Vector2df position) {
+  RandomStream random;
+  std::unique_ptr<Body2df> asteroid = std::make_unique<Asteroid>(size, position, random);
+  asteroid->set_velocity( Vector2df{0.0f, 0.0f} );
+  game.get_physics().add_body(asteroid);
+}
+
+// the torpedoes of a destroyed ship no longer belong to the player, so they do not score
+TEST(GAME, TorpedoOfDestroyedShipDoesNotScore) {
+  Game game{};
+  game.tick(0.05f);
+  game.tick(0.05f);
+  ASSERT_TRUE(game.ship_exists());
+  game.ship_shoots();
+  game.tick(0.01f);
+  add_asteroid(game, 1, game.get_ship()->get_position());
+  game.tick(0.01f);
+  ASSERT_FALSE(game.ship_exists());
+  EXPECT_EQ(2.0f, game.get_no_of_ships());
+
+  Torpedo * torpedo = nullptr;
+  for (auto & body : game.get_physics().get_bodies()) {
+    if (static_cast<TypedBody *>(body.get())->get_type() == BodyType::torpedo) {
+      torpedo = static_cast<Torpedo *>(body.get());
+    }
+  }
+  ASSERT_NE(nullptr, torpedo);
+  EXPECT_EQ(nullptr, torpedo->get_origin());
+  add_asteroid(game, 1, torpedo->get_position() + 0.01f * torpedo->get_velocity());
+  game.tick(0.01f);
+  EXPECT_TRUE(torpedo->is_marked_for_deletion());
+  EXPECT_EQ(0LL, game.get_score());
+}
+
+TEST(HEADLESS, ScriptedInput) {
+  std::istringstream in("2 LEFT THRUST # comment\n\n1 FIRE HYPERSPACE\n1\n");
+  ScriptedInputSource input = ScriptedInputSource::parse(in);
+
+  EXPECT_EQ(GameController::LEFT | GameController::THRUST, input.next_input());
+  EXPECT_EQ(GameController::LEFT | GameController::THRUST, input.next_input());
+  EXPECT_EQ(GameController::FIRE | GameController::HYPERSPACE, input.next_input());
+  EXPECT_EQ(0u, input.next_input());
+  EXPECT_EQ(GameController::LEFT | GameController::THRUST, input.next_input());
+}
+
+TEST(HEADLESS, MalformedScript) {
+  std::istringstream unknown_button("10 JUMP\n");
+  EXPECT_THROW(ScriptedInputSource::parse(unknown_button), std::invalid_argument);
+  std::istringstream empty("# nothing\n");
+  EXPECT_THROW(ScriptedInputSource::parse(empty), std::invalid_argument);
+}
+
+TEST(HEADLESS, RunTicks) {
+  Game game{};
+  RandomInputSource input{1u};
+  HeadlessGameController controller{game, input};
+  for (int i = 0; i < 600; i++) {
+    controller.do_user_interactions();
+    controller.do_game_events();
+  }
+
+  EXPECT_EQ(600u, controller.get_ticks());
+  EXPECT_LT(0.0, controller.get_bodies_per_tick());
+  EXPECT_TRUE(game.get_game_events().empty());
+}
+
+// records a session with random input and returns the checksum of the final game state
+std::uint64_t record_session(Replay & replay, size_t no_of_ticks) {
+  Game game{replay.get_seed()};
+  RandomInputSource random_input{7u};
+  RecordingInputSource input{random_input, replay, game};
+  HeadlessGameController controller{game, input, replay.get_tick_time()};
+  while (controller.get_ticks() < no_of_ticks) {
+    controller.do_user_interactions();
+    controller.do_game_events();
+  }
+  return game_checksum(game);
+}
+
+TEST(REPLAY, EncodeDecode) {
+  Replay replay{42u, 1.0f / 60.0f, 100u};
+  record_session(replay, 1000);
+  std::vector<std::uint8_t> data = replay.encode();
+  Replay decoded = Replay::decode(data);
+
+  EXPECT_EQ(42u, decoded.get_seed());
+  EXPECT_EQ(1.0f / 60.0f, decoded.get_tick_time());
+  EXPECT_EQ(100u, decoded.get_keyframe_interval());
+  EXPECT_EQ(replay.get_inputs(), decoded.get_inputs());
+  ASSERT_EQ(10u, decoded.get_keyframes().size());
+  size_t size_of_states = 0;
+  for (size_t i = 0; i < 10u; i++) {
+    EXPECT_EQ(100u * i, decoded.get_keyframes()[i].tick);
+    EXPECT_EQ(replay.get_keyframes()[i].checksum, decoded.get_keyframes()[i].checksum);
+    EXPECT_FALSE(decoded.get_keyframes()[i].state.empty());
+    EXPECT_EQ(replay.get_keyframes()[i].state, decoded.get_keyframes()[i].state);
+    size_of_states += decoded.get_keyframes()[i].state.size();
+  }
+  // inputs are held for several ticks, so the runs are much shorter than one byte per tick
+  EXPECT_GT(500u, data.size() - size_of_states);
+}
+
+TEST(REPLAY, DecodeInvalidData) {
+  Replay replay{42u};
+  record_session(replay, 100);
+  std::vector<std::uint8_t> data = replay.encode();
+
+  EXPECT_THROW(Replay::decode( std::span{data}.first(data.size() - 1) ), std::invalid_argument);
+  EXPECT_EQ(Replay::VERSION, data[4]);
+  data[4] = 1u;  // recorded with the Mersenne Twister
+  EXPECT_THROW(Replay::decode(data), std::invalid_argument);
+  data[4] = Replay::VERSION;
+  data[0] = 'X';
+  EXPECT_THROW(Replay::decode(data), std::invalid_argument);
+}
+
+TEST(REPLAY, PlayReproducesSession) {
+  Replay replay{3u, 1.0f / 60.0f, 60u};
+  std::uint64_t checksum = record_session(replay, 3000);
+
+  ReplayPlayer player{replay};
+  player.seek(3000);
+  EXPECT_FALSE(player.is_desynchronized());
+  EXPECT_EQ(checksum, game_checksum(player.get_game()));
+}
+
+TEST(REPLAY, SeekBackward) {
+  Replay replay{5u, 1.0f / 60.0f, 60u};
+  record_session(replay, 2000);
+
+  ReplayPlayer player{replay};
+  player.seek(1500);
+  std::uint64_t checksum = game_checksum(player.get_game());
+  player.seek(1900);
+  player.seek(1500);
+  EXPECT_EQ(1500u, player.get_tick());
+  EXPECT_EQ(checksum, game_checksum(player.get_game()));
+  EXPECT_FALSE(player.is_desynchronized());
+}
+
+// changes the input of the first run of an encoded replay, so playing it from the start desynchronizes
+void change_first_input(std::vector<std::uint8_t> & data) {
+  size_t position = 4;
+  for (size_t i = 0; i < 6; i++) {  // version, seed, tick time, keyframe interval, number of ticks and of runs
+    while (data[position++] & 0x80u) { }
+  }
+  data[position] ^= GameController::THRUST | GameController::LEFT;
+}
+
+// a loaded replay is played from the state of the last keyframe before the tick, not from the start
+TEST(REPLAY, SeekStartsAtTheStateOfAKeyframe) {
+  Replay replay{8u, 1.0f / 60.0f, 60u};
+  record_session(replay, 1500);
+  ReplayPlayer player{replay};
+  player.seek(1500);
+  std::uint64_t checksum = game_checksum(player.get_game());
+
+  std::vector<std::uint8_t> data = replay.encode();
+  change_first_input(data);
+  Replay changed = Replay::decode(data);
+  ReplayPlayer changed_player{changed};
+  changed_player.seek(1500);
+  EXPECT_EQ(checksum, game_checksum(changed_player.get_game()));
+  EXPECT_FALSE(changed_player.is_desynchronized());
+  changed_player.seek(10);
+  changed_player.seek(1500);
+  EXPECT_EQ(checksum, game_checksum(changed_player.get_game()));
+
+  // without the states the changed input is played from the start
+  Replay without_states{8u, 1.0f / 60.0f, 0u};
+  for (Input input : changed.get_inputs()) {
+    without_states.record(input, player.get_game());
+  }
+  ReplayPlayer player_without_states{without_states};
+  player_without_states.seek(1500);
+  EXPECT_NE(checksum, game_checksum(player_without_states.get_game()));
+
+  // states of another build of the game are not restored, the replay is played from the start
+  data = replay.encode();
+  const std::uint8_t magic[4] = { 0x50u, 0x4Eu, 0x53u, 0x41u };  // of the snapshots
+  size_t no_of_states = 0;
+  for (auto position = data.begin(); (position = std::search(position, data.end(), magic, magic + 4)) != data.end(); ) {
+    *position++ ^= 0xFFu;
+    no_of_states++;
+  }
+  EXPECT_EQ(replay.get_keyframes().size(), no_of_states);
+  Replay other_build = Replay::decode(data);
+  ReplayPlayer other_build_player{other_build};
+  other_build_player.seek(1500);
+  EXPECT_EQ(checksum, game_checksum(other_build_player.get_game()));
+  EXPECT_FALSE(other_build_player.is_desynchronized());
+}
+
+// plays a list of inputs from the given tick on
+class ListInputSource : public InputSource {
+  const std::vector<Input> & inputs;
+  size_t tick;
+public:
+  ListInputSource(const std::vector<Input> & inputs, size_t tick = 0) : inputs(inputs), tick(tick) { }
+  virtual Input next_input() {
+    return inputs[tick++];
+  }
+};
+
+// compares the bodies of two games member by member, the bytes of their snapshots also contain padding
+void expect_equal_bodies(const std::vector< std::unique_ptr<Body2df> > & expected_bodies,
+                         const std::vector< std::unique_ptr<Body2df> > & bodies) {
+  ASSERT_EQ(expected_bodies.size(), bodies.size());
+  for (size_t i = 0; i < bodies.size(); i++) {
+    EXPECT_EQ(static_cast<TypedBody *>(expected_bodies[i].get())->get_type(), static_cast<TypedBody *>(bodies[i].get())->get_type()) << i;
+    Body2df::State expected = expected_bodies[i]->get_state();
+    Body2df::State state = bodies[i]->get_state();
+    for (size_t k = 0; k < 2; k++) {
+      EXPECT_EQ(expected.bounding.get_position()[k], state.bounding.get_position()[k]) << i;
+      EXPECT_EQ(expected.velocity[k], state.velocity[k]) << i;
+      EXPECT_EQ(expected.previous_position[k], state.previous_position[k]) << i;
+    }
+    EXPECT_EQ(expected.bounding.get_radius(), state.bounding.get_radius()) << i;
+    EXPECT_EQ(expected.max_velocity, state.max_velocity) << i;
+    EXPECT_EQ(expected.min_velocity, state.min_velocity) << i;
+    EXPECT_EQ(expected.angle, state.angle) << i;
+    EXPECT_EQ(expected.previous_angle, state.previous_angle) << i;
+    EXPECT_EQ(expected.deletable, state.deletable) << i;
+    if (expected.deletable) {
+      EXPECT_EQ(expected.delete_time, state.delete_time) << i;
+    }
+    EXPECT_EQ(expected.age, state.age) << i;
+    EXPECT_EQ(expected.birth_time, state.birth_time) << i;
+    EXPECT_EQ(expected.category, state.category) << i;
+    EXPECT_EQ(expected.mask, state.mask) << i;
+  }
+}
+
+TEST(GAME, RestoredSnapshotContinuesIdentically) {
+  const size_t no_of_ticks = 4000;
+  std::vector<Input> inputs;
+  RandomInputSource random_input{9u};
+  for (size_t i = 0; i < no_of_ticks; i++) {
+    inputs.push_back( random_input.next_input() );
+  }
+  std::mt19937 gen(21);
+  std::uniform_int_distribution<size_t> random_tick(0, no_of_ticks - 1);
+  std::vector<size_t> snapshot_ticks;
+  for (size_t i = 0; i < 8; i++) {
+    snapshot_ticks.push_back( random_tick(gen) );
+  }
+  std::sort(snapshot_ticks.begin(), snapshot_ticks.end());
+
+  Game game{13u};
+  ListInputSource input{inputs};
+  HeadlessGameController controller{game, input};
+  std::vector<std::uint64_t> checksums;
+  std::vector< std::vector<std::uint8_t> > snapshots;
+  while (controller.get_ticks() < no_of_ticks) {
+    while (snapshots.size() < snapshot_ticks.size() && snapshot_ticks[snapshots.size()] == controller.get_ticks()) {
+      snapshots.emplace_back();
+      game.snapshot(snapshots.back());
+    }
+    controller.do_user_interactions();
+    controller.do_game_events();
+    checksums.push_back( game_checksum(game) );
+  }
+
+  // the same game is restored again and again, so restore() has to replace all of its state
+  Game restored_game{};
+  for (size_t i = 0; i < snapshot_ticks.size(); i++) {
+    restored_game.restore(snapshots[i]);
+    ListInputSource restored_input{inputs, snapshot_ticks[i]};
+    HeadlessGameController restored_controller{restored_game, restored_input};
+    restored_controller.set_ticks(snapshot_ticks[i]);
+    while (restored_controller.get_ticks() < no_of_ticks) {
+      restored_controller.do_user_interactions();
+      restored_controller.do_game_events();
+      ASSERT_EQ(checksums[restored_controller.get_ticks() - 1], game_checksum(restored_game)) << "restored at tick " << snapshot_ticks[i];
+    }
+    EXPECT_EQ(game.get_score(), restored_game.get_score());
+    EXPECT_EQ(game.get_no_of_ships(), restored_game.get_no_of_ships());
+    EXPECT_EQ(game.get_time_since_start_of_level(), restored_game.get_time_since_start_of_level());
+    EXPECT_EQ(game.get_physics().get_time(), restored_game.get_physics().get_time());
+    EXPECT_EQ(game.get_physics().get_no_of_ticks(), restored_game.get_physics().get_no_of_ticks());
+    expect_equal_bodies(game.get_physics().get_bodies(), restored_game.get_physics().get_bodies());
+    expect_equal_bodies(game.get_physics().get_bodies_to_add(), restored_game.get_physics().get_bodies_to_add());
+  }
+}
+
+TEST(GAME, RestoreInvalidSnapshot) {
+  Game game{};
+  std::vector<std::uint8_t> snapshot;
+  game.snapshot(snapshot);
+  EXPECT_THROW(game.restore( std::span{snapshot}.first(snapshot.size() - 1) ), std::invalid_argument);
+  snapshot[0] ^= 0xFFu;
+  EXPECT_THROW(game.restore(snapshot), std::invalid_argument);
+}
+
+TEST(FIXED_TIMESTEP, StepsPerFrame) {
+  FixedTimestep timestep{0.01f};
+
+  EXPECT_EQ(0, timestep.advance(0.004f));
+  EXPECT_NEAR(0.4f, timestep.get_alpha(), 0.0001f);
+  EXPECT_EQ(1, timestep.advance(0.008f));
+  EXPECT_NEAR(0.2f, timestep.get_alpha(), 0.0001f);
+  EXPECT_EQ(2, timestep.advance(0.0205f));
+  EXPECT_NEAR(0.25f, timestep.get_alpha(), 0.0001f);
+}
+
+TEST(FIXED_TIMESTEP, SpiralOfDeathCap) {
+  FixedTimestep timestep{0.01f, 5};
+
+  EXPECT_EQ(5, timestep.advance(1.0f));
+  EXPECT_GT(1.0f, timestep.get_alpha());
+  EXPECT_EQ(1, timestep.advance(0.01f));
+}
+
+// the renderer draws each body at alpha between its positions and angles of the last two ticks,
+// a body wrapping around the edge of the world in a tick is drawn moving on across the edge, not across the screen
+TEST(FIXED_TIMESTEP, InterpolatesBetweenTheLastTwoTicks) {
+  Game game{11u};
+  std::istringstream script("40 LEFT THRUST\n20 FIRE\n30 RIGHT FIRE\n50 THRUST\n");
+  ScriptedInputSource input = ScriptedInputSource::parse(script);
+  HeadlessGameController controller{game, input};
+  const Vector2df world_size = game.get_physics().get_world_size();
+  const float alphas[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
+  // the distance of two points on the torus along an axis
+  auto distance = [&](float a, float b, size_t axis) {
+    float difference = std::fmod(std::abs(a - b), world_size[axis]);
+    return std::min(difference, world_size[axis] - difference);
+  };
+
+  struct Transform {
+    Body2df * body;
+    Vector2df position;
+    float angle;
+  };
+  size_t no_of_checked_bodies = 0;
+  size_t no_of_wrapped_bodies = 0;
+  for (size_t tick = 0; tick < 2000; tick++) {
+    std::vector<Transform> before;
+    for (auto & body : game.get_physics().get_bodies()) {
+      before.push_back( { body.get(), body->get_position(), body->get_angle() } );
+    }
+    controller.do_user_interactions();
+    controller.do_game_events();
+    for (auto & body : game.get_physics().get_bodies()) {
+      auto transform = std::find_if(before.begin(), before.end(), [&](const Transform & t) { return t.body == body.get(); });
+      // bodies added in this tick, maybe into the slot of a deleted one, have no previous tick
+      if (transform == before.end() || body->get_age() < 1.5f * controller.get_tick_time()) {
+        continue;
+      }
+      Vector2df displacement = body->get_position() - transform->position;
+      for (size_t axis = 0; axis < 2; axis++) {
+        if (std::abs(displacement[axis]) > 0.5f * world_size[axis]) {
+          displacement[axis] -= std::copysign(world_size[axis], displacement[axis]);
+          no_of_wrapped_bodies++;
+        }
+      }
+      for (float alpha : alphas) {
+        Vector2df expected = transform->position + alpha * displacement;
+        Vector2df interpolated = body->get_interpolated_position(alpha);
+        EXPECT_NEAR(0.0f, distance(expected[0], interpolated[0], 0), 1e-3f) << tick << " " << alpha;
+        EXPECT_NEAR(0.0f, distance(expected[1], interpolated[1], 1), 1e-3f) << tick << " " << alpha;
+        EXPECT_NEAR(transform->angle + alpha * (body->get_angle() - transform->angle), body->get_interpolated_angle(alpha), 1e-5f);
+      }
+      no_of_checked_bodies++;
+    }
+  }
+  EXPECT_LT(10000u, no_of_checked_bodies);
+  EXPECT_LT(0u, no_of_wrapped_bodies);
+}
+
+}
@@ -98,6 +98,10 @@ public:
 
   bool intersects(Sphere<FLOAT, N> sphere) const;
 
+  // returns the first time t in [0, 1] when this Sphere moving by displacement and the given sphere
+  // moving by sphere_displacement touch each other, both moving linearly from t = 0 to t = 1
+  // t is zero if the spheres intersect at the start, t is negative if they do not touch while moving
+  FLOAT time_of_impact(Sphere<FLOAT, N> sphere, Vector<FLOAT, N> displacement, Vector<FLOAT, N> sphere_displacement) const;
   
   // returns true iff the given point is inside this Sphere or on its surface
   bool inside(const Vector<FLOAT, N> p) const;
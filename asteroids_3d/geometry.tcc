@@ -80,6 +80,31 @@ bool Sphere<FLOAT,N>::intersects(Sphere<FLOAT, N> sphere) const {
     return centerVector.length() <= radiusSum;
 }
 
+// solution via
+// ( (sphere.center - center) + t (sphere_displacement - displacement) )^2 = (radius + sphere.radius)^2
+// the smaller root is the time at which the spheres start touching
+template <class FLOAT, size_t N>
+FLOAT Sphere<FLOAT,N>::time_of_impact(Sphere<FLOAT, N> sphere, Vector<FLOAT, N> displacement, Vector<FLOAT, N> sphere_displacement) const {
+  Vector<FLOAT,N> distance = sphere.center - center;
+  Vector<FLOAT,N> relative_displacement = sphere_displacement - displacement;
+  FLOAT radius_sum = radius + sphere.radius;
+  FLOAT c = distance * distance - radius_sum * radius_sum;
+  if (c <= 0) {
+    return 0;
+  }
+  FLOAT a = relative_displacement * relative_displacement,
+        b = distance * relative_displacement;
+  if (a == 0 || b >= 0) {
+    return -1; // not moving or moving apart
+  }
+  FLOAT d = b * b - a * c;
+  if (d < 0) {
+    return -1;
+  }
+  FLOAT t = (-b - std::sqrt(d)) / a;
+  return t <= 1 ? t : -1;
+}
+
 template <class FLOAT, size_t N>
 bool Sphere<FLOAT, N>::inside(const Vector<FLOAT, N> p) const {
     Vector<FLOAT,N> centerVector = this->center - p;
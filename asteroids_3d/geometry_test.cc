@@ -171,6 +171,32 @@ TEST(SPHERE, CustomIntersect3) {
     EXPECT_TRUE( sphere1.intersects(sphere2) );
 }
 
+TEST(SPHERE, TimeOfImpact) {
+  Sphere2df sphere1 = { {0.0, 0.0}, 1.0 };
+  Sphere2df sphere2 = { {10.0, 0.0}, 1.0 };
+
+  EXPECT_NEAR(0.4, sphere1.time_of_impact(sphere2, {20.0, 0.0}, {0.0, 0.0}), 0.00001);
+  EXPECT_NEAR(0.4, sphere2.time_of_impact(sphere1, {0.0, 0.0}, {20.0, 0.0}), 0.00001);
+  EXPECT_NEAR(0.2, sphere1.time_of_impact(sphere2, {20.0, 0.0}, {-20.0, 0.0}), 0.00001);
+}
+
+TEST(SPHERE, TimeOfImpactIntersectingAtStart) {
+  Sphere2df sphere1 = { {0.0, 0.0}, 1.0 };
+  Sphere2df sphere2 = { {1.0, 1.0}, 1.0 };
+
+  EXPECT_EQ(0.0, sphere1.time_of_impact(sphere2, {-20.0, 0.0}, {0.0, 0.0}));
+}
+
+TEST(SPHERE, TimeOfImpactNoImpact) {
+  Sphere2df sphere1 = { {0.0, 0.0}, 1.0 };
+  Sphere2df sphere2 = { {10.0, 0.0}, 1.0 };
+
+  EXPECT_GT(0.0, sphere1.time_of_impact(sphere2, {5.0, 0.0}, {0.0, 0.0}));    // too short
+  EXPECT_GT(0.0, sphere1.time_of_impact(sphere2, {0.0, 20.0}, {0.0, 0.0}));   // passing by
+  EXPECT_GT(0.0, sphere1.time_of_impact(sphere2, {-20.0, 0.0}, {0.0, 0.0}));  // moving apart
+  EXPECT_GT(0.0, sphere1.time_of_impact(sphere2, {20.0, 0.0}, {20.0, 0.0}));  // moving in parallel
+}
+
 
 TEST(SPHERE, Intersects2dfWithRay_1) {
   Sphere2df sphere = { {0.0, 0.0}, 1.0 };
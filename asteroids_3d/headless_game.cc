@@ -0,0 +1,159 @@
+#include "game.h"
+#include "headless_game_controller.h"
+#include "replay.h"
+#include "trace.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+// runs the game without video and audio as fast as the cpu allows, for soak and throughput tests
+//   headless_game [--ticks N] [--tick-time SECONDS] [--seed S | --script FILE] [--record FILE]
+//   headless_game --replay FILE [--ticks N]
+// the game and the random input are seeded with S (default 1), or the input is read from a script (see ScriptedInputSource::parse)
+// --record saves the session as a replay, --replay plays a recorded session (see replay.h)
+// --trace writes the traced zones as Chrome trace events, if built with TRACE_ENABLED (see trace.h)
+
+namespace {
+
+void usage() {
+  std::cerr << "usage: headless_game [--ticks N] [--tick-time SECONDS] [--seed S | --script FILE] [--record FILE] [--trace FILE]" << std::endl;
+  std::cerr << "       headless_game --replay FILE [--ticks N] [--trace FILE]" << std::endl;
+}
+
+void report(size_t ticks, double seconds, double bodies_per_tick, long long score) {
+  std::cout << "ticks: " << ticks << std::endl;
+  std::cout << "ticks per second: " << ticks / seconds << std::endl;
+  std::cout << "bodies per tick: " << bodies_per_tick << std::endl;
+  std::cout << "score: " << score << std::endl;
+}
+
+void write_trace(const std::string & trace_file) {
+  if (!trace_file.empty()) {
+    std::ofstream out(trace_file);
+    trace_write_chrome_json(out);
+  }
+}
+
+int play_replay(const std::string & replay_file, size_t no_of_ticks) {
+  std::ifstream in(replay_file, std::ios::binary);
+  if (!in) {
+    std::cerr << "could not open " << replay_file << std::endl;
+    return EXIT_FAILURE;
+  }
+  try {
+    Replay replay = Replay::load(in);
+    no_of_ticks = std::min(no_of_ticks, replay.get_inputs().size());
+    Game game{replay.get_seed()};
+    ReplayInputSource input_source{replay, game};
+    HeadlessGameController controller{game, input_source, replay.get_tick_time()};
+    auto start = std::chrono::steady_clock::now();
+    while (controller.get_ticks() < no_of_ticks) {
+      controller.do_user_interactions();
+      controller.do_game_events();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report(controller.get_ticks(), elapsed.count(), controller.get_bodies_per_tick(), game.get_score());
+    if (input_source.is_desynchronized()) {
+      std::cerr << "replay desynchronized: a keyframe does not match the game state" << std::endl;
+      return EXIT_FAILURE;
+    }
+  } catch (std::invalid_argument & e) {
+    std::cerr << replay_file << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
+}
+
+int main(int argc, char * argv[]) {
+  size_t no_of_ticks = 60 * 60 * 10;  // ten minutes of game time
+  float tick_time = 1.0f / 60.0f;
+  unsigned int seed = 1;
+  std::string script_file;
+  std::string record_file;
+  std::string replay_file;
+  std::string trace_file;
+  bool ticks_given = false;
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (i + 1 >= argc) {
+      usage();
+      return EXIT_FAILURE;
+    }
+    std::string value = argv[++i];
+    try {
+      if (argument == "--ticks") {
+        no_of_ticks = std::stoull(value);
+        ticks_given = true;
+      } else if (argument == "--tick-time") {
+        tick_time = std::stof(value);
+      } else if (argument == "--seed") {
+        seed = std::stoul(value);
+      } else if (argument == "--script") {
+        script_file = value;
+      } else if (argument == "--record") {
+        record_file = value;
+      } else if (argument == "--replay") {
+        replay_file = value;
+      } else if (argument == "--trace") {
+        trace_file = value;
+      } else {
+        usage();
+        return EXIT_FAILURE;
+      }
+    } catch (std::logic_error & e) {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!replay_file.empty()) {
+    int result = play_replay(replay_file, ticks_given ? no_of_ticks : std::numeric_limits<size_t>::max());
+    write_trace(trace_file);
+    return result;
+  }
+
+  std::unique_ptr<InputSource> input_source;
+  if (script_file.empty()) {
+    input_source = std::make_unique<RandomInputSource>(seed);
+  } else {
+    std::ifstream in(script_file);
+    if (!in) {
+      std::cerr << "could not open " << script_file << std::endl;
+      return EXIT_FAILURE;
+    }
+    try {
+      input_source = std::make_unique<ScriptedInputSource>( ScriptedInputSource::parse(in) );
+    } catch (std::invalid_argument & e) {
+      std::cerr << script_file << ": " << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Game game{seed};
+  Replay replay{seed, tick_time};
+  RecordingInputSource recording_input_source{*input_source, replay, game};
+  InputSource & controller_input = (record_file.empty() ? *input_source : recording_input_source);
+  HeadlessGameController controller{game, controller_input, tick_time};
+  auto start = std::chrono::steady_clock::now();
+  while (controller.get_ticks() < no_of_ticks && ! controller.exit_game()) {
+    controller.do_user_interactions();
+    controller.do_game_events();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  report(controller.get_ticks(), elapsed.count(), controller.get_bodies_per_tick(), game.get_score());
+
+  if (!record_file.empty()) {
+    std::ofstream out(record_file, std::ios::binary);
+    replay.save(out);
+  }
+  write_trace(trace_file);
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "headless_game_controller.h"
+#include "debug.h"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// class RandomInputSource
+
+RandomInputSource::RandomInputSource(unsigned int seed) : gen(seed) { }
+
+Input RandomInputSource::next_input() {
+  if (remaining_ticks <= 0) {
+    input = static_cast<Input>( buttons(gen) );
+    remaining_ticks = duration(gen);
+  }
+  remaining_ticks--;
+  return input;
+}
+
+// class ScriptedInputSource
+
+ScriptedInputSource::ScriptedInputSource(std::vector< std::pair<size_t, Input> > script) : script(script) {
+  if (script.empty()) {
+    throw std::invalid_argument("empty input script");
+  }
+}
+
+ScriptedInputSource ScriptedInputSource::parse(std::istream & in) {
+  std::vector< std::pair<size_t, Input> > script;
+  std::string line;
+  size_t line_number = 0;
+  while ( std::getline(in, line) ) {
+    line_number++;
+    line = line.substr(0, line.find('#'));
+    std::istringstream tokens(line);
+    size_t ticks;
+    if ( !(tokens >> ticks) ) {
+      if ( line.find_first_not_of(" \t\r") != std::string::npos ) {
+        throw std::invalid_argument("number of ticks expected in line " + std::to_string(line_number));
+      }
+      continue;
+    }
+    Input input = 0u;
+    std::string button;
+    while (tokens >> button) {
+      if (button == "LEFT") {
+        input |= GameController::LEFT;
+      } else if (button == "RIGHT") {
+        input |= GameController::RIGHT;
+      } else if (button == "THRUST") {
+        input |= GameController::THRUST;
+      } else if (button == "FIRE") {
+        input |= GameController::FIRE;
+      } else if (button == "HYPERSPACE") {
+        input |= GameController::HYPERSPACE;
+      } else {
+        throw std::invalid_argument("unknown button " + button + " in line " + std::to_string(line_number));
+      }
+    }
+    if (ticks > 0) {
+      script.push_back( {ticks, input} );
+    }
+  }
+  return ScriptedInputSource(script);
+}
+
+Input ScriptedInputSource::next_input() {
+  if (ticks_in_step == script[step].first) {
+    step = (step + 1) % script.size();
+    ticks_in_step = 0;
+  }
+  ticks_in_step++;
+  return script[step].second;
+}
+
+// class HeadlessGameController
+
+HeadlessGameController::HeadlessGameController(Game & game, InputSource & input_source, float tick_time)
+  : GameController(game), input_source(input_source), tick_time(tick_time) { }
+
+void HeadlessGameController::do_user_interactions() {
+  debug(2, "do_user_interactions() entry...");
+  game.tick(tick_time);
+  apply_next_input();
+  debug(2, "do_user_interactions() exit.");
+}
+
+void HeadlessGameController::apply_next_input() {
+  apply_input(input_source.next_input(), tick_time);
+  ticks++;
+  body_ticks += game.get_physics().get_bodies().size();
+}
+
+void HeadlessGameController::do_game_events() {
+  game.get_game_events().clear();
+}
+
+float HeadlessGameController::get_tick_time() const {
+  return tick_time;
+}
+
+size_t HeadlessGameController::get_ticks() const {
+  return ticks;
+}
+
+void HeadlessGameController::set_ticks(size_t ticks) {
+  this->ticks = ticks;
+}
+
+double HeadlessGameController::get_bodies_per_tick() const {
+  return ticks > 0 ? static_cast<double>(body_ticks) / ticks : 0.0;
+}
@@ -0,0 +1,69 @@
+#ifndef HEADLESS_GAME_CONTROLLER_H
+#define HEADLESS_GAME_CONTROLLER_H
+
+#include "game_controller.h"
+#include <random>
+#include <vector>
+#include <utility>
+#include <istream>
+
+// provides the input of each tick for the HeadlessGameController
+class InputSource {
+public:
+  virtual ~InputSource() = default;
+  virtual Input next_input() = 0;
+};
+
+// presses random buttons, each combination of buttons is held for a random number of ticks
+class RandomInputSource : public InputSource {
+  std::mt19937 gen;
+  std::uniform_int_distribution<int> buttons{0, 31};
+  std::uniform_int_distribution<int> duration{1, 30};
+  Input input = 0u;
+  int remaining_ticks = 0;
+public:
+  RandomInputSource(unsigned int seed);
+  virtual Input next_input();
+};
+
+// plays a script of (number of ticks, input) steps, the script starts again after its last step
+class ScriptedInputSource : public InputSource {
+  std::vector< std::pair<size_t, Input> > script;
+  size_t step = 0;
+  size_t ticks_in_step = 0;
+public:
+  ScriptedInputSource(std::vector< std::pair<size_t, Input> > script);
+
+  // reads one step per line: the number of ticks followed by the pressed buttons, for instance
+  //   30 LEFT THRUST
+  //   10 FIRE
+  //   60
+  // the buttons are LEFT, RIGHT, THRUST, FIRE and HYPERSPACE, # starts a comment
+  // throws std::invalid_argument if the script is malformed or empty
+  static ScriptedInputSource parse(std::istream & in);
+
+  virtual Input next_input();
+};
+
+// runs the game without video and audio as fast as possible
+// each call of do_user_interactions() advances the game by one tick and applies the next input
+class HeadlessGameController : public GameController {
+  InputSource & input_source;
+  float tick_time;
+  size_t ticks = 0;
+  size_t body_ticks = 0;  // sum of the number of bodies after each tick
+public:
+  HeadlessGameController(Game & game, InputSource & input_source, float tick_time = 1.0f / 60.0f);
+  virtual void do_user_interactions();
+  // applies the next input without ticking the game, e.g. after the state of a keyframe has been restored,
+  // which was taken after the tick of the game (see Replay::record())
+  void apply_next_input();
+  virtual void do_game_events();  // game events are discarded
+  float get_tick_time() const;
+  size_t get_ticks() const;
+  // continues counting at the given tick, e.g. after a snapshot of the game has been restored
+  void set_ticks(size_t ticks);
+  double get_bodies_per_tick() const;
+};
+
+#endif
@@ -8,42 +8,68 @@
 #include "game_controller.h"
 #include "sdl2_game_controller.h"
 #include <memory>
+#include <fstream>
+#include <random>
 
 #include "debug.h"
+#include "trace.h"
+#include "fixed_timestep.h"
 
 #ifdef _WIN32
 #include <windows.h>
-int main(void);
+int main(int argc, char * argv[]);
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int CmdShow)
 {
-    return main();
+    return main(__argc, __argv);
 }
 #endif
 
 // sets up the model, view, and controller objects
 // main itself is a controller containing the game main loop
-int main(void) {
-  Timer timer;
-  Game game{};
+// the game is simulated with the fixed tick time of the controller, independent of the frame rate,
+// each frame is drawn between the last two ticks
+// if a file name is given, the session is recorded into this file as a replay (see replay.h)
+int main(int argc, char * argv[]) {
+  std::uint32_t seed = std::random_device{}();
+  Game game{seed};
   SDL2GameController controller = SDL2GameController{game};
+  Replay replay{seed, controller.get_tick_time()};
+  if (argc > 1) {
+    controller.set_recording(&replay);
+  }
   //std::unique_ptr<Renderer> renderer = std::make_unique<SDL2Renderer>(game, "Asteroids");
   std::unique_ptr<Renderer> renderer = std::make_unique<OpenGLRenderer>(game, "Asteroids", 1024, 768);
 
   renderer->init();
+  FixedTimestep timestep{controller.get_tick_time()};
+  const Uint64 frequency = SDL_GetPerformanceFrequency();
+  Uint64 last_frame = SDL_GetPerformanceCounter();
   do {
     debug(1, "game loop begin.");
-    timer.reset();
-    renderer->render();
-    controller.do_user_interactions();
-    if ( ! controller.exit_game() ) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    float elapsed_time = static_cast<float>(now - last_frame) / frequency;
+    last_frame = now;
+
+    controller.handle_events();
+    for (int steps = timestep.advance(elapsed_time); steps > 0 && ! controller.exit_game(); steps--) {
+      controller.do_user_interactions();
       controller.do_game_events();
-      timer.tick_and_delay( controller.get_tick_time() );
     }
+    renderer->set_interpolation( timestep.get_alpha() );
+    renderer->render();
     debug(1, "game loop end.");
   } while (! controller.exit_game() );
 
   renderer->exit();
 
+  if (argc > 1) {
+    std::ofstream out(argv[1], std::ios::binary);
+    replay.save(out);
+  }
+#if TRACE_ENABLED
+  std::ofstream trace("trace.json");
+  trace_write_chrome_json(trace);
+#endif
   return 0;
 }
@@ -11,19 +11,29 @@ template class Vector<float, 4u>;
 
 
 // instantiations of each template function
+// the operators of the float vectors are specialized in math_simd.tcc, unless GENERIC_VECTORS is defined
+#if !defined(__SSE2__) || defined(GENERIC_VECTORS)
 template Vector<float, 2u> operator*(float scalar, Vector<float, 2u> value);
 template Vector<float, 2u> operator+(Vector<float, 2u> value, const Vector<float, 2u> addend);
 template Vector<float, 2u> operator-(Vector<float, 2u> value, const Vector<float, 2u> addend);
-template float operator*(Vector<float, 2u> value, const Vector<float, 2u> addend);
 
 template Vector<float, 3u> operator*(float scalar, Vector<float, 3u> value);
 template Vector<float, 3u> operator+(Vector<float, 3u> value, const Vector<float, 3u> addend);
 template Vector<float, 3u> operator-(Vector<float, 3u> value, const Vector<float, 3u> addend);
-template float operator*(Vector<float, 3u> value, const Vector<float, 3u> addend);
 
 template Vector<float, 4u> operator*(float scalar, Vector<float, 4u> value);
 template Vector<float, 4u> operator+(Vector<float, 4u> value, const Vector<float, 4u> addend);
 template Vector<float, 4u> operator-(Vector<float, 4u> value, const Vector<float, 4u> addend);
-template float operator*(Vector<float, 4u> value, const Vector<float, 4u> addend);
-
 
+template float operator*(Vector<float, 2u> value, const Vector<float, 2u> addend);
+template float operator*(Vector<float, 3u> value, const Vector<float, 3u> addend);
+template float operator*(Vector<float, 4u> value, const Vector<float, 4u> addend);
+#endif
+
+SimdLevel simd_level() {
+#if defined(__SSE2__) && !defined(GENERIC_VECTORS)
+  return SimdLevel::sse2;
+#else
+  return SimdLevel::scalar;
+#endif
+}
@@ -6,6 +6,14 @@
 #include <cstddef>
 #include <cmath>
 
+// returns the alignment of the scalar values of a Vector
+// four floats are 16 byte aligned to allow aligned SIMD loads and stores,
+// all other vectors keep the alignment of their scalar values, because they are used as tightly packed vertex data
+template<class FLOAT_TYPE, size_t N>
+constexpr size_t vector_alignment() {
+  return (N == 4u && sizeof(FLOAT_TYPE) == 4u) ? 16u : alignof(std::array<FLOAT_TYPE, N>);
+}
+
 // A Vector consisting of N scalar values of type FLOAT_TYPE
 template<class FLOAT_TYPE, size_t N>
 struct Vector {
@@ -13,9 +21,10 @@ struct Vector {
   
   // stores the N scalar values of this Vector
   // index 0, 1, 2, ... corresponds to x,y,z,... axis
-  std::array<FLOAT_TYPE, N> vector;
+  alignas(vector_alignment<FLOAT_TYPE, N>()) std::array<FLOAT_TYPE, N> vector;
 
-  Vector();
+  // not user-provided, so that Vector v = {} is zero-initialized
+  Vector() = default;
 
   // creates a new Vector with the given scalar values
   // if values is empty, then this->vector is initilized with zeros
@@ -93,6 +102,34 @@ struct Vector {
 
 static const long double PI = std::acos(-1.0L);
 
+template <class F, size_t K>    
+F operator*(Vector<F, K> vector1, Vector<F, K> vector2);
+
+template <class F, size_t K>
+Vector<F, K> operator*(F scalar, Vector<F, K> value);
+
+template <class F, size_t K>
+Vector<F, K> operator+(const Vector<F, K> value, const Vector<F, K> addend);
+
+template <class F, size_t K>
+Vector<F, K> operator-(const Vector<F, K> value, const Vector<F, K> minuend);
+
+// instruction sets used by the float vectors of size 2, 3 and 4
+// sse2 is part of every x86-64 cpu and used for all operations, when the compiler targets it
+enum class SimdLevel : short { scalar, sse2 };
+
+// returns the instruction set used by the float vectors
+SimdLevel simd_level();
+
+// GENERIC_VECTORS keeps the generic loops for all vectors, e.g. to compare them with the SIMD implementations
+#if defined(__SSE2__) && !defined(GENERIC_VECTORS)
+// SIMD implementations of the float vectors, see math_simd.tcc
+// + - * / produce the same results as the scalar implementation,
+// sums of products (scalar product, square_of_length, length) are added pairwise: (x + y) + (z + w)
+// they are defined inline, so they are inlined into the loops of the physics
+#include "math_simd.tcc"
+#endif
+
 // shorter comfortable type names
 typedef Vector<float, 2u> Vector2df;
 typedef Vector<float, 3u> Vector3df;
@@ -136,7 +136,4 @@ FLOAT_TYPE Vector<FLOAT_TYPE, N>::angle(size_t axis_1, size_t axis_2) const {
   return atan2( normalized[axis_2], normalized[axis_1] );
 }
 
-template<class FLOAT_TYPE, size_t N>
-Vector<FLOAT_TYPE, N>::Vector() = default;
-
 
@@ -0,0 +1,91 @@
+#include "math.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+// measures the float vectors of size 2, 3 and 4 on arrays of vectors, like the loops of the physics:
+// scalar products, lengths and the motion update position += velocity * time
+// built twice, as math_benchmark with the SIMD implementations (inline) and as math_benchmark_generic with
+// GENERIC_VECTORS (the generic loops, out of line in math.cc)
+// the best of a few runs is reported in nanoseconds per vector
+
+namespace {
+
+constexpr size_t NO_OF_VECTORS = 4096;  // fits into the first level cache
+constexpr size_t NO_OF_REPETITIONS = 2000;
+constexpr int NO_OF_RUNS = 5;
+
+const char * vector_name() {
+  switch (simd_level()) {
+    case SimdLevel::scalar: return "generic";
+    case SimdLevel::sse2: return "sse2";
+  }
+  return "";
+}
+
+template<class F>
+double nanoseconds_per_vector(F loop) {
+  double best = 1e30;
+  float checksum = 0.0f;
+  for (int run = 0; run < NO_OF_RUNS; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NO_OF_REPETITIONS; i++) {
+      checksum += loop();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / (NO_OF_REPETITIONS * NO_OF_VECTORS));
+  }
+  volatile float sink = checksum;  // keeps the loops from being removed
+  (void) sink;
+  return best;
+}
+
+template<size_t N>
+void benchmark(const char * name) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+  std::vector< Vector<float, N> > positions(NO_OF_VECTORS), velocities(NO_OF_VECTORS);
+  for (size_t i = 0; i < NO_OF_VECTORS; i++) {
+    for (size_t k = 0; k < N; k++) {
+      positions[i][k] = value(gen);
+      velocities[i][k] = value(gen);
+    }
+  }
+
+  double scalar_product = nanoseconds_per_vector([&]() {
+    float sum = 0.0f;
+    for (size_t i = 0; i < NO_OF_VECTORS; i++) {
+      sum += positions[i] * velocities[i];
+    }
+    return sum;
+  });
+  double length = nanoseconds_per_vector([&]() {
+    float sum = 0.0f;
+    for (size_t i = 0; i < NO_OF_VECTORS; i++) {
+      sum += positions[i].length();
+    }
+    return sum;
+  });
+  double motion = nanoseconds_per_vector([&]() {
+    for (size_t i = 0; i < NO_OF_VECTORS; i++) {
+      positions[i] += 1e-6f * velocities[i];
+    }
+    return positions[0][0];
+  });
+  std::cout << std::setw(12) << name << std::fixed << std::setprecision(2) << std::setw(18) << scalar_product
+            << std::setw(12) << length << std::setw(12) << motion << std::endl;
+}
+
+}
+
+int main() {
+  std::cout << "vectors: " << vector_name() << ", ns per vector" << std::endl;
+  std::cout << std::setw(12) << "" << std::setw(18) << "scalar product" << std::setw(12) << "length"
+            << std::setw(12) << "motion" << std::endl;
+  benchmark<2>("Vector2df");
+  benchmark<3>("Vector3df");
+  benchmark<4>("Vector4df");
+  return 0;
+}
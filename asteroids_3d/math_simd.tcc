@@ -0,0 +1,121 @@
+#if defined(__SSE2__) && !defined(GENERIC_VECTORS)
+#include <immintrin.h>
+
+// SSE2 implementations of Vector<float, 2u>, Vector<float, 3u>, and Vector<float, 4u>, included by math.h,
+// so that they are inlined into the loops using them
+// the vectors are loaded into one register, unused lanes are set to zero
+
+namespace simd {
+
+inline __m128 load(const Vector<float, 2u> & v) {
+  return _mm_setr_ps(v.vector[0], v.vector[1], 0.0f, 0.0f);
+}
+
+inline __m128 load(const Vector<float, 3u> & v) {
+  return _mm_setr_ps(v.vector[0], v.vector[1], v.vector[2], 0.0f);
+}
+
+inline __m128 load(const Vector<float, 4u> & v) {
+  return _mm_load_ps(v.vector.data());
+}
+
+inline void store(Vector<float, 2u> & v, __m128 values) {
+  _mm_storel_pi(reinterpret_cast<__m64 *>(v.vector.data()), values);
+}
+
+inline void store(Vector<float, 3u> & v, __m128 values) {
+  _mm_storel_pi(reinterpret_cast<__m64 *>(v.vector.data()), values);
+  _mm_store_ss(v.vector.data() + 2, _mm_movehl_ps(values, values));
+}
+
+inline void store(Vector<float, 4u> & v, __m128 values) {
+  _mm_store_ps(v.vector.data(), values);
+}
+
+// returns (x1 * x2 + y1 * y2) + (z1 * z2 + w1 * w2)
+// dpps of sse4.1 is not used: it is slower than these three instructions, and a function with another target
+// cannot be inlined (see math_benchmark.cc)
+inline float sum_of_products(__m128 values1, __m128 values2) {
+  __m128 products = _mm_mul_ps(values1, values2);
+  __m128 sums = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtss_f32( _mm_add_ss(sums, _mm_movehl_ps(sums, sums)) );
+}
+
+template <size_t N>
+inline Vector<float, N> & add(Vector<float, N> & value, const Vector<float, N> & addend) {
+  store(value, _mm_add_ps(load(value), load(addend)));
+  return value;
+}
+
+template <size_t N>
+inline Vector<float, N> & subtract(Vector<float, N> & value, const Vector<float, N> & minuend) {
+  store(value, _mm_sub_ps(load(value), load(minuend)));
+  return value;
+}
+
+template <size_t N>
+inline Vector<float, N> & multiply(Vector<float, N> & value, float factor) {
+  store(value, _mm_mul_ps(load(value), _mm_set1_ps(factor)));
+  return value;
+}
+
+template <size_t N>
+inline Vector<float, N> & divide(Vector<float, N> & value, float factor) {
+  store(value, _mm_div_ps(load(value), _mm_set1_ps(factor)));
+  return value;
+}
+
+inline float square_root(float value) {
+  return _mm_cvtss_f32( _mm_sqrt_ss(_mm_set_ss(value)) );
+}
+
+}
+
+template<> inline Vector<float, 2u> & Vector<float, 2u>::operator+=(const Vector<float, 2u> addend) { return simd::add(*this, addend); }
+template<> inline Vector<float, 2u> & Vector<float, 2u>::operator-=(const Vector<float, 2u> minuend) { return simd::subtract(*this, minuend); }
+template<> inline Vector<float, 2u> & Vector<float, 2u>::operator*=(const float factor) { return simd::multiply(*this, factor); }
+template<> inline Vector<float, 2u> & Vector<float, 2u>::operator/=(const float factor) { return simd::divide(*this, factor); }
+template<> inline float Vector<float, 2u>::square_of_length() const { return simd::sum_of_products(simd::load(*this), simd::load(*this)); }
+template<> inline float Vector<float, 2u>::length() const { return simd::square_root( square_of_length() ); }
+template<> inline float operator*(Vector<float, 2u> vector1, Vector<float, 2u> vector2) { return simd::sum_of_products(simd::load(vector1), simd::load(vector2)); }
+template<> inline Vector<float, 2u> operator*(float scalar, Vector<float, 2u> value) { return simd::multiply(value, scalar); }
+template<> inline Vector<float, 2u> operator+(Vector<float, 2u> value, const Vector<float, 2u> addend) { return simd::add(value, addend); }
+template<> inline Vector<float, 2u> operator-(Vector<float, 2u> value, const Vector<float, 2u> minuend) { return simd::subtract(value, minuend); }
+
+template<> inline Vector<float, 3u> & Vector<float, 3u>::operator+=(const Vector<float, 3u> addend) { return simd::add(*this, addend); }
+template<> inline Vector<float, 3u> & Vector<float, 3u>::operator-=(const Vector<float, 3u> minuend) { return simd::subtract(*this, minuend); }
+template<> inline Vector<float, 3u> & Vector<float, 3u>::operator*=(const float factor) { return simd::multiply(*this, factor); }
+template<> inline Vector<float, 3u> & Vector<float, 3u>::operator/=(const float factor) { return simd::divide(*this, factor); }
+template<> inline float Vector<float, 3u>::square_of_length() const { return simd::sum_of_products(simd::load(*this), simd::load(*this)); }
+template<> inline float Vector<float, 3u>::length() const { return simd::square_root( square_of_length() ); }
+template<> inline float operator*(Vector<float, 3u> vector1, Vector<float, 3u> vector2) { return simd::sum_of_products(simd::load(vector1), simd::load(vector2)); }
+template<> inline Vector<float, 3u> operator*(float scalar, Vector<float, 3u> value) { return simd::multiply(value, scalar); }
+template<> inline Vector<float, 3u> operator+(Vector<float, 3u> value, const Vector<float, 3u> addend) { return simd::add(value, addend); }
+template<> inline Vector<float, 3u> operator-(Vector<float, 3u> value, const Vector<float, 3u> minuend) { return simd::subtract(value, minuend); }
+
+// same component order (and sign of the y component) as the generic implementation
+template<>
+inline Vector<float, 3u> Vector<float, 3u>::cross_product(const Vector<float, 3u> v) const {
+  __m128 a = simd::load(*this);
+  __m128 b = simd::load(v);
+  __m128 a_yxx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 0, 1));
+  __m128 b_zzy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 2, 2));
+  __m128 a_zzy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 2, 2));
+  __m128 b_yxx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 0, 1));
+  Vector<float, 3u> product;
+  simd::store(product, _mm_sub_ps(_mm_mul_ps(a_yxx, b_zzy), _mm_mul_ps(a_zzy, b_yxx)));
+  return product;
+}
+
+template<> inline Vector<float, 4u> & Vector<float, 4u>::operator+=(const Vector<float, 4u> addend) { return simd::add(*this, addend); }
+template<> inline Vector<float, 4u> & Vector<float, 4u>::operator-=(const Vector<float, 4u> minuend) { return simd::subtract(*this, minuend); }
+template<> inline Vector<float, 4u> & Vector<float, 4u>::operator*=(const float factor) { return simd::multiply(*this, factor); }
+template<> inline Vector<float, 4u> & Vector<float, 4u>::operator/=(const float factor) { return simd::divide(*this, factor); }
+template<> inline float Vector<float, 4u>::square_of_length() const { return simd::sum_of_products(simd::load(*this), simd::load(*this)); }
+template<> inline float Vector<float, 4u>::length() const { return simd::square_root( square_of_length() ); }
+template<> inline float operator*(Vector<float, 4u> vector1, Vector<float, 4u> vector2) { return simd::sum_of_products(simd::load(vector1), simd::load(vector2)); }
+template<> inline Vector<float, 4u> operator*(float scalar, Vector<float, 4u> value) { return simd::multiply(value, scalar); }
+template<> inline Vector<float, 4u> operator+(Vector<float, 4u> value, const Vector<float, 4u> addend) { return simd::add(value, addend); }
+template<> inline Vector<float, 4u> operator-(Vector<float, 4u> value, const Vector<float, 4u> minuend) { return simd::subtract(value, minuend); }
+
+#endif
@@ -1,5 +1,9 @@
 #include "math.h"
+#include "random.h"
 #include "gtest/gtest.h"
+#include <random>
+#include <vector>
+#include <cstdint>
 
 namespace {
 	
@@ -468,4 +472,169 @@ TEST(VECTOR, CrossVectorProduct7) {
   EXPECT_NEAR(0.0, cross[2], 0.00001);
 }
 
+// the following tests compare the (SIMD) float vectors with plain scalar loops
+
+template<size_t N>
+std::vector< Vector<float, N> > random_vectors(size_t count) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dis(-1000.0f, 1000.0f);
+  std::vector< Vector<float, N> > vectors(count);
+  for (auto & vector : vectors) {
+    for (size_t i = 0; i < N; i++) {
+      vector[i] = dis(gen);
+    }
+  }
+  return vectors;
+}
+
+template<size_t N>
+void expect_elementwise_operations_equal_scalar_loops() {
+  auto vectors = random_vectors<N>(1000);
+  for (size_t k = 0; k + 1 < vectors.size(); k++) {
+    Vector<float, N> v1 = vectors[k];
+    Vector<float, N> v2 = vectors[k + 1];
+    float factor = v2[0] / 100.0f;
+    Vector<float, N> sum = v1;
+    sum += v2;
+    Vector<float, N> difference = v1;
+    difference -= v2;
+    Vector<float, N> product = v1;
+    product *= factor;
+    Vector<float, N> quotient = v1;
+    quotient /= factor;
+    for (size_t i = 0; i < N; i++) {
+      EXPECT_EQ(v1[i] + v2[i], sum[i]);
+      EXPECT_EQ(v1[i] - v2[i], difference[i]);
+      EXPECT_EQ(v1[i] * factor, product[i]);
+      EXPECT_EQ(v1[i] / factor, quotient[i]);
+    }
+  }
+}
+
+template<size_t N>
+void expect_sums_of_products_near_scalar_loops() {
+  auto vectors = random_vectors<N>(1000);
+  for (size_t k = 0; k + 1 < vectors.size(); k++) {
+    Vector<float, N> v1 = vectors[k];
+    Vector<float, N> v2 = vectors[k + 1];
+    double scalar_product = 0.0;
+    double square_of_length = 0.0;
+    for (size_t i = 0; i < N; i++) {
+      scalar_product += double(v1[i]) * double(v2[i]);
+      square_of_length += double(v1[i]) * double(v1[i]);
+    }
+    EXPECT_NEAR(scalar_product, v1 * v2, 1.0);
+    EXPECT_NEAR(square_of_length, v1.square_of_length(), 1.0);
+    EXPECT_NEAR(std::sqrt(square_of_length), v1.length(), 0.001);
+    v1.normalize();
+    EXPECT_NEAR(1.0, v1.length(), 0.00001);
+  }
+}
+
+TEST(VECTOR, ElementwiseOperationsEqualScalarLoops) {
+  expect_elementwise_operations_equal_scalar_loops<2u>();
+  expect_elementwise_operations_equal_scalar_loops<3u>();
+  expect_elementwise_operations_equal_scalar_loops<4u>();
+}
+
+TEST(VECTOR, SumsOfProductsNearScalarLoops) {
+  expect_sums_of_products_near_scalar_loops<2u>();
+  expect_sums_of_products_near_scalar_loops<3u>();
+  expect_sums_of_products_near_scalar_loops<4u>();
+}
+
+TEST(VECTOR, CrossProductEqualsScalarLoop) {
+  auto vectors = random_vectors<3u>(1000);
+  for (size_t k = 0; k + 1 < vectors.size(); k++) {
+    Vector3df a = vectors[k];
+    Vector3df b = vectors[k + 1];
+    Vector3df cross = a.cross_product(b);
+    EXPECT_EQ(a[1] * b[2] - a[2] * b[1], cross[0]);
+    EXPECT_EQ(a[0] * b[2] - a[2] * b[0], cross[1]);
+    EXPECT_EQ(a[0] * b[1] - a[1] * b[0], cross[2]);
+  }
+}
+
+TEST(VECTOR, Alignment4df) {
+  EXPECT_EQ(16u, alignof(Vector4df));
+  EXPECT_EQ(16u, sizeof(Vector4df));
+  EXPECT_EQ(12u, sizeof(Vector3df));
+  EXPECT_EQ(8u, sizeof(Vector2df));
+  std::vector<Vector4df> vectors(3);
+  for (auto & vector : vectors) {
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(vector.vector.data()) % 16u);
+  }
+}
+
+// known answers of Philox4x32-10 published with the Random123 library
+TEST(RANDOM, PhiloxKnownAnswers) {
+  EXPECT_EQ((RandomStream::Block{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}),
+            RandomStream::philox({0u, 0u, 0u, 0u}, {0u, 0u}));
+  EXPECT_EQ((RandomStream::Block{0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}),
+            RandomStream::philox({0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu}));
+  EXPECT_EQ((RandomStream::Block{0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}),
+            RandomStream::philox({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u}));
+}
+
+TEST(RANDOM, StreamsAreReproducibleAndIndependent) {
+  RandomStream stream1{42u, 0u};
+  RandomStream stream2{42u, 0u};
+  RandomStream other_stream{42u, 1u};
+  RandomStream other_seed{43u, 0u};
+  size_t no_of_equal_numbers = 0;
+  for (int i = 0; i < 1000; i++) {
+    std::uint32_t number = stream1.next();
+    EXPECT_EQ(number, stream2.next());
+    no_of_equal_numbers += (number == other_stream.next()) + (number == other_seed.next());
+  }
+  EXPECT_EQ(0u, no_of_equal_numbers);
+
+  // a copy continues where the stream stands
+  RandomStream copy = stream1;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(stream1.next(), copy.next());
+  }
+}
+
+TEST(RANDOM, UniformFloats) {
+  RandomStream random{7u};
+  double sum = 0.0;
+  constexpr int N = 100000;
+  for (int i = 0; i < N; i++) {
+    float value = random.uniform();
+    ASSERT_LE(0.0f, value);
+    ASSERT_GT(1.0f, value);
+    sum += value;
+  }
+  EXPECT_NEAR(0.5, sum / N, 0.01);
+}
+
+// fill() draws the same numbers as single calls, wherever the stream stands in its current block
+TEST(RANDOM, FillMatchesUniform) {
+  for (size_t offset = 0; offset < 4; offset++) {
+    for (size_t count : {0u, 1u, 3u, 4u, 5u, 17u}) {
+      RandomStream batch{5u, 2u};
+      RandomStream single{5u, 2u};
+      for (size_t i = 0; i < offset; i++) {
+        batch.next();
+        single.next();
+      }
+      std::vector<float> values(count);
+      batch.fill(values);
+      for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(single.uniform(), values[i]);
+      }
+      EXPECT_EQ(single.next(), batch.next());
+    }
+  }
+}
+
+TEST(VECTOR, SimdLevel) {
+#if defined(__SSE2__) && !defined(GENERIC_VECTORS)
+  EXPECT_NE(SimdLevel::scalar, simd_level());
+#else
+  EXPECT_EQ(SimdLevel::scalar, simd_level());
+#endif
+}
+
 }
@@ -0,0 +1,112 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// a pool of fixed size memory blocks for objects of type T
+// blocks are allocated in chunks of BLOCKS_PER_CHUNK and never given back to the heap before the pool is destroyed,
+// freed blocks are kept in a free list and reused by the next allocate(), so once the pool has grown to the
+// maximum number of living objects, allocating and deallocating objects does not touch the heap anymore
+template<class T, size_t BLOCKS_PER_CHUNK = 64>
+class ObjectPool {
+  union Block {
+    Block * next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  std::vector< std::unique_ptr<Block[]> > chunks;
+  Block * free_list = nullptr;
+  size_t no_of_allocated = 0;
+  std::mutex mutex;
+
+  // requires a locked mutex
+  void grow() {
+    chunks.push_back( std::make_unique<Block[]>(BLOCKS_PER_CHUNK) );
+    Block * chunk = chunks.back().get();
+    for (size_t i = 0; i < BLOCKS_PER_CHUNK; i++) {
+      chunk[i].next = free_list;
+      free_list = &chunk[i];
+    }
+  }
+
+public:
+  ObjectPool() = default;
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool & operator=(const ObjectPool &) = delete;
+
+  // returns uninitialized memory for one object of type T
+  void * allocate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (free_list == nullptr) {
+      grow();
+    }
+    Block * block = free_list;
+    free_list = block->next;
+    no_of_allocated++;
+    return block->storage;
+  }
+
+  // gives back the memory of an object, that has been allocated by this pool and already been destroyed
+  void deallocate(void * pointer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Block * block = static_cast<Block *>(pointer);
+    block->next = free_list;
+    free_list = block;
+    no_of_allocated--;
+  }
+
+  // grows the pool until it can hold at least no_of_objects living objects without allocating
+  void reserve(size_t no_of_objects) {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (chunks.size() * BLOCKS_PER_CHUNK < no_of_objects) {
+      grow();
+    }
+  }
+
+  // returns the number of living objects
+  size_t get_no_of_allocated() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return no_of_allocated;
+  }
+
+  // returns the number of objects the pool can hold without allocating
+  size_t get_capacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return chunks.size() * BLOCKS_PER_CHUNK;
+  }
+};
+
+
+// base class, that lets new and delete of the derived class T use an ObjectPool
+// all objects of type T share one pool; objects of classes derived from T have a different size and use the heap
+// the class that deletes a T through a pointer to one of its base classes needs a virtual destructor
+template<class T>
+class PoolAllocated {
+public:
+  // the pool is never destroyed, so objects living in static containers can still be deleted at exit
+  static ObjectPool<T> & get_pool() {
+    static ObjectPool<T> * pool = new ObjectPool<T>();
+    return *pool;
+  }
+
+  static void * operator new(size_t size) {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+    return get_pool().allocate();
+  }
+
+  static void operator delete(void * pointer, size_t size) {
+    if (size != sizeof(T)) {
+      ::operator delete(pointer);
+      return;
+    }
+    get_pool().deallocate(pointer);
+  }
+};
+
+#endif
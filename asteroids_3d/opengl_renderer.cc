@@ -1,8 +1,11 @@
 #include "opengl_renderer.h"
 #include <cassert>
+#include <cstdint>
 #include <span>
 #include <utility>
+#include <algorithm>
 #include "viewer/wavefront.h"
+#include "trace.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -160,43 +163,91 @@ std::vector< std::vector<Vector2df> * > vertice_data = {
   &debris_points,
   &digit_0, &digit_1, &digit_2, &digit_3, &digit_4, &digit_5, &digit_6, &digit_7, &digit_8, &digit_9 };
 
+// number of draw calls since the start of the current frame
+static size_t draw_call_counter = 0;
+
+// number of triangles of 3d meshes since the start of the current frame
+static size_t triangle_counter = 0;
+
+// half the width and height of the viewport in pixels, the size of the canonical view volume on the screen
+static std::array<float, 2> half_viewport_size = { 512.0f, 384.0f };
+
+// sets the vertex layout of the mesh for the bound vertex array object, which also stores the index buffer
+static void set_vertex_attributes(const MeshBuffers & mesh) {
+  glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+  for (const VertexAttribute & attribute : mesh.attributes) {
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    if (attribute.type == AttributeType::int16_normalized) {
+      type = GL_SHORT;
+      normalized = GL_TRUE;
+    } else if (attribute.type == AttributeType::int_2_10_10_10_normalized) {
+      type = GL_INT_2_10_10_10_REV;
+      normalized = GL_TRUE;
+    }
+    glVertexAttribPointer(attribute.location, attribute.components, type, normalized, mesh.vertex_stride,
+                          reinterpret_cast<void *>( static_cast<std::uintptr_t>(attribute.offset) ));
+    glEnableVertexAttribArray(attribute.location);
+  }
+}
+
+// draws up to MAX_MATERIALS_PER_DRAW draw ranges of the level of detail with one draw call, but at least one draw call per mesh,
+// the fragment shader takes the color of a triangle from the uniforms by its gl_PrimitiveID
+static void draw_mesh(const MeshBuffers & mesh, unsigned int shaderProgram, GLsizei no_of_instances = 0, size_t lod = 0) {
+  glUniform3fv(glGetUniformLocation(shaderProgram, "position_offset"), 1, mesh.position_offset.data());
+  glUniform3fv(glGetUniformLocation(shaderProgram, "position_scale"), 1, mesh.position_scale.data());
+  GLint colors_location = glGetUniformLocation(shaderProgram, "material_colors");
+  GLint ends_location = glGetUniformLocation(shaderProgram, "material_ends");
+  const MeshLod & level = mesh.lods[lod];
+  size_t first_range = level.first_draw_range;
+  size_t end_range = level.first_draw_range + level.no_of_draw_ranges;
+  do {
+    size_t no_of_ranges = std::min(MAX_MATERIALS_PER_DRAW, end_range - first_range);
+    std::array<GLfloat, 3 * MAX_MATERIALS_PER_DRAW> colors{};
+    std::array<GLint, MAX_MATERIALS_PER_DRAW> ends{};  // the number of triangles up to the end of each range
+    size_t first_index = no_of_ranges > 0 ? mesh.draw_ranges[first_range].first_index : 0;
+    GLsizei no_of_indices = 0;
+    for (size_t i = 0; i < no_of_ranges; i++) {
+      const DrawRange & range = mesh.draw_ranges[first_range + i];
+      std::copy(range.color, range.color + 3, colors.begin() + 3 * i);
+      no_of_indices += range.no_of_indices;
+      ends[i] = no_of_indices / 3;
+    }
+    glUniform3fv(colors_location, MAX_MATERIALS_PER_DRAW, colors.data());
+    glUniform1iv(ends_location, MAX_MATERIALS_PER_DRAW, ends.data());
+    const void * offset = reinterpret_cast<const void *>(first_index * sizeof(std::uint32_t));
+    if (no_of_instances > 0) {
+      glDrawElementsInstanced(GL_TRIANGLES, no_of_indices, GL_UNSIGNED_INT, offset, no_of_instances);
+    } else {
+      glDrawElements(GL_TRIANGLES, no_of_indices, GL_UNSIGNED_INT, offset);
+    }
+    draw_call_counter++;
+    triangle_counter += no_of_indices / 3 * std::max<GLsizei>(no_of_instances, 1);
+    first_range += no_of_ranges;
+  } while (first_range < end_range);
+}
+
 // class OpenGLView
 
-  OpenGLView::OpenGLView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode, bool is_3d_object)
-    : shaderProgram(shaderProgram), vertices_size(vertices_size), is_3d(is_3d_object), mode(mode) {
+  OpenGLView::OpenGLView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode)
+    : shaderProgram(shaderProgram), vertices_size(vertices_size), is_3d(false), mode(mode) {
 
     glGenVertexArrays(1, &vao);
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    if(!is_3d_object){
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-    }else{
-        glVertexAttribPointer(0,
-                              3,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              9 * sizeof(float),
-                              (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1,
-                              3,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              9 * sizeof(float),
-                              (void*)(6 * sizeof(float)) );
-        glEnableVertexAttribArray(1);
-
-        glVertexAttribPointer(2,
-                              3,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              9 * sizeof(float),
-                              (void*)(3 * sizeof(float)) );
-        glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
 
-    }
+  OpenGLView::OpenGLView(const MeshBuffers & mesh, unsigned int shaderProgram)
+    : shaderProgram(shaderProgram), vertices_size(0), is_3d(true), mode(GL_TRIANGLES), mesh_buffers(&mesh) {
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    set_vertex_attributes(mesh);
+    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
@@ -205,27 +256,135 @@ std::vector< std::vector<Vector2df> * > vertice_data = {
     glDeleteVertexArrays(1, &vao3d);
   }
 
-  void OpenGLView::render( SquareMatrix<float,4> & matrice) {
+  void OpenGLView::render( SquareMatrix<float,4> & matrice, size_t lod) {
     glBindVertexArray(vao);
     glUseProgram(shaderProgram);
-    int vertex_division_factor = 1;
     if(is_3d){
-        vertex_division_factor = 9;
         unsigned int modelLoc = glGetUniformLocation (shaderProgram, "model");
         glUniformMatrix4fv(modelLoc, 1 , GL_FALSE , &matrice[0][0] ) ;
-
+        draw_mesh(*mesh_buffers, shaderProgram, 0, lod);
     }else{
         unsigned int transformLoc = glGetUniformLocation(shaderProgram, "transform");
         glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &matrice[0][0] );
+        glDrawArrays(mode, 0, vertices_size);
+        draw_call_counter++;
+    }
+  }
+
+// class InstancedView
+
+  InstancedView::InstancedView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode)
+    : shaderProgram(shaderProgram), vertex_count(vertices_size), mode(mode), instances(1) {
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    create_instance_buffer();
+  }
+
+  InstancedView::InstancedView(const MeshBuffers & mesh, unsigned int shaderProgram)
+    : shaderProgram(shaderProgram), vertex_count(0), mode(GL_TRIANGLES), mesh_buffers(&mesh), instances(mesh.lods.size()) {
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    set_vertex_attributes(mesh);
+    create_instance_buffer();
+  }
+
+  // one 4 x 4 matrix per instance, stored in column order, one column per attribute location
+  void InstancedView::create_instance_buffer() {
+    glGenBuffers(1, &instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    for (GLuint column = 0; column < 4; column++) {
+      glEnableVertexAttribArray(3 + column);
+      glVertexAttribDivisor(3 + column, 1);
+    }
+    set_instance_attributes(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  // the instances of a level of detail follow the ones of the previous levels in the instance buffer,
+  // without glDrawElementsInstancedBaseInstance (OpenGL 4.2) the attributes start at the first instance of the level
+  void InstancedView::set_instance_attributes(size_t first_instance) {
+    for (GLuint column = 0; column < 4; column++) {
+      size_t offset = (first_instance * 16 + column * 4) * sizeof(float);
+      glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(SquareMatrix4df), reinterpret_cast<void *>(offset) );
+    }
+  }
+
+  InstancedView::~InstancedView() {
+    glDeleteBuffers(1, &instance_vbo);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  void InstancedView::add_instance(const SquareMatrix4df & transformation, size_t lod) {
+    instances[lod].push_back(transformation);
+  }
+
+  void InstancedView::render() {
+    size_t no_of_instances = 0;
+    for (const std::vector<SquareMatrix4df> & lod_instances : instances) {
+      no_of_instances += lod_instances.size();
+    }
+    if (no_of_instances == 0) {
+      return;
+    }
+    static_assert(sizeof(SquareMatrix4df) == 16 * sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+    if (no_of_instances > instance_capacity) {
+      instance_capacity = std::max(no_of_instances, 2 * instance_capacity);
     }
-    glDrawArrays(mode, 0, vertices_size / vertex_division_factor);
+    // orphan the buffer of the last frame, so that the driver does not have to wait until it is drawn
+    glBufferData(GL_ARRAY_BUFFER, instance_capacity * sizeof(SquareMatrix4df), nullptr, GL_STREAM_DRAW);
+    size_t first_instance = 0;
+    for (const std::vector<SquareMatrix4df> & lod_instances : instances) {
+      glBufferSubData(GL_ARRAY_BUFFER, first_instance * sizeof(SquareMatrix4df), lod_instances.size() * sizeof(SquareMatrix4df), lod_instances.data());
+      first_instance += lod_instances.size();
+    }
+
+    glBindVertexArray(vao);
+    glUseProgram(shaderProgram);
+    first_instance = 0;
+    for (size_t lod = 0; lod < instances.size(); lod++) {
+      if (instances[lod].empty()) {
+        continue;
+      }
+      set_instance_attributes(first_instance);
+      if (mesh_buffers != nullptr) {
+        draw_mesh(*mesh_buffers, shaderProgram, instances[lod].size(), lod);
+      } else {
+        glDrawArraysInstanced(mode, 0, vertex_count, instances[lod].size());
+        draw_call_counter++;
+      }
+      first_instance += instances[lod].size();
+      instances[lod].clear();
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
+SquareMatrix4df createTranslationMatrix(float x, float y) {
+    SquareMatrix4df matrix = {
+                    {1, 0, 0, 0},
+                    {0, 1, 0, 0},
+                    {0, 0, 1, 0},
+                    {x, y, 0, 1}
+    };
+    return matrix;
+}
+
 // class TypedBodyView
 
-  TypedBodyView::TypedBodyView(TypedBody * typed_body, GLuint vbo, unsigned int shaderProgram, size_t vertices_size, float scale, GLuint mode, bool is_3d,
+  TypedBodyView::TypedBodyView(TypedBody * typed_body, Mesh mesh, GLuint vbo, unsigned int shaderProgram, size_t vertices_size, float scale, GLuint mode,
+               std::function<bool()> draw, std::function<void(TypedBodyView *)> modify)
+        : OpenGLView(vbo, shaderProgram, vertices_size, mode),  typed_body(typed_body), mesh(mesh), scale(scale), draw(draw), modify(modify) {
+  }
+
+  TypedBodyView::TypedBodyView(TypedBody * typed_body, Mesh mesh, const MeshBuffers & buffers, unsigned int shaderProgram, float scale,
                std::function<bool()> draw, std::function<void(TypedBodyView *)> modify)
-        : OpenGLView(vbo, shaderProgram, vertices_size, mode, is_3d),  typed_body(typed_body), scale(scale), draw(draw), modify(modify) {
+        : OpenGLView(buffers, shaderProgram),  typed_body(typed_body), mesh(mesh), scale(scale), draw(draw), modify(modify) {
   }
   
   SquareMatrix4df TypedBodyView::create_object_transformation(Vector2df direction, float angle, float scale) {
@@ -248,20 +407,84 @@ std::vector< std::vector<Vector2df> * > vertice_data = {
     return translation * rotation * scaling;
   }
 
-  void TypedBodyView::render( SquareMatrix<float,4> & world) {
+  // the largest length in pixels of a unit vector of the mesh, the errors of the levels of detail increase
+  size_t TypedBodyView::select_lod(const SquareMatrix4df & transformation) const {
+    if (mesh_buffers == nullptr) {
+      return 0;
+    }
+    float pixels_per_unit = 0.0f;
+    for (size_t column = 0; column < 3; column++) {
+      pixels_per_unit = std::max(pixels_per_unit, std::hypot(transformation[column][0] * half_viewport_size[0],
+                                                             transformation[column][1] * half_viewport_size[1]));
+    }
+    size_t lod = 0;
+    while (lod + 1 < mesh_buffers->lods.size() && mesh_buffers->lods[lod + 1].error * pixels_per_unit <= MAX_LOD_ERROR_IN_PIXELS) {
+      lod++;
+    }
+    return lod;
+  }
+
+  size_t TypedBodyView::create_image_transformations(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha,
+                                                     std::array<SquareMatrix4df, 4> & transformations) {
+    Vector2df position = typed_body->get_interpolated_position(alpha);
+    // translations of the visible images per axis, an axis with a world size of zero does not wrap around
+    std::array< std::array<float, 2>, 2> offsets{};
+    std::array<size_t, 2> no_of_offsets{1u, 1u};
+    for (size_t axis = 0u; axis < 2u; axis++) {
+      float size = world_size[axis];
+      if (size > 0.0f) {
+        float difference = position[axis] - view_center[axis];
+        offsets[axis][0] = -std::round(difference / size) * size;
+        difference += offsets[axis][0];
+        if (difference > 0.5f * size - WRAP_MARGIN) {
+          offsets[axis][no_of_offsets[axis]++] = offsets[axis][0] - size;
+        } else if (difference < -0.5f * size + WRAP_MARGIN) {
+          offsets[axis][no_of_offsets[axis]++] = offsets[axis][0] + size;
+        }
+      }
+    }
+    SquareMatrix4df object_transformation = create_object_transformation(position, typed_body->get_interpolated_angle(alpha), scale);
+    size_t count = 0u;
+    for (size_t i = 0u; i < no_of_offsets[0]; i++) {
+      for (size_t j = 0u; j < no_of_offsets[1]; j++) {
+        transformations[count++] = view * createTranslationMatrix(offsets[0][i], offsets[1][j]) * object_transformation;
+      }
+    }
+    return count;
+  }
+
+  void TypedBodyView::render( const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha) {
     debug(2, "render() entry...");
     if ( draw() ) {
       modify(this);
-      auto transform = world * create_object_transformation(typed_body->get_position(), typed_body->get_angle(), scale);
-      OpenGLView::render(transform);
+      std::array<SquareMatrix4df, 4> transformations;
+      size_t count = create_image_transformations(view, view_center, world_size, alpha, transformations);
+      for (size_t i = 0u; i < count; i++) {
+        OpenGLView::render(transformations[i], select_lod(transformations[i]));
+      }
     }
     debug(2, "render() exit.");
   }
+
+  void TypedBodyView::add_instances( InstancedView & batch, const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha ) {
+    if ( draw() ) {
+      modify(this);
+      std::array<SquareMatrix4df, 4> transformations;
+      size_t count = create_image_transformations(view, view_center, world_size, alpha, transformations);
+      for (size_t i = 0u; i < count; i++) {
+        batch.add_instance( transformations[i], select_lod(transformations[i]) );
+      }
+    }
+  }
   
  TypedBody * TypedBodyView::get_typed_body() {
    return typed_body;
  }
 
+ Mesh TypedBodyView::get_mesh() {
+   return mesh;
+ }
+
  bool TypedBodyView::get_is_3d() {
       return is_3d;
   }
@@ -271,37 +494,40 @@ std::vector< std::vector<Vector2df> * > vertice_data = {
  }
 
 // class OpenGLRenderer
-Material default_material = { {1.0f, 1.0f, 1.0f} };
-
-std::vector<float> create_vertices(WavefrontImporter & wi_p) {
-  std::vector<float> vertices;
-  
-  for (Face face : wi_p.get_faces() ) {
-    for (ReferenceGroup group : face.reference_groups ) {
-      for (size_t i = 0; i < 3; i++) {
-        vertices.push_back( group.vertice[i]);
-      }
-      for (size_t i = 0; i < 3; i++) {
-        vertices.push_back( group.normal[i] );
-      }
-      if (face.material == nullptr) face.material = &default_material;
-      for (size_t i = 0; i < 3; i++) {
-        vertices.push_back( face.material->ambient[i]);
-      }
-    } 
-  }
-  return vertices;
-}
-
 void OpenGLRenderer::create3dVbos() {
-  size_t vertex_object_count = vertex_data_3d.size();
-  vbos3d = new GLuint[vertex_object_count];
-  glGenBuffers(vertex_object_count, vbos3d);
-
-  for (size_t i = 0; i < vertex_object_count; i++) {
-   glBindBuffer(GL_ARRAY_BUFFER, vbos3d[i]);
-   glBufferData(GL_ARRAY_BUFFER, vertex_data_3d[i].size() * sizeof( float ), vertex_data_3d[i].data(), GL_STATIC_DRAW);
+  // the views refer to the buffers, so they are not moved later on
+  mesh_buffers_3d.clear();
+  mesh_buffers_3d.resize(meshes_3d.size());
+
+  // the vertex data and the indices are the mapped mesh cache, so they are not parsed or copied before the upload,
+  // both are uploaded to the array buffer target, for the element array buffer is stored in a vertex array object
+  for (size_t i = 0; i < meshes_3d.size(); i++) {
+   const MeshCache & mesh = meshes_3d[i];
+   MeshBuffers & buffers = mesh_buffers_3d[i];
+   std::span<const char> vertex_data = mesh.get_vertex_data();
+   std::span<const std::uint32_t> indices = mesh.get_indices();
+   glGenBuffers(1, &buffers.vbo);
+   glBindBuffer(GL_ARRAY_BUFFER, buffers.vbo);
+   glBufferData(GL_ARRAY_BUFFER, vertex_data.size(), vertex_data.data(), GL_STATIC_DRAW);
+   glGenBuffers(1, &buffers.ibo);
+   glBindBuffer(GL_ARRAY_BUFFER, buffers.ibo);
+   glBufferData(GL_ARRAY_BUFFER, indices.size_bytes(), indices.data(), GL_STATIC_DRAW);
+
+   const MeshCacheHeader & header = mesh.get_header();
+   buffers.vertex_stride = header.vertex_stride;
+   buffers.attributes.assign(mesh.get_attributes().begin(), mesh.get_attributes().end());
+   buffers.draw_ranges.assign(mesh.get_draw_ranges().begin(), mesh.get_draw_ranges().end());
+   buffers.lods.assign(mesh.get_lods().begin(), mesh.get_lods().end());
+   if (buffers.lods.empty()) {
+     buffers.lods.push_back( MeshLod{ 0.0f, 0u, static_cast<std::uint32_t>( buffers.draw_ranges.size() ) } );
+   }
+   bool quantized = ! buffers.attributes.empty() && buffers.attributes[0].type != AttributeType::float32;
+   for (size_t k = 0; k < 3; k++) {
+     buffers.position_offset[k] = quantized ? 0.5f * (header.bounds_min[k] + header.bounds_max[k]) : 0.0f;
+     buffers.position_scale[k] = quantized ? 0.5f * (header.bounds_max[k] - header.bounds_min[k]) : 1.0f;
+   }
  }
+ glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void OpenGLRenderer::createVbos() {
@@ -317,10 +543,10 @@ void OpenGLRenderer::createVbos() {
 void OpenGLRenderer::create(Spaceship * ship, std::vector< std::unique_ptr<TypedBodyView> > & views) {
   debug(4, "create(Spaceship *) entry...");
 
-  views.push_back(std::make_unique<TypedBodyView>(ship, vbos3d[2], shaderProgram3d, vertex_data_3d[2].size(), 1.0f, GL_TRIANGLES, true,
+  views.push_back(std::make_unique<TypedBodyView>(ship, Mesh::spaceship, mesh_buffers_3d[2], shaderProgram3d, 1.0f,
                   [ship]() -> bool {return ! ship->is_in_hyperspace();}) // only show ship if outside hyperspace
                  );
-  views.push_back(std::make_unique<TypedBodyView>(ship, vbos3d[3], shaderProgram3d, vertex_data_3d[3].size(), 1.0f, GL_TRIANGLES, true,
+  views.push_back(std::make_unique<TypedBodyView>(ship, Mesh::flame, mesh_buffers_3d[3], shaderProgram3d, 1.0f,
                   [ship]() -> bool {return ! ship->is_in_hyperspace() && ship->is_accelerating();}) // only show flame if accelerating
                  );   
 
@@ -333,26 +559,26 @@ void OpenGLRenderer::create(Saucer * saucer, std::vector< std::unique_ptr<TypedB
   if ( saucer->get_size() == 0 ) {
     scale = 1.5;
   }
-  views.push_back(std::make_unique<TypedBodyView>(saucer, vbos3d[0], shaderProgram3d, vertex_data_3d[0].size(), scale, GL_TRIANGLES, true));
+  views.push_back(std::make_unique<TypedBodyView>(saucer, Mesh::saucer, mesh_buffers_3d[0], shaderProgram3d, scale));
   debug(4, "create(Saucer *) exit.");
 }
 
 
 void OpenGLRenderer::create(Torpedo * torpedo, std::vector< std::unique_ptr<TypedBodyView> > & views) {
   debug(4, "create(Torpedo *) entry...");
-  views.push_back(std::make_unique<TypedBodyView>(torpedo, vbos[2], shaderProgram, vertice_data[2]->size(), 1.0f, GL_LINE_LOOP, false));
+  views.push_back(std::make_unique<TypedBodyView>(torpedo, Mesh::torpedo, vbos[2], shaderProgram, vertice_data[2]->size(), 1.0f, GL_LINE_LOOP));
   debug(4, "create(Torpedo *) exit.");
 }
 
 void OpenGLRenderer::create(Asteroid * asteroid, std::vector< std::unique_ptr<TypedBodyView> > & views) {
   float scale = (asteroid->get_size() == 3 ? 1.0 : ( asteroid->get_size() == 2 ? 0.5 : 0.25 ));
-  views.push_back(std::make_unique<TypedBodyView>(asteroid, vbos3d[1], shaderProgram3d, vertex_data_3d[1].size(), scale, GL_TRIANGLES, true));
+  views.push_back(std::make_unique<TypedBodyView>(asteroid, Mesh::asteroid, mesh_buffers_3d[1], shaderProgram3d, scale));
   debug(4, "create(Asteroid *) exit.");
 }
 
 void OpenGLRenderer::create(SpaceshipDebris * debris, std::vector< std::unique_ptr<TypedBodyView> > & views) {
   debug(4, "create(SpaceshipDebris *) entry...");
-  views.push_back(std::make_unique<TypedBodyView>(debris, vbos[10], shaderProgram, vertice_data[10]->size(), 0.1f, GL_POINTS, false,
+  views.push_back(std::make_unique<TypedBodyView>(debris, Mesh::debris, vbos[10], shaderProgram, vertice_data[10]->size(), 0.1f, GL_POINTS,
             []() -> bool {return true;},
             [debris](TypedBodyView * view) -> void { view->set_scale( 0.5f * (SpaceshipDebris::TIME_TO_DELETE - debris->get_time_to_delete()));}));
   debug(4, "create(SpaceshipDebris *) exit.");
@@ -360,23 +586,32 @@ void OpenGLRenderer::create(SpaceshipDebris * debris, std::vector< std::unique_p
 
 void OpenGLRenderer::create(Debris * debris, std::vector< std::unique_ptr<TypedBodyView> > & views) {
   debug(4, "create(Debris *) entry...");
-  views.push_back(std::make_unique<TypedBodyView>(debris, vbos[10], shaderProgram, vertice_data[10]->size(), 0.1f, GL_POINTS, false,
+  views.push_back(std::make_unique<TypedBodyView>(debris, Mesh::debris, vbos[10], shaderProgram, vertice_data[10]->size(), 0.1f, GL_POINTS,
             []() -> bool {return true;},
             [debris](TypedBodyView * view) -> void { view->set_scale(Debris::TIME_TO_DELETE - debris->get_time_to_delete());}));   
   debug(4, "create(Debris *) exit.");
 }
 
 void OpenGLRenderer::createSpaceShipView() {
-  spaceship_view = std::make_unique<OpenGLView>(vbos[0], shaderProgram, vertice_data[0]->size(), GL_LINE_STRIP, false);
+  spaceship_view = std::make_unique<OpenGLView>(vbos[0], shaderProgram, vertice_data[0]->size(), GL_LINE_STRIP);
 }
 
 void OpenGLRenderer::createDigitViews() {
   for (size_t i = 0; i < 10; i++ ) {
-    digit_views[i] = std::make_unique<OpenGLView>(vbos[11 + i], shaderProgram, vertice_data[11 + i]->size(), GL_LINE_STRIP, false);
+    digit_views[i] = std::make_unique<OpenGLView>(vbos[11 + i], shaderProgram, vertice_data[11 + i]->size(), GL_LINE_STRIP);
   }
 }
 
 
+void OpenGLRenderer::createBatches() {
+  batches[static_cast<size_t>(Mesh::saucer)] = std::make_unique<InstancedView>(mesh_buffers_3d[0], instancedShaderProgram3d);
+  batches[static_cast<size_t>(Mesh::asteroid)] = std::make_unique<InstancedView>(mesh_buffers_3d[1], instancedShaderProgram3d);
+  batches[static_cast<size_t>(Mesh::spaceship)] = std::make_unique<InstancedView>(mesh_buffers_3d[2], instancedShaderProgram3d);
+  batches[static_cast<size_t>(Mesh::flame)] = std::make_unique<InstancedView>(mesh_buffers_3d[3], instancedShaderProgram3d);
+  batches[static_cast<size_t>(Mesh::torpedo)] = std::make_unique<InstancedView>(vbos[2], instancedShaderProgram, vertice_data[2]->size(), GL_LINE_LOOP);
+  batches[static_cast<size_t>(Mesh::debris)] = std::make_unique<InstancedView>(vbos[10], instancedShaderProgram, vertice_data[10]->size(), GL_POINTS);
+}
+
 void OpenGLRenderer::renderFreeShips(SquareMatrix4df & matrice) {
   constexpr float FREE_SHIP_X = 128;
   constexpr float FREE_SHIP_Y = 64;
@@ -441,52 +676,102 @@ void compile_shader(GLint shader, const char * source) {
   }
 }
 
-void OpenGLRenderer::create_3dshader_programs() {
-
-  const char *vertexShaderSource3d = "#version 330 core\n"
-    "layout (location = 0) in vec3 position;\n"
-    "layout (location = 1) in vec3 incolor;\n"
-    "layout (location = 2) in vec3 innormal;\n"
-    "out vec3 color;\n"
-    "out vec4 normal;\n"
-    "uniform mat4 model;\n"
-    "void main()\n"
-    "{\n"
-    "gl_Position = model * vec4(position, 1.0);\n"
-    "color = incolor;\n"
-    "normal = normalize( model * vec4(innormal, 1.0));\n"
-    "}\0";
-
-  const char *fragmentShaderSource3d = "#version 330 core\n"
+// the fragment shaders are shared by the shader programs with and without instancing
+// the color of a triangle is the one of the draw range containing it, the sizes of the arrays are MAX_MATERIALS_PER_DRAW
+static const char *fragmentShaderSource3d = "#version 330 core\n"
   "out vec4 outColor;\n"
-  "in vec3 color;\n"
+  "uniform vec3 material_colors[8];\n"
+  "uniform int material_ends[8];\n"
   "in vec4 normal;\n"
   "void main () {\n"
+  "  int material = 0;\n"
+  "  while (material < 7 && gl_PrimitiveID >= material_ends[material]) {\n"
+  "    material++;\n"
+  "  }\n"
+  "  vec3 color = material_colors[material];\n"
   "  outColor = vec4(color * (0.3 + 0.7 * max(0.0, dot(normal, normalize( vec4(0.0, 1.0, -4.0, 0.0))))) , 1.0);\n"
   "}\n\0";
 
+static const char *fragmentShaderSource = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);\n"
+    "}\n\0";
+
+GLuint create_shader_program(const char * vertex_source, const char * fragment_source, const char * fragment_output) {
   GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER) ;
-  compile_shader(vertexShader, vertexShaderSource3d);
+  compile_shader(vertexShader, vertex_source);
 
   GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) ;
-  compile_shader(fragmentShader, fragmentShaderSource3d);
+  compile_shader(fragmentShader, fragment_source);
 
-  shaderProgram3d = glCreateProgram() ;
-  glAttachShader(shaderProgram3d, vertexShader);
-  glAttachShader(shaderProgram3d, fragmentShader);
-  glBindFragDataLocation(shaderProgram3d, 0, "outColor");
-  glLinkProgram(shaderProgram3d);
+  GLuint program = glCreateProgram() ;
+  glAttachShader(program, vertexShader);
+  glAttachShader(program, fragmentShader);
+  glBindFragDataLocation(program, 0, fragment_output);
+  glLinkProgram(program);
 
   GLint status;
-  glGetProgramiv(shaderProgram3d, GL_LINK_STATUS, &status);
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
   if (status == GL_FALSE) {
     GLint length;
-    glGetProgramiv(shaderProgram3d, GL_INFO_LOG_LENGTH, &length);
-    GLchar *log = new char[length + 1];
-    glGetProgramInfoLog(shaderProgram3d, length, &length, &log[0]);
-    error(log);
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(length + 1);
+    glGetProgramInfoLog(program, length, &length, log.data());
+    error(log.data());
     throw EXIT_FAILURE;
   }
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+  return program;
+}
+
+// same shaders as above, but the transformation is an instance attribute instead of a uniform
+void OpenGLRenderer::create_instanced_shader_programs() {
+  const char *vertexShaderSource3d = "#version 330 core\n"
+    "layout (location = 0) in vec3 inposition;\n"
+    "layout (location = 2) in vec4 innormal;\n"
+    "layout (location = 3) in mat4 model;\n"
+    "uniform vec3 position_offset;\n"
+    "uniform vec3 position_scale;\n"
+    "out vec4 normal;\n"
+    "void main()\n"
+    "{\n"
+    "vec3 position = position_offset + position_scale * inposition;\n"
+    "gl_Position = model * vec4(position, 1.0);\n"
+    "normal = normalize( model * vec4(innormal.xyz, 1.0));\n"
+    "}\0";
+
+  const char *vertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 p;\n"
+    "layout (location = 3) in mat4 transform;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = transform * vec4(p, 1.0, 1.0);\n"
+    "}\0";
+
+  instancedShaderProgram3d = create_shader_program(vertexShaderSource3d, fragmentShaderSource3d, "outColor");
+  instancedShaderProgram = create_shader_program(vertexShaderSource, fragmentShaderSource, "FragColor");
+}
+
+void OpenGLRenderer::create_3dshader_programs() {
+
+  const char *vertexShaderSource3d = "#version 330 core\n"
+    "layout (location = 0) in vec3 inposition;\n"
+    "layout (location = 2) in vec4 innormal;\n"
+    "out vec4 normal;\n"
+    "uniform mat4 model;\n"
+    "uniform vec3 position_offset;\n"
+    "uniform vec3 position_scale;\n"
+    "void main()\n"
+    "{\n"
+    "vec3 position = position_offset + position_scale * inposition;\n"
+    "gl_Position = model * vec4(position, 1.0);\n"
+    "normal = normalize( model * vec4(innormal.xyz, 1.0));\n"
+    "}\0";
+
+  shaderProgram3d = create_shader_program(vertexShaderSource3d, fragmentShaderSource3d, "outColor");
 }
 
 void OpenGLRenderer::create_shader_programs() {
@@ -498,12 +783,6 @@ static const char *vertexShaderSource = "#version 330 core\n"
     "{\n"
     "   gl_Position = transform * vec4(p, 1.0, 1.0);\n"
     "}\0";
-static const char *fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);\n"
-    "}\n\0";
 
     // build and compile vertex shader
     unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -577,50 +856,42 @@ bool OpenGLRenderer::init() {
 
       create_shader_programs();
       create_3dshader_programs();
+      create_instanced_shader_programs();
       
       createVbos();
       create3dVbos();
       createSpaceShipView();
       createDigitViews();
+      createBatches();
       return true;
     }
   }
   return false;
 }
 
-/* tile positions in world coordinates
-   used to draw objects seemless between boundary
-  +---+---+---+   
-  | 5 | 7 | 2 |
-  +---+---+---+
-  | 4 | 0 | 1 |
-  +---+---+---+
-  | 6 | 8 | 3 |
-  +---+---+---+
-*/
-static Vector2df tile_positions [] = {
-                         {0.0f, 0.0f},
-                         {1024.0f, 0.0f},
-                         {1024.0f, 768.0f},
-                         {1024.0f, -768.0f},
-                         {-1024.0f, 0.0f},
-                         {-1024.0f, 768.0f},
-                         {-1024.0f, -768.0f},
-                         {0.0f, 768.0f},
-                         {0.0f, -768.0f} };
+void OpenGLRenderer::renderViews(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size) {
+  for (auto & typed_body_view : views) {
+    typed_body_view->render( view, view_center, world_size, interpolation );
+  }
+}
 
-SquareMatrix4df createTranslationMatrix(float x, float y) {
-    SquareMatrix4df matrix = {
-                    {1, 0, 0, 0},
-                    {0, 1, 0, 0},
-                    {0, 0, 1, 0},
-                    {x, y, 0, 1}
-    };
-    return matrix;
+void OpenGLRenderer::renderBatches(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size) {
+  for (auto & typed_body_view : views) {
+    typed_body_view->add_instances( *batches[static_cast<size_t>(typed_body_view->get_mesh())], view, view_center, world_size, interpolation );
+  }
+  for (auto & batch : batches) {
+    batch->render();
+  }
 }
 
 void OpenGLRenderer::render() {
   debug(2, "render() entry...");
+  trace_zone("OpenGLRenderer::render");
+  draw_call_counter = 0;
+  triangle_counter = 0;
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  half_viewport_size = { 0.5f * viewport[2], 0.5f * viewport[3] };
 
   // // transformation to canonical view and from left handed to right handed coordinates
   SquareMatrix4df world_transformation =
@@ -639,7 +910,12 @@ void OpenGLRenderer::render() {
   // remove all views for typed bodies that have to be deleted 
   erase_if(views, []( std::unique_ptr<TypedBodyView> & view) { return view->get_typed_body()->is_marked_for_deletion();}); 
 
-  auto new_bodies = game.get_physics().get_recently_added_bodies();
+  // with a fixed timestep several frames may be rendered per tick, the new bodies of a tick get their views only once
+  std::vector<Body2df *> new_bodies;
+  if (game.get_physics().get_no_of_ticks() != no_of_ticks) {
+    no_of_ticks = game.get_physics().get_no_of_ticks();
+    new_bodies = game.get_physics().get_recently_added_bodies();
+  }
   for (Body2df * body : new_bodies) {
     assert(body != nullptr);
     TypedBody * typed_body = static_cast<TypedBody *>(body);
@@ -660,42 +936,64 @@ void OpenGLRenderer::render() {
   }
 
   debug(2, "render all views");
-  for (auto & view : views) {
-      for (int i = 0; i < 9; ++i) {
-          auto resulting_transformation = world_transformation;
-          auto shifted_matrix = createTranslationMatrix(tile_positions[i][0], tile_positions[i][1]);
-          if(game.ship_exists()) {
-              auto ship = game.get_ship();
-              Vector2df shipPos = ship->get_position();
-              SquareMatrix4df translationShip = SquareMatrix4df{
-                      {1.0f,                               0.0f,                                0.0f, 0.0f},
-                      {0.0f,                               1.0f,                                0.0f, 0.0f},
-                      {0.0f,                               0.0f,                                1.0f, 0.0f},
-                      {this->window_width / 2.0f - shipPos[0], this->window_height / 2.0f - shipPos[1], 0.0f, 1.0f}
-              };
-              resulting_transformation = resulting_transformation * shifted_matrix * translationShip;
-          }
-          view->render( resulting_transformation );
-      }
+  // the view follows the ship, without a ship it shows the playfield [0, 1024] x [0, 768]
+  // the playfield is a torus, each body is drawn at its images visible in the view
+  Vector2df world_size = game.get_physics().get_world_size();
+  SquareMatrix4df view_transformation = world_transformation;
+  Vector2df view_center{512.0f, 384.0f};
+  if (game.ship_exists()) {
+    Vector2df ship_position = game.get_ship()->get_interpolated_position(interpolation);
+    Vector2df translation{ window_width / 2.0f - ship_position[0], window_height / 2.0f - ship_position[1] };
+    view_transformation = world_transformation * createTranslationMatrix(translation[0], translation[1]);
+    view_center -= translation;
+  }
+  if (batched) {
+    renderBatches(view_transformation, view_center, world_size);
+  } else {
+    renderViews(view_transformation, view_center, world_size);
   }
   renderFreeShips(world_transformation);
   renderScore(world_transformation);
+  draw_calls = draw_call_counter;
+  triangles = triangle_counter;
 
-  SDL_GL_SwapWindow(window);
+  {
+    trace_zone("SDL_GL_SwapWindow");
+    SDL_GL_SwapWindow(window);
+  }
   debug(2, "render() exit.");
 }
 
+void OpenGLRenderer::set_batched(bool batched) {
+  this->batched = batched;
+}
+
+size_t OpenGLRenderer::get_draw_calls() const {
+  return draw_calls;
+}
+
+size_t OpenGLRenderer::get_triangles() const {
+  return triangles;
+}
+
 void OpenGLRenderer::exit() {
   views.clear();
+  for (auto & batch : batches) {
+    batch.reset();
+  }
   glDeleteBuffers(vertice_data.size(), vbos);
-  glDeleteBuffers(vertex_data_3d.size(), vbos3d);
+  for (MeshBuffers & buffers : mesh_buffers_3d) {
+    glDeleteBuffers(1, &buffers.vbo);
+    glDeleteBuffers(1, &buffers.ibo);
+  }
+  mesh_buffers_3d.clear();
   SDL_GL_DeleteContext(context);
   SDL_DestroyWindow( window );
   SDL_Quit();
 }
 
 void OpenGLRenderer::load_wavefront_data() {
-    vertex_data_3d.clear();
+    meshes_3d.clear();
 
     std::vector<std::string> wavefront_files = {
             "saucer.obj",
@@ -705,15 +1003,17 @@ void OpenGLRenderer::load_wavefront_data() {
     };
 
     for (const auto& file : wavefront_files) {
-        std::vector<float> vertices = load_wavefront_file(file);
-        vertex_data_3d.push_back(vertices);
+        meshes_3d.push_back( load_wavefront_file(file) );
     }
 }
 
-std::vector<float> OpenGLRenderer::load_wavefront_file(const std::string &file_path) {
-    std::fstream in(file_path);
-    WavefrontImporter importer(in);
-    importer.parse();
-    return create_vertices(importer);
+// the wavefront file is only parsed, if its mesh cache is missing or outdated (see mesh_cache.h)
+MeshCache OpenGLRenderer::load_wavefront_file(const std::string &file_path) {
+    try {
+        return load_mesh(file_path);
+    } catch (const std::exception & e) {
+        error( std::string("loading ") + file_path + " failed: " + e.what() );
+        return MeshCache( CompactMesh{} );
+    }
 }
  
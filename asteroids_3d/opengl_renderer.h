@@ -10,47 +10,128 @@
 #include "game.h"
 #include "renderer.h"
 #include "debug.h"
+#include "viewer/mesh_cache.h"
 #include <array>
 #include <vector>
 #include <memory>
 
-// stores information on how to render a specific vertex buffer (vbo)
-// the vob's layout used by the shaderProgram is hard coded into the render() method.
+// the buffers of a 3d mesh in the compact format of viewer/mesh_optimizer.h: the vertex buffer with the layout
+// given by the attributes, the index buffer and one material color per draw range
+struct MeshBuffers {
+  GLuint vbo = 0;
+  GLuint ibo = 0;
+  GLsizei vertex_stride = 0;
+  std::vector<VertexAttribute> attributes;
+  std::vector<DrawRange> draw_ranges;
+  std::vector<MeshLod> lods;  // the levels of detail, the full mesh first, see viewer/mesh_simplifier.h
+  std::array<float, 3> position_offset{};  // the position is position_offset + position_scale * the normalized integers
+  std::array<float, 3> position_scale{};
+};
+
+// the size of the arrays of material colors of the 3d shaders, a mesh with more draw ranges needs more draw calls
+constexpr size_t MAX_MATERIALS_PER_DRAW = 8;
+
+// a mesh is drawn with its coarsest level of detail, whose error is at most that many pixels on the screen
+constexpr float MAX_LOD_ERROR_IN_PIXELS = 0.5f;
+
+// stores information on how to render a specific vertex buffer (vbo) of 2d points drawn with glDrawArrays,
+// or a 3d mesh drawn with glDrawElements
+// the vob's layout used by the shaderProgram is hard coded into the render() method for 2d points.
 class OpenGLView {
 protected:
   unsigned int shaderProgram;
   size_t vertices_size;
   bool is_3d;
   GLuint mode;
+  const MeshBuffers * mesh_buffers = nullptr;
   GLuint vao{};
   GLuint vao3d{};
 public:
-  OpenGLView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode = GL_LINE_LOOP, bool is_3d = false);
+  OpenGLView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode = GL_LINE_LOOP);
+
+  OpenGLView(const MeshBuffers & mesh, unsigned int shaderProgram);
 
   ~OpenGLView();
     
-  void render( SquareMatrix<float,4> & matrice);
+  // the level of detail is the one of the mesh of a 3d view
+  void render( SquareMatrix<float,4> & matrice, size_t lod = 0);
   void render3d( SquareMatrix<float,4> & matrice);
 };
 
 
+// the meshes of the game objects, all views of one mesh are rendered with one instanced draw call
+enum class Mesh : short { saucer, asteroid, spaceship, flame, torpedo, debris };
+constexpr size_t NO_OF_MESHES = 6;
+
+// renders all instances of one vertex buffer (vbo) or 3d mesh with a single instanced draw call per level of detail
+// the transformations of the instances are collected by add_instance() and streamed into an instance buffer when render() is called
+// the shaderProgram reads the transformation of each instance from the attribute locations 3 to 6
+class InstancedView {
+  unsigned int shaderProgram;
+  size_t vertex_count;
+  GLuint mode;
+  const MeshBuffers * mesh_buffers = nullptr;
+  GLuint vao{};
+  GLuint instance_vbo{};
+  size_t instance_capacity = 0;
+  std::vector< std::vector<SquareMatrix4df> > instances;  // per level of detail
+  void create_instance_buffer();
+  void set_instance_attributes(size_t first_instance);
+public:
+  InstancedView(GLuint vbo, unsigned int shaderProgram, size_t vertices_size, GLuint mode = GL_LINE_LOOP);
+
+  InstancedView(const MeshBuffers & mesh, unsigned int shaderProgram);
+
+  ~InstancedView();
+
+  void add_instance(const SquareMatrix4df & transformation, size_t lod = 0);
+
+  // draws all instances added since the last call and removes them
+  void render();
+};
+
+
 class TypedBodyView : public OpenGLView {
   TypedBody * typed_body;    // the body that is rendered by this view
+  Mesh mesh;
   float scale;
   std::function<bool()> draw; // view is rendered iff draw() returns true
   std::function<void(TypedBodyView *)> modify; // a callback which my change this TypedBodyView, for instance, for animations
   SquareMatrix4df create_object_transformation(Vector2df direction, float angle, float scale);
+
+  // returns the level of detail of the mesh of a 3d view for a transformation into the canonical view volume,
+  // the coarsest whose error is at most MAX_LOD_ERROR_IN_PIXELS on the screen
+  size_t select_lod(const SquareMatrix4df & transformation) const;
+
+  // stores the transformations of all images of the body on the torus of the given world size, which are visible
+  // in a view centered at view_center, and returns their number: the nearest image, and a second image on each axis
+  // if the body is closer than WRAP_MARGIN to an edge of the view
+  size_t create_image_transformations(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha,
+                                      std::array<SquareMatrix4df, 4> & transformations);
 public:
-  TypedBodyView(TypedBody * typed_body, GLuint vbo, unsigned int shaderProgram, size_t vertices_size, float scale = 1.0f, GLuint mode = GL_LINE_LOOP, bool is_3d = false,
+  // larger than the largest object, in world coordinates
+  static constexpr float WRAP_MARGIN = 64.0f;
+
+  TypedBodyView(TypedBody * typed_body, Mesh mesh, GLuint vbo, unsigned int shaderProgram, size_t vertices_size, float scale = 1.0f, GLuint mode = GL_LINE_LOOP,
+               std::function<bool()> draw = []() -> bool {return true;},
+               std::function<void(TypedBodyView *)> modify = [](TypedBodyView *) -> void {});
+
+  TypedBodyView(TypedBody * typed_body, Mesh mesh, const MeshBuffers & buffers, unsigned int shaderProgram, float scale = 1.0f,
                std::function<bool()> draw = []() -> bool {return true;},
                std::function<void(TypedBodyView *)> modify = [](TypedBodyView *) -> void {});
 
   // returns a 4 x 4 transformation matrice that rotates an object counter clockwise by the given angle in the x/y plane,
   // scales it, and moves it to the given direction 
  
-  void render( SquareMatrix<float,4> & world) ;
+  // renders the visible images of the body (see create_image_transformations)
+  // alpha interpolates the body between the previous and the current tick
+  void render( const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha = 1.0f) ;
+
+  // adds one instance per visible image of the body to the batch
+  void add_instances( InstancedView & batch, const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size, float alpha = 1.0f );
   
  TypedBody * get_typed_body();
+ Mesh get_mesh();
  bool get_is_3d();
 
  void set_scale(float scale);
@@ -69,16 +150,24 @@ class OpenGLRenderer : public Renderer {
   SDL_GLContext context;
   unsigned int shaderProgram;
   GLuint shaderProgram3d;
+  GLuint instancedShaderProgram;
+  GLuint instancedShaderProgram3d;
+  bool batched = true;
+  size_t draw_calls = 0;
+  size_t triangles = 0;
+  size_t no_of_ticks = 0;  // number of physics ticks, whose new bodies got views
   std::vector< std::unique_ptr<TypedBodyView > > views;
+  std::array< std::unique_ptr<InstancedView>, NO_OF_MESHES> batches;
   GLuint * vbos;
-  GLuint * vbos3d;
-  std::vector< std::vector<float>> vertex_data_3d;
+  std::vector<MeshCache> meshes_3d;  // saucer, asteroid, spaceship and flame
+  std::vector<MeshBuffers> mesh_buffers_3d;
   std::unique_ptr<OpenGLView> spaceship_view;
   std::array< std::unique_ptr<OpenGLView>, 10> digit_views;
   void createVbos();
   void create3dVbos();
   void createSpaceShipView();
   void createDigitViews();
+  void createBatches();
   void create(Spaceship * ship, std::vector< std::unique_ptr<TypedBodyView> > & views); 
   void create(Torpedo * torpedo, std::vector< std::unique_ptr<TypedBodyView> > & views);
   void create(Asteroid * asteroid, std::vector< std::unique_ptr<TypedBodyView> > & views);
@@ -87,10 +176,13 @@ class OpenGLRenderer : public Renderer {
   void create(Debris * debris, std::vector< std::unique_ptr<TypedBodyView> > & views);
   void renderFreeShips(SquareMatrix4df & matrice);
   void renderScore(SquareMatrix4df & matrice);
+  void renderViews(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size);
+  void renderBatches(const SquareMatrix4df & view, Vector2df view_center, Vector2df world_size);
   void create_shader_programs();
   void create_3dshader_programs();
+  void create_instanced_shader_programs();
   void load_wavefront_data();
-  static std::vector<float> load_wavefront_file(const std::string& file_path);
+  static MeshCache load_wavefront_file(const std::string& file_path);
 public:
   OpenGLRenderer(Game & game, std::string title, int window_width = 1024, int window_height = 768)
     : Renderer(game), title(title), window_width(window_width), window_height(window_height) { }
@@ -102,6 +194,16 @@ public:
   virtual void render();
   
   virtual void exit(); 
+
+  // if batched is true (default), all views of one mesh are rendered with one instanced draw call,
+  // otherwise each view is rendered once per tile
+  void set_batched(bool batched);
+
+  // returns the number of draw calls of the last render() call
+  size_t get_draw_calls() const;
+
+  // returns the number of triangles of the 3d meshes drawn by the last render() call
+  size_t get_triangles() const;
   
 };
 
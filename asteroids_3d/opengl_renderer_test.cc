@@ -0,0 +1,185 @@
+#include "opengl_renderer.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+
+
+namespace {
+
+// renders with an offscreen OpenGL context, for instance with Mesa llvmpipe:
+//   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./opengl_renderer_test
+// the tests are skipped if no OpenGL 3.3 context can be created
+
+constexpr size_t NO_OF_ASTEROIDS = 100;
+
+void add_asteroids(Game & game, size_t count) {
+  RandomStream random{1u};
+  for (size_t i = 0; i < count; i++) {
+    std::unique_ptr<Body2df> asteroid = std::make_unique<Asteroid>(3, random);
+    game.get_physics().add_body(asteroid);
+  }
+}
+
+TEST(OPENGLRENDERER, BatchedDrawCallsPerMesh) {
+  setenv("SDL_VIDEODRIVER", "offscreen", 0);
+  Game game{};
+  OpenGLRenderer renderer(game, "OpenGLRendererTest");
+  if ( ! renderer.init() ) {
+    GTEST_SKIP() << "no OpenGL context available";
+  }
+  game.tick(0.05f);
+  add_asteroids(game, NO_OF_ASTEROIDS);
+  game.tick(0.05f);
+
+  renderer.set_batched(false);
+  renderer.render();
+  size_t unbatched_draw_calls = renderer.get_draw_calls();
+
+  renderer.set_batched(true);
+  renderer.render();
+  size_t batched_draw_calls = renderer.get_draw_calls();
+  renderer.exit();
+
+  // free ships and score digits are drawn one by one in both cases
+  size_t hud_draw_calls = static_cast<size_t>( game.get_no_of_ships() ) + 20;
+  EXPECT_LE(NO_OF_ASTEROIDS, unbatched_draw_calls);
+  EXPECT_GT(2 * NO_OF_ASTEROIDS, unbatched_draw_calls);
+  EXPECT_LE(batched_draw_calls, NO_OF_MESHES + hud_draw_calls);
+}
+
+// with a fixed timestep several frames are rendered per tick
+TEST(OPENGLRENDERER, RenderingTwicePerTickDoesNotDuplicateViews) {
+  setenv("SDL_VIDEODRIVER", "offscreen", 0);
+  Game game{};
+  OpenGLRenderer renderer(game, "OpenGLRendererTest");
+  if ( ! renderer.init() ) {
+    GTEST_SKIP() << "no OpenGL context available";
+  }
+  renderer.set_batched(false);
+  add_asteroids(game, 10);
+  game.tick(0.05f);
+  renderer.render();
+  size_t draw_calls = renderer.get_draw_calls();
+  renderer.render();
+  renderer.exit();
+  EXPECT_EQ(draw_calls, renderer.get_draw_calls());
+}
+
+// a body is drawn once, unless it is close to an edge of the view, a body in a corner is drawn in all four corners
+TEST(OPENGLRENDERER, DrawsVisibleImagesOnly) {
+  setenv("SDL_VIDEODRIVER", "offscreen", 0);
+  Game game{};
+  OpenGLRenderer renderer(game, "OpenGLRendererTest");
+  if ( ! renderer.init() ) {
+    GTEST_SKIP() << "no OpenGL context available";
+  }
+  renderer.set_batched(false);
+  game.tick(0.05f);
+  RandomStream random{1u};
+  std::unique_ptr<Body2df> asteroid = std::make_unique<Asteroid>(1, Vector2df{200.0f, 200.0f}, random);
+  Body2df * a = asteroid.get();
+  game.get_physics().add_body(asteroid);
+  game.tick(0.05f);
+  a->set_position( game.ship_exists() ? game.get_ship()->get_position() + Vector2df{100.0f, 100.0f} : Vector2df{600.0f, 500.0f} );
+  renderer.render();
+  size_t draw_calls = renderer.get_draw_calls();
+
+  a->set_position( game.ship_exists() ? game.get_ship()->get_position() + Vector2df{510.0f, 380.0f} : Vector2df{1020.0f, 760.0f} );
+  renderer.render();
+  renderer.exit();
+  EXPECT_EQ(draw_calls + 3, renderer.get_draw_calls());
+}
+
+// a sphere of radius 40 as the asteroid mesh in the working directory, the other meshes of the game are missing
+class OPENGLRENDERER_LOD : public ::testing::Test {
+protected:
+  bool created = false;
+
+  void SetUp() override {
+    if (std::filesystem::exists("asteroid.obj")) {
+      GTEST_SKIP() << "asteroid.obj is not replaced";
+    }
+    created = true;
+    constexpr int STACKS = 32, SLICES = 64;
+    std::ofstream("lod_test.mtl") << "newmtl grey\nKd 0.5 0.5 0.5\n";
+    std::ofstream obj("asteroid.obj");
+    obj << "mtllib lod_test.mtl\nusemtl grey\n";
+    for (int stack = 0; stack <= STACKS; stack++) {
+      for (int slice = 0; slice < SLICES; slice++) {
+        float theta = std::numbers::pi_v<float> * stack / STACKS, phi = 2.0f * std::numbers::pi_v<float> * slice / SLICES;
+        float x = std::sin(theta) * std::cos(phi), y = std::sin(theta) * std::sin(phi), z = std::cos(theta);
+        obj << "v " << 40.0f * x << " " << 40.0f * y << " " << 40.0f * z << "\nvn " << x << " " << y << " " << z << "\n";
+      }
+    }
+    // the vertices of the poles are stored once per slice, the triangles at the poles are omitted
+    for (int stack = 1; stack + 1 < STACKS; stack++) {
+      for (int slice = 0; slice < SLICES; slice++) {
+        int a = stack * SLICES + slice + 1, b = stack * SLICES + (slice + 1) % SLICES + 1, c = a + SLICES, d = b + SLICES;
+        obj << "f " << a << "//" << a << " " << c << "//" << c << " " << d << "//" << d << "\n";
+        obj << "f " << a << "//" << a << " " << d << "//" << d << " " << b << "//" << b << "\n";
+      }
+    }
+  }
+
+  void TearDown() override {
+    if (created) {
+      std::filesystem::remove("asteroid.obj");
+      std::filesystem::remove("asteroid.obj.mesh");
+      std::filesystem::remove("lod_test.mtl");
+    }
+  }
+
+  // returns the triangles of one of ten asteroids of the given size in the view, the asteroids of the level are not counted
+  size_t render_asteroid(short size, bool batched) {
+    Game game{};
+    OpenGLRenderer renderer(game, "OpenGLRendererTest");
+    if ( ! renderer.init() ) {
+      return 0;
+    }
+    renderer.set_batched(batched);
+    game.tick(0.05f);
+    RandomStream random{1u};
+    std::vector<Body2df *> asteroids;
+    for (size_t i = 0; i < 10; i++) {
+      std::unique_ptr<Body2df> asteroid = std::make_unique<Asteroid>(size, Vector2df{200.0f, 200.0f}, random);
+      asteroids.push_back(asteroid.get());
+      game.get_physics().add_body(asteroid);
+    }
+    game.tick(0.05f);
+    Vector2df center = game.ship_exists() ? game.get_ship()->get_position() : Vector2df{512.0f, 384.0f};
+    for (size_t i = 0; i < asteroids.size(); i++) {
+      asteroids[i]->set_position( center + Vector2df{ 60.0f * i - 270.0f, 250.0f } );
+    }
+    // the first render() creates the views of the new bodies, the second one removes the views of the deleted bodies
+    renderer.render();
+    for (const std::unique_ptr<Body2df> & body : game.get_physics().get_bodies()) {
+      if (std::find(asteroids.begin(), asteroids.end(), body.get()) == asteroids.end()) {
+        body->mark_for_deletion();
+      }
+    }
+    renderer.render();
+    renderer.exit();
+    return renderer.get_triangles() / asteroids.size();
+  }
+};
+
+// small asteroids are drawn with a coarser level of detail of the same mesh
+TEST_F(OPENGLRENDERER_LOD, SmallAsteroidsHaveFewerTriangles) {
+  setenv("SDL_VIDEODRIVER", "offscreen", 0);
+  size_t large = render_asteroid(3, true);
+  if (large == 0) {
+    GTEST_SKIP() << "no OpenGL context available";
+  }
+  size_t small = render_asteroid(1, true);
+  EXPECT_GE(30u * 64u * 2u, large);
+  EXPECT_GE(large / 2, small);
+  EXPECT_LT(0u, small);
+  EXPECT_EQ(small, render_asteroid(1, false));
+  EXPECT_EQ(large, render_asteroid(3, false));
+}
+
+}
@@ -0,0 +1,80 @@
+#include "physics.h"
+#include "broad_phase.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+#include <thread>
+
+// measures how the ticks per second of Physics scale with the number of threads (see Physics::set_no_of_threads())
+// for the broad phases, that find their pairs in parallel (the aabb tree only moves the bodies in parallel)
+
+namespace {
+
+constexpr float TICK_TIME = 1.0f / 60.0f;
+
+struct Scenario {
+  size_t no_of_bodies;
+  size_t no_of_ticks;
+  float world_size;    // the bodies are spread uniformly over a torus with this edge length
+};
+
+double ticks_per_second(const Scenario & scenario, BroadPhase broad_phase, size_t no_of_threads) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> position(0.0f, scenario.world_size);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(1.0f, 33.0f);
+  Physics2df physics{};
+  physics.set_broad_phase(broad_phase);
+  physics.set_world_size( {scenario.world_size, scenario.world_size} );
+  physics.set_no_of_threads(no_of_threads);
+  for (size_t i = 0; i < scenario.no_of_bodies; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, radius(gen)},
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    physics.add_body(body);
+  }
+  physics.tick(TICK_TIME);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < scenario.no_of_ticks; i++) {
+    physics.tick(TICK_TIME);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return scenario.no_of_ticks / elapsed.count();
+}
+
+}
+
+int main() {
+  const Scenario scenarios[] = { {10000u, 50u, 16000.0f},
+                                 {100000u, 10u, 50000.0f} };
+  const std::pair<const char *, BroadPhase> broad_phases[] = { {"spatial grid", BroadPhase::spatial_grid},
+                                                               {"sweep and prune", BroadPhase::sweep_and_prune},
+                                                               {"aabb tree", BroadPhase::aabb_tree} };
+  const size_t thread_counts[] = { 1u, 2u, 4u, 8u, 16u };
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+  std::cout << std::setw(18) << "broad phase" << std::setw(10) << "bodies";
+  for (size_t no_of_threads : thread_counts) {
+    std::cout << std::setw(8) << no_of_threads << " threads";
+  }
+  std::cout << "  (ticks/s, speedup)" << std::endl;
+  for (const Scenario & scenario : scenarios) {
+    for (auto [name, broad_phase] : broad_phases) {
+      std::cout << std::setw(18) << name << std::setw(10) << scenario.no_of_bodies;
+      double serial = 0.0;
+      for (size_t no_of_threads : thread_counts) {
+        double ticks = ticks_per_second(scenario, broad_phase, no_of_threads);
+        if (no_of_threads == 1u) {
+          serial = ticks;
+          std::cout << std::setw(16) << std::fixed << std::setprecision(1) << ticks;
+        } else {
+          std::cout << std::setw(10) << std::fixed << std::setprecision(1) << ticks
+                    << " x" << std::setprecision(2) << ticks / serial;
+        }
+      }
+      std::cout << std::endl;
+    }
+  }
+  return 0;
+}
@@ -4,7 +4,15 @@
 template class BoundingVolumeCircle<float, 2>;
 template class BoundingVolumeHyperRectangle<float, 2>;
 template class Body<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class BroadPhaseStrategy<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class SpatialIndex<float, 2u, BoundingVolumeCircle<float, 2>>;
+template class FunctionPhysicsPolicy<float, 2u, BoundingVolumeCircle<float, 2>>;
 template class Physics<float, 2u, BoundingVolumeCircle<float, 2>>;
 template class Body<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class BroadPhaseStrategy<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class SpatialIndex<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
+template class FunctionPhysicsPolicy<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
 template class Physics<float, 2u, BoundingVolumeHyperRectangle<float, 2>>;
 
+template class DenseBody<float, 2u>;
+template class DensePhysics<float, 2u>;
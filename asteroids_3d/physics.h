@@ -6,10 +6,14 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <cstdint>
+#include <array>
+#include <utility>
 
 #include "math.h"
-#include "timer.h"
 #include "geometry.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
 
 
 // a bounding "box" based on a sphere
@@ -20,8 +24,27 @@ public:
 
   bool collides(BoundingVolumeCircle<FLOAT_TYPE, N> volume) const;
 
+  // returns true iff this volume and the given volume touch while moving linearly by the given displacements
+  // to their current positions (swept test, so fast volumes do not pass through each other)
+  bool collides(BoundingVolumeCircle<FLOAT_TYPE, N> volume, Vector<FLOAT_TYPE,N> displacement, Vector<FLOAT_TYPE,N> volume_displacement) const;
+
   FLOAT_TYPE get_radius() const;
   
+  // returns the maximal distance (in each axis) between the positions of this volume and
+  // a colliding volume that is not larger than this volume
+  FLOAT_TYPE get_collision_distance() const;
+
+  // return the lower and upper corner of the axis aligned box enclosing this volume
+  Vector<FLOAT_TYPE,N> get_lower_bound() const;
+  Vector<FLOAT_TYPE,N> get_upper_bound() const;
+
+  // returns the distance between the given point and this volume, zero if the point is inside
+  FLOAT_TYPE get_distance(Vector<FLOAT_TYPE,N> point) const;
+
+  // returns the smallest t >= 0 such that ray.origin + t * ray.direction is inside this volume,
+  // or a negative value if the ray misses this volume
+  FLOAT_TYPE ray_intersection(const Ray<FLOAT_TYPE,N> & ray) const;
+
   Vector<FLOAT_TYPE,N> get_position() const;
     
   void set_position(Vector<FLOAT_TYPE,N> position);  
@@ -40,7 +63,26 @@ public:
 
   bool collides(BoundingVolumeHyperRectangle<FLOAT_TYPE, N> volume) const;
 
+  // returns true iff this volume and the given volume touch while moving linearly by the given displacements
+  // to their current positions (swept test, so fast volumes do not pass through each other)
+  bool collides(BoundingVolumeHyperRectangle<FLOAT_TYPE, N> volume, Vector<FLOAT_TYPE,N> displacement, Vector<FLOAT_TYPE,N> volume_displacement) const;
+
   FLOAT_TYPE get_edge_length(size_t edge) const;
+
+  // returns the maximal distance (in each axis) between the positions of this volume and
+  // a colliding volume that is not larger than this volume
+  FLOAT_TYPE get_collision_distance() const;
+
+  // return the lower and upper corner of this volume
+  Vector<FLOAT_TYPE,N> get_lower_bound() const;
+  Vector<FLOAT_TYPE,N> get_upper_bound() const;
+
+  // returns the distance between the given point and this volume, zero if the point is inside
+  FLOAT_TYPE get_distance(Vector<FLOAT_TYPE,N> point) const;
+
+  // returns the smallest t >= 0 such that ray.origin + t * ray.direction is inside this volume,
+  // or a negative value if the ray misses this volume
+  FLOAT_TYPE ray_intersection(const Ray<FLOAT_TYPE,N> & ray) const;
   
   Vector<FLOAT_TYPE,N> get_position() const;
     
@@ -48,7 +90,29 @@ public:
   
 };
 
-template<class FLOAT_TYPE, size_t N, class BV> class Physics;
+template<class FLOAT_TYPE, size_t N, class BV> class FunctionPhysicsPolicy;
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY = FunctionPhysicsPolicy<FLOAT_TYPE, N, BV> > class Physics;
+
+// algorithms used by Physics to find the pairs of bodies which have to be tested for a collision (see broad_phase.h)
+// brute_force tests each body against every other body
+// spatial_grid sorts the bodies into a uniform grid and only tests bodies in the same or in neighbouring cells
+// sweep_and_prune keeps the bodies sorted by their lower bound on one axis from tick to tick
+// aabb_tree keeps the enlarged bounds of the bodies in a balanced bounding volume hierarchy
+// custom is any other BroadPhaseStrategy given to Physics::set_broad_phase()
+enum class BroadPhase : short { brute_force, spatial_grid, sweep_and_prune, aabb_tree, custom };
+
+// the simulation time is a double for every FLOAT_TYPE: a float sum of tick times of 1/60 s rounds each tick
+// to a larger step from 2^14 s on and stops growing at 2^19 s, so the deadlines would no longer expire
+typedef double SimulationTime;
+
+// the simulation time of a Physics and the deadlines registered for it, each Body of the Physics refers to it
+struct SimulationClock {
+  SimulationTime time = 0.0;  // sum of the tick times of all ticks
+  TimerWheel< SimulationTime, std::function<void()> > timers;
+  size_t no_of_expired_bodies = 0;  // bodies whose time to delete has expired since the Physics deleted bodies
+  // set while the bodies are moved by several threads, the timers are then scheduled after the move
+  bool defers_scheduling = false;
+};
 
 // dynamic physical body  with a bounding value of type BV
 // the body has a (central) position, a velocity, an orientation defined by an angle and other physical attributes
@@ -61,11 +125,44 @@ protected:
   FLOAT_TYPE min_velocity;
   FLOAT_TYPE angle;
 
+  // position and angle at the start of the last tick, used to interpolate between two ticks
+  Vector<FLOAT_TYPE, N> previous_position;
+  FLOAT_TYPE previous_angle;
+
   std::function<void(Body<FLOAT_TYPE, N, BV> *, FLOAT_TYPE)> fix; // fix object values after movement
 
-  Counter delete_counter;
+  // time of deletion in the simulation time of the clock, or in the age of the body as long as it has no clock,
+  // the Physics is told by a timer of the clock, when it has expired
+  SimulationTime delete_time = 0.0;
   bool deletable = false;
+  size_t delete_timer = TimerWheel< SimulationTime, std::function<void()> >::NO_TIMER;
+  bool deletion_is_deferred = false;  // the time of deletion changed while the clock deferred the scheduling
+
+  // clock of the Physics the body belongs to, nullptr until it is added by a tick
+  SimulationClock * clock = nullptr;
+  FLOAT_TYPE age = 0.0;         // seconds moved before the body has been added to a Physics
+  SimulationTime birth_time = 0.0;  // simulation time of the clock at age zero
+
+  // returns the simulation time of the clock, or the age of the body as long as it has no clock
+  SimulationTime get_time() const {
+    return clock != nullptr ? clock->time : age;
+  }
+
+  // registers the time of deletion on the clock
+  void schedule_deletion();
+
+  // makes the body use the clock of the Physics it is added to, the time of deletion is kept relative to its age
+  void set_clock(SimulationClock * clock);
+
+  size_t index = 0;  // position in the bodies of the Physics, updated in each tick
+  size_t proxy = 0;  // id of the body in the broad phase of the Physics
+
+  // collision filter, see set_collision_filter()
+  std::uint32_t category = 1u;
+  std::uint32_t mask = ALL_CATEGORIES;
 public:
+  static constexpr std::uint32_t ALL_CATEGORIES = UINT32_MAX;
+
   Body(  BV bounding_volume,
          Vector<FLOAT_TYPE, N> velocity, 
          FLOAT_TYPE max_velocity = 1.0,
@@ -76,10 +173,18 @@ public:
 
             = [](Body<FLOAT_TYPE, N, BV> * , FLOAT_TYPE ) -> void {  }); 
 
+  // virtual, because Physics deletes derived bodies through a pointer to Body
+  virtual ~Body();
+
  
 
+ // moves the Body according to its velocity and calls its fix afterwards
  void move(FLOAT_TYPE seconds = 1.0);
 
+ // moves the Body according to its velocity and calls fix_body(this, seconds) afterwards instead of its own fix
+ template<class F>
+ void move(FLOAT_TYPE seconds, F && fix_body);
+
   
 
   // turns the Body in the x/y-Plane 
@@ -101,24 +206,223 @@ public:
   
   FLOAT_TYPE get_angle() const;
   
+  // the body is marked for deletion as soon as the given time has passed, a single comparison with the
+  // simulation time of its Physics (or its age, while it belongs to no Physics)
   void set_time_to_delete(FLOAT_TYPE time_to_delete);
   
   FLOAT_TYPE get_time_to_delete() const;
 
+  // returns the seconds since the body has been created, which pass with its moves, derived bodies measure
+  // their cooldowns with it instead of counting them down in each tick
+  FLOAT_TYPE get_age() const;
+
   Vector<FLOAT_TYPE,N> get_position() const;
     
+  // moves the Body to the given position without interpolation (a jump)
   void set_position(Vector<FLOAT_TYPE,N> position);  
+
+  // stores the current position and angle as the previous ones, Physics calls it at the start of each move
+  void save_transform();
+
+  // returns the position/angle between the previous (alpha = 0) and the current (alpha = 1) tick
+  // a fix that moves the Body after its movement (e.g. wrapping around the screen) moves the previous position along,
+  // so the Body does not appear to fly across the screen
+  Vector<FLOAT_TYPE,N> get_interpolated_position(FLOAT_TYPE alpha) const;
+  FLOAT_TYPE get_interpolated_angle(FLOAT_TYPE alpha) const;
+
+  // returns the distance moved during the last tick, without jumps and wrapping
+  Vector<FLOAT_TYPE,N> get_displacement() const;
+
+  // moves the Body into [0, world_size) on each axis with a world size larger than zero (the world is a torus),
+  // the previous position is moved by the same offset, so the wrapped movement is still interpolated
+  void wrap(Vector<FLOAT_TYPE,N> world_size);
+
+  // returns the lower and upper corner of the axis aligned box enclosing the bounding volume
+  // swept from its previous to its current position
+  void get_swept_bounds(Vector<FLOAT_TYPE,N> & lower, Vector<FLOAT_TYPE,N> & upper) const;
   
-  friend class Physics<FLOAT_TYPE, N, BV>;
+  template<class, size_t, class, class> friend class Physics;
+  friend class FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>;
 
   BV get_bounding_volume() const;
+
+  // the complete state of a Body except its fix and its membership in a Physics, e.g. for snapshots;
+  // the time of deletion is measured with the clock of the Physics, if the body belongs to one
+  struct State {
+    BV bounding;
+    Vector<FLOAT_TYPE, N> velocity;
+    Vector<FLOAT_TYPE, N> previous_position;
+    FLOAT_TYPE max_velocity;
+    FLOAT_TYPE min_velocity;
+    FLOAT_TYPE angle;
+    FLOAT_TYPE previous_angle;
+    SimulationTime delete_time;
+    FLOAT_TYPE age;
+    SimulationTime birth_time;
+    std::uint32_t category;
+    std::uint32_t mask;
+    bool deletable;
+  };
+
+  State get_state() const;
+
+  // assigns the state member by member, so padding bytes of the given state keep their values (e.g. zero)
+  void get_state(State & state) const;
+
+  // sets the state of a body, that does not belong to a Physics (see Physics::restore())
+  void set_state(const State & state);
+
+  // sets the categories the body belongs to and the categories it collides with (one bit per category),
+  // two bodies can only collide, if the category of each body is in the mask of the other one; by default
+  // a body belongs to the first category and collides with all categories
+  // a body with an empty category or mask never collides and is left out of the broad phase, when it is added
+  // to a Physics, so its filter must not be changed while it belongs to a Physics
+  void set_collision_filter(std::uint32_t category, std::uint32_t mask);
+
+  std::uint32_t get_category() const;
+
+  std::uint32_t get_mask() const;
+
+  // returns true iff the collision filters of this body and the given body allow a collision
+  bool can_collide(const Body<FLOAT_TYPE, N, BV> & body) const {
+    return (category & body.mask) != 0u && (body.category & mask) != 0u;
+  }
 };
 
 
-// a basic physic engine controlling the movements and collisions of Body-objects
-// the collisions are resolved with callback handlers
+// finds the pairs of bodies of a Physics that may collide (broad phase), implementations are in broad_phase.h
+// the physics tells the strategy which bodies it contains, the strategy identifies a body by a proxy id
 template<class FLOAT_TYPE, size_t N, class BV>
+class BroadPhaseStrategy {
+protected:
+  std::vector< Body<FLOAT_TYPE, N, BV> * > proxies;  // body of each proxy id, nullptr if the id is free
+  std::vector<size_t> free_proxies;
+public:
+  virtual ~BroadPhaseStrategy() = default;
+
+  // creates a proxy for a body added to the physics and returns its id
+  virtual size_t add(Body<FLOAT_TYPE, N, BV> * body);
+
+  // removes the proxy of a body removed from the physics, the id may be reused by the next add()
+  virtual void remove(size_t proxy);
+
+  // appends (at least) all pairs of bodies whose swept bounds overlap, in any order, a pair may be appended more than once
+  // on a torus the bounds overlapping across the edges of the world have to be found too (see Physics::set_world_size())
+  virtual void find_pairs(Vector<FLOAT_TYPE, N> world_size,
+                          std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > & pairs) = 0;
+
+  // appends the same pairs as find_pairs(), but may use the threads of the pool, thread i appends to thread_pairs[i]
+  // (thread_pairs has one vector per thread); the default implementation calls find_pairs() in the calling thread
+  virtual void find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool & pool,
+                                   std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs);
+};
+
+
+// a bounding volume hierarchy over the boxes of the bodies of a Physics, used to answer spatial queries
+// it is built top down by splitting the bodies at the median of the longest axis, and only finds candidates,
+// the Physics tests the bounding volumes of the candidates
+template<class FLOAT_TYPE, size_t N, class BV>
+class SpatialIndex {
+  static constexpr size_t NO_NODE = static_cast<size_t>(-1);
+  static constexpr size_t MAX_LEAF_SIZE = 4;
+
+  struct Entry {
+    Vector<FLOAT_TYPE, N> lower;
+    Vector<FLOAT_TYPE, N> upper;
+    Body<FLOAT_TYPE, N, BV> * body;
+  };
+
+  // a node contains the entries [begin, end), a leaf has no children
+  struct Node {
+    Vector<FLOAT_TYPE, N> lower;
+    Vector<FLOAT_TYPE, N> upper;
+    size_t begin;
+    size_t end;
+    size_t child1 = NO_NODE;
+    size_t child2 = NO_NODE;
+  };
+
+  std::vector<Entry> entries;
+  std::vector<Node> nodes;
+  Vector<FLOAT_TYPE, N> world_size{};
+  Vector<FLOAT_TYPE, N> overhang{};  // how far the boxes reach beyond the edges of the torus
+
+  // kept as members to reuse the allocated memory in each query
+  std::vector<size_t> stack;
+  std::vector< std::pair<FLOAT_TYPE, size_t> > queue;
+
+  size_t build_node(size_t begin, size_t end);
+
+  // returns the distance between the point and the nearest image of the box on the torus
+  FLOAT_TYPE get_distance(Vector<FLOAT_TYPE, N> point, const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper) const;
+public:
+  void build(const std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies, Vector<FLOAT_TYPE, N> world_size);
+
+  // calls visit(body) for each body whose box overlaps the given box on the torus, a body may be visited more than once
+  // stops and returns false as soon as visit() returns false
+  template<class F>
+  bool for_each_overlapping(Vector<FLOAT_TYPE, N> lower, Vector<FLOAT_TYPE, N> upper, F visit);
+
+  // appends up to k bodies to result, nearest first, distance(body) returns the distance between the point and
+  // the body, which must not be less than the distance to its box, or infinity to skip the body
+  template<class F>
+  void find_nearest(Vector<FLOAT_TYPE, N> point, size_t k, F distance, std::vector< Body<FLOAT_TYPE, N, BV> * > & result);
+
+  // returns the body with the smallest t in [0, max_t] returned by intersection(body, ray), or nullptr
+  // on a torus intersection() is called with images of the ray, intersection() returns a negative t if it misses the body
+  template<class F>
+  Body<FLOAT_TYPE, N, BV> * ray_cast(const Ray<FLOAT_TYPE, N> & ray, FLOAT_TYPE max_t, F intersection, FLOAT_TYPE & t);
+};
+
+
+// the default policy of Physics, which resolves the collisions with std::function callbacks
+// and fixes each Body with the fix given to its constructor
+template<class FLOAT_TYPE, size_t N, class BV>
+class FunctionPhysicsPolicy {
+  // collision callback that returns true if the collision of to Body objects has to be resolved
+  std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision_callback;
+
+  // callback that is responsible for resolving the collision
+  std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision_callback;
+
+  // callback that is responsible for some cleanup on deleted bodies
+  std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body_callback;
+public:
+  FunctionPhysicsPolicy( std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision
+                           = [](Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> * ) -> bool { return true; },
+
+                         std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision
+                           = [](Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *) -> void { },
+
+                         std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body
+                           = [](Body<FLOAT_TYPE, N, BV> *) -> void { }
+                       );
+
+  bool check_collision(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2);
+
+  void resolve_collision(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2);
+
+  void resolve_deleted_body(Body<FLOAT_TYPE, N, BV> * body);
+
+  void fix(Body<FLOAT_TYPE, N, BV> * body, FLOAT_TYPE seconds);
+};
+
+
+// a basic physic engine controlling the movements and collisions of Body-objects
+// the collisions are resolved by the POLICY, which is called without indirection, so its calls can be inlined;
+// a POLICY has the following member functions:
+//   bool check_collision(Body * body1, Body * body2)  returns true if the collision of the bodies has to be resolved
+//   void resolve_collision(Body * body1, Body * body2)
+//   void resolve_deleted_body(Body * body)            is responsible for some cleanup on deleted bodies
+//   void fix(Body * body, FLOAT_TYPE seconds)         fixes the values of a body after its movement in each tick,
+//                                                     before it is wrapped around the torus
+// the default policy calls std::function callbacks (see FunctionPhysicsPolicy), a Physics with any other policy
+// has to be instantiated by the translation unit defining the policy, which includes physics.tcc
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
 class Physics {
+  // simulation time and timers, declared before the bodies, which cancel their timers when they are destroyed
+  SimulationClock clock;
+
   // all Body objects managed and controlled by the engine
   std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > bodies;
 
@@ -128,33 +432,111 @@ class Physics {
   // Body objects that have been added during the last call of tick()
   std::vector< Body<FLOAT_TYPE, N, BV> * > recently_added_bodies;
 
-  // collision callback that returns true if the collision of to Body objects has to be resolved
-  std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision;
-  
-  // callback that is responsible for resolving the collision
-  std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision;
+  POLICY policy;
 
-  // callback that is responsible for some cleanup on deleted bodies
-  std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body;
+  FLOAT_TYPE tick_time = 1.0;
 
+  size_t no_of_ticks = 0;
 
-  FLOAT_TYPE tick_time = 1.0;
+  BroadPhase broad_phase = BroadPhase::brute_force;
+  std::unique_ptr< BroadPhaseStrategy<FLOAT_TYPE, N, BV> > broad_phase_strategy;
+
+  // size of the toroidal world, zero on axes that do not wrap around
+  Vector<FLOAT_TYPE, N> world_size{};
+
+  // the following vectors are kept as members to reuse the allocated memory in each tick
+
+  // pairs found by the broad phase, and the same pairs as ordered indices into bodies
+  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > candidate_pairs;
+  std::vector< std::pair<size_t, size_t> > candidate_indices;
+
+  // moves the bodies and finds the candidate pairs with more than one thread, nullptr for a single thread
+  std::unique_ptr<ThreadPool> thread_pool;
+
+  // pairs found by each thread of the thread pool, and their ordered indices
+  std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > thread_pairs;
+  std::vector< std::vector< std::pair<size_t, size_t> > > thread_indices;
+
+  // pairs of colliding bodies found during the current tick
+  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > bodies_to_resolve;
+
+  // answers the spatial queries, rebuilt by the first query after the bodies have been added, deleted or moved
+  SpatialIndex<FLOAT_TYPE, N, BV> spatial_index;
+  bool spatial_index_is_valid = false;
+  std::vector< Body<FLOAT_TYPE, N, BV> * > query_result;
+
+  // rebuilds the spatial index, if it is not valid
+  void update_spatial_index();
+
+  // returns the given volume moved to its image on the torus, that is nearest to the given position
+  BV nearest_image(BV volume, Vector<FLOAT_TYPE, N> position) const;
+
+  // returns true iff the bounding volumes of the bodies collide, on a torus the nearest images of the bodies are tested
+  // if one of the bodies moved further than half of its collision distance during the last tick,
+  // both bodies are swept from their previous to their current position (continuous collision detection)
+  bool collides(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2) const;
+
+  // proxy of the bodies left out of the broad phase (see Body::set_collision_filter())
+  static constexpr size_t NO_PROXY = static_cast<size_t>(-1);
+
+  // adds the body to the broad phase, unless its collision filter is empty
+  void add_to_broad_phase(Body<FLOAT_TYPE, N, BV> * body);
+
+  // moves the bodies [begin, end) and wraps them around the torus
+  void move_bodies(size_t begin, size_t end);
+
+  // appends the ordered indices of the candidate pairs [begin, end), whose bodies collide, to indices
+  void filter_candidates(size_t begin, size_t end, std::vector< std::pair<size_t, size_t> > & indices) const;
+
+  // appends all colliding pairs, whose collision has to be resolved, to bodies_to_resolve
+  // the pairs are ordered by the indices of their bodies (lexicographical), whatever broad phase found them
+  void find_collisions();
+
+  // lets the timers expire, whose deadline is not after the simulation time
+  void advance_timers();
 public:
+  static constexpr size_t NO_TIMER = TimerWheel< SimulationTime, std::function<void()> >::NO_TIMER;
 
-  Physics( std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision
-                   = [](Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> * ) -> bool { return true; },
-                   
-           std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision 
-                              = [](Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *) -> void { },
-                              
-           std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body 
-                              = [](Body<FLOAT_TYPE, N, BV> *) -> void { }
-         );
+  // the arguments are passed to the constructor of the policy, e.g. the callbacks of FunctionPhysicsPolicy
+  template<class... ARGS>
+  explicit Physics(ARGS &&... args) : policy(std::forward<ARGS>(args)...) {
+    set_broad_phase(BroadPhase::brute_force);
+  }
 
   void set_tick_time(FLOAT_TYPE tick_time);
 
   // returns the tick_time which was used during the last tick 
-  FLOAT_TYPE get_tick_time();
+  FLOAT_TYPE get_tick_time() const;
+
+  // selects the algorithm used to find collision candidates during tick()
+  // all algorithms resolve the same collisions in the same order, they can be switched between two ticks
+  // BroadPhase::custom is ignored, use the overload below
+  void set_broad_phase(BroadPhase broad_phase);
+
+  // uses the given strategy to find collision candidates, get_broad_phase() returns BroadPhase::custom
+  void set_broad_phase(std::unique_ptr< BroadPhaseStrategy<FLOAT_TYPE, N, BV> > strategy);
+
+  BroadPhase get_broad_phase() const;
+
+  // uses the given number of threads (including the calling thread) to move the bodies and to find the colliding
+  // pairs in tick(), the collisions are still resolved in the calling thread; all numbers of threads give
+  // bit-identical results
+  // with more than one thread the fix of the policy is called concurrently for different bodies,
+  // so it must only change the given body (Game uses a single thread); a time to delete set by the fix is
+  // scheduled on the clock after all bodies have been moved
+  void set_no_of_threads(size_t no_of_threads);
+
+  size_t get_no_of_threads() const;
+
+  // makes the world a torus with the given size and a corner at the origin: each tick wraps the bodies
+  // into [0, world_size), and collisions are detected across the edges with the nearest images of the bodies
+  // an axis with a size of zero does not wrap around, the default world is unbounded on all axes
+  void set_world_size(Vector<FLOAT_TYPE, N> world_size);
+
+  Vector<FLOAT_TYPE, N> get_world_size() const;
+
+  // returns the shortest vector that is equivalent to the given difference of two positions on the torus
+  Vector<FLOAT_TYPE, N> minimum_image(Vector<FLOAT_TYPE, N> difference) const;
 
   // adds a new Body object to this engine
   // the body is added in the next call to tick()  
@@ -162,24 +544,183 @@ public:
   
   Body<FLOAT_TYPE, N, BV> * get_body(size_t i);
   
-  const std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> >  > & get_bodies();
+  const std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> >  > & get_bodies() const;
+
+  // returns the bodies, that will be added in the next call to tick()
+  const std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> >  > & get_bodies_to_add() const;
 
   // Peforms the follown steps in the given order:
   // 1. adds all new Body object to this engine,
-  // 2. removes all Body object, that has to be deleted from it
-  // 3. moves all objects according to the current tick_time
+  // 2. removes all Body object, that has to be deleted from it, if the time to delete of any body has expired
+  // 3. advances the simulation time by tick_time, moves all objects accordingly and wraps them around the torus
   // 4. checks for collisions and uses the callback handler to resolve them
-  // 5. removes all Body objects, that has to be deleted
+  // 5. calls the callbacks of the expired timers (see add_timer())
   void tick();
   
   void tick(FLOAT_TYPE tick_time);
   
+  // returns true iff no body accepted by check_body collides with the given area
   bool is_area_free_of_bodies(BV * area,
                               std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body
                                 = [](Body<FLOAT_TYPE, N, BV> * body) -> bool {return ! body->is_marked_for_deletion();});
+
+  // the following spatial queries use the nearest images of the bodies on a torus and cost O(log n + k) for k results,
+  // they can be used between two ticks and by the callbacks during a tick, bodies added by add_body() are found
+  // after the next tick
+
+  // appends all bodies accepted by check_body, whose bounding volumes are at most radius away from the point,
+  // to result ordered by their index in get_bodies()
+  void query_radius(Vector<FLOAT_TYPE, N> point, FLOAT_TYPE radius, std::vector< Body<FLOAT_TYPE, N, BV> * > & result,
+                    std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body
+                      = [](Body<FLOAT_TYPE, N, BV> * body) -> bool {return ! body->is_marked_for_deletion();});
+
+  // appends the k bodies accepted by check_body, whose bounding volumes are nearest to the point, to result, nearest first
+  void query_nearest(Vector<FLOAT_TYPE, N> point, size_t k, std::vector< Body<FLOAT_TYPE, N, BV> * > & result,
+                     std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body
+                       = [](Body<FLOAT_TYPE, N, BV> * body) -> bool {return ! body->is_marked_for_deletion();});
+
+  // returns the first body accepted by check_body, that is hit by the ray at ray.origin + t * ray.direction
+  // with t in [0, max_t], and sets t, or returns nullptr; on a torus max_t * |ray.direction| must not
+  // exceed the world size
+  Body<FLOAT_TYPE, N, BV> * ray_cast(const Ray<FLOAT_TYPE, N> & ray, FLOAT_TYPE max_t, FLOAT_TYPE & t,
+                                     std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body
+                                       = [](Body<FLOAT_TYPE, N, BV> * body) -> bool {return ! body->is_marked_for_deletion();});
   
   // returns a list of all bodies that have been added at the last call to tick();                              
-  std::vector<Body<FLOAT_TYPE, N, BV> *> & get_recently_added_bodies();
+  const std::vector<Body<FLOAT_TYPE, N, BV> *> & get_recently_added_bodies() const;
+
+  // returns the number of calls to tick(), for instance to find out if get_recently_added_bodies() has changed
+  size_t get_no_of_ticks() const;
+
+  // returns the sum of the tick times of all calls to tick()
+  SimulationTime get_time() const;
+
+  // registers a callback, that is called at the end of the first tick() reaching the given simulation time,
+  // the callbacks of a tick are called in the order of their deadlines; returns a handle for cancel_timer(),
+  // which is valid until the callback has been called
+  // the timers are kept in a hierarchical timer wheel, so each tick only costs time for the expired timers
+  size_t add_timer(SimulationTime deadline, std::function<void()> callback);
+
+  void cancel_timer(size_t timer);
+
+  // returns the deadline of a timer, whose callback has not been called yet
+  SimulationTime get_timer_deadline(size_t timer) const;
+
+  // replaces the state of the engine, e.g. to restore a snapshot: destroys its bodies without resolve_deleted_body(),
+  // cancels all timers and takes over the given bodies in their order at the given simulation time
+  // the bodies have to be in the state of bodies of a Physics (see Body::get_state()), the bodies to add in the state
+  // of bodies not added yet, recently_added are indices into bodies (see get_recently_added_bodies())
+  // the broad phase, the world size and the number of threads are kept
+  void restore(SimulationTime time, FLOAT_TYPE tick_time, size_t no_of_ticks,
+               std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies,
+               std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies_to_add,
+               const std::vector<size_t> & recently_added);
+};
+
+
+template<class FLOAT_TYPE, size_t N> class DensePhysics;
+
+// identifies a body of a DensePhysics, stays valid until the body is deleted
+typedef std::uint32_t BodyHandle;
+
+// a light weight view of a body stored inside a DensePhysics,
+// all values are read from and written to the component arrays of the physics
+template<class FLOAT_TYPE, size_t N>
+class DenseBody {
+  DensePhysics<FLOAT_TYPE, N> * physics;
+  BodyHandle handle;
+public:
+  DenseBody(DensePhysics<FLOAT_TYPE, N> * physics, BodyHandle handle);
+
+  BodyHandle get_handle() const;
+
+  Vector<FLOAT_TYPE, N> get_position() const;
+
+  void set_position(Vector<FLOAT_TYPE, N> position);
+
+  Vector<FLOAT_TYPE, N> get_velocity() const;
+
+  void set_velocity(Vector<FLOAT_TYPE, N> velocity);
+
+  FLOAT_TYPE get_radius() const;
+
+  FLOAT_TYPE get_angle() const;
+
+  // turns the body in the x/y-Plane 
+  // angle is measured in radians
+  void turn(FLOAT_TYPE angle, FLOAT_TYPE seconds = 1.0);
+
+  // the body is removed from the physics after the given time has elapsed
+  void set_time_to_delete(FLOAT_TYPE time_to_delete);
+
+  FLOAT_TYPE get_time_to_delete() const;
+
+  void mark_for_deletion();
+
+  bool is_marked_for_deletion() const;
+};
+
+
+// a physic engine with the same tick semantics as Physics using BoundingVolumeCircle volumes,
+// but storing the bodies as structure of arrays: positions, velocities, radii, angles and
+// deletion deadlines are kept in contiguous arrays, so moving and overlap tests run over dense data.
+// bodies are accessed by handles; the order of the arrays is the order in which the bodies have been added,
+// so collisions are resolved in the same order as with Physics
+template<class FLOAT_TYPE, size_t N>
+class DensePhysics {
+  static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+  // component arrays, index i of each array belongs to the same body
+  std::array< std::vector<FLOAT_TYPE>, N > positions;  // one array per axis
+  std::array< std::vector<FLOAT_TYPE>, N > velocities; // one array per axis
+  std::vector<FLOAT_TYPE> radii;
+  std::vector<FLOAT_TYPE> angles;
+  std::vector<SimulationTime> delete_deadlines;  // simulation time of deletion, infinity if the body is not deletable
+  std::vector<BodyHandle> handles;         // handle of the body stored at an index
+
+  std::vector<std::uint32_t> slots;        // index of the body in the component arrays for each handle
+  std::vector<BodyHandle> free_handles;
+
+  SimulationTime time = 0.0;
+  FLOAT_TYPE tick_time = 1.0;
+
+  std::function<bool(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> check_collision;
+  std::function<void(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> resolve_collision;
+  std::function<void(DenseBody<FLOAT_TYPE, N>)> resolve_deleted_body;
+
+  // reused memory for the collision detection
+  std::vector< std::pair<std::uint64_t, std::uint32_t> > grid_cells;
+  std::vector<std::uint32_t> grid_candidates;
+  std::vector< std::pair<BodyHandle, BodyHandle> > bodies_to_resolve;
+
+  void delete_bodies();
+  void find_collisions();
+  // returns true iff the body at index i moves further than its radius during a tick
+  bool is_fast(size_t i) const;
+  friend class DenseBody<FLOAT_TYPE, N>;
+public:
+  DensePhysics( std::function<bool(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> check_collision
+                   = [](DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>) -> bool { return true; },
+                std::function<void(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> resolve_collision
+                   = [](DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>) -> void { },
+                std::function<void(DenseBody<FLOAT_TYPE, N>)> resolve_deleted_body
+                   = [](DenseBody<FLOAT_TYPE, N>) -> void { } );
+
+  // adds a new body and returns its handle
+  BodyHandle add_body(Vector<FLOAT_TYPE, N> position, FLOAT_TYPE radius, Vector<FLOAT_TYPE, N> velocity, FLOAT_TYPE angle = 0.0);
+
+  DenseBody<FLOAT_TYPE, N> get_body(BodyHandle handle);
+
+  // returns false if the body of the handle has been deleted
+  bool contains(BodyHandle handle) const;
+
+  size_t size() const;
+
+  FLOAT_TYPE get_tick_time() const;
+
+  // performs the same steps as Physics::tick():
+  // removes the bodies to delete, moves all bodies, and resolves the collisions
+  void tick(FLOAT_TYPE tick_time);
 };
 
 
@@ -191,4 +732,7 @@ typedef BoundingVolumeHyperRectangle<float, 2u> Rectangle2df;
 typedef Body<float, 2u, Rectangle2df> BodyRect2df;
 typedef Physics<float, 2u, Rectangle2df> PhysicsRect2df;
 
+typedef DenseBody<float, 2u> DenseBody2df;
+typedef DensePhysics<float, 2u> DensePhysics2df;
+
 #endif
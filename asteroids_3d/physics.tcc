@@ -1,7 +1,31 @@
 #include <utility>
 #include <cassert>
 #include "debug.h"
+#include "trace.h"
+#include "broad_phase.h"
 #include <algorithm>
+#include <limits>
+
+// returns the smallest t in [0, max_t] such that ray.origin + t * ray.direction is inside the box,
+// or a negative value if there is none (slab test)
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE ray_box_intersection(const Ray<FLOAT_TYPE, N> & ray, const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper, FLOAT_TYPE max_t) {
+  FLOAT_TYPE t_first = 0.0;
+  FLOAT_TYPE t_last = max_t;
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (ray.direction[axis] == 0.0) {
+      if (ray.origin[axis] < lower[axis] || ray.origin[axis] > upper[axis]) {
+        return -1;
+      }
+      continue;
+    }
+    FLOAT_TYPE t_lower = (lower[axis] - ray.origin[axis]) / ray.direction[axis];
+    FLOAT_TYPE t_upper = (upper[axis] - ray.origin[axis]) / ray.direction[axis];
+    t_first = std::max(t_first, std::min(t_lower, t_upper));
+    t_last = std::min(t_last, std::max(t_lower, t_upper));
+  }
+  return t_first <= t_last ? t_first : -1;
+}
 
 template<class FLOAT_TYPE, size_t N>
 BoundingVolumeCircle<FLOAT_TYPE, N>::BoundingVolumeCircle(Vector<FLOAT_TYPE,N> position, FLOAT_TYPE radius) 
@@ -12,11 +36,66 @@ bool BoundingVolumeCircle<FLOAT_TYPE, N>::collides(BoundingVolumeCircle<FLOAT_TY
   return this->intersects(volume);
 }
 
+template<class FLOAT_TYPE, size_t N>
+bool BoundingVolumeCircle<FLOAT_TYPE, N>::collides(BoundingVolumeCircle<FLOAT_TYPE, N> volume, Vector<FLOAT_TYPE,N> displacement, Vector<FLOAT_TYPE,N> volume_displacement) const {
+  Sphere<FLOAT_TYPE, N> start{this->center - displacement, this->radius};
+  Sphere<FLOAT_TYPE, N> volume_start{volume.center - volume_displacement, volume.radius};
+  return start.time_of_impact(volume_start, displacement, volume_displacement) >= 0;
+}
+
 template<class FLOAT_TYPE, size_t N>  
 FLOAT_TYPE BoundingVolumeCircle<FLOAT_TYPE, N>::get_radius() const {
   return this->radius;
 }
 
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeCircle<FLOAT_TYPE, N>::get_collision_distance() const {
+  return 2 * this->radius;
+}
+
+template<class FLOAT_TYPE, size_t N>  
+Vector<FLOAT_TYPE,N> BoundingVolumeCircle<FLOAT_TYPE, N>::get_lower_bound() const {
+  Vector<FLOAT_TYPE,N> lower = this->center;
+  for (size_t axis = 0u; axis < N; axis++) {
+    lower[axis] -= this->radius;
+  }
+  return lower;
+}
+
+template<class FLOAT_TYPE, size_t N>  
+Vector<FLOAT_TYPE,N> BoundingVolumeCircle<FLOAT_TYPE, N>::get_upper_bound() const {
+  Vector<FLOAT_TYPE,N> upper = this->center;
+  for (size_t axis = 0u; axis < N; axis++) {
+    upper[axis] += this->radius;
+  }
+  return upper;
+}
+
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeCircle<FLOAT_TYPE, N>::get_distance(Vector<FLOAT_TYPE,N> point) const {
+  return std::max<FLOAT_TYPE>(0.0, (point - this->center).length() - this->radius);
+}
+
+// solution of (ray.origin + t * ray.direction - center)^2 = radius^2, the smaller root is the entry point
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeCircle<FLOAT_TYPE, N>::ray_intersection(const Ray<FLOAT_TYPE,N> & ray) const {
+  Vector<FLOAT_TYPE,N> distance = ray.origin - this->center;
+  FLOAT_TYPE c = distance * distance - this->radius * this->radius;
+  if (c <= 0) {
+    return 0; // the ray starts inside
+  }
+  FLOAT_TYPE a = ray.direction * ray.direction,
+             b = distance * ray.direction;
+  if (a == 0 || b >= 0) {
+    return -1; // pointing away
+  }
+  FLOAT_TYPE d = b * b - a * c;
+  if (d < 0) {
+    return -1;
+  }
+  return (-b - std::sqrt(d)) / a;
+}
+
 template<class FLOAT_TYPE, size_t N>  
 Vector<FLOAT_TYPE,N> BoundingVolumeCircle<FLOAT_TYPE, N>::get_position() const {
   return this->center;
@@ -42,11 +121,68 @@ bool BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::collides(BoundingVolumeHyperRec
  return collision;
 }
 
+// clips the interval of the relative movement [0, 1] against the interval of overlap of each axis (slab test)
+template<class FLOAT_TYPE, size_t N>  
+bool BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::collides(BoundingVolumeHyperRectangle<FLOAT_TYPE, N> volume, Vector<FLOAT_TYPE,N> displacement, Vector<FLOAT_TYPE,N> volume_displacement) const {
+  FLOAT_TYPE t_first = 0.0;
+  FLOAT_TYPE t_last = 1.0;
+  for (size_t axis = 0u; axis < N; axis++) {
+    FLOAT_TYPE start = position[axis] - displacement[axis];
+    FLOAT_TYPE lower = volume.position[axis] - volume_displacement[axis] - edge_lengths[axis];
+    FLOAT_TYPE upper = volume.position[axis] - volume_displacement[axis] + volume.edge_lengths[axis];
+    FLOAT_TYPE speed = displacement[axis] - volume_displacement[axis];
+    if (speed == 0.0) {
+      if (start < lower || start > upper) {
+        return false;
+      }
+      continue;
+    }
+    FLOAT_TYPE t_lower = (lower - start) / speed;
+    FLOAT_TYPE t_upper = (upper - start) / speed;
+    t_first = std::max(t_first, std::min(t_lower, t_upper));
+    t_last = std::min(t_last, std::max(t_lower, t_upper));
+  }
+  return t_first <= t_last;
+}
+
 template<class FLOAT_TYPE, size_t N>  
 FLOAT_TYPE BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_edge_length(size_t edge) const {
   return edge_lengths[edge];
 }
   
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_collision_distance() const {
+  FLOAT_TYPE distance = 0.0;
+  for (size_t axis = 0u; axis < N; axis++) {
+    distance = std::max(distance, edge_lengths[axis]);
+  }
+  return distance;
+}
+  
+template<class FLOAT_TYPE, size_t N>  
+Vector<FLOAT_TYPE,N> BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_lower_bound() const {
+  return position;
+}
+
+template<class FLOAT_TYPE, size_t N>  
+Vector<FLOAT_TYPE,N> BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_upper_bound() const {
+  return position + edge_lengths;
+}
+
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_distance(Vector<FLOAT_TYPE,N> point) const {
+  Vector<FLOAT_TYPE,N> distance;
+  for (size_t axis = 0u; axis < N; axis++) {
+    distance[axis] = std::max<FLOAT_TYPE>( { 0.0, position[axis] - point[axis], point[axis] - position[axis] - edge_lengths[axis] } );
+  }
+  return distance.length();
+}
+
+template<class FLOAT_TYPE, size_t N>  
+FLOAT_TYPE BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::ray_intersection(const Ray<FLOAT_TYPE,N> & ray) const {
+  return ray_box_intersection(ray, position, position + edge_lengths, std::numeric_limits<FLOAT_TYPE>::infinity());
+}
+
 template<class FLOAT_TYPE, size_t N>  
 Vector<FLOAT_TYPE,N> BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::get_position() const {
   return position;
@@ -58,8 +194,6 @@ void BoundingVolumeHyperRectangle<FLOAT_TYPE,N>::set_position(Vector<FLOAT_TYPE,
 }
 
 
-template<class FLOAT_TYPE, size_t N, class BV> class Physics;
-
 template<class FLOAT_TYPE, size_t N, class BV>
 Body<FLOAT_TYPE, N, BV>::Body(
        BV bounding_volume,
@@ -69,17 +203,61 @@ Body<FLOAT_TYPE, N, BV>::Body(
        FLOAT_TYPE angle,
        std::function<void(Body<FLOAT_TYPE, N, BV> *, FLOAT_TYPE)> fix)
   : bounding(bounding_volume), velocity(velocity), max_velocity(max_velocity),
-    min_velocity(min_velocity), angle(angle)
+    min_velocity(min_velocity), angle(angle), previous_position(bounding_volume.get_position()), previous_angle(angle)
     {
       this->fix = fix;
-      delete_counter.set_time(0.0);
     }
+
+template<class FLOAT_TYPE, size_t N, class BV>
+Body<FLOAT_TYPE, N, BV>::~Body() {
+  if (clock != nullptr && delete_timer != TimerWheel< SimulationTime, std::function<void()> >::NO_TIMER) {
+    clock->timers.cancel(delete_timer);
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::set_clock(SimulationClock * clock) {
+  this->clock = clock;
+  birth_time = clock->time - age;
+  delete_time = birth_time + delete_time;
+  schedule_deletion();
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::schedule_deletion() {
+  if (clock == nullptr || ! deletable) {
+    return;
+  }
+  if (clock->defers_scheduling) {
+    deletion_is_deferred = true;
+    return;
+  }
+  if (delete_timer != TimerWheel< SimulationTime, std::function<void()> >::NO_TIMER) {
+    clock->timers.cancel(delete_timer);
+  }
+  delete_timer = clock->timers.schedule(delete_time, [this]() {
+    delete_timer = TimerWheel< SimulationTime, std::function<void()> >::NO_TIMER;
+    clock->no_of_expired_bodies++;
+  });
+}
  
 template<class FLOAT_TYPE, size_t N, class BV>
 void Body<FLOAT_TYPE, N, BV>::move(FLOAT_TYPE seconds) {
-  set_position( get_position() +  seconds * velocity);
-  delete_counter.tick(seconds);
-  fix(this, seconds);
+  move(seconds, fix);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+template<class F>
+void Body<FLOAT_TYPE, N, BV>::move(FLOAT_TYPE seconds, F && fix_body) {
+  Vector<FLOAT_TYPE, N> moved_position = get_position() +  seconds * velocity;
+  Vector<FLOAT_TYPE, N> moved_previous_position = previous_position;
+  bounding.set_position(moved_position);
+  if (clock == nullptr) {
+    age += seconds;
+  }
+  fix_body(this, seconds);
+  // the fix may have wrapped the position, the previous position is wrapped by the same offset
+  previous_position = moved_previous_position + (get_position() - moved_position);
 }
   
 // turns the Body in the x/y-Plane 
@@ -125,6 +303,55 @@ Vector<FLOAT_TYPE, N> Body<FLOAT_TYPE, N, BV>::get_position() const {
 template<class FLOAT_TYPE, size_t N, class BV>
 void Body<FLOAT_TYPE, N, BV>::set_position(Vector<FLOAT_TYPE,N> position) {
   bounding.set_position(position);
+  previous_position = position;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::save_transform() {
+  previous_position = get_position();
+  previous_angle = angle;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+Vector<FLOAT_TYPE,N> Body<FLOAT_TYPE, N, BV>::get_interpolated_position(FLOAT_TYPE alpha) const {
+  return previous_position + alpha * (get_position() - previous_position);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+FLOAT_TYPE Body<FLOAT_TYPE, N, BV>::get_interpolated_angle(FLOAT_TYPE alpha) const {
+  return previous_angle + alpha * (angle - previous_angle);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+Vector<FLOAT_TYPE,N> Body<FLOAT_TYPE, N, BV>::get_displacement() const {
+  return get_position() - previous_position;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::wrap(Vector<FLOAT_TYPE,N> world_size) {
+  Vector<FLOAT_TYPE, N> position = get_position();
+  Vector<FLOAT_TYPE, N> offset{};
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (world_size[axis] > 0.0) {
+      offset[axis] = -std::floor(position[axis] / world_size[axis]) * world_size[axis];
+    }
+  }
+  bounding.set_position(position + offset);
+  previous_position += offset;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::get_swept_bounds(Vector<FLOAT_TYPE,N> & lower, Vector<FLOAT_TYPE,N> & upper) const {
+  lower = bounding.get_lower_bound();
+  upper = bounding.get_upper_bound();
+  Vector<FLOAT_TYPE, N> displacement = get_displacement();
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (displacement[axis] > 0.0) {
+      lower[axis] -= displacement[axis];
+    } else {
+      upper[axis] -= displacement[axis];
+    }
+  }
 }
 
 
@@ -136,7 +363,7 @@ void Body<FLOAT_TYPE, N, BV>::mark_for_deletion() {
 
 template<class FLOAT_TYPE, size_t N, class BV>
 bool Body<FLOAT_TYPE, N, BV>::is_marked_for_deletion() const {
-  return deletable && delete_counter.get_time() <= 0.0;
+  return deletable && delete_time <= get_time();
 }
 
 template<class FLOAT_TYPE, size_t N, class BV>
@@ -148,12 +375,58 @@ template<class FLOAT_TYPE, size_t N, class BV>
 void Body<FLOAT_TYPE, N, BV>::set_time_to_delete(FLOAT_TYPE time_to_delete) {
   time_to_delete = std::max(time_to_delete, static_cast<FLOAT_TYPE>(0.0));
   this->deletable = true;
-  delete_counter.set_time(time_to_delete);
+  delete_time = get_time() + time_to_delete;
+  schedule_deletion();
 }
 
 template<class FLOAT_TYPE, size_t N, class BV>
 FLOAT_TYPE Body<FLOAT_TYPE, N, BV>::get_time_to_delete() const {
-  return delete_counter.get_time();
+  return deletable ? static_cast<FLOAT_TYPE>(delete_time - get_time()) : static_cast<FLOAT_TYPE>(0.0);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+typename Body<FLOAT_TYPE, N, BV>::State Body<FLOAT_TYPE, N, BV>::get_state() const {
+  return State{ bounding, velocity, previous_position, max_velocity, min_velocity, angle, previous_angle,
+                delete_time, age, birth_time, category, mask, deletable };
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::get_state(State & state) const {
+  state.bounding = bounding;
+  state.velocity = velocity;
+  state.previous_position = previous_position;
+  state.max_velocity = max_velocity;
+  state.min_velocity = min_velocity;
+  state.angle = angle;
+  state.previous_angle = previous_angle;
+  state.delete_time = delete_time;
+  state.age = age;
+  state.birth_time = birth_time;
+  state.category = category;
+  state.mask = mask;
+  state.deletable = deletable;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::set_state(const State & state) {
+  bounding = state.bounding;
+  velocity = state.velocity;
+  previous_position = state.previous_position;
+  max_velocity = state.max_velocity;
+  min_velocity = state.min_velocity;
+  angle = state.angle;
+  previous_angle = state.previous_angle;
+  delete_time = state.delete_time;
+  age = state.age;
+  birth_time = state.birth_time;
+  category = state.category;
+  mask = state.mask;
+  deletable = state.deletable;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+FLOAT_TYPE Body<FLOAT_TYPE, N, BV>::get_age() const {
+  return clock != nullptr ? static_cast<FLOAT_TYPE>(clock->time - birth_time) : age;
 }
 
 template<class FLOAT_TYPE, size_t N, class BV>
@@ -162,28 +435,365 @@ BV Body<FLOAT_TYPE, N, BV>::get_bounding_volume() const {
   return bounding;
 }
 
+template<class FLOAT_TYPE, size_t N, class BV>
+void Body<FLOAT_TYPE, N, BV>::set_collision_filter(std::uint32_t category, std::uint32_t mask) {
+  this->category = category;
+  this->mask = mask;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+std::uint32_t Body<FLOAT_TYPE, N, BV>::get_category() const {
+  return category;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+std::uint32_t Body<FLOAT_TYPE, N, BV>::get_mask() const {
+  return mask;
+}
+
 
 
 
 template<class FLOAT_TYPE, size_t N, class BV>
-Physics<FLOAT_TYPE, N, BV>::Physics( std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision,
-                                 std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision,
-                                 std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body )
-  : check_collision(check_collision), resolve_collision(resolve_collision), resolve_deleted_body(resolve_deleted_body) { }
+size_t BroadPhaseStrategy<FLOAT_TYPE, N, BV>::add(Body<FLOAT_TYPE, N, BV> * body) {
+  if (free_proxies.empty()) {
+    proxies.push_back(body);
+    // each proxy may be freed, so remove() never allocates
+    free_proxies.reserve(proxies.capacity());
+    return proxies.size() - 1;
+  }
+  size_t proxy = free_proxies.back();
+  free_proxies.pop_back();
+  proxies[proxy] = body;
+  return proxy;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void BroadPhaseStrategy<FLOAT_TYPE, N, BV>::remove(size_t proxy) {
+  proxies[proxy] = nullptr;
+  free_proxies.push_back(proxy);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void BroadPhaseStrategy<FLOAT_TYPE, N, BV>::find_pairs_parallel(Vector<FLOAT_TYPE, N> world_size, ThreadPool &,
+                                                                std::vector< std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > > & thread_pairs) {
+  find_pairs(world_size, thread_pairs[0]);
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void SpatialIndex<FLOAT_TYPE, N, BV>::build(const std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies, Vector<FLOAT_TYPE, N> world_size) {
+  this->world_size = world_size;
+  overhang = Vector<FLOAT_TYPE, N>{};
+  entries.clear();
+  for (auto & body : bodies) {
+    BV volume = body->get_bounding_volume();
+    entries.push_back( { volume.get_lower_bound(), volume.get_upper_bound(), body.get() } );
+    extend_overhang(world_size, entries.back().lower, entries.back().upper, overhang);
+  }
+  nodes.clear();
+  if ( !entries.empty() ) {
+    build_node(0, entries.size());
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+size_t SpatialIndex<FLOAT_TYPE, N, BV>::build_node(size_t begin, size_t end) {
+  size_t node = nodes.size();
+  nodes.push_back( Node{ entries[begin].lower, entries[begin].upper, begin, end } );
+  for (size_t i = begin + 1; i < end; i++) {
+    for (size_t axis = 0u; axis < N; axis++) {
+      nodes[node].lower[axis] = std::min(nodes[node].lower[axis], entries[i].lower[axis]);
+      nodes[node].upper[axis] = std::max(nodes[node].upper[axis], entries[i].upper[axis]);
+    }
+  }
+  if (end - begin <= MAX_LEAF_SIZE) {
+    return node;
+  }
+
+  size_t longest_axis = 0u;
+  for (size_t axis = 1u; axis < N; axis++) {
+    if (nodes[node].upper[axis] - nodes[node].lower[axis] > nodes[node].upper[longest_axis] - nodes[node].lower[longest_axis]) {
+      longest_axis = axis;
+    }
+  }
+  size_t middle = begin + (end - begin) / 2;
+  std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                   [longest_axis](const Entry & entry1, const Entry & entry2)
+                   { return entry1.lower[longest_axis] + entry1.upper[longest_axis] < entry2.lower[longest_axis] + entry2.upper[longest_axis]; });
+  size_t child1 = build_node(begin, middle);
+  size_t child2 = build_node(middle, end);
+  nodes[node].child1 = child1;
+  nodes[node].child2 = child2;
+  return node;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+FLOAT_TYPE SpatialIndex<FLOAT_TYPE, N, BV>::get_distance(Vector<FLOAT_TYPE, N> point, const Vector<FLOAT_TYPE, N> & lower, const Vector<FLOAT_TYPE, N> & upper) const {
+  FLOAT_TYPE square_of_distance = 0.0;
+  for (size_t axis = 0u; axis < N; axis++) {
+    FLOAT_TYPE distance = std::max<FLOAT_TYPE>( { 0.0, lower[axis] - point[axis], point[axis] - upper[axis] } );
+    if (world_size[axis] > 0.0) {
+      // the images of the box in the neighbouring tiles
+      for (FLOAT_TYPE offset : { world_size[axis], -world_size[axis] }) {
+        distance = std::min( distance, std::max<FLOAT_TYPE>( { 0.0, lower[axis] + offset - point[axis], point[axis] - upper[axis] - offset } ) );
+      }
+    }
+    square_of_distance += distance * distance;
+  }
+  return std::sqrt(square_of_distance);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+template<class F>
+bool SpatialIndex<FLOAT_TYPE, N, BV>::for_each_overlapping(Vector<FLOAT_TYPE, N> lower, Vector<FLOAT_TYPE, N> upper, F visit) {
+  if ( nodes.empty() ) {
+    return true;
+  }
+  bool go_on = true;
+  auto search = [this, &lower, &upper, &visit, &go_on](Vector<FLOAT_TYPE, N> offset) {
+    Vector<FLOAT_TYPE, N> image_lower = lower + offset;
+    Vector<FLOAT_TYPE, N> image_upper = upper + offset;
+    stack.clear();
+    stack.push_back(0);
+    while ( go_on && !stack.empty() ) {
+      const Node & node = nodes[stack.back()];
+      stack.pop_back();
+      if ( !overlaps<FLOAT_TYPE, N>(node.lower, node.upper, image_lower, image_upper) ) {
+        continue;
+      }
+      if (node.child1 == NO_NODE) {
+        for (size_t i = node.begin; go_on && i < node.end; i++) {
+          if ( overlaps<FLOAT_TYPE, N>(entries[i].lower, entries[i].upper, image_lower, image_upper) ) {
+            go_on = visit(entries[i].body);
+          }
+        }
+      } else {
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+      }
+    }
+  };
+  Vector<FLOAT_TYPE, N> images_overhang = overhang;
+  extend_overhang(world_size, lower, upper, images_overhang);
+  search( Vector<FLOAT_TYPE, N>{} );
+  for_each_image_offset(world_size, lower, upper, images_overhang, [&go_on, &search](Vector<FLOAT_TYPE, N> offset) {
+    if (go_on) {
+      search(offset);
+    }
+  });
+  return go_on;
+}
+
+// best first search: the nodes and entries are visited in the order of their distance to the point,
+// an entry is found when it is the nearest of all entries and nodes, that have not been visited yet
+template<class FLOAT_TYPE, size_t N, class BV>
+template<class F>
+void SpatialIndex<FLOAT_TYPE, N, BV>::find_nearest(Vector<FLOAT_TYPE, N> point, size_t k, F distance, std::vector< Body<FLOAT_TYPE, N, BV> * > & result) {
+  if ( nodes.empty() ) {
+    return;
+  }
+  // (distance, 2 * node) or (distance, 2 * entry + 1) in a min heap
+  auto nearer = std::greater< std::pair<FLOAT_TYPE, size_t> >();
+  queue.clear();
+  queue.push_back( { get_distance(point, nodes[0].lower, nodes[0].upper), 0u } );
+  size_t no_of_found = 0u;
+  while ( no_of_found < k && !queue.empty() ) {
+    std::pop_heap(queue.begin(), queue.end(), nearer);
+    size_t id = queue.back().second;
+    queue.pop_back();
+    if (id % 2 == 1) {
+      result.push_back(entries[id / 2].body);
+      no_of_found++;
+      continue;
+    }
+    const Node & node = nodes[id / 2];
+    if (node.child1 == NO_NODE) {
+      for (size_t i = node.begin; i < node.end; i++) {
+        FLOAT_TYPE entry_distance = distance(entries[i].body);
+        if (entry_distance != std::numeric_limits<FLOAT_TYPE>::infinity()) {
+          queue.push_back( { entry_distance, 2 * i + 1 } );
+          std::push_heap(queue.begin(), queue.end(), nearer);
+        }
+      }
+    } else {
+      for (size_t child : { node.child1, node.child2 }) {
+        queue.push_back( { get_distance(point, nodes[child].lower, nodes[child].upper), 2 * child } );
+        std::push_heap(queue.begin(), queue.end(), nearer);
+      }
+    }
+  }
+}
+
+// the ray is cut off at max_t, so only the images of its segment have to be tested
+template<class FLOAT_TYPE, size_t N, class BV>
+template<class F>
+Body<FLOAT_TYPE, N, BV> * SpatialIndex<FLOAT_TYPE, N, BV>::ray_cast(const Ray<FLOAT_TYPE, N> & ray, FLOAT_TYPE max_t, F intersection, FLOAT_TYPE & t) {
+  Body<FLOAT_TYPE, N, BV> * hit = nullptr;
+  if ( nodes.empty() ) {
+    return hit;
+  }
+  FLOAT_TYPE hit_t = max_t;
+  auto cast = [this, &ray, &intersection, &hit, &hit_t](Vector<FLOAT_TYPE, N> offset) {
+    Ray<FLOAT_TYPE, N> image{ ray.origin + offset, ray.direction };
+    stack.clear();
+    stack.push_back(0);
+    while ( !stack.empty() ) {
+      const Node & node = nodes[stack.back()];
+      stack.pop_back();
+      if ( ray_box_intersection(image, node.lower, node.upper, hit_t) < 0 ) {
+        continue;
+      }
+      if (node.child1 == NO_NODE) {
+        for (size_t i = node.begin; i < node.end; i++) {
+          FLOAT_TYPE entry_t = ray_box_intersection(image, entries[i].lower, entries[i].upper, hit_t);
+          if (entry_t >= 0) {
+            entry_t = intersection(entries[i].body, image);
+          }
+          if ( entry_t >= 0 && entry_t <= hit_t && (hit == nullptr || entry_t < hit_t) ) {
+            hit = entries[i].body;
+            hit_t = entry_t;
+          }
+        }
+      } else {
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+      }
+    }
+  };
+  Vector<FLOAT_TYPE, N> lower = ray.origin;
+  Vector<FLOAT_TYPE, N> upper = ray.origin;
+  for (size_t axis = 0u; axis < N; axis++) {
+    FLOAT_TYPE end = ray.origin[axis] + max_t * ray.direction[axis];
+    lower[axis] = std::min(lower[axis], end);
+    upper[axis] = std::max(upper[axis], end);
+  }
+  Vector<FLOAT_TYPE, N> images_overhang = overhang;
+  extend_overhang(world_size, lower, upper, images_overhang);
+  cast( Vector<FLOAT_TYPE, N>{} );
+  for_each_image_offset(world_size, lower, upper, images_overhang, cast);
+  if (hit != nullptr) {
+    t = hit_t;
+  }
+  return hit;
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV>
+FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>::FunctionPhysicsPolicy(
+       std::function<bool(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> check_collision,
+       std::function<void(Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *)> resolve_collision,
+       std::function<void(Body<FLOAT_TYPE, N, BV> *)> resolve_deleted_body )
+  : check_collision_callback(check_collision), resolve_collision_callback(resolve_collision),
+    resolve_deleted_body_callback(resolve_deleted_body) { }
+
+template<class FLOAT_TYPE, size_t N, class BV>
+bool FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>::check_collision(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2) {
+  return check_collision_callback(body1, body2);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>::resolve_collision(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2) {
+  resolve_collision_callback(body1, body2);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>::resolve_deleted_body(Body<FLOAT_TYPE, N, BV> * body) {
+  resolve_deleted_body_callback(body);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV>
+void FunctionPhysicsPolicy<FLOAT_TYPE, N, BV>::fix(Body<FLOAT_TYPE, N, BV> * body, FLOAT_TYPE seconds) {
+  body->fix(body, seconds);
+}
          
   
-template<class FLOAT_TYPE, size_t N, class BV>
-void Physics<FLOAT_TYPE, N, BV>::set_tick_time(FLOAT_TYPE tick_time) {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::set_tick_time(FLOAT_TYPE tick_time) {
   this->tick_time = tick_time;
 }   
 
-template<class FLOAT_TYPE, size_t N, class BV>
-FLOAT_TYPE Physics<FLOAT_TYPE, N, BV>::get_tick_time() {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+FLOAT_TYPE Physics<FLOAT_TYPE, N, BV, POLICY>::get_tick_time() const {
   return tick_time;
 }   
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::set_broad_phase(BroadPhase broad_phase) {
+  if (broad_phase != BroadPhase::custom) {
+    set_broad_phase( make_broad_phase<FLOAT_TYPE, N, BV>(broad_phase) );
+    this->broad_phase = broad_phase;
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::set_broad_phase(std::unique_ptr< BroadPhaseStrategy<FLOAT_TYPE, N, BV> > strategy) {
+  broad_phase_strategy = std::move(strategy);
+  broad_phase = BroadPhase::custom;
+  for (auto & body : bodies) {
+    add_to_broad_phase(body.get());
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::add_to_broad_phase(Body<FLOAT_TYPE, N, BV> * body) {
+  if (body->category != 0u && body->mask != 0u) {
+    body->proxy = broad_phase_strategy->add(body);
+  } else {
+    body->proxy = NO_PROXY;
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+BroadPhase Physics<FLOAT_TYPE, N, BV, POLICY>::get_broad_phase() const {
+  return broad_phase;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::set_no_of_threads(size_t no_of_threads) {
+  if (no_of_threads > 1u) {
+    thread_pool = std::make_unique<ThreadPool>(no_of_threads);
+  } else {
+    thread_pool.reset();
+  }
+  thread_pairs.resize(no_of_threads);
+  thread_indices.resize(no_of_threads);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+size_t Physics<FLOAT_TYPE, N, BV, POLICY>::get_no_of_threads() const {
+  return thread_pool ? thread_pool->get_no_of_threads() : 1u;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::set_world_size(Vector<FLOAT_TYPE, N> world_size) {
+  this->world_size = world_size;
+  spatial_index_is_valid = false;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+Vector<FLOAT_TYPE, N> Physics<FLOAT_TYPE, N, BV, POLICY>::get_world_size() const {
+  return world_size;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+Vector<FLOAT_TYPE, N> Physics<FLOAT_TYPE, N, BV, POLICY>::minimum_image(Vector<FLOAT_TYPE, N> difference) const {
+  for (size_t axis = 0u; axis < N; axis++) {
+    if (world_size[axis] > 0.0) {
+      difference[axis] -= std::round(difference[axis] / world_size[axis]) * world_size[axis];
+    }
+  }
+  return difference;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+BV Physics<FLOAT_TYPE, N, BV, POLICY>::nearest_image(BV volume, Vector<FLOAT_TYPE, N> position) const {
+  volume.set_position( position + minimum_image(volume.get_position() - position) );
+  return volume;
+}
   
-template<class FLOAT_TYPE, size_t N, class BV>
-void Physics<FLOAT_TYPE, N, BV>::add_body( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body ) {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::add_body( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body ) {
   if (body != nullptr) {
     if ( std::find( bodies.begin(), bodies.end(), body) == bodies.end() ) {
       bodies_to_add.push_back( std::move(body) );
@@ -196,75 +806,606 @@ void Physics<FLOAT_TYPE, N, BV>::add_body( std::unique_ptr< Body<FLOAT_TYPE, N,
 }
 
 
-template<class FLOAT_TYPE, size_t N, class BV>
-Body<FLOAT_TYPE, N, BV> * Physics<FLOAT_TYPE, N, BV>::get_body(size_t i) {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+Body<FLOAT_TYPE, N, BV> * Physics<FLOAT_TYPE, N, BV, POLICY>::get_body(size_t i) {
   return bodies[i].get();
 }
 
-template<class FLOAT_TYPE, size_t N, class BV>
-const std::vector< std::unique_ptr<Body<FLOAT_TYPE, N, BV> > > & Physics<FLOAT_TYPE, N, BV>::get_bodies() {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+const std::vector< std::unique_ptr<Body<FLOAT_TYPE, N, BV> > > & Physics<FLOAT_TYPE, N, BV, POLICY>::get_bodies() const {
   return bodies;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+const std::vector< std::unique_ptr<Body<FLOAT_TYPE, N, BV> > > & Physics<FLOAT_TYPE, N, BV, POLICY>::get_bodies_to_add() const {
+  return bodies_to_add;
 }  
 
-template<class FLOAT_TYPE, size_t N, class BV>
-bool Physics<FLOAT_TYPE, N, BV>::is_area_free_of_bodies(BV * area, std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body) {
-  for (auto & body : bodies) {
-    if ( check_body(body.get()) && body->bounding.collides(*area) ) {
-      return false;
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+bool Physics<FLOAT_TYPE, N, BV, POLICY>::is_area_free_of_bodies(BV * area, std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body) {
+  update_spatial_index();
+  return spatial_index.for_each_overlapping(area->get_lower_bound(), area->get_upper_bound(), [this, area, &check_body](Body<FLOAT_TYPE, N, BV> * body) -> bool {
+    return ! ( check_body(body) && nearest_image(body->bounding, area->get_position()).collides(*area) );
+  });
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::query_radius(Vector<FLOAT_TYPE, N> point, FLOAT_TYPE radius, std::vector< Body<FLOAT_TYPE, N, BV> * > & result,
+                                              std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body) {
+  update_spatial_index();
+  Vector<FLOAT_TYPE, N> lower = point;
+  Vector<FLOAT_TYPE, N> upper = point;
+  for (size_t axis = 0u; axis < N; axis++) {
+    lower[axis] -= radius;
+    upper[axis] += radius;
+  }
+  query_result.clear();
+  spatial_index.for_each_overlapping(lower, upper, [this, point, radius, &check_body](Body<FLOAT_TYPE, N, BV> * body) -> bool {
+    if ( check_body(body) && nearest_image(body->bounding, point).get_distance(point) <= radius ) {
+      query_result.push_back(body);
     }
+    return true;
+  });
+  std::sort(query_result.begin(), query_result.end(),
+            [](Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2) { return body1->index < body2->index; });
+  auto last = std::unique(query_result.begin(), query_result.end());
+  result.insert(result.end(), query_result.begin(), last);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::query_nearest(Vector<FLOAT_TYPE, N> point, size_t k, std::vector< Body<FLOAT_TYPE, N, BV> * > & result,
+                                               std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body) {
+  update_spatial_index();
+  spatial_index.find_nearest(point, k, [this, point, &check_body](Body<FLOAT_TYPE, N, BV> * body) -> FLOAT_TYPE {
+    if ( !check_body(body) ) {
+      return std::numeric_limits<FLOAT_TYPE>::infinity();
+    }
+    return nearest_image(body->bounding, point).get_distance(point);
+  }, result);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+Body<FLOAT_TYPE, N, BV> * Physics<FLOAT_TYPE, N, BV, POLICY>::ray_cast(const Ray<FLOAT_TYPE, N> & ray, FLOAT_TYPE max_t, FLOAT_TYPE & t,
+                                                               std::function<bool(Body<FLOAT_TYPE, N, BV> *)> check_body) {
+  update_spatial_index();
+  return spatial_index.ray_cast(ray, max_t, [&check_body](Body<FLOAT_TYPE, N, BV> * body, const Ray<FLOAT_TYPE, N> & ray) -> FLOAT_TYPE {
+    return check_body(body) ? body->bounding.ray_intersection(ray) : -1;
+  }, t);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::update_spatial_index() {
+  if (!spatial_index_is_valid) {
+    for (size_t i = 0; i < bodies.size(); i++) {
+      bodies[i]->index = i;
+    }
+    spatial_index.build(bodies, world_size);
+    spatial_index_is_valid = true;
   }
-  return true;
 }
 
-template<class FLOAT_TYPE, size_t N, class BV>
-std::vector< Body<FLOAT_TYPE, N, BV> * > & Physics<FLOAT_TYPE, N, BV>::get_recently_added_bodies() {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+const std::vector< Body<FLOAT_TYPE, N, BV> * > & Physics<FLOAT_TYPE, N, BV, POLICY>::get_recently_added_bodies() const {
   return recently_added_bodies;
 }
 
 
-template<class FLOAT_TYPE, size_t N, class BV>
-void Physics<FLOAT_TYPE, N, BV>::tick() {
-  Physics<FLOAT_TYPE, N, BV>::tick(tick_time);
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+size_t Physics<FLOAT_TYPE, N, BV, POLICY>::get_no_of_ticks() const {
+  return no_of_ticks;
 }
 
-template<class FLOAT_TYPE, size_t N, class BV>
-void Physics<FLOAT_TYPE, N, BV>::tick(FLOAT_TYPE tick_time) {
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+SimulationTime Physics<FLOAT_TYPE, N, BV, POLICY>::get_time() const {
+  return clock.time;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+size_t Physics<FLOAT_TYPE, N, BV, POLICY>::add_timer(SimulationTime deadline, std::function<void()> callback) {
+  return clock.timers.schedule(deadline, std::move(callback));
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::cancel_timer(size_t timer) {
+  clock.timers.cancel(timer);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+SimulationTime Physics<FLOAT_TYPE, N, BV, POLICY>::get_timer_deadline(size_t timer) const {
+  return clock.timers.get_deadline(timer);
+}
+
+// the order of the proxies in the broad phase differs from the original engine, but the collisions do not depend on it
+// (see find_collisions()), neither do the timers depend on the order they have been scheduled in: the timers of
+// bodies only count the expired bodies, and a Game restores its own timers after the bodies
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::restore(SimulationTime time, FLOAT_TYPE tick_time, size_t no_of_ticks,
+                                                 std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies,
+                                                 std::vector< std::unique_ptr< Body<FLOAT_TYPE, N, BV> > > & bodies_to_add,
+                                                 const std::vector<size_t> & recently_added) {
+  for (auto & body : this->bodies) {
+    if (body->proxy != NO_PROXY) {
+      broad_phase_strategy->remove(body->proxy);
+    }
+  }
+  this->bodies.clear();
+  this->bodies_to_add.clear();
+  clock.timers.clear(time);
+  clock.time = time;
+  clock.no_of_expired_bodies = 0;
+  this->tick_time = tick_time;
+  this->no_of_ticks = no_of_ticks;
+
+  for (auto & body : bodies) {
+    body->clock = &clock;
+    body->schedule_deletion();
+    add_to_broad_phase(body.get());
+    this->bodies.push_back( std::move(body) );
+  }
+  for (auto & body : bodies_to_add) {
+    this->bodies_to_add.push_back( std::move(body) );
+  }
+  recently_added_bodies.clear();
+  for (size_t index : recently_added) {
+    recently_added_bodies.push_back( this->bodies[index].get() );
+  }
+  spatial_index_is_valid = false;
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::advance_timers() {
+  clock.timers.advance(clock.time, [](std::function<void()> & callback) { callback(); });
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::tick() {
+  Physics<FLOAT_TYPE, N, BV, POLICY>::tick(tick_time);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::tick(FLOAT_TYPE tick_time) {
   debug(3, "tick() entry...")
+  trace_zone("Physics::tick");
   set_tick_time(tick_time);
-  std::vector< std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *> > bodies_to_resolve;
+  no_of_ticks++;
+  bodies_to_resolve.clear();
   
-  erase_if(bodies_to_add, [this]( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body) 
-   { if (body->is_marked_for_deletion()) { resolve_deleted_body(body.get()); return true;} else {return false;}}); 
+  {
+    trace_zone("Physics::tick add");
+    erase_if(bodies_to_add, [this]( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body) 
+     { if (body->is_marked_for_deletion()) { policy.resolve_deleted_body(body.get()); return true;} else {return false;}}); 
 
-  recently_added_bodies.clear();
-  for (auto & body : bodies_to_add ) {
-    recently_added_bodies.push_back(body.get()); 
-    bodies.push_back( std::move(body) );
-  }
+    recently_added_bodies.clear();
+    for (auto & body : bodies_to_add ) {
+      recently_added_bodies.push_back(body.get()); 
+      body->set_clock(&clock);
+      add_to_broad_phase(body.get());
+      bodies.push_back( std::move(body) );
+    }
 
-  bodies_to_add.clear();
+    bodies_to_add.clear();
+    spatial_index_is_valid = false;
+  }
 
-  erase_if(bodies, [this]( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body) 
-   { if (body->is_marked_for_deletion()) { resolve_deleted_body(body.get()); return true;} else {return false;}}); 
+  // bodies may have been marked for deletion since the last tick
+  advance_timers();
+  if (clock.no_of_expired_bodies > 0) {
+    trace_zone("Physics::tick delete");
+    clock.no_of_expired_bodies = 0;
+    erase_if(bodies, [this]( std::unique_ptr< Body<FLOAT_TYPE, N, BV> > & body) {
+      if (! body->is_marked_for_deletion()) {
+        return false;
+      }
+      if (body->proxy != NO_PROXY) {
+        broad_phase_strategy->remove(body->proxy);
+      }
+      policy.resolve_deleted_body(body.get());
+      return true;
+    });
+    spatial_index_is_valid = false;
+  }
 
-  for (auto & body : bodies) {
-    body->move(tick_time);
+  {
+    trace_zone("Physics::tick move");
+    clock.time += tick_time;
+    if (thread_pool) {
+      // the timer wheel is shared, so the threads only record the times of deletion set by the fix
+      clock.defers_scheduling = true;
+      thread_pool->run(bodies.size(), [this](size_t, size_t begin, size_t end) { move_bodies(begin, end); });
+      clock.defers_scheduling = false;
+      for (auto & body : bodies) {
+        if (body->deletion_is_deferred) {
+          body->deletion_is_deferred = false;
+          body->schedule_deletion();
+        }
+      }
+    } else {
+      move_bodies(0, bodies.size());
+    }
+    spatial_index_is_valid = false;
   }
    
-  for (auto iterator1 = bodies.begin(); iterator1 != bodies.end(); iterator1++ ) {
-    for (auto iterator2 = iterator1 + 1; iterator2 != bodies.end(); iterator2++) {
-      if ( (*iterator1)->bounding.collides( (*iterator2)->bounding)   ) {
-        if (check_collision( (*iterator1).get(), (*iterator2).get()) ) {
-          bodies_to_resolve.push_back( std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *>( (*iterator1).get(), (*iterator2).get()) );
+  {
+    trace_zone("Physics::tick broad phase");
+    find_collisions();
+  }
+
+  {
+    trace_zone("Physics::tick resolve");
+    for (auto pair : bodies_to_resolve) {
+      policy.resolve_collision(pair.first, pair.second);
+    }    
+    spatial_index_is_valid = false;
+  }
+
+  {
+    trace_zone("Physics::tick timers");
+    advance_timers();
+  }
+
+  debug(3, "tick() exit."); 
+}
+
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+bool Physics<FLOAT_TYPE, N, BV, POLICY>::collides(Body<FLOAT_TYPE, N, BV> * body1, Body<FLOAT_TYPE, N, BV> * body2) const {
+  BV volume2 = nearest_image(body2->bounding, body1->get_position());
+  Vector<FLOAT_TYPE, N> displacement1 = body1->get_displacement();
+  Vector<FLOAT_TYPE, N> displacement2 = body2->get_displacement();
+  FLOAT_TYPE half_distance1 = body1->bounding.get_collision_distance() / 2;
+  FLOAT_TYPE half_distance2 = body2->bounding.get_collision_distance() / 2;
+  if ( displacement1.square_of_length() > half_distance1 * half_distance1
+       || displacement2.square_of_length() > half_distance2 * half_distance2 ) {
+    return body1->bounding.collides(volume2, displacement1, displacement2);
+  }
+  return body1->bounding.collides(volume2);
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::move_bodies(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    Body<FLOAT_TYPE, N, BV> * body = bodies[i].get();
+    body->save_transform();
+    body->move(tick_time, [this](Body<FLOAT_TYPE, N, BV> * body, FLOAT_TYPE seconds) { policy.fix(body, seconds); });
+    body->wrap(world_size);
+  }
+}
+
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::filter_candidates(size_t begin, size_t end, std::vector< std::pair<size_t, size_t> > & indices) const {
+  for (size_t i = begin; i < end; i++) {
+    auto pair = candidate_pairs[i];
+    size_t index1 = pair.first->index;
+    size_t index2 = pair.second->index;
+    if (index1 != index2 && pair.first->can_collide(*pair.second) && collides(pair.first, pair.second)) {
+      indices.push_back( { std::min(index1, index2), std::max(index1, index2) } );
+    }
+  }
+}
+
+// the broad phase may find a pair more than once and in any order, the colliding pairs are sorted by the
+// indices of their bodies, so all broad phases and all numbers of threads resolve the same collisions in the same order
+template<class FLOAT_TYPE, size_t N, class BV, class POLICY>
+void Physics<FLOAT_TYPE, N, BV, POLICY>::find_collisions() {
+  for (size_t i = 0; i < bodies.size(); i++) {
+    bodies[i]->index = i;
+  }
+  candidate_pairs.clear();
+  candidate_indices.clear();
+  if (thread_pool) {
+    for (auto & pairs : thread_pairs) {
+      pairs.clear();
+    }
+    broad_phase_strategy->find_pairs_parallel(world_size, *thread_pool, thread_pairs);
+    for (auto & pairs : thread_pairs) {
+      candidate_pairs.insert(candidate_pairs.end(), pairs.begin(), pairs.end());
+    }
+    for (auto & indices : thread_indices) {
+      indices.clear();
+    }
+    thread_pool->run(candidate_pairs.size(), [this](size_t thread, size_t begin, size_t end)
+      { filter_candidates(begin, end, thread_indices[thread]); });
+    for (auto & indices : thread_indices) {
+      candidate_indices.insert(candidate_indices.end(), indices.begin(), indices.end());
+    }
+  } else {
+    broad_phase_strategy->find_pairs(world_size, candidate_pairs);
+    filter_candidates(0, candidate_pairs.size(), candidate_indices);
+  }
+  std::sort(candidate_indices.begin(), candidate_indices.end());
+  auto last = std::unique(candidate_indices.begin(), candidate_indices.end());
+
+  for (auto pair = candidate_indices.begin(); pair != last; pair++) {
+    Body<FLOAT_TYPE, N, BV> * body1 = bodies[pair->first].get();
+    Body<FLOAT_TYPE, N, BV> * body2 = bodies[pair->second].get();
+    if ( policy.check_collision(body1, body2) ) {
+      bodies_to_resolve.push_back( std::pair<Body<FLOAT_TYPE, N, BV> *, Body<FLOAT_TYPE, N, BV> *>(body1, body2) );
+    }
+  }
+}
+
+template<class FLOAT_TYPE, size_t N>
+DenseBody<FLOAT_TYPE, N>::DenseBody(DensePhysics<FLOAT_TYPE, N> * physics, BodyHandle handle)
+  : physics(physics), handle(handle) { }
+
+template<class FLOAT_TYPE, size_t N>
+BodyHandle DenseBody<FLOAT_TYPE, N>::get_handle() const {
+  return handle;
+}
+
+template<class FLOAT_TYPE, size_t N>
+Vector<FLOAT_TYPE, N> DenseBody<FLOAT_TYPE, N>::get_position() const {
+  Vector<FLOAT_TYPE, N> position;
+  std::uint32_t slot = physics->slots[handle];
+  for (size_t axis = 0u; axis < N; axis++) {
+    position[axis] = physics->positions[axis][slot];
+  }
+  return position;
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DenseBody<FLOAT_TYPE, N>::set_position(Vector<FLOAT_TYPE, N> position) {
+  std::uint32_t slot = physics->slots[handle];
+  for (size_t axis = 0u; axis < N; axis++) {
+    physics->positions[axis][slot] = position[axis];
+  }
+}
+
+template<class FLOAT_TYPE, size_t N>
+Vector<FLOAT_TYPE, N> DenseBody<FLOAT_TYPE, N>::get_velocity() const {
+  Vector<FLOAT_TYPE, N> velocity;
+  std::uint32_t slot = physics->slots[handle];
+  for (size_t axis = 0u; axis < N; axis++) {
+    velocity[axis] = physics->velocities[axis][slot];
+  }
+  return velocity;
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DenseBody<FLOAT_TYPE, N>::set_velocity(Vector<FLOAT_TYPE, N> velocity) {
+  std::uint32_t slot = physics->slots[handle];
+  for (size_t axis = 0u; axis < N; axis++) {
+    physics->velocities[axis][slot] = velocity[axis];
+  }
+}
+
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE DenseBody<FLOAT_TYPE, N>::get_radius() const {
+  return physics->radii[ physics->slots[handle] ];
+}
+
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE DenseBody<FLOAT_TYPE, N>::get_angle() const {
+  return physics->angles[ physics->slots[handle] ];
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DenseBody<FLOAT_TYPE, N>::turn(FLOAT_TYPE angle, FLOAT_TYPE seconds) {
+  physics->angles[ physics->slots[handle] ] += seconds * angle;
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DenseBody<FLOAT_TYPE, N>::set_time_to_delete(FLOAT_TYPE time_to_delete) {
+  time_to_delete = std::max(time_to_delete, static_cast<FLOAT_TYPE>(0.0));
+  physics->delete_deadlines[ physics->slots[handle] ] = physics->time + time_to_delete;
+}
+
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE DenseBody<FLOAT_TYPE, N>::get_time_to_delete() const {
+  return static_cast<FLOAT_TYPE>(physics->delete_deadlines[ physics->slots[handle] ] - physics->time);
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DenseBody<FLOAT_TYPE, N>::mark_for_deletion() {
+  set_time_to_delete(0.0);
+}
+
+template<class FLOAT_TYPE, size_t N>
+bool DenseBody<FLOAT_TYPE, N>::is_marked_for_deletion() const {
+  return physics->delete_deadlines[ physics->slots[handle] ] <= physics->time;
+}
+
+
+
+template<class FLOAT_TYPE, size_t N>
+DensePhysics<FLOAT_TYPE, N>::DensePhysics( std::function<bool(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> check_collision,
+                                           std::function<void(DenseBody<FLOAT_TYPE, N>, DenseBody<FLOAT_TYPE, N>)> resolve_collision,
+                                           std::function<void(DenseBody<FLOAT_TYPE, N>)> resolve_deleted_body )
+  : check_collision(check_collision), resolve_collision(resolve_collision), resolve_deleted_body(resolve_deleted_body) { }
+
+template<class FLOAT_TYPE, size_t N>
+BodyHandle DensePhysics<FLOAT_TYPE, N>::add_body(Vector<FLOAT_TYPE, N> position, FLOAT_TYPE radius, Vector<FLOAT_TYPE, N> velocity, FLOAT_TYPE angle) {
+  BodyHandle handle;
+  if (free_handles.empty()) {
+    handle = static_cast<BodyHandle>( slots.size() );
+    slots.push_back(NO_SLOT);
+  } else {
+    handle = free_handles.back();
+    free_handles.pop_back();
+  }
+  slots[handle] = static_cast<std::uint32_t>( handles.size() );
+  for (size_t axis = 0u; axis < N; axis++) {
+    positions[axis].push_back(position[axis]);
+    velocities[axis].push_back(velocity[axis]);
+  }
+  radii.push_back(radius);
+  angles.push_back(angle);
+  delete_deadlines.push_back( std::numeric_limits<SimulationTime>::infinity() );
+  handles.push_back(handle);
+  return handle;
+}
+
+template<class FLOAT_TYPE, size_t N>
+DenseBody<FLOAT_TYPE, N> DensePhysics<FLOAT_TYPE, N>::get_body(BodyHandle handle) {
+  assert( contains(handle) );
+  return DenseBody<FLOAT_TYPE, N>(this, handle);
+}
+
+template<class FLOAT_TYPE, size_t N>
+bool DensePhysics<FLOAT_TYPE, N>::contains(BodyHandle handle) const {
+  return handle < slots.size() && slots[handle] != NO_SLOT;
+}
+
+template<class FLOAT_TYPE, size_t N>
+size_t DensePhysics<FLOAT_TYPE, N>::size() const {
+  return handles.size();
+}
+
+template<class FLOAT_TYPE, size_t N>
+FLOAT_TYPE DensePhysics<FLOAT_TYPE, N>::get_tick_time() const {
+  return tick_time;
+}
+
+// compacts the arrays and keeps the order of the remaining bodies
+template<class FLOAT_TYPE, size_t N>
+void DensePhysics<FLOAT_TYPE, N>::delete_bodies() {
+  size_t size = handles.size();
+  size_t kept = 0u;
+  for (size_t i = 0u; i < size; i++) {
+    if (delete_deadlines[i] <= time) {
+      resolve_deleted_body( DenseBody<FLOAT_TYPE, N>(this, handles[i]) );
+    }
+  }
+  for (size_t i = 0u; i < size; i++) {
+    if (delete_deadlines[i] <= time) {
+      slots[ handles[i] ] = NO_SLOT;
+      free_handles.push_back( handles[i] );
+      continue;
+    }
+    if (kept != i) {
+      for (size_t axis = 0u; axis < N; axis++) {
+        positions[axis][kept] = positions[axis][i];
+        velocities[axis][kept] = velocities[axis][i];
+      }
+      radii[kept] = radii[i];
+      angles[kept] = angles[i];
+      delete_deadlines[kept] = delete_deadlines[i];
+      handles[kept] = handles[i];
+      slots[ handles[kept] ] = static_cast<std::uint32_t>(kept);
+    }
+    kept++;
+  }
+  for (size_t axis = 0u; axis < N; axis++) {
+    positions[axis].resize(kept);
+    velocities[axis].resize(kept);
+  }
+  radii.resize(kept);
+  angles.resize(kept);
+  delete_deadlines.resize(kept);
+  handles.resize(kept);
+}
+
+// uses the same uniform grid and the same swept test for fast bodies as Physics with BroadPhase::spatial_grid,
+// the displacement of a body during the tick is tick_time * velocity
+template<class FLOAT_TYPE, size_t N>
+void DensePhysics<FLOAT_TYPE, N>::find_collisions() {
+  const size_t size = handles.size();
+  FLOAT_TYPE cell_size = 0.0;
+  for (size_t i = 0u; i < size; i++) {
+    FLOAT_TYPE square_speed = 0.0;
+    for (size_t axis = 0u; axis < N; axis++) {
+      square_speed += velocities[axis][i] * velocities[axis][i];
+    }
+    cell_size = std::max(cell_size, 2 * radii[i] + 2 * tick_time * std::sqrt(square_speed));
+  }
+  if ( ! (cell_size > 0.0) ) {
+    cell_size = 1.0;
+  }
+
+  grid_cells.resize(size);
+  for (size_t i = 0u; i < size; i++) {
+    std::array<std::int64_t, N> cell;
+    for (size_t axis = 0u; axis < N; axis++) {
+      cell[axis] = static_cast<std::int64_t>( std::floor(positions[axis][i] / cell_size) );
+    }
+    grid_cells[i] = { grid_cell_key<N>(cell), static_cast<std::uint32_t>(i) };
+  }
+  std::sort(grid_cells.begin(), grid_cells.end());
+
+  size_t no_of_neighbours = 1u;
+  for (size_t axis = 0u; axis < N; axis++) {
+    no_of_neighbours *= 3u;
+  }
+
+  for (size_t i = 0u; i < size; i++) {
+    std::array<std::int64_t, N> cell;
+    for (size_t axis = 0u; axis < N; axis++) {
+      cell[axis] = static_cast<std::int64_t>( std::floor(positions[axis][i] / cell_size) );
+    }
+    grid_candidates.clear();
+    for (size_t neighbour = 0u; neighbour < no_of_neighbours; neighbour++) {
+      std::array<std::int64_t, N> neighbour_cell = cell;
+      for (size_t axis = 0u, offsets = neighbour; axis < N; axis++, offsets /= 3u) {
+        neighbour_cell[axis] += static_cast<std::int64_t>(offsets % 3u) - 1;
+      }
+      std::uint64_t key = grid_cell_key<N>(neighbour_cell);
+      auto entry = std::lower_bound(grid_cells.begin(), grid_cells.end(), std::pair<std::uint64_t, std::uint32_t>(key, 0u) );
+      for (; entry != grid_cells.end() && entry->first == key; entry++) {
+        if (entry->second > i) {
+          grid_candidates.push_back(entry->second);
         }
       }
     }
+    std::sort(grid_candidates.begin(), grid_candidates.end());
+    auto last = std::unique(grid_candidates.begin(), grid_candidates.end());
+
+    for (auto candidate = grid_candidates.begin(); candidate != last; candidate++) {
+      std::uint32_t j = *candidate;
+      FLOAT_TYPE square_distance = 0.0;
+      for (size_t axis = 0u; axis < N; axis++) {
+        FLOAT_TYPE difference = positions[axis][i] - positions[axis][j];
+        square_distance += difference * difference;
+      }
+      FLOAT_TYPE radius_sum = radii[i] + radii[j];
+      bool collision = square_distance <= radius_sum * radius_sum;
+      if ( ! collision && (is_fast(i) || is_fast(j)) ) {
+        Vector<FLOAT_TYPE, N> position_i, position_j, displacement_i, displacement_j;
+        for (size_t axis = 0u; axis < N; axis++) {
+          displacement_i[axis] = tick_time * velocities[axis][i];
+          displacement_j[axis] = tick_time * velocities[axis][j];
+          position_i[axis] = positions[axis][i] - displacement_i[axis];
+          position_j[axis] = positions[axis][j] - displacement_j[axis];
+        }
+        collision = Sphere<FLOAT_TYPE, N>{position_i, radii[i]}.time_of_impact( Sphere<FLOAT_TYPE, N>{position_j, radii[j]}, displacement_i, displacement_j ) >= 0;
+      }
+      if ( collision
+           && check_collision( DenseBody<FLOAT_TYPE, N>(this, handles[i]), DenseBody<FLOAT_TYPE, N>(this, handles[j]) ) ) {
+        bodies_to_resolve.push_back( { handles[i], handles[j] } );
+      }
+    }
   }
+}
 
-  for (auto pair : bodies_to_resolve) {
-    resolve_collision(pair.first, pair.second);
-  }    
+template<class FLOAT_TYPE, size_t N>
+bool DensePhysics<FLOAT_TYPE, N>::is_fast(size_t i) const {
+  FLOAT_TYPE square_displacement = 0.0;
+  for (size_t axis = 0u; axis < N; axis++) {
+    square_displacement += tick_time * tick_time * velocities[axis][i] * velocities[axis][i];
+  }
+  return square_displacement > radii[i] * radii[i];
+}
+
+template<class FLOAT_TYPE, size_t N>
+void DensePhysics<FLOAT_TYPE, N>::tick(FLOAT_TYPE tick_time) {
+  debug(3, "tick() entry...")
+  this->tick_time = tick_time;
+
+  delete_bodies();
 
+  const size_t size = handles.size();
+  for (size_t axis = 0u; axis < N; axis++) {
+    FLOAT_TYPE * position = positions[axis].data();
+    const FLOAT_TYPE * velocity = velocities[axis].data();
+    for (size_t i = 0u; i < size; i++) {
+      position[i] += tick_time * velocity[i];
+    }
+  }
+  time += tick_time;
+
+  bodies_to_resolve.clear();
+  find_collisions();
+  for (auto pair : bodies_to_resolve) {
+    resolve_collision( DenseBody<FLOAT_TYPE, N>(this, pair.first), DenseBody<FLOAT_TYPE, N>(this, pair.second) );
+  }
   debug(3, "tick() exit."); 
 }
-
@@ -0,0 +1,255 @@
+#include "physics.h"
+#include "physics.tcc"
+#include "broad_phase.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <memory>
+
+// compares the ticks per second of Physics (array of Body objects) and DensePhysics (structure of arrays)
+// both engines use the spatial grid, because brute force collision detection does not scale to 100k bodies
+// then compares the broad phases of Physics on workloads with bodies of similar and of different sizes and with clustered bodies
+// and measures the spatial queries of Physics
+// finally compares the ticks per second of Physics with std::function callbacks and with a policy resolved at compile time
+
+namespace {
+
+constexpr float TICK_TIME = 1.0f / 60.0f;
+
+struct Scenario {
+  size_t no_of_bodies;
+  size_t no_of_ticks;
+  float world_size;    // the bodies are spread uniformly over a square with this edge length
+};
+
+template<class F>
+double ticks_per_second(size_t no_of_ticks, F tick) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < no_of_ticks; i++) {
+    tick();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return no_of_ticks / elapsed.count();
+}
+
+double physics_ticks_per_second(const Scenario & scenario) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> position(0.0f, scenario.world_size);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(1.0f, 33.0f);
+  Physics2df physics{};
+  physics.set_broad_phase(BroadPhase::spatial_grid);
+  for (size_t i = 0; i < scenario.no_of_bodies; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, radius(gen)},
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    physics.add_body(body);
+  }
+  physics.tick(TICK_TIME);
+  return ticks_per_second(scenario.no_of_ticks, [&]() { physics.tick(TICK_TIME); });
+}
+
+double dense_physics_ticks_per_second(const Scenario & scenario) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> position(0.0f, scenario.world_size);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(1.0f, 33.0f);
+  DensePhysics2df physics{};
+  for (size_t i = 0; i < scenario.no_of_bodies; i++) {
+    Vector2df p{position(gen), position(gen)};
+    float r = radius(gen);
+    physics.add_body(p, r, Vector2df{velocity(gen), velocity(gen)});
+  }
+  physics.tick(TICK_TIME);
+  return ticks_per_second(scenario.no_of_ticks, [&]() { physics.tick(TICK_TIME); });
+}
+
+// a workload of the broad phase benchmark on a torus with the given world size
+struct Workload {
+  const char * name;
+  size_t no_of_bodies;
+  size_t no_of_ticks;
+  float world_size;
+  std::function<float(std::mt19937 &)> radius;
+  size_t no_of_clusters;  // 0 to spread the bodies uniformly
+};
+
+double broad_phase_ticks_per_second(const Workload & workload, BroadPhase broad_phase) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> position(0.0f, workload.world_size);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::normal_distribution<float> cluster_offset(0.0f, workload.world_size / 50.0f);
+  std::vector<Vector2df> clusters;
+  for (size_t i = 0; i < workload.no_of_clusters; i++) {
+    clusters.push_back( {position(gen), position(gen)} );
+  }
+  Physics2df physics{};
+  physics.set_broad_phase(broad_phase);
+  physics.set_world_size( {workload.world_size, workload.world_size} );
+  for (size_t i = 0; i < workload.no_of_bodies; i++) {
+    Vector2df p = clusters.empty() ? Vector2df{position(gen), position(gen)}
+                                   : clusters[i % clusters.size()] + Vector2df{cluster_offset(gen), cluster_offset(gen)};
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ p, workload.radius(gen) },
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    physics.add_body(body);
+  }
+  physics.tick(TICK_TIME);
+  return ticks_per_second(workload.no_of_ticks, [&]() { physics.tick(TICK_TIME); });
+}
+
+// measures the queries per second of the given query between two ticks, the first query rebuilds the spatial index
+template<class F>
+double queries_per_second(const Scenario & scenario, F query) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> position(0.0f, scenario.world_size);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(1.0f, 33.0f);
+  Physics2df physics{};
+  physics.set_broad_phase(BroadPhase::spatial_grid);
+  physics.set_world_size( {scenario.world_size, scenario.world_size} );
+  for (size_t i = 0; i < scenario.no_of_bodies; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, radius(gen)},
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    physics.add_body(body);
+  }
+  physics.tick(TICK_TIME);
+  const size_t no_of_queries = 10000u;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < no_of_queries; i++) {
+    query(physics, Vector2df{position(gen), position(gen)});
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return no_of_queries / elapsed.count();
+}
+
+// counts the collisions and turns each body after its movement, the same logic as the callbacks of policy_ticks_per_second()
+struct CountingPolicy {
+  size_t * no_of_collisions;
+
+  bool check_collision(Body2df * body1, Body2df * body2) {
+    return body1->get_angle() <= body2->get_angle();
+  }
+
+  void resolve_collision(Body2df *, Body2df *) {
+    (*no_of_collisions)++;
+  }
+
+  void resolve_deleted_body(Body2df *) { }
+
+  void fix(Body2df * body, float seconds) {
+    body->turn(1.0f, seconds);
+  }
+};
+
+// returns the ticks per second of Physics2df with std::function callbacks (first) and of a Physics with the CountingPolicy (second)
+std::pair<double, double> policy_ticks_per_second(const Scenario & scenario) {
+  auto fill = [&scenario](auto & physics, std::function<void(Body2df *, float)> fix) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> position(0.0f, scenario.world_size);
+    std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> radius(1.0f, 33.0f);
+    physics.set_broad_phase(BroadPhase::sweep_and_prune);
+    physics.set_world_size( {scenario.world_size, scenario.world_size} );
+    for (size_t i = 0; i < scenario.no_of_bodies; i++) {
+      std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, radius(gen)},
+                                                                 Vector2df{velocity(gen), velocity(gen)}, 1000.0f, 0.0f, 0.0f, fix );
+      physics.add_body(body);
+    }
+    physics.tick(TICK_TIME);
+  };
+
+  size_t no_of_collisions = 0;
+  double function_ticks;
+  {
+    Physics2df physics{ [](Body2df * body1, Body2df * body2) -> bool { return body1->get_angle() <= body2->get_angle(); },
+                        [&no_of_collisions](Body2df *, Body2df *) -> void { no_of_collisions++; } };
+    fill(physics, [](Body2df * body, float seconds) -> void { body->turn(1.0f, seconds); });
+    function_ticks = ticks_per_second(scenario.no_of_ticks, [&]() { physics.tick(TICK_TIME); });
+  }
+  double policy_ticks;
+  {
+    Physics<float, 2u, BoundingVolume2df, CountingPolicy> physics{ CountingPolicy{ &no_of_collisions } };
+    fill(physics, [](Body2df *, float) -> void { });
+    policy_ticks = ticks_per_second(scenario.no_of_ticks, [&]() { physics.tick(TICK_TIME); });
+  }
+  return { function_ticks, policy_ticks };
+}
+
+}
+
+int main() {
+  // about 30 bodies on an area of 1024 x 768 pixels as in a crowded level
+  const Scenario scenarios[] = { {1000u, 200u, 5000.0f},
+                                 {10000u, 50u, 16000.0f},
+                                 {100000u, 10u, 50000.0f} };
+
+  std::cout << std::setw(10) << "bodies" << std::setw(22) << "Physics ticks/s" << std::setw(22) << "DensePhysics ticks/s" << std::setw(10) << "speedup" << std::endl;
+  for (const Scenario & scenario : scenarios) {
+    double physics = physics_ticks_per_second(scenario);
+    double dense_physics = dense_physics_ticks_per_second(scenario);
+    std::cout << std::setw(10) << scenario.no_of_bodies
+              << std::setw(22) << std::fixed << std::setprecision(1) << physics
+              << std::setw(22) << dense_physics
+              << std::setw(10) << std::setprecision(2) << dense_physics / physics << std::endl;
+  }
+
+  // radius of an asteroid, a torpedo and a saucer in the game
+  auto uniform_radius = [](std::mt19937 & gen) { return std::uniform_real_distribution<float>(1.0f, 33.0f)(gen); };
+  auto game_radius = [](std::mt19937 & gen) { const float radii[] = {33.0f, 1.0f, 1.0f, 1.0f, 15.0f}; return radii[gen() % 5]; };
+  const Workload workloads[] = { {"uniform", 1000u, 200u, 5000.0f, uniform_radius, 0u},
+                                 {"game sizes", 1000u, 200u, 5000.0f, game_radius, 0u},
+                                 {"clustered", 1000u, 200u, 5000.0f, uniform_radius, 10u},
+                                 {"uniform", 10000u, 50u, 16000.0f, uniform_radius, 0u},
+                                 {"game sizes", 10000u, 50u, 16000.0f, game_radius, 0u},
+                                 {"clustered", 10000u, 50u, 16000.0f, uniform_radius, 10u} };
+  const std::pair<const char *, BroadPhase> broad_phases[] = { {"brute force", BroadPhase::brute_force},
+                                                               {"spatial grid", BroadPhase::spatial_grid},
+                                                               {"sweep and prune", BroadPhase::sweep_and_prune},
+                                                               {"aabb tree", BroadPhase::aabb_tree} };
+
+  std::cout << std::endl << std::setw(12) << "workload" << std::setw(10) << "bodies";
+  for (auto [name, broad_phase] : broad_phases) {
+    std::cout << std::setw(18) << name;
+  }
+  std::cout << "  (ticks/s)" << std::endl;
+  for (const Workload & workload : workloads) {
+    std::cout << std::setw(12) << workload.name << std::setw(10) << workload.no_of_bodies;
+    for (auto [name, broad_phase] : broad_phases) {
+      // brute force does not scale
+      if (broad_phase == BroadPhase::brute_force && workload.no_of_bodies > 1000u) {
+        std::cout << std::setw(18) << "-";
+      } else {
+        std::cout << std::setw(18) << std::fixed << std::setprecision(1) << broad_phase_ticks_per_second(workload, broad_phase);
+      }
+    }
+    std::cout << std::endl;
+  }
+
+  std::vector<Body2df *> result;
+  std::cout << std::endl << std::setw(10) << "bodies" << std::setw(18) << "radius 100" << std::setw(18) << "5 nearest" << std::setw(18) << "ray 1000" << "  (queries/s)" << std::endl;
+  for (const Scenario & scenario : scenarios) {
+    double radius = queries_per_second(scenario, [&result](Physics2df & physics, Vector2df point) {
+      result.clear();
+      physics.query_radius(point, 100.0f, result);
+    });
+    double nearest = queries_per_second(scenario, [&result](Physics2df & physics, Vector2df point) {
+      result.clear();
+      physics.query_nearest(point, 5, result);
+    });
+    double ray = queries_per_second(scenario, [](Physics2df & physics, Vector2df point) {
+      float t;
+      physics.ray_cast( Ray2df{point, Vector2df(point[0])}, 1000.0f, t );
+    });
+    std::cout << std::setw(10) << scenario.no_of_bodies << std::setw(18) << std::fixed << std::setprecision(0) << radius
+              << std::setw(18) << nearest << std::setw(18) << ray << std::endl;
+  }
+
+  std::cout << std::endl << std::setw(10) << "bodies" << std::setw(22) << "std::function ticks/s" << std::setw(18) << "policy ticks/s"
+            << std::setw(18) << "saved us/tick" << std::endl;
+  for (const Scenario & scenario : scenarios) {
+    auto [function_ticks, policy_ticks] = policy_ticks_per_second(scenario);
+    std::cout << std::setw(10) << scenario.no_of_bodies << std::setw(22) << std::fixed << std::setprecision(1) << function_ticks
+              << std::setw(18) << policy_ticks << std::setw(18) << 1e6 / function_ticks - 1e6 / policy_ticks << std::endl;
+  }
+  return 0;
+}
@@ -1,6 +1,12 @@
 #include "physics.h"
+#include "physics.tcc"
+#include "broad_phase.h"
 #include "gtest/gtest.h"
 #include <memory>
+#include <random>
+#include <map>
+#include <cstring>
+#include <algorithm>
 
 namespace {
 	
@@ -61,6 +67,34 @@ TEST(RECT_BOUNDING_VOLUME, CollidesInside) {
   EXPECT_TRUE( boundingVolume1.collides(boundingVolume2) );
 }
 
+// the first volume moved from (-10, 0) through the second one to (10, 0)
+TEST(BOUNDING_VOLUME, SweptCollides) {
+  BoundingVolume2df boundingVolume1( {10.0, 0.0}, 1.0 );
+  BoundingVolume2df boundingVolume2( {0.0, 0.0}, 1.0 );
+
+  EXPECT_FALSE( boundingVolume1.collides(boundingVolume2) );
+  EXPECT_TRUE( boundingVolume1.collides(boundingVolume2, {20.0, 0.0}, {0.0, 0.0}) );
+  EXPECT_TRUE( boundingVolume2.collides(boundingVolume1, {0.0, 0.0}, {20.0, 0.0}) );
+}
+
+TEST(BOUNDING_VOLUME, SweptDoesNotCollide) {
+  BoundingVolume2df boundingVolume1( {10.0, 3.0}, 1.0 );
+  BoundingVolume2df boundingVolume2( {0.0, 0.0}, 1.0 );
+
+  EXPECT_FALSE( boundingVolume1.collides(boundingVolume2, {20.0, 0.0}, {0.0, 0.0}) );
+  // both volumes move in parallel
+  EXPECT_FALSE( boundingVolume1.collides(boundingVolume2, {20.0, 0.0}, {20.0, 0.0}) );
+}
+
+TEST(RECT_BOUNDING_VOLUME, SweptCollides) {
+  Rectangle2df boundingVolume1( {10.0, 0.0}, {1.0, 1.0} );
+  Rectangle2df boundingVolume2( {0.0, 0.5}, {1.0, 1.0} );
+
+  EXPECT_FALSE( boundingVolume1.collides(boundingVolume2) || boundingVolume1.collides(boundingVolume2, {5.0, 0.0}, {0.0, 0.0}) );
+  EXPECT_TRUE( boundingVolume1.collides(boundingVolume2, {20.0, 0.0}, {0.0, 0.0}) );
+  EXPECT_FALSE( boundingVolume1.collides(boundingVolume2, {20.0, 5.0}, {0.0, 0.0}) );
+}
+
 
 TEST(BODY, Move) {
   Body2df body( BoundingVolume2df({0.0, 0.0}, 1.0), {1.0, 0.0} );
@@ -142,6 +176,103 @@ TEST(BODY, AccelerateAndMoveWithMaximumVelocity) {
   EXPECT_NEAR(0.0, body.get_position()[1], 0.00001);
 }
 
+TEST(BODY, InterpolatedPosition) {
+  Body2df body{ BoundingVolume2df{ {10.0f, 20.0f}, 1.0f }, Vector2df{ 4.0f, -2.0f }, 100.0f, 0.0f, 1.0f };
+  body.save_transform();
+  body.move(1.0f);
+  body.turn(0.5f, 1.0f);
+
+  EXPECT_NEAR(12.0f, body.get_interpolated_position(0.5f)[0], 0.00001f);
+  EXPECT_NEAR(19.0f, body.get_interpolated_position(0.5f)[1], 0.00001f);
+  EXPECT_NEAR(10.0f, body.get_interpolated_position(0.0f)[0], 0.00001f);
+  EXPECT_NEAR(14.0f, body.get_interpolated_position(1.0f)[0], 0.00001f);
+  EXPECT_NEAR(1.25f, body.get_interpolated_angle(0.5f), 0.00001f);
+}
+
+TEST(BODY, InterpolatedPositionWrapsWithFix) {
+  auto wrap = [](Body2df * body, float) -> void {
+    Vector2df position = body->get_position();
+    if (position[0] > 100.0f) {
+      position[0] -= 100.0f;
+      body->set_position(position);
+    }
+  };
+  Body2df body{ BoundingVolume2df{ {98.0f, 0.0f}, 1.0f }, Vector2df{ 4.0f, 0.0f }, 100.0f, 0.0f, 0.0f, wrap };
+  body.save_transform();
+  body.move(1.0f);
+
+  // the previous position is wrapped, too, so that the body continues from the left edge
+  EXPECT_NEAR(2.0f, body.get_position()[0], 0.00001f);
+  EXPECT_NEAR(0.0f, body.get_interpolated_position(0.5f)[0], 0.00001f);
+}
+
+TEST(BODY, SetPositionIsNotInterpolated) {
+  Body2df body{ BoundingVolume2df{ {10.0f, 20.0f}, 1.0f }, Vector2df{ 4.0f, -2.0f }, 100.0f };
+  body.save_transform();
+  body.set_position( {500.0f, 300.0f} );
+
+  EXPECT_NEAR(500.0f, body.get_interpolated_position(0.5f)[0], 0.00001f);
+  EXPECT_NEAR(300.0f, body.get_interpolated_position(0.5f)[1], 0.00001f);
+}
+
+TEST(BODY, WrapIsInterpolated) {
+  Body2df body{ BoundingVolume2df({1020.0, 10.0}, 1.0), Vector2df{10.0, -20.0}, 100.0 };
+  body.save_transform();
+  body.move(1.0);
+  body.wrap( {1024.0, 768.0} );
+  EXPECT_NEAR(6.0, body.get_position()[0], 0.0001);
+  EXPECT_NEAR(758.0, body.get_position()[1], 0.0001);
+  EXPECT_NEAR(10.0, body.get_displacement()[0], 0.0001);
+  EXPECT_NEAR(-20.0, body.get_displacement()[1], 0.0001);
+}
+
+TEST(BODY, WrapOnlyToroidalAxes) {
+  Body2df body{ BoundingVolume2df({-10.0, -10.0}, 1.0), Vector2df{0.0, 0.0} };
+  body.wrap( {100.0, 0.0} );
+  EXPECT_NEAR(90.0, body.get_position()[0], 0.0001);
+  EXPECT_NEAR(-10.0, body.get_position()[1], 0.0001);
+}
+
+TEST(PHYSICS, MinimumImage) {
+  Physics2df physics{};
+  Vector2df difference{1000.0, -700.0};
+  EXPECT_NEAR(1000.0, physics.minimum_image(difference)[0], 0.0001);
+  physics.set_world_size( {1024.0, 768.0} );
+  EXPECT_NEAR(-24.0, physics.minimum_image(difference)[0], 0.0001);
+  EXPECT_NEAR(68.0, physics.minimum_image(difference)[1], 0.0001);
+  EXPECT_NEAR(100.0, physics.minimum_image( {100.0, 0.0} )[0], 0.0001);
+}
+
+// a big asteroid crossing the left edge hits a ship at the right edge
+TEST(PHYSICS, CollidesAcrossEdge) {
+  for (BroadPhase broad_phase : { BroadPhase::brute_force, BroadPhase::spatial_grid }) {
+    std::unique_ptr<Body2df> asteroid = std::make_unique<Body2df>( BoundingVolume2df({10.0, 300.0}, 33.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> ship = std::make_unique<Body2df>( BoundingVolume2df({1014.0, 310.0}, 10.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> far_away = std::make_unique<Body2df>( BoundingVolume2df({500.0, 310.0}, 10.0), Vector2df{0.0, 0.0} );
+    size_t collisions = 0;
+    Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                        [&](Body2df *, Body2df * ) -> void { collisions++; } };
+    physics.set_broad_phase(broad_phase);
+    physics.set_world_size( {1024.0, 768.0} );
+    physics.add_body( asteroid );
+    physics.add_body( ship );
+    physics.add_body( far_away );
+    physics.tick(1.0 / 60.0);
+    EXPECT_EQ(1, collisions);
+  }
+}
+
+TEST(PHYSICS, IsAreaFreeOfBodiesAcrossEdge) {
+  std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({5.0, 5.0}, 10.0), Vector2df{0.0, 0.0} );
+  BoundingVolume2df area{{1020.0f, 760.0f}, 10.0f };
+  Physics2df physics{};
+  physics.add_body( body );
+  physics.tick(1.0);
+  EXPECT_TRUE( physics.is_area_free_of_bodies( &area ) );
+  physics.set_world_size( {1024.0, 768.0} );
+  EXPECT_FALSE( physics.is_area_free_of_bodies( &area ) );
+}
+
 TEST(PHYSICS, IsAreaFreeOfBodiesTrue) {
   std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{-0.5, -0.5} );
   std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, -1.0} );
@@ -166,6 +297,162 @@ TEST(PHYSICS, IsAreaFreeOfBodiesFalse) {
   EXPECT_FALSE( physics.is_area_free_of_bodies( &area ) );
 }
 
+TEST(PHYSICS, IsAreaFreeOfBodiesIgnoresDeletedBodies) {
+  std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>(BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{0.0, 0.0} );
+  Body2df * b1 = body1.get();
+  BoundingVolume2df area{{0.0f, 0.0f}, 10.0f };
+  Physics2df physics{};
+  physics.add_body( body1 );
+  physics.tick();
+  EXPECT_FALSE( physics.is_area_free_of_bodies( &area ) );
+  b1->mark_for_deletion();
+  physics.tick();
+  EXPECT_TRUE( physics.is_area_free_of_bodies( &area, [](Body2df *) -> bool { return true; } ) );
+}
+
+// 500 random circles on a torus of 1024 x 768 pixel
+void add_random_circles(Physics2df & physics) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> x(0.0f, 1024.0f);
+  std::uniform_real_distribution<float> y(0.0f, 768.0f);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(0.0f, 33.0f);
+  physics.set_world_size( {1024.0f, 768.0f} );
+  for (size_t i = 0; i < 500; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {x(gen), y(gen)}, radius(gen) },
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    physics.add_body(body);
+  }
+  physics.tick(1.0f / 60.0f);
+}
+
+// distance between a point and a circle on the torus
+float distance(Physics2df & physics, Vector2df point, Body2df * body) {
+  return std::max(0.0f, physics.minimum_image(body->get_position() - point).length() - body->get_bounding_volume().get_radius());
+}
+
+TEST(PHYSICS, QueryRadiusFindsSameBodiesAsLinearScan) {
+  Physics2df physics{};
+  add_random_circles(physics);
+  std::mt19937 gen(8);
+  std::uniform_real_distribution<float> position(-100.0f, 1100.0f);
+  std::uniform_real_distribution<float> radius(0.0f, 100.0f);
+  size_t no_of_found = 0;
+  for (size_t i = 0; i < 100; i++) {
+    Vector2df point{position(gen), position(gen)};
+    float r = radius(gen);
+    std::vector<Body2df *> expected;
+    for (auto & body : physics.get_bodies()) {
+      if ( distance(physics, point, body.get()) <= r ) {
+        expected.push_back( body.get() );
+      }
+    }
+    std::vector<Body2df *> found;
+    physics.query_radius(point, r, found);
+    EXPECT_EQ(expected, found);
+    no_of_found += found.size();
+  }
+  EXPECT_LT(100, no_of_found);
+}
+
+TEST(PHYSICS, QueryNearestFindsSameBodiesAsLinearScan) {
+  Physics2df physics{};
+  add_random_circles(physics);
+  auto small = [](Body2df * body) -> bool { return body->get_bounding_volume().get_radius() < 10.0f; };
+  std::mt19937 gen(9);
+  std::uniform_real_distribution<float> position(0.0f, 1024.0f);
+  for (size_t i = 0; i < 100; i++) {
+    Vector2df point{position(gen), position(gen)};
+    std::vector< std::pair<float, Body2df *> > expected;
+    for (auto & body : physics.get_bodies()) {
+      if ( small(body.get()) ) {
+        expected.push_back( {distance(physics, point, body.get()), body.get()} );
+      }
+    }
+    std::sort(expected.begin(), expected.end());
+    std::vector<Body2df *> found;
+    physics.query_nearest(point, 5, found, small);
+    ASSERT_EQ(5, found.size());
+    for (size_t j = 0; j < 5; j++) {
+      EXPECT_NEAR(expected[j].first, distance(physics, point, found[j]), 0.001f);
+    }
+  }
+}
+
+TEST(PHYSICS, RayCastFindsFirstBody) {
+  std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({10.0, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+  std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({20.0, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+  std::unique_ptr<BodyRect2df> rectangle = std::make_unique<BodyRect2df>( Rectangle2df({30.0, -5.0}, {2.0, 10.0}), Vector2df{0.0, 0.0} );
+  Body2df * b1 = body1.get();
+  Body2df * b2 = body2.get();
+  Physics2df physics{};
+  physics.add_body( body1 );
+  physics.add_body( body2 );
+  physics.tick();
+  float t = -1.0f;
+  EXPECT_EQ(b1, physics.ray_cast( Ray2df{ {0.0, 0.0}, {2.0, 0.0} }, 100.0f, t ));
+  EXPECT_NEAR(4.5f, t, 0.0001f);
+  EXPECT_EQ(b2, physics.ray_cast( Ray2df{ {0.0, 0.0}, {1.0, 0.0} }, 100.0f, t, [b1](Body2df * body) -> bool { return body != b1; } ));
+  EXPECT_NEAR(19.0f, t, 0.0001f);
+  EXPECT_EQ(nullptr, physics.ray_cast( Ray2df{ {0.0, 0.0}, {1.0, 0.0} }, 8.0f, t ));
+  EXPECT_EQ(nullptr, physics.ray_cast( Ray2df{ {0.0, 0.0}, {-1.0, 0.0} }, 100.0f, t ));
+  EXPECT_EQ(b1, physics.ray_cast( Ray2df{ {10.5, 0.0}, {1.0, 0.0} }, 100.0f, t ));
+  EXPECT_EQ(0.0f, t);
+
+  PhysicsRect2df physics_rect{};
+  physics_rect.add_body( rectangle );
+  physics_rect.tick();
+  EXPECT_NE(nullptr, physics_rect.ray_cast( Ray2df{ {0.0, 0.0}, {1.0, 0.0} }, 100.0f, t ));
+  EXPECT_NEAR(30.0f, t, 0.0001f);
+}
+
+TEST(PHYSICS, RayCastAcrossEdge) {
+  std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({5.0, 50.0}, 2.0), Vector2df{0.0, 0.0} );
+  Body2df * b = body.get();
+  Physics2df physics{};
+  physics.set_world_size( {100.0, 100.0} );
+  physics.add_body( body );
+  physics.tick();
+  float t = -1.0f;
+  EXPECT_EQ(b, physics.ray_cast( Ray2df{ {95.0, 50.0}, {1.0, 0.0} }, 50.0f, t ));
+  EXPECT_NEAR(8.0f, t, 0.0001f);
+  EXPECT_EQ(b, physics.ray_cast( Ray2df{ {5.0, 10.0}, {0.0, -1.0} }, 70.0f, t ));
+  EXPECT_NEAR(58.0f, t, 0.0001f);
+}
+
+TEST(PHYSICS, RayCastFindsSameBodyAsLinearScan) {
+  Physics2df physics{};
+  add_random_circles(physics);
+  std::mt19937 gen(10);
+  std::uniform_real_distribution<float> position(0.0f, 768.0f);
+  std::uniform_real_distribution<float> angle(0.0f, 2.0f * 3.14159265f);
+  for (size_t i = 0; i < 100; i++) {
+    Ray2df ray{ {position(gen), position(gen)}, Vector2df(angle(gen)) };
+    float expected_t = 300.0f;
+    Body2df * expected = nullptr;
+    for (auto & body : physics.get_bodies()) {
+      for (float x : {-1024.0f, 0.0f, 1024.0f}) {
+        for (float y : {-768.0f, 0.0f, 768.0f}) {
+          BoundingVolume2df image{ body->get_position() + Vector2df{x, y}, body->get_bounding_volume().get_radius() };
+          float t = image.ray_intersection(ray);
+          if (t >= 0.0f && t < expected_t) {
+            expected_t = t;
+            expected = body.get();
+          }
+        }
+      }
+    }
+    float t = -1.0f;
+    // the ray may start inside of more than one body
+    Body2df * found = physics.ray_cast(ray, 300.0f, t);
+    EXPECT_EQ(expected == nullptr, found == nullptr);
+    if (expected != nullptr && found != nullptr) {
+      EXPECT_NEAR(expected_t, t, 0.001f);
+      EXPECT_TRUE(expected == found || t == 0.0f);
+    }
+  }
+}
+
 TEST(PHYSICS, TickCheckMovement) {
   std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{-0.5, -0.5} );
   std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, -1.0} );
@@ -213,6 +500,69 @@ TEST(PHYSICS, TickCheckCollision) {
   EXPECT_TRUE(collision_ok);
 }
 
+// logs the positions of the bodies passed to the callbacks, turns each body after its movement and deletes
+// the second body of each collision
+struct LoggingPhysicsPolicy {
+  std::vector<Vector2df> * log;
+
+  bool check_collision(Body2df * body1, Body2df * body2) {
+    return body1->get_position()[0] < body2->get_position()[0];
+  }
+
+  void resolve_collision(Body2df * body1, Body2df * body2) {
+    log->push_back(body1->get_position());
+    body2->mark_for_deletion();
+  }
+
+  void resolve_deleted_body(Body2df * body) {
+    log->push_back(body->get_position());
+  }
+
+  void fix(Body2df * body, float seconds) {
+    body->turn(1.0f, seconds);
+  }
+};
+
+template<class PHYSICS>
+void add_turning_bodies(PHYSICS & physics, bool with_fix) {
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> position(0.0f, 200.0f);
+  std::uniform_real_distribution<float> velocity(-20.0f, 20.0f);
+  auto fix = [with_fix](Body2df * body, float seconds) -> void { if (with_fix) { body->turn(1.0f, seconds); } };
+  for (size_t i = 0; i < 100; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, 5.0f },
+                                                               Vector2df{velocity(gen), velocity(gen)}, 100.0f, 0.0f, 0.0f, fix );
+    physics.add_body(body);
+  }
+}
+
+TEST(PHYSICS, PolicyResolvesSameCollisionsAsCallbacks) {
+  std::vector<Vector2df> callback_log;
+  Physics2df physics{ [](Body2df * body1, Body2df * body2) -> bool { return body1->get_position()[0] < body2->get_position()[0]; },
+                      [&](Body2df * body1, Body2df * body2) -> void { callback_log.push_back(body1->get_position()); body2->mark_for_deletion(); },
+                      [&](Body2df * body) -> void { callback_log.push_back(body->get_position()); } };
+  std::vector<Vector2df> policy_log;
+  Physics<float, 2u, BoundingVolume2df, LoggingPhysicsPolicy> policy_physics{ LoggingPhysicsPolicy{ &policy_log } };
+  add_turning_bodies(physics, true);
+  add_turning_bodies(policy_physics, false);  // the policy turns the bodies, not their fix
+  for (size_t i = 0; i < 10; i++) {
+    physics.tick(0.5f);
+    policy_physics.tick(0.5f);
+  }
+  EXPECT_LT(50, callback_log.size());
+  ASSERT_EQ(callback_log.size(), policy_log.size());
+  for (size_t i = 0; i < callback_log.size(); i++) {
+    EXPECT_EQ(callback_log[i][0], policy_log[i][0]);
+    EXPECT_EQ(callback_log[i][1], policy_log[i][1]);
+  }
+  ASSERT_EQ(physics.get_bodies().size(), policy_physics.get_bodies().size());
+  for (size_t i = 0; i < physics.get_bodies().size(); i++) {
+    EXPECT_EQ(physics.get_body(i)->get_position()[0], policy_physics.get_body(i)->get_position()[0]);
+    EXPECT_EQ(physics.get_body(i)->get_position()[1], policy_physics.get_body(i)->get_position()[1]);
+    EXPECT_EQ(physics.get_body(i)->get_angle(), policy_physics.get_body(i)->get_angle());
+  }
+}
+
 TEST(PHYSICS, TickBodiesDeletedWhenMarkedForDeletion) {
   std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{-0.5, -0.5} );
   std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, -1.0} );
@@ -247,6 +597,7 @@ TEST(PHYSICS, GetRecentlyAddedBodies) {
     
   EXPECT_EQ(1, added.size());
   EXPECT_EQ(b1, added[0]);
+  EXPECT_EQ(1, physics.get_no_of_ticks());
 }
 
 
@@ -298,4 +649,612 @@ TEST(PHYSICS, TickTime120) {
   EXPECT_NEAR(768.0, std::round(b->get_position()[1]), 0.00001);
 }
 
+
+// runs a physics with many random bodies and returns the indices of all resolved collisions in the order of their resolution
+// the physics switches to the next of the given broad phases after an equal number of ticks
+// if replace_colliding_bodies is true, the second body of each collision is replaced by a new body
+template<class BV>
+std::vector< std::pair<size_t, size_t> > resolved_collisions(std::vector<BroadPhase> broad_phases, std::function<BV(Vector2df, float)> create_volume,
+                                                             Vector2df world_size = {0.0f, 0.0f}, bool replace_colliding_bodies = false) {
+  const size_t no_of_ticks = 10;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> position(0.0f, 1024.0f);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> size(0.0f, 33.0f);
+  std::map< Body<float, 2u, BV> *, size_t > index;  // a new body may be allocated at the address of a deleted body
+  size_t no_of_bodies = 0;
+  std::vector< std::pair<size_t, size_t> > collisions;
+
+  Physics<float, 2u, BV> * p = nullptr;
+  auto add_body = [&]() {
+    std::unique_ptr< Body<float, 2u, BV> > body = std::make_unique< Body<float, 2u, BV> >(
+                                                    create_volume( Vector2df{position(gen), position(gen)}, size(gen) ),
+                                                    Vector2df{velocity(gen), velocity(gen)}, 1000.0f );
+    index[body.get()] = no_of_bodies++;
+    p->add_body(body);
+  };
+  Physics<float, 2u, BV> physics{ [](Body<float, 2u, BV> *, Body<float, 2u, BV> *) -> bool { return true; },
+                                  [&](Body<float, 2u, BV> * b1, Body<float, 2u, BV> * b2) -> void {
+                                    collisions.push_back( {index[b1], index[b2]} );
+                                    if (replace_colliding_bodies && !b2->is_marked_for_deletion()) {
+                                      b2->mark_for_deletion();
+                                      add_body();
+                                    }
+                                  } };
+  p = &physics;
+  physics.set_world_size(world_size);
+  for (size_t i = 0; i < 1000; i++) {
+    add_body();
+  }
+  for (size_t i = 0; i < no_of_ticks; i++) {
+    BroadPhase broad_phase = broad_phases[i * broad_phases.size() / no_of_ticks];
+    if (i == 0 || broad_phase != physics.get_broad_phase()) {
+      physics.set_broad_phase(broad_phase);
+    }
+    physics.tick(1.0f / 60.0f);
+  }
+  return collisions;
+}
+
+const BroadPhase broad_phases[] = { BroadPhase::spatial_grid, BroadPhase::sweep_and_prune, BroadPhase::aabb_tree };
+
+auto create_circle = [](Vector2df position, float size) -> BoundingVolume2df { return BoundingVolume2df{position, size}; };
+auto create_rectangle = [](Vector2df position, float size) -> Rectangle2df { return Rectangle2df{position, {size, 0.5f * size}}; };
+
+TEST(PHYSICS, BroadPhasesResolveSameCollisionsAsBruteForce) {
+  auto brute_force = resolved_collisions<BoundingVolume2df>( {BroadPhase::brute_force}, create_circle);
+  EXPECT_LT(0, brute_force.size());
+  for (BroadPhase broad_phase : broad_phases) {
+    EXPECT_EQ(brute_force, resolved_collisions<BoundingVolume2df>( {broad_phase}, create_circle)) << static_cast<int>(broad_phase);
+  }
+}
+
+TEST(PHYSICS, BroadPhasesResolveSameCollisionsAsBruteForceRectangle) {
+  auto brute_force = resolved_collisions<Rectangle2df>( {BroadPhase::brute_force}, create_rectangle);
+  EXPECT_LT(0, brute_force.size());
+  for (BroadPhase broad_phase : broad_phases) {
+    EXPECT_EQ(brute_force, resolved_collisions<Rectangle2df>( {broad_phase}, create_rectangle)) << static_cast<int>(broad_phase);
+  }
+}
+
+TEST(PHYSICS, BroadPhasesResolveSameCollisionsAsBruteForceOnTorus) {
+  auto brute_force = resolved_collisions<BoundingVolume2df>( {BroadPhase::brute_force}, create_circle, {1024.0f, 1000.0f});
+  auto brute_force_rectangle = resolved_collisions<Rectangle2df>( {BroadPhase::brute_force}, create_rectangle, {1024.0f, 1000.0f});
+  EXPECT_LT(0, brute_force.size());
+  for (BroadPhase broad_phase : broad_phases) {
+    EXPECT_EQ(brute_force, resolved_collisions<BoundingVolume2df>( {broad_phase}, create_circle, {1024.0f, 1000.0f})) << static_cast<int>(broad_phase);
+    EXPECT_EQ(brute_force_rectangle, resolved_collisions<Rectangle2df>( {broad_phase}, create_rectangle, {1024.0f, 1000.0f})) << static_cast<int>(broad_phase);
+  }
+}
+
+TEST(PHYSICS, BroadPhasesResolveSameCollisionsAsBruteForceWithReplacedBodies) {
+  auto brute_force = resolved_collisions<BoundingVolume2df>( {BroadPhase::brute_force}, create_circle, {1024.0f, 1000.0f}, true);
+  EXPECT_LT(0, brute_force.size());
+  for (BroadPhase broad_phase : broad_phases) {
+    EXPECT_EQ(brute_force, resolved_collisions<BoundingVolume2df>( {broad_phase}, create_circle, {1024.0f, 1000.0f}, true)) << static_cast<int>(broad_phase);
+  }
+}
+
+TEST(PHYSICS, SwitchBroadPhaseWhileRunning) {
+  auto brute_force = resolved_collisions<BoundingVolume2df>( {BroadPhase::brute_force}, create_circle, {1024.0f, 1000.0f}, true);
+  auto switched = resolved_collisions<BoundingVolume2df>( {BroadPhase::aabb_tree, BroadPhase::sweep_and_prune, BroadPhase::spatial_grid, BroadPhase::aabb_tree, BroadPhase::brute_force},
+                                                          create_circle, {1024.0f, 1000.0f}, true);
+  EXPECT_EQ(brute_force, switched);
+}
+
+TEST(PHYSICS, BroadPhasesBodiesWithoutExtent) {
+  for (BroadPhase broad_phase : broad_phases) {
+    std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 0.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 0.0), Vector2df{0.0, 0.0} );
+    size_t collisions = 0;
+    Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                        [&](Body2df *, Body2df * ) -> void { collisions++; } };
+    physics.set_broad_phase(broad_phase);
+    physics.add_body( body1 );
+    physics.add_body( body2 );
+    physics.tick(1.0);
+    EXPECT_EQ(1, collisions) << static_cast<int>(broad_phase);
+  }
+}
+
+// bodies inserted from left to right would degenerate an unbalanced tree to a list
+TEST(PHYSICS, AabbTreeStaysBalanced) {
+  auto strategy = std::make_unique<AabbTreeBroadPhase2df>();
+  AabbTreeBroadPhase2df * tree = strategy.get();
+  Physics2df physics{};
+  physics.set_broad_phase( std::move(strategy) );
+  for (size_t i = 0; i < 1024; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({10.0f * i, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+    physics.add_body( body );
+  }
+  physics.tick(1.0);
+  EXPECT_LE(10, tree->get_height());
+  EXPECT_GE(20, tree->get_height());
+  for (size_t i = 0; i < 1024; i += 2) {
+    physics.get_body(i)->mark_for_deletion();
+  }
+  physics.tick(1.0);
+  EXPECT_EQ(512, physics.get_bodies().size());
+  EXPECT_GE(18, tree->get_height());
+}
+
+// a strategy, that never finds any pair
+class NoPairsBroadPhase : public BroadPhaseStrategy<float, 2u, BoundingVolume2df> {
+public:
+  size_t no_of_calls = 0;
+  void find_pairs(Vector2df, std::vector< std::pair<Body2df *, Body2df *> > &) override { no_of_calls++; }
+};
+
+TEST(PHYSICS, CollisionFilter) {
+  for (BroadPhase broad_phase : { BroadPhase::brute_force, BroadPhase::spatial_grid, BroadPhase::sweep_and_prune, BroadPhase::aabb_tree }) {
+    // four overlapping bodies: a and b belong to category 1, c to category 2 and collides with category 1 only,
+    // d collides with nothing and is left out of the broad phase
+    std::unique_ptr<Body2df> a = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> b = std::make_unique<Body2df>( BoundingVolume2df({2.5, 2.0}, 1.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> c = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.5}, 1.0), Vector2df{0.0, 0.0} );
+    std::unique_ptr<Body2df> d = std::make_unique<Body2df>( BoundingVolume2df({2.5, 2.5}, 1.0), Vector2df{0.0, 0.0} );
+    a->set_collision_filter(1u, 1u);
+    b->set_collision_filter(1u, 3u);
+    c->set_collision_filter(2u, 1u);
+    d->set_collision_filter(4u, 0u);
+    Body2df * a_pointer = a.get();
+    Body2df * b_pointer = b.get();
+    Body2df * c_pointer = c.get();
+    Body2df * d_pointer = d.get();
+    EXPECT_TRUE(a->can_collide(*b));
+    EXPECT_FALSE(a->can_collide(*c));  // c is not in the mask of a
+    EXPECT_TRUE(b->can_collide(*c));
+    EXPECT_FALSE(d->can_collide(*a));
+    std::vector< std::pair<Body2df *, Body2df *> > collisions;
+    Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                        [&](Body2df * body1, Body2df * body2) -> void { collisions.push_back( {body1, body2} ); } };
+    physics.set_broad_phase(broad_phase);
+    physics.add_body(a);
+    physics.add_body(b);
+    physics.add_body(c);
+    physics.add_body(d);
+    physics.tick(1.0);
+    ASSERT_EQ(2, collisions.size()) << static_cast<int>(broad_phase);
+    EXPECT_EQ(a_pointer, collisions[0].first);
+    EXPECT_EQ(b_pointer, collisions[0].second);
+    EXPECT_EQ(b_pointer, collisions[1].first);
+    EXPECT_EQ(c_pointer, collisions[1].second);
+    // the body without a proxy can be deleted and the broad phase can be switched
+    d_pointer->mark_for_deletion();
+    physics.tick(1.0);
+    physics.set_broad_phase(BroadPhase::sweep_and_prune);
+    physics.tick(1.0);
+    EXPECT_EQ(3, physics.get_bodies().size());
+    EXPECT_EQ(6, collisions.size());
+  }
+}
+
+// runs a simulation with the given broad phase and number of threads, in which colliding bodies bounce and every
+// third collision deletes a body, and logs the positions and angles of the colliding and of all remaining bodies
+std::vector<float> simulate_with_threads(BroadPhase broad_phase, size_t no_of_threads) {
+  std::vector<float> log;
+  size_t no_of_collisions = 0;
+  Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                      [&](Body2df * body1, Body2df * body2) -> void {
+                        log.insert(log.end(), { body1->get_position()[0], body1->get_position()[1], body2->get_position()[0], body2->get_position()[1] });
+                        body1->bounce(0);
+                        body2->bounce(1);
+                        if (++no_of_collisions % 3 == 0) {
+                          body2->mark_for_deletion();
+                        }
+                      } };
+  physics.set_broad_phase(broad_phase);
+  physics.set_world_size( {500.0f, 400.0f} );
+  physics.set_no_of_threads(no_of_threads);
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> position(0.0f, 500.0f);
+  std::uniform_real_distribution<float> velocity(-300.0f, 300.0f);
+  std::uniform_real_distribution<float> radius(0.5f, 6.0f);
+  auto turn = [](Body2df * body, float seconds) -> void { body->turn(0.5f, seconds); };
+  for (size_t i = 0; i < 1000; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen), position(gen)}, radius(gen) },
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f, 0.0f, 0.0f, turn );
+    physics.add_body(body);
+  }
+  for (size_t i = 0; i < 30; i++) {
+    physics.tick(1.0f / 30.0f);
+  }
+  for (auto & body : physics.get_bodies()) {
+    log.insert(log.end(), { body->get_position()[0], body->get_position()[1], body->get_angle() });
+  }
+  return log;
+}
+
+TEST(PHYSICS, ThreadsGiveBitIdenticalResults) {
+  for (BroadPhase broad_phase : { BroadPhase::brute_force, BroadPhase::spatial_grid, BroadPhase::sweep_and_prune, BroadPhase::aabb_tree }) {
+    std::vector<float> serial = simulate_with_threads(broad_phase, 1u);
+    EXPECT_LT(3000u, serial.size());  // some collisions besides the final bodies
+    for (size_t no_of_threads : { 2u, 3u, 8u }) {
+      std::vector<float> parallel = simulate_with_threads(broad_phase, no_of_threads);
+      ASSERT_EQ(serial.size(), parallel.size()) << static_cast<int>(broad_phase) << " " << no_of_threads;
+      EXPECT_EQ(0, std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(float)))
+        << static_cast<int>(broad_phase) << " " << no_of_threads;
+    }
+  }
+}
+
+// the fix deletes the bodies leaving the left border after a while and the bodies near the bottom at once,
+// while it is called by several threads
+std::vector<float> delete_in_fix_with_threads(size_t no_of_threads) {
+  Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return false; },
+                      [](Body2df *, Body2df * ) -> void { } };
+  physics.set_broad_phase(BroadPhase::spatial_grid);
+  physics.set_world_size( {500.0f, 400.0f} );
+  physics.set_no_of_threads(no_of_threads);
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> position(0.0f, 400.0f);
+  std::uniform_real_distribution<float> velocity(-300.0f, 300.0f);
+  auto fix = [](Body2df * body, float) -> void {
+    if (body->get_position()[1] < 5.0f) {
+      body->mark_for_deletion();
+    } else if (body->get_position()[0] < 20.0f && body->get_time_to_delete() == 0.0f) {
+      body->set_time_to_delete(0.1f);
+    }
+  };
+  for (size_t i = 0; i < 1000; i++) {
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{ {position(gen) + 50.0f, position(gen)}, 1.0f },
+                                                               Vector2df{velocity(gen), velocity(gen)}, 1000.0f, 0.0f, 0.0f, fix );
+    physics.add_body(body);
+  }
+  for (size_t i = 0; i < 30; i++) {
+    physics.tick(1.0f / 30.0f);
+  }
+  std::vector<float> log;
+  for (auto & body : physics.get_bodies()) {
+    log.insert(log.end(), { body->get_position()[0], body->get_position()[1], body->get_time_to_delete() });
+  }
+  return log;
+}
+
+TEST(PHYSICS, ThreadsScheduleTheDeletionsOfTheFix) {
+  std::vector<float> serial = delete_in_fix_with_threads(1u);
+  EXPECT_GT(3 * 900u, serial.size());  // bodies have been deleted
+  EXPECT_LT(3 * 100u, serial.size());
+  for (size_t no_of_threads : { 2u, 3u, 8u }) {
+    std::vector<float> parallel = delete_in_fix_with_threads(no_of_threads);
+    ASSERT_EQ(serial.size(), parallel.size()) << no_of_threads;
+    EXPECT_EQ(0, std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(float))) << no_of_threads;
+  }
+}
+
+TEST(THREAD_POOL, RunsEachItemOnce) {
+  for (size_t no_of_threads : { 1u, 2u, 5u }) {
+    ThreadPool pool{no_of_threads};
+    EXPECT_EQ(no_of_threads, pool.get_no_of_threads());
+    for (size_t no_of_items : { 0u, 1u, 3u, 1000u }) {
+      std::vector<int> runs(no_of_items, 0);
+      std::vector<size_t> threads(no_of_items, 0);
+      pool.run(no_of_items, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          runs[i]++;
+          threads[i] = thread;
+        }
+      });
+      EXPECT_EQ(std::vector<int>(no_of_items, 1), runs);
+      // the chunks are contiguous and ordered by thread
+      EXPECT_TRUE(std::is_sorted(threads.begin(), threads.end()));
+    }
+  }
+}
+
+TEST(TIMER_WHEEL, ExpiresInOrderOfDeadlines) {
+  std::mt19937 gen(3);
+  // up to 2^25 ticks of the resolution, further than all levels of the wheel
+  std::uniform_real_distribution<double> deadline(0.0, 524288.0);
+  std::uniform_real_distribution<double> step(0.0, 4096.0);
+  TimerWheel<double, size_t> wheel;
+  std::vector<double> deadlines;
+  std::vector<size_t> handles;
+  for (size_t i = 0; i < 2000; i++) {
+    deadlines.push_back( i > 0 && i % 10 == 0 ? deadlines[i / 2] : deadline(gen) );  // some equal deadlines
+    handles.push_back( wheel.schedule(deadlines[i], i) );
+  }
+  std::vector<int> expirations(deadlines.size(), 0);
+  for (size_t i = 0; i < deadlines.size(); i += 7) {
+    wheel.cancel(handles[i]);
+  }
+  EXPECT_EQ(deadlines.size() - (deadlines.size() + 6) / 7, wheel.get_no_of_timers());
+  double previous_now = -1.0;
+  for (double now = 0.0; wheel.get_no_of_timers() > 0; now += step(gen)) {
+    std::vector<size_t> expired;
+    wheel.advance(now, [&](size_t i) { expired.push_back(i); });
+    for (size_t j = 0; j < expired.size(); j++) {
+      size_t i = expired[j];
+      expirations[i]++;
+      EXPECT_LE(deadlines[i], now);
+      EXPECT_GT(deadlines[i], previous_now);
+      if (j > 0) {
+        size_t previous = expired[j - 1];
+        EXPECT_TRUE(deadlines[previous] < deadlines[i] || (deadlines[previous] == deadlines[i] && previous < i));
+      }
+    }
+    previous_now = now;
+  }
+  for (size_t i = 0; i < deadlines.size(); i++) {
+    EXPECT_EQ(i % 7 == 0 ? 0 : 1, expirations[i]);
+  }
+}
+
+TEST(TIMER_WHEEL, ExpiredTimerCancelsAndSchedules) {
+  TimerWheel<float, std::function<void()> > wheel(0.25f);
+  std::vector<int> expired;
+  size_t cancelled = 0;
+  wheel.schedule(1.0f, [&]() { expired.push_back(1); wheel.cancel(cancelled); wheel.schedule(0.5f, [&]() { expired.push_back(3); }); });
+  cancelled = wheel.schedule(1.1f, [&]() { expired.push_back(2); });
+  wheel.advance(0.9f, [](std::function<void()> & callback) { callback(); });
+  EXPECT_TRUE(expired.empty());
+  wheel.advance(2.0f, [](std::function<void()> & callback) { callback(); });
+  EXPECT_EQ(std::vector<int>{1}, expired);
+  wheel.advance(2.0f, [](std::function<void()> & callback) { callback(); });
+  EXPECT_EQ((std::vector<int>{1, 3}), expired);
+  EXPECT_EQ(0, wheel.get_no_of_timers());
+}
+
+// 2^36 ticks of the resolution after time zero, stepping through them would take minutes
+TEST(TIMER_WHEEL, ClearStartsAtTheGivenTime) {
+  TimerWheel<double, int> wheel(1.0 / 64.0);
+  wheel.schedule(1.0, 1);
+  wheel.clear(1073741824.0);
+  EXPECT_EQ(0, wheel.get_no_of_timers());
+  std::vector<int> expired;
+  wheel.schedule(1073741825.0, 2);
+  wheel.schedule(1073741824.5, 1);
+  wheel.schedule(1073741900.0, 3);
+  wheel.advance(1073741824.25, [&](int i) { expired.push_back(i); });
+  EXPECT_TRUE(expired.empty());
+  wheel.advance(1073741825.0, [&](int i) { expired.push_back(i); });
+  EXPECT_EQ((std::vector<int>{1, 2}), expired);
+  wheel.advance(1073742000.0, [&](int i) { expired.push_back(i); });
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), expired);
+}
+
+// the timers continue at the restored time instead of stepping through 2^28 ticks from time zero
+TEST(PHYSICS, RestoreAtLateTime) {
+  std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+  body->set_time_to_delete(2.0f);
+  Body2df::State state = body->get_state();
+  state.delete_time = 4194306.0f;
+  state.birth_time = 4194290.0f;
+  body->set_state(state);
+  std::vector< std::unique_ptr<Body2df> > bodies, bodies_to_add;
+  bodies.push_back( std::move(body) );
+  Physics2df physics{};
+  physics.tick(1.0f);
+  physics.restore(4194304.0f, 1.0f, 4194304u, bodies, bodies_to_add, {});
+  std::vector<int> expired;
+  physics.add_timer(4194305.0f, [&]() { expired.push_back(1); });
+  physics.tick(1.0f);
+  EXPECT_EQ(std::vector<int>{1}, expired);
+  EXPECT_FALSE(physics.get_bodies()[0]->is_marked_for_deletion());
+  physics.tick(1.0f);
+  EXPECT_TRUE(physics.get_bodies()[0]->is_marked_for_deletion());
+  physics.tick(1.0f);
+  EXPECT_EQ(0, physics.get_bodies().size());
+  EXPECT_FLOAT_EQ(4194307.0f, physics.get_time());
+}
+
+// a float time would no longer grow by a tick of 1/60 s at 2^19 s
+TEST(PHYSICS, ClockAdvancesAfterLongSimulations) {
+  Physics2df physics{};
+  std::vector< std::unique_ptr<Body2df> > bodies, bodies_to_add;
+  physics.restore(524288.0, 1.0f / 60.0f, 31457280u, bodies, bodies_to_add, {});
+  std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+  Body2df * b = body.get();
+  b->set_time_to_delete(0.5f);
+  physics.add_body(body);
+  std::vector<size_t> expired;
+  size_t ticks = 0;
+  physics.add_timer(524289.0, [&]() { expired.push_back(ticks); });
+  for (; ticks < 29; ticks++) {
+    physics.tick(1.0f / 60.0f);
+  }
+  EXPECT_NEAR(29.0 / 60.0, b->get_age(), 1e-5);
+  EXPECT_NEAR(1.0f / 60.0f, b->get_time_to_delete(), 1e-5);
+  EXPECT_FALSE(b->is_marked_for_deletion());
+  for (; ticks < 60; ticks++) {
+    physics.tick(1.0f / 60.0f);
+  }
+  EXPECT_EQ(0, physics.get_bodies().size());
+  EXPECT_EQ(std::vector<size_t>{59}, expired);
+  EXPECT_NEAR(524289.0, physics.get_time(), 1e-5);
+}
+
+TEST(PHYSICS, TimersExpireAtEndOfTick) {
+  Physics2df physics{};
+  std::vector<int> expired;
+  physics.add_timer(2.0f, [&]() { expired.push_back(2); });
+  physics.add_timer(1.5f, [&]() { expired.push_back(1); });
+  size_t cancelled = physics.add_timer(1.0f, [&]() { expired.push_back(0); });
+  physics.cancel_timer(cancelled);
+  physics.tick(1.0f);
+  EXPECT_TRUE(expired.empty());
+  physics.tick(1.0f);
+  EXPECT_FLOAT_EQ(2.0f, physics.get_time());
+  EXPECT_EQ((std::vector<int>{1, 2}), expired);
+}
+
+TEST(PHYSICS, TimeToDeleteContinuesWhenBodyIsAdded) {
+  std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{0.0, 0.0} );
+  Body2df * b = body.get();
+  b->set_time_to_delete(3.0f);
+  b->move(0.5f);
+  Physics2df physics{};
+  physics.tick(1.0f);
+  physics.add_body(body);
+  physics.tick(1.0f);
+  EXPECT_FLOAT_EQ(1.5f, b->get_age());
+  EXPECT_FLOAT_EQ(1.5f, b->get_time_to_delete());
+  physics.tick(1.0f);
+  EXPECT_FALSE(b->is_marked_for_deletion());
+  physics.tick(1.0f);
+  EXPECT_TRUE(b->is_marked_for_deletion());
+  EXPECT_EQ(1, physics.get_bodies().size());
+  physics.tick(1.0f);
+  EXPECT_EQ(0, physics.get_bodies().size());
+}
+
+TEST(PHYSICS, CustomBroadPhase) {
+  std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{0.0, 0.0} );
+  std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({2.0, 2.0}, 1.0), Vector2df{0.0, 0.0} );
+  size_t collisions = 0;
+  Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                      [&](Body2df *, Body2df * ) -> void { collisions++; } };
+  auto strategy = std::make_unique<NoPairsBroadPhase>();
+  NoPairsBroadPhase * no_pairs = strategy.get();
+  physics.set_broad_phase( std::move(strategy) );
+  physics.add_body( body1 );
+  physics.add_body( body2 );
+  physics.tick(1.0);
+  EXPECT_EQ(BroadPhase::custom, physics.get_broad_phase());
+  EXPECT_EQ(1, no_pairs->no_of_calls);
+  EXPECT_EQ(0, collisions);
+}
+
+// a torpedo (radius 1, 768 pixel per second) is fired at a small saucer (radius 7),
+// it must hit the saucer at every tick rate instead of jumping over it
+void expect_fast_body_hits(BroadPhase broad_phase, float tick_time) {
+  std::unique_ptr<Body2df> torpedo = std::make_unique<Body2df>( BoundingVolume2df({0.0, 0.0}, 1.0), Vector2df{768.0, 0.0}, 768.0f );
+  std::unique_ptr<Body2df> saucer = std::make_unique<Body2df>( BoundingVolume2df({90.0, 0.0}, 7.0), Vector2df{0.0, 0.0} );
+  Body2df * t = torpedo.get();
+  size_t collisions = 0;
+  Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                      [&](Body2df * body1, Body2df * ) -> void { collisions++; body1->mark_for_deletion(); } };
+  physics.set_broad_phase(broad_phase);
+  physics.add_body( torpedo );
+  physics.add_body( saucer );
+  for (float time = 0.0f; time < 0.5f; time += tick_time) {
+    physics.tick(tick_time);
+  }
+  EXPECT_EQ(1, collisions) << "tick time " << tick_time;
+  EXPECT_EQ(1, physics.get_bodies().size());
+  EXPECT_NE(t, physics.get_body(0));
+}
+
+TEST(PHYSICS, FastBodyDoesNotTunnel) {
+  for (float tick_time : { 1.0f / 30.0f, 1.0f / 60.0f, 1.0f / 144.0f, 1.0f / 240.0f }) {
+    expect_fast_body_hits(BroadPhase::brute_force, tick_time);
+    for (BroadPhase broad_phase : broad_phases) {
+      expect_fast_body_hits(broad_phase, tick_time);
+    }
+  }
+}
+
+TEST(PHYSICS, FastBodiesCrossingEachOther) {
+  for (BroadPhase broad_phase : broad_phases) {
+    std::unique_ptr<Body2df> body1 = std::make_unique<Body2df>( BoundingVolume2df({-5.0, 0.0}, 1.0), Vector2df{20.0, 0.0}, 20.0f );
+    std::unique_ptr<Body2df> body2 = std::make_unique<Body2df>( BoundingVolume2df({0.0, -5.0}, 1.0), Vector2df{0.0, 20.0}, 20.0f );
+    size_t collisions = 0;
+    Physics2df physics{ [](Body2df *, Body2df * ) -> bool { return true; },
+                        [&](Body2df *, Body2df * ) -> void { collisions++; } };
+    physics.set_broad_phase(broad_phase);
+    physics.add_body( body1 );
+    physics.add_body( body2 );
+    physics.tick(0.5);
+    EXPECT_EQ(1, collisions) << static_cast<int>(broad_phase);
+  }
+}
+
+
+TEST(DENSE_PHYSICS, TickCheckMovement) {
+  DensePhysics2df physics{};
+  BodyHandle h1 = physics.add_body( {2.0, 2.0}, 1.0, {-0.5, -0.5} );
+  BodyHandle h2 = physics.add_body( {0.0, 0.0}, 1.0, {0.0, -1.0} );
+  physics.tick(1.0);
+  EXPECT_NEAR(1.5, physics.get_body(h1).get_position()[0], 0.00001);
+  EXPECT_NEAR(1.5, physics.get_body(h1).get_position()[1], 0.00001);
+  EXPECT_NEAR(0.0, physics.get_body(h2).get_position()[0], 0.00001);
+  EXPECT_NEAR(-1.0, physics.get_body(h2).get_position()[1], 0.00001);
+}
+
+TEST(DENSE_PHYSICS, TickCheckCollision) {
+  bool collision_ok = false;
+  DensePhysics2df physics{ [](DenseBody2df, DenseBody2df) -> bool { return true; },
+                           [&](DenseBody2df body_1, DenseBody2df body_2) -> void { collision_ok = (body_1.get_handle() == 1u && body_2.get_handle() == 2u); } };
+  physics.add_body( {2.0, 2.0}, 1.0, {-0.5, -0.5} );
+  physics.add_body( {0.0, 0.0}, 1.0, {0.0, -1.0} );
+  physics.add_body( {0.0, -3.0}, 1.0, {0.0, 0.5} );
+  physics.tick(1.0); // only one collision between body2 and body3 has to be reported
+  EXPECT_TRUE(collision_ok);
+}
+
+TEST(DENSE_PHYSICS, TickBodiesDeletedWhenMarkedForDeletion) {
+  std::vector<BodyHandle> deleted;
+  DensePhysics2df physics{ [](DenseBody2df, DenseBody2df) -> bool { return true; },
+                           [](DenseBody2df, DenseBody2df) -> void { },
+                           [&](DenseBody2df body) -> void { deleted.push_back(body.get_handle()); } };
+  BodyHandle h1 = physics.add_body( {2.0, 2.0}, 1.0, {-0.5, -0.5} );
+  BodyHandle h2 = physics.add_body( {0.0, 0.0}, 1.0, {0.0, -1.0} );
+  BodyHandle h3 = physics.add_body( {0.0, -3.0}, 1.0, {0.0, 0.5} );
+  physics.get_body(h1).set_time_to_delete(1.0);
+  physics.get_body(h3).set_time_to_delete(2.1);
+  physics.tick(1.0);
+  physics.get_body(h2).mark_for_deletion();
+  physics.tick(1.0);
+  EXPECT_EQ( (std::vector<BodyHandle>{h1, h2}), deleted );
+  EXPECT_EQ(1, physics.size());
+  EXPECT_FALSE( physics.contains(h1) );
+  EXPECT_FALSE( physics.contains(h2) );
+  EXPECT_TRUE( physics.contains(h3) );
+  EXPECT_NEAR(-2.0, physics.get_body(h3).get_position()[1], 0.00001);
+}
+
+TEST(DENSE_PHYSICS, HandlesAreReused) {
+  DensePhysics2df physics{};
+  BodyHandle h1 = physics.add_body( {2.0, 2.0}, 1.0, {0.0, 0.0} );
+  physics.get_body(h1).mark_for_deletion();
+  physics.tick(1.0);
+  BodyHandle h2 = physics.add_body( {0.0, 0.0}, 1.0, {0.0, 0.0} );
+  EXPECT_EQ(h1, h2);
+  EXPECT_TRUE( physics.contains(h2) );
+}
+
+TEST(DENSE_PHYSICS, FastBodyDoesNotTunnel) {
+  for (float tick_time : { 1.0f / 30.0f, 1.0f / 240.0f }) {
+    size_t collisions = 0;
+    DensePhysics2df physics{ [](DenseBody2df, DenseBody2df) -> bool { return true; },
+                             [&](DenseBody2df body1, DenseBody2df) -> void { collisions++; body1.mark_for_deletion(); } };
+    physics.add_body( {0.0, 0.0}, 1.0, {768.0, 0.0} );
+    physics.add_body( {90.0, 0.0}, 7.0, {0.0, 0.0} );
+    for (float time = 0.0f; time < 0.5f; time += tick_time) {
+      physics.tick(tick_time);
+    }
+    EXPECT_EQ(1, collisions) << "tick time " << tick_time;
+    EXPECT_EQ(1, physics.size());
+  }
+}
+
+TEST(DENSE_PHYSICS, ResolvesSameCollisionsAsPhysics) {
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> position(0.0f, 1024.0f);
+  std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(0.0f, 33.0f);
+  std::map< Body2df *, size_t > index;
+  std::vector< std::pair<size_t, size_t> > collisions, dense_collisions;
+
+  Physics2df physics{ [](Body2df *, Body2df *) -> bool { return true; },
+                      [&](Body2df * b1, Body2df * b2) -> void { collisions.push_back( {index[b1], index[b2]} ); } };
+  DensePhysics2df dense_physics{ [](DenseBody2df, DenseBody2df) -> bool { return true; },
+                                 [&](DenseBody2df b1, DenseBody2df b2) -> void { dense_collisions.push_back( {b1.get_handle(), b2.get_handle()} ); } };
+  for (size_t i = 0; i < 500; i++) {
+    Vector2df p{position(gen), position(gen)};
+    Vector2df v{velocity(gen), velocity(gen)};
+    float r = radius(gen);
+    std::unique_ptr<Body2df> body = std::make_unique<Body2df>( BoundingVolume2df{p, r}, v, 1000.0f );
+    index[body.get()] = i;
+    physics.add_body(body);
+    dense_physics.add_body(p, r, v);
+  }
+  for (size_t i = 0; i < 10; i++) {
+    physics.tick(1.0f / 60.0f);
+    dense_physics.tick(1.0f / 60.0f);
+  }
+  EXPECT_LT(0, collisions.size());
+  EXPECT_EQ(collisions, dense_collisions);
+}
+
 }
@@ -0,0 +1,91 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// a stream of random numbers of a counter-based generator (Philox4x32-10 of Salmon et al.,
+// "Parallel random numbers: as easy as 1, 2, 3"): the n-th block of four numbers of a stream is a function
+// of the seed, the number of the stream and n alone, so the streams of one seed are independent of each other,
+// a stream only has to store its position and the blocks of a batch can be computed independently (see fill())
+// the streams are trivially copyable, so they can be stored in a snapshot as they are
+class RandomStream {
+public:
+  typedef std::array<std::uint32_t, 4> Block;
+  typedef std::array<std::uint32_t, 2> Key;
+private:
+  static constexpr size_t NO_OF_ROUNDS = 10;
+  static constexpr std::uint32_t MULTIPLIER0 = 0xD2511F53u;
+  static constexpr std::uint32_t MULTIPLIER1 = 0xCD9E8D57u;
+  static constexpr std::uint32_t WEYL0 = 0x9E3779B9u;
+  static constexpr std::uint32_t WEYL1 = 0xBB67AE85u;
+
+  // ordered without padding, so a copy in a snapshot only consists of these values
+  Key key;
+  std::uint32_t stream;
+  std::uint32_t next_in_block = 4;  // 4, if the current block is used up
+  std::uint64_t next_block = 0;     // number of the next block of the stream
+  Block block{};                    // the current block
+
+  Block get_counter(std::uint64_t n) const {
+    return { static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(n >> 32), stream, 0u };
+  }
+
+  // the 24 high bits of the number as a float in [0, 1), every float of the result is equally likely
+  static float to_float(std::uint32_t number) {
+    return static_cast<float>(number >> 8) * (1.0f / 16777216.0f);
+  }
+
+public:
+  // the streams of one seed are distinguished by their numbers, e.g. one stream for each subsystem
+  explicit RandomStream(std::uint64_t seed = 0u, std::uint32_t stream = 0u)
+    : key{ static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32) }, stream(stream) { }
+
+  // the block of the generator for a counter and a key
+  static constexpr Block philox(Block counter, Key key) {
+    for (size_t round = 0; round < NO_OF_ROUNDS; round++) {
+      std::uint64_t product0 = static_cast<std::uint64_t>(MULTIPLIER0) * counter[0];
+      std::uint64_t product1 = static_cast<std::uint64_t>(MULTIPLIER1) * counter[2];
+      counter = { static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<std::uint32_t>(product1),
+                  static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<std::uint32_t>(product0) };
+      key[0] += WEYL0;
+      key[1] += WEYL1;
+    }
+    return counter;
+  }
+
+  std::uint32_t next() {
+    if (next_in_block == 4) {
+      block = philox(get_counter(next_block++), key);
+      next_in_block = 0;
+    }
+    return block[next_in_block++];
+  }
+
+  // a float in [0, 1)
+  float uniform() {
+    return to_float( next() );
+  }
+
+  // fills the values with the same floats as values.size() calls of uniform(),
+  // the whole blocks in between are computed without dependencies between them, so the compiler can vectorize them
+  void fill(std::span<float> values) {
+    size_t i = 0;
+    for (; i < values.size() && next_in_block < 4; i++) {
+      values[i] = to_float( block[next_in_block++] );
+    }
+    for (; values.size() - i >= 4; i += 4) {
+      Block numbers = philox(get_counter(next_block++), key);
+      for (size_t j = 0; j < 4; j++) {
+        values[i + j] = to_float( numbers[j] );
+      }
+    }
+    for (; i < values.size(); i++) {
+      values[i] = uniform();
+    }
+  }
+};
+
+#endif
@@ -7,11 +7,17 @@
 class Renderer {
 protected:
   Game & game;  
+  float interpolation = 1.0f;
 public:
   Renderer(Game & game) : game(game) { }
   virtual bool init() = 0;
   virtual void render() = 0;
   virtual void exit() = 0;
+
+  // bodies are drawn between their previous (0.0) and current (1.0, default) position of the last tick
+  void set_interpolation(float alpha) {
+    interpolation = alpha;
+  }
 };
 
 #endif
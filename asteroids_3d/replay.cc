@@ -0,0 +1,331 @@
+#include "replay.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+constexpr char MAGIC[4] = {'A', 'S', 'T', 'R'};
+
+void write_varint(std::vector<std::uint8_t> & out, std::uint64_t value) {
+  while (value >= 0x80u) {
+    out.push_back( static_cast<std::uint8_t>(value | 0x80u) );
+    value >>= 7;
+  }
+  out.push_back( static_cast<std::uint8_t>(value) );
+}
+
+void write_u64(std::vector<std::uint8_t> & out, std::uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    out.push_back( static_cast<std::uint8_t>(value >> (8 * i)) );
+  }
+}
+
+// reads the encoded replay, throws std::invalid_argument if it ends early
+class Reader {
+  std::span<const std::uint8_t> data;
+  size_t position = 0;
+public:
+  Reader(std::span<const std::uint8_t> data) : data(data) { }
+
+  std::uint8_t byte() {
+    if (position >= data.size()) {
+      throw std::invalid_argument("replay data is truncated");
+    }
+    return data[position++];
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      std::uint8_t b = byte();
+      value |= static_cast<std::uint64_t>(b & 0x7Fu) << shift;
+      if ((b & 0x80u) == 0) {
+        return value;
+      }
+    }
+    throw std::invalid_argument("malformed varint in replay data");
+  }
+
+  std::uint64_t u64() {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+      value |= static_cast<std::uint64_t>(byte()) << (8 * i);
+    }
+    return value;
+  }
+
+  size_t remaining() const {
+    return data.size() - position;
+  }
+};
+
+// FNV-1a
+class Hash {
+  std::uint64_t hash = 14695981039346656037ULL;
+public:
+  void add(std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xFFu;
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  void add(float value) {
+    add( static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(value)) );
+  }
+
+  std::uint64_t get() const {
+    return hash;
+  }
+};
+
+}
+
+std::uint64_t game_checksum(Game & game) {
+  Hash hash;
+  hash.add( static_cast<std::uint64_t>(game.get_score()) );
+  hash.add( game.get_no_of_ships() );
+  for (auto & body : game.get_physics().get_bodies()) {
+    TypedBody * typed_body = static_cast<TypedBody *>(body.get());
+    hash.add( static_cast<std::uint64_t>(typed_body->get_type()) );
+    Vector2df position = body->get_position();
+    Vector2df velocity = body->get_velocity();
+    hash.add(position[0]);
+    hash.add(position[1]);
+    hash.add(velocity[0]);
+    hash.add(velocity[1]);
+    hash.add(body->get_angle());
+  }
+  return hash.get();
+}
+
+// class Replay
+
+Replay::Replay(std::uint32_t seed, float tick_time, std::uint64_t keyframe_interval)
+  : seed(seed), tick_time(tick_time), keyframe_interval(keyframe_interval) { }
+
+void Replay::record(Input input, Game & game) {
+  if (keyframe_interval > 0 && inputs.size() % keyframe_interval == 0) {
+    keyframes.push_back( Keyframe{inputs.size(), game_checksum(game), {}} );
+    game.snapshot(keyframes.back().state);
+  }
+  inputs.push_back(input);
+}
+
+std::uint32_t Replay::get_seed() const {
+  return seed;
+}
+
+float Replay::get_tick_time() const {
+  return tick_time;
+}
+
+std::uint64_t Replay::get_keyframe_interval() const {
+  return keyframe_interval;
+}
+
+const std::vector<Input> & Replay::get_inputs() const {
+  return inputs;
+}
+
+const std::vector<Keyframe> & Replay::get_keyframes() const {
+  return keyframes;
+}
+
+std::vector<std::uint8_t> Replay::encode() const {
+  std::vector<std::uint8_t> out(std::begin(MAGIC), std::end(MAGIC));
+  write_varint(out, VERSION);
+  write_varint(out, seed);
+  write_varint(out, std::bit_cast<std::uint32_t>(tick_time));
+  write_varint(out, keyframe_interval);
+  write_varint(out, inputs.size());
+
+  std::vector<std::pair<Input, std::uint64_t>> runs;
+  for (Input input : inputs) {
+    if (runs.empty() || runs.back().first != input) {
+      runs.push_back( {input, 0u} );
+    }
+    runs.back().second++;
+  }
+  write_varint(out, runs.size());
+  for (auto [input, length] : runs) {
+    out.push_back(input);
+    write_varint(out, length);
+  }
+
+  write_varint(out, keyframes.size());
+  for (const Keyframe & keyframe : keyframes) {
+    write_varint(out, keyframe.tick);
+    write_u64(out, keyframe.checksum);
+    write_varint(out, keyframe.state.size());
+    out.insert(out.end(), keyframe.state.begin(), keyframe.state.end());
+  }
+  return out;
+}
+
+Replay Replay::decode(std::span<const std::uint8_t> data) {
+  Reader reader(data);
+  for (char c : MAGIC) {
+    if (reader.byte() != static_cast<std::uint8_t>(c)) {
+      throw std::invalid_argument("not a replay");
+    }
+  }
+  if (reader.varint() != VERSION) {
+    throw std::invalid_argument("unsupported replay version");
+  }
+  std::uint32_t seed = static_cast<std::uint32_t>( reader.varint() );
+  float tick_time = std::bit_cast<float>( static_cast<std::uint32_t>(reader.varint()) );
+  std::uint64_t keyframe_interval = reader.varint();
+  Replay replay(seed, tick_time, keyframe_interval);
+
+  std::uint64_t no_of_ticks = reader.varint();
+  std::uint64_t no_of_runs = reader.varint();
+  for (std::uint64_t i = 0; i < no_of_runs; i++) {
+    Input input = reader.byte();
+    std::uint64_t length = reader.varint();
+    if (length > no_of_ticks - replay.inputs.size()) {
+      throw std::invalid_argument("replay inputs exceed the number of ticks");
+    }
+    replay.inputs.insert(replay.inputs.end(), length, input);
+  }
+  if (replay.inputs.size() != no_of_ticks) {
+    throw std::invalid_argument("replay inputs do not match the number of ticks");
+  }
+
+  std::uint64_t no_of_keyframes = reader.varint();
+  for (std::uint64_t i = 0; i < no_of_keyframes; i++) {
+    Keyframe keyframe;
+    keyframe.tick = reader.varint();
+    keyframe.checksum = reader.u64();
+    std::uint64_t state_size = reader.varint();
+    if (state_size > reader.remaining()) {
+      throw std::invalid_argument("replay data is truncated");
+    }
+    keyframe.state.resize(state_size);
+    for (auto & b : keyframe.state) {
+      b = reader.byte();
+    }
+    replay.keyframes.push_back( std::move(keyframe) );
+  }
+  return replay;
+}
+
+void Replay::save(std::ostream & out) const {
+  std::vector<std::uint8_t> data = encode();
+  out.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+Replay Replay::load(std::istream & in) {
+  std::vector<std::uint8_t> data{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+  return decode(data);
+}
+
+// class RecordingInputSource
+
+RecordingInputSource::RecordingInputSource(InputSource & input_source, Replay & replay, Game & game)
+  : input_source(input_source), replay(replay), game(game) { }
+
+Input RecordingInputSource::next_input() {
+  Input input = input_source.next_input();
+  replay.record(input, game);
+  return input;
+}
+
+// class ReplayInputSource
+
+ReplayInputSource::ReplayInputSource(const Replay & replay, Game & game) : replay(replay), game(game) { }
+
+Input ReplayInputSource::next_input() {
+  const auto & keyframes = replay.get_keyframes();
+  if (next_keyframe < keyframes.size() && keyframes[next_keyframe].tick == tick) {
+    if (keyframes[next_keyframe].checksum != game_checksum(game)) {
+      desynchronized = true;
+    }
+    next_keyframe++;
+  }
+  const auto & inputs = replay.get_inputs();
+  Input input = (tick < inputs.size() ? inputs[tick] : 0u);
+  tick++;
+  return input;
+}
+
+void ReplayInputSource::set_tick(size_t tick) {
+  const auto & keyframes = replay.get_keyframes();
+  this->tick = tick;
+  next_keyframe = std::lower_bound(keyframes.begin(), keyframes.end(), tick,
+                                   [](const Keyframe & keyframe, size_t tick) { return keyframe.tick < tick; }) - keyframes.begin();
+}
+
+bool ReplayInputSource::is_desynchronized() const {
+  return desynchronized;
+}
+
+// class ReplayPlayer
+
+ReplayPlayer::ReplayPlayer(const Replay & replay) : replay(replay) {
+  restart();
+  for (const Keyframe & keyframe : replay.get_keyframes()) {
+    if ( ! keyframe.state.empty() ) {
+      snapshots.push_back( Snapshot{keyframe.tick + 1, keyframe.state, true} );
+    }
+  }
+}
+
+void ReplayPlayer::restart() {
+  controller.reset();
+  input_source.reset();
+  game.reset();
+  game = std::make_unique<Game>(replay.get_seed());
+  input_source = std::make_unique<ReplayInputSource>(replay, *game);
+  controller = std::make_unique<HeadlessGameController>(*game, *input_source, replay.get_tick_time());
+}
+
+void ReplayPlayer::seek(size_t tick) {
+  auto snapshot = std::upper_bound(snapshots.begin(), snapshots.end(), tick,
+                                   [](size_t tick, const Snapshot & snapshot) { return tick < snapshot.tick; });
+  if (snapshot != snapshots.begin() && (tick < controller->get_ticks() || (snapshot - 1)->tick > controller->get_ticks())) {
+    snapshot--;
+    try {
+      game->restore(snapshot->state);
+      size_t restored_tick = snapshot->of_keyframe ? snapshot->tick - 1 : snapshot->tick;
+      input_source->set_tick(restored_tick);
+      controller->set_ticks(restored_tick);
+      if (snapshot->of_keyframe) {
+        controller->apply_next_input();
+      }
+    } catch (const std::invalid_argument &) {
+      // the states of the keyframes were taken by another build, the game is left unchanged by restore()
+      snapshots.clear();
+      if (tick < controller->get_ticks()) {
+        restart();
+      }
+    }
+  } else if (tick < controller->get_ticks()) {
+    restart();
+  }
+  std::uint64_t interval = replay.get_keyframe_interval();
+  while (controller->get_ticks() < tick) {
+    size_t ticks = controller->get_ticks();
+    if (interval > 0 && ticks % interval == 0 && (snapshots.empty() || snapshots.back().tick < ticks)) {
+      snapshots.push_back( Snapshot{ticks, {}, false} );
+      game->snapshot(snapshots.back().state);
+    }
+    controller->do_user_interactions();
+    controller->do_game_events();
+  }
+}
+
+size_t ReplayPlayer::get_tick() const {
+  return controller->get_ticks();
+}
+
+Game & ReplayPlayer::get_game() {
+  return *game;
+}
+
+bool ReplayPlayer::is_desynchronized() const {
+  return input_source->is_desynchronized();
+}
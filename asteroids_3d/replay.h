@@ -0,0 +1,119 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+#include "game_controller.h"
+#include "headless_game_controller.h"
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <istream>
+#include <ostream>
+#include <memory>
+
+// the checksum and the snapshot of the game at the start of a tick (see Game::snapshot()), the checksum verifies
+// replays, the state lets the ReplayPlayer seek without playing the ticks before the keyframe
+struct Keyframe {
+  std::uint64_t tick;
+  std::uint64_t checksum;
+  std::vector<std::uint8_t> state;
+};
+
+// returns a hash of the score, free ships and all bodies (type, position, velocity, angle) of the game
+std::uint64_t game_checksum(Game & game);
+
+// a recorded game session: the random seed, the tick time, the input of each tick and periodic keyframes
+// the binary format (all integers are little endian varints, unless stated otherwise) is
+//   "ASTR"  version  seed  tick_time (float bits)  keyframe_interval  no_of_ticks
+//   no_of_runs  { input (1 byte)  length }*
+//   no_of_keyframes  { tick  checksum (8 bytes)  state_size  state }*
+// the inputs are run-length coded, because a button combination is usually held for many ticks
+class Replay {
+  std::uint32_t seed;
+  float tick_time;
+  std::uint64_t keyframe_interval;
+  std::vector<Input> inputs;
+  std::vector<Keyframe> keyframes;
+public:
+  // 2: the games draw from seeded Philox streams, so replays of version 1 do not play back identically
+  static constexpr std::uint32_t VERSION = 2u;
+
+  Replay(std::uint32_t seed = 0u, float tick_time = 1.0f / 60.0f, std::uint64_t keyframe_interval = 600u);
+
+  // records the input of the next tick, the game must have been ticked but the input not applied yet
+  // every keyframe_interval ticks a keyframe with a snapshot of the game is added
+  void record(Input input, Game & game);
+
+  std::uint32_t get_seed() const;
+  float get_tick_time() const;
+  std::uint64_t get_keyframe_interval() const;
+  const std::vector<Input> & get_inputs() const;
+  const std::vector<Keyframe> & get_keyframes() const;
+
+  std::vector<std::uint8_t> encode() const;
+
+  // throws std::invalid_argument if data is not a valid replay
+  static Replay decode(std::span<const std::uint8_t> data);
+
+  void save(std::ostream & out) const;
+  static Replay load(std::istream & in);
+};
+
+// records the inputs of another InputSource into a replay
+class RecordingInputSource : public InputSource {
+  InputSource & input_source;
+  Replay & replay;
+  Game & game;
+public:
+  RecordingInputSource(InputSource & input_source, Replay & replay, Game & game);
+  virtual Input next_input();
+};
+
+// plays the inputs of a replay and verifies the keyframes on the way
+// after the last recorded tick the input is empty
+class ReplayInputSource : public InputSource {
+  const Replay & replay;
+  Game & game;
+  size_t tick = 0;
+  size_t next_keyframe = 0;
+  bool desynchronized = false;
+public:
+  ReplayInputSource(const Replay & replay, Game & game);
+  virtual Input next_input();
+  // continues with the input of the given tick, e.g. after a snapshot of the game at this tick has been restored
+  void set_tick(size_t tick);
+  // returns true, if a keyframe's checksum did not match the game
+  bool is_desynchronized() const;
+};
+
+// plays a replay headless and seeks to arbitrary ticks
+// the player starts with the states of the keyframes and takes a snapshot of the game at each keyframe it plays
+// without a state, seeking restores the latest snapshot before the tick, if it is closer than the current tick,
+// and plays the remaining ticks at headless speed; the states of a replay recorded by another build of the game
+// cannot be restored, then the player only uses its own snapshots
+class ReplayPlayer {
+  // a snapshot of the game after the given number of ticks, or the state of a keyframe, which is continued by
+  // applying the input of the keyframe's tick, so it counts as taken after that tick
+  struct Snapshot {
+    size_t tick;
+    std::vector<std::uint8_t> state;
+    bool of_keyframe;
+  };
+  const Replay & replay;
+  std::vector<Snapshot> snapshots;  // ordered by their ticks
+  std::unique_ptr<Game> game;
+  std::unique_ptr<ReplayInputSource> input_source;
+  std::unique_ptr<HeadlessGameController> controller;
+  void restart();
+public:
+  ReplayPlayer(const Replay & replay);
+
+  // advances the game until tick ticks (tick and input) have been played
+  void seek(size_t tick);
+
+  size_t get_tick() const;
+  Game & get_game();
+  bool is_desynchronized() const;
+};
+
+#endif
@@ -21,38 +21,36 @@ void SDL2GameController::set_fps(int fps) {
 }
 
 
-void SDL2GameController::do_user_interactions() {
-  debug(2, "do_user_interactions() entry...");
-  const Uint8 *keys = SDL_GetKeyboardState(NULL);
- 
+void SDL2GameController::set_recording(Replay * recording) {
+  this->recording = recording;
+}
+
+void SDL2GameController::handle_events() {
   SDL_Event e;
   while ( SDL_PollEvent( &e ) ) {
     if (e.type == SDL_QUIT ) {
       quit = true;
     }
   }
+}
+
+void SDL2GameController::do_user_interactions() {
+  debug(2, "do_user_interactions() entry...");
+  const Uint8 *keys = SDL_GetKeyboardState(NULL);
 
   if (! quit) {
     game.tick(tick_time);
     sound.tick(tick_time);
 
-    if ( game.ship_exists() ) {
-      if ( keys[SDL_SCANCODE_LEFT] ) {
-        game.get_ship()->turn_left(tick_time);
-      }
-      if ( keys[SDL_SCANCODE_RIGHT] ) {
-        game.get_ship()->turn_right(tick_time);
-      }
-      if ( keys[SDL_SCANCODE_UP] ) {
-        game.accelerate_ship(tick_time);
-      }
-      if ( keys[SDL_SCANCODE_D] ) {
-        game.ship_shoots();
-      }
-      if ( keys[SDL_SCANCODE_SPACE] ) {
-        game.hyperspace();
-      }
+    Input input = (keys[SDL_SCANCODE_LEFT] ? LEFT : 0u)
+                | (keys[SDL_SCANCODE_RIGHT] ? RIGHT : 0u)
+                | (keys[SDL_SCANCODE_UP] ? THRUST : 0u)
+                | (keys[SDL_SCANCODE_D] ? FIRE : 0u)
+                | (keys[SDL_SCANCODE_SPACE] ? HYPERSPACE : 0u);
+    if (recording != nullptr) {
+      recording->record(input, game);
     }
+    apply_input(input, tick_time);
   }
   debug(2, "do_user_interactions() exit.");
 }
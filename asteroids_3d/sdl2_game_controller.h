@@ -5,6 +5,7 @@
 #include "game_controller.h"
 #include "timer.h"
 #include "sound.h"
+#include "replay.h"
 #include <span>
 
 class SDL2GameController : public GameController {
@@ -14,12 +15,18 @@ class SDL2GameController : public GameController {
   int fps;
   Sound sound;
   Effect backgroundSound = Effect( std::span{beats}, MAX_DISTANCE_BETWEEN_BEATS, 10.0f);
+  Replay * recording = nullptr;
 public:
   SDL2GameController(Game & game);
+  // handles the SDL events (once per frame), for instance, quitting the game
+  void handle_events();
+  // advances the game by one tick with the buttons currently pressed
   virtual void do_user_interactions();
   virtual void do_game_events();
   float get_tick_time() const;
   void set_fps(int fps);
+  // records the input of each tick into the given replay, nullptr stops recording
+  void set_recording(Replay * recording);
 };
 
 #endif
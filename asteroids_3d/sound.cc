@@ -1,4 +1,5 @@
 #include "sound.h"
+#include "trace.h"
 
 Effect::Effect(std::span<SoundId> wave_ids, float interval_between_sounds, float duration)
  : interval_between_sounds(interval_between_sounds), duration(duration) {
@@ -62,6 +63,7 @@ void Sound::erase_effect(Effect * effect) {
 }
 
 void Sound::tick(float seconds) {
+  trace_zone("Sound::tick");
   for (Effect * effect : effects) {
     effect->current_duration += seconds;
     effect->current_interval += seconds;
@@ -0,0 +1,104 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed number of threads, that process the items [0, no_of_items) of a run() together
+// the items are split into one contiguous chunk per thread, thread i always gets the i-th chunk, so a run() with
+// the same number of items and threads always passes the same items to the same thread; the calling thread
+// processes the first chunk itself
+// the work must not throw exceptions
+class ThreadPool {
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_available;
+  std::condition_variable work_done;
+  const std::function<void(size_t, size_t, size_t)> * work = nullptr;
+  size_t no_of_items = 0;
+  size_t generation = 0;          // incremented by each run(), so each worker processes each run once
+  size_t no_of_busy_workers = 0;
+  bool stopping = false;
+
+  // calls work(thread, begin, end) for the chunk of the given thread, if it is not empty
+  void process_chunk(const std::function<void(size_t, size_t, size_t)> & work, size_t no_of_items, size_t thread) const {
+    size_t no_of_threads = get_no_of_threads();
+    size_t begin = no_of_items * thread / no_of_threads;
+    size_t end = no_of_items * (thread + 1) / no_of_threads;
+    if (begin < end) {
+      work(thread, begin, end);
+    }
+  }
+
+  void work_loop(size_t thread) {
+    size_t processed_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      work_available.wait(lock, [&]() { return stopping || generation != processed_generation; });
+      if (stopping) {
+        return;
+      }
+      processed_generation = generation;
+      const std::function<void(size_t, size_t, size_t)> * current_work = work;
+      size_t current_no_of_items = no_of_items;
+      lock.unlock();
+      process_chunk(*current_work, current_no_of_items, thread);
+      lock.lock();
+      if (--no_of_busy_workers == 0) {
+        work_done.notify_one();
+      }
+    }
+  }
+
+public:
+  // no_of_threads includes the calling thread, so ThreadPool(1) runs all work in the calling thread
+  explicit ThreadPool(size_t no_of_threads) {
+    for (size_t thread = 1; thread < no_of_threads; thread++) {
+      workers.emplace_back( [this, thread]() { work_loop(thread); } );
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    work_available.notify_all();
+    for (std::thread & worker : workers) {
+      worker.join();
+    }
+  }
+
+  size_t get_no_of_threads() const {
+    return workers.size() + 1;
+  }
+
+  // calls work(thread, begin, end) for the chunk [begin, end) of the items of each thread and returns,
+  // when all chunks have been processed
+  void run(size_t no_of_items, const std::function<void(size_t thread, size_t begin, size_t end)> & work) {
+    if (workers.empty()) {
+      process_chunk(work, no_of_items, 0);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      this->work = &work;
+      this->no_of_items = no_of_items;
+      no_of_busy_workers = workers.size();
+      generation++;
+    }
+    work_available.notify_all();
+    process_chunk(work, no_of_items, 0);
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this]() { return no_of_busy_workers == 0; });
+  }
+};
+
+#endif
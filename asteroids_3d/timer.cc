@@ -3,22 +3,6 @@
 #include <thread>
 #include <iostream>
 
-Counter::Counter(float time) : time(time) { }
-
-float Counter::get_time() const {
-  return time;
-}
-
-void Counter::set_time(float time) {
-  this->time = time;
-}
-
-void Counter::tick(float seconds) {
-  if (time > 0.0) {
-    time -= seconds;
-  }
-}
-
 void Timer::reset() {
   start = SDL_GetTicks64();
 }
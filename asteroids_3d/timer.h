@@ -3,20 +3,12 @@
 
 #include <functional>
 #include <SDL2/SDL.h>
+#include "counter.h"
 
 #ifndef SDL_GetTicks64
 #define SDL_GetTicks64 SDL_GetTicks
 #endif
 
-class Counter {
-  float time;
-public:
-  Counter(float time = 0.0f);
-  float get_time() const;
-  void set_time(float time);
-  void tick(float seconds);
-};
-
 class Timer {
   Uint64 start = SDL_GetTicks64();
   Uint64 end;
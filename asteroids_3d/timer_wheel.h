@@ -0,0 +1,222 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// a hierarchical timer wheel keyed on an absolute time, e.g. the simulation time of a Physics
+// the time is divided into ticks of the given resolution, the wheel has NO_OF_LEVELS levels of NO_OF_SLOTS slots,
+// a slot of level l covers NO_OF_SLOTS^l ticks; a timer is kept in the slot of the lowest level, that covers its tick
+// without covering the current tick, and moves down one level each time the wheel reaches its slot, so
+// advance() only touches the expired timers, the timers moving down and the timers sharing the slot of the current tick,
+// besides one step per elapsed tick of the resolution (none at all while no timer is registered)
+// timers further away than all levels wait in the last level and are sorted in again each time it wraps around
+// scheduling and cancelling take constant time, the timers are kept in doubly linked lists over a vector,
+// so they do not allocate memory once the vector is large enough
+template<class TIME, class PAYLOAD>
+class TimerWheel {
+public:
+  static constexpr size_t NO_TIMER = static_cast<size_t>(-1);
+private:
+  static constexpr size_t SLOT_BITS = 6;
+  static constexpr size_t NO_OF_SLOTS = size_t(1) << SLOT_BITS;
+  static constexpr size_t NO_OF_LEVELS = 4;
+
+  // values of Timer::slot, when the timer is not in a slot
+  static constexpr size_t FREE = static_cast<size_t>(-1);
+  static constexpr size_t DUE = static_cast<size_t>(-2);        // expired during the current advance()
+  static constexpr size_t CANCELLED = static_cast<size_t>(-3);  // cancelled while it was due
+
+  struct Timer {
+    TIME deadline;
+    std::uint64_t tick;      // deadline in units of the resolution
+    std::uint64_t sequence;  // orders timers with equal deadlines by the order they have been scheduled in
+    PAYLOAD payload;
+    size_t slot = FREE;
+    size_t previous = NO_TIMER;
+    size_t next = NO_TIMER;  // next timer in the slot or in the list of free timers
+  };
+
+  TIME resolution;
+  std::vector<Timer> timers;
+  std::vector<size_t> slots = std::vector<size_t>(NO_OF_LEVELS * NO_OF_SLOTS, NO_TIMER);  // first timer of each slot
+  size_t free_timers = NO_TIMER;
+  size_t no_of_timers = 0;
+  std::uint64_t current_tick = 0;
+  std::uint64_t no_of_scheduled = 0;
+  std::vector<size_t> due;  // kept as a member to reuse the allocated memory in each advance()
+
+  std::uint64_t get_tick(TIME time) const {
+    constexpr std::uint64_t MAX_TICK = std::uint64_t(1) << 62;
+    if ( ! (time > 0) ) {
+      return 0;
+    }
+    TIME tick = time / resolution;
+    return tick < static_cast<TIME>(MAX_TICK) ? static_cast<std::uint64_t>(tick) : MAX_TICK;
+  }
+
+  // returns the slot of a timer with the given tick, which must not be less than the current tick
+  size_t get_slot(std::uint64_t tick) const {
+    size_t level = 0;
+    while (level + 1 < NO_OF_LEVELS && (tick >> (SLOT_BITS * (level + 1))) != (current_tick >> (SLOT_BITS * (level + 1)))) {
+      level++;
+    }
+    return level * NO_OF_SLOTS + ((tick >> (SLOT_BITS * level)) & (NO_OF_SLOTS - 1));
+  }
+
+  void link(size_t timer) {
+    Timer & t = timers[timer];
+    t.slot = get_slot(t.tick);
+    t.previous = NO_TIMER;
+    t.next = slots[t.slot];
+    if (t.next != NO_TIMER) {
+      timers[t.next].previous = timer;
+    }
+    slots[t.slot] = timer;
+  }
+
+  void unlink(size_t timer) {
+    Timer & t = timers[timer];
+    if (t.previous != NO_TIMER) {
+      timers[t.previous].next = t.next;
+    } else {
+      slots[t.slot] = t.next;
+    }
+    if (t.next != NO_TIMER) {
+      timers[t.next].previous = t.previous;
+    }
+  }
+
+  void free(size_t timer) {
+    timers[timer].slot = FREE;
+    timers[timer].payload = PAYLOAD();
+    timers[timer].next = free_timers;
+    free_timers = timer;
+    no_of_timers--;
+  }
+
+  // moves the timers of a slot of a higher level down to the slots of the lower levels
+  void cascade(size_t slot) {
+    size_t timer = slots[slot];
+    slots[slot] = NO_TIMER;
+    while (timer != NO_TIMER) {
+      size_t next = timers[timer].next;
+      link(timer);
+      timer = next;
+    }
+  }
+
+  // moves the timers of the slot of the current tick, that expire at the given time, to due
+  void collect(TIME now) {
+    size_t timer = slots[current_tick & (NO_OF_SLOTS - 1)];
+    while (timer != NO_TIMER) {
+      size_t next = timers[timer].next;
+      if (timers[timer].deadline <= now) {
+        unlink(timer);
+        timers[timer].slot = DUE;
+        due.push_back(timer);
+      }
+      timer = next;
+    }
+  }
+
+public:
+  explicit TimerWheel(TIME resolution = static_cast<TIME>(1.0 / 64.0)) : resolution(resolution) { }
+
+  // registers a timer, that expires in the first advance() to a time not less than the deadline,
+  // and returns its handle, which is valid until the timer has expired or has been cancelled
+  size_t schedule(TIME deadline, PAYLOAD payload) {
+    size_t timer = free_timers;
+    if (timer != NO_TIMER) {
+      free_timers = timers[timer].next;
+    } else {
+      timer = timers.size();
+      timers.emplace_back();
+    }
+    Timer & t = timers[timer];
+    t.deadline = deadline;
+    t.tick = std::max(get_tick(deadline), current_tick);
+    t.sequence = no_of_scheduled++;
+    t.payload = std::move(payload);
+    link(timer);
+    no_of_timers++;
+    return timer;
+  }
+
+  // removes a timer, that has not expired yet; a timer that expires in the current advance() can be cancelled
+  // by the payload of a timer expiring before it
+  void cancel(size_t timer) {
+    if (timer >= timers.size() || timers[timer].slot == FREE || timers[timer].slot == CANCELLED) {
+      return;
+    }
+    if (timers[timer].slot == DUE) {
+      timers[timer].slot = CANCELLED;
+    } else {
+      unlink(timer);
+      free(timer);
+    }
+  }
+
+  // returns the deadline of a timer, that has not expired yet
+  TIME get_deadline(size_t timer) const {
+    return timers[timer].deadline;
+  }
+
+  // removes all timers and starts again at the given time, e.g. the simulation time of a restored Physics,
+  // so the next advance() does not step through all ticks from time zero
+  void clear(TIME now = 0) {
+    timers.clear();
+    std::fill(slots.begin(), slots.end(), NO_TIMER);
+    free_timers = NO_TIMER;
+    no_of_timers = 0;
+    current_tick = get_tick(now);
+    no_of_scheduled = 0;
+  }
+
+  // returns the number of timers, that have not expired yet
+  size_t get_no_of_timers() const {
+    return no_of_timers;
+  }
+
+  // calls expired(payload) for all timers with a deadline not greater than now, ordered by their deadlines and
+  // (for equal deadlines) by the order they have been scheduled in; expired() may schedule new timers, these
+  // expire in the next advance() at the earliest
+  // the time must not go backwards
+  template<class F>
+  void advance(TIME now, F expired) {
+    std::uint64_t target = get_tick(now);
+    due.clear();
+    if (no_of_timers == 0) {
+      current_tick = std::max(current_tick, target);
+      return;
+    }
+    collect(now);
+    while (current_tick < target) {
+      current_tick++;
+      for (size_t level = 1; level < NO_OF_LEVELS; level++) {
+        if ( (current_tick & ((std::uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0 ) {
+          break;
+        }
+        cascade(level * NO_OF_SLOTS + ((current_tick >> (SLOT_BITS * level)) & (NO_OF_SLOTS - 1)));
+      }
+      collect(now);
+    }
+    std::sort(due.begin(), due.end(), [this](size_t timer1, size_t timer2)
+      { return timers[timer1].deadline < timers[timer2].deadline
+               || (timers[timer1].deadline == timers[timer2].deadline && timers[timer1].sequence < timers[timer2].sequence); });
+    for (size_t i = 0; i < due.size(); i++) {
+      size_t timer = due[i];
+      bool cancelled = timers[timer].slot == CANCELLED;
+      PAYLOAD payload = std::move(timers[timer].payload);
+      free(timer);
+      if ( ! cancelled ) {
+        expired(payload);
+      }
+    }
+  }
+};
+
+#endif
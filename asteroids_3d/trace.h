@@ -0,0 +1,201 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// scoped zone tracing, for instance:
+//   void Game::tick(float tick_time) {
+//     trace_zone("Game::tick");
+//     ...
+//   }
+// each thread writes the completed zones into its own ring buffer without locks,
+// trace_write_chrome_json() writes all buffers in the Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+// zones compile to nothing unless TRACE_ENABLED is defined as 1 (cmake -DTRACE=ON)
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+// number of zones kept per thread, older zones are overwritten
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE (1u << 16)
+#endif
+
+#include <cstddef>
+#include <ostream>
+
+#if TRACE_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// returns a timestamp in ticks of the fastest available clock (the time stamp counter on x86)
+inline std::uint64_t trace_now() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct TraceEvent {
+  const char * name;  // must be a string literal (or live until the trace is written)
+  std::uint64_t begin;
+  std::uint64_t end;
+};
+
+// the ring buffer of one thread, only the owning thread writes into it
+class TraceBuffer {
+  std::unique_ptr<TraceEvent[]> events{ new TraceEvent[TRACE_BUFFER_SIZE] };
+  std::atomic<std::uint64_t> head{0};  // number of events ever added
+  std::uint32_t thread_id;
+public:
+  TraceBuffer(std::uint32_t thread_id) : thread_id(thread_id) { }
+
+  void add(const char * name, std::uint64_t begin, std::uint64_t end) {
+    std::uint64_t h = head.load(std::memory_order_relaxed);
+    events[h % TRACE_BUFFER_SIZE] = TraceEvent{name, begin, end};
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  // returns the events that are still in the buffer, the oldest first
+  std::vector<TraceEvent> get_events() const {
+    std::uint64_t h = head.load(std::memory_order_acquire);
+    std::uint64_t first = (h > TRACE_BUFFER_SIZE ? h - TRACE_BUFFER_SIZE : 0);
+    std::vector<TraceEvent> result;
+    result.reserve(h - first);
+    for (std::uint64_t i = first; i < h; i++) {
+      result.push_back(events[i % TRACE_BUFFER_SIZE]);
+    }
+    return result;
+  }
+
+  void clear() {
+    head.store(0, std::memory_order_release);
+  }
+
+  std::uint32_t get_thread_id() const {
+    return thread_id;
+  }
+};
+
+// all buffers that have been created, buffers live until the end of the program
+// the mutex is only locked when a thread traces its first zone and when the trace is written
+struct TraceRegistry {
+  std::mutex mutex;
+  std::vector< std::unique_ptr<TraceBuffer> > buffers;
+  std::uint64_t start_ticks = trace_now();
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+  TraceBuffer * create_buffer() {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back( std::make_unique<TraceBuffer>(buffers.size() + 1) );
+    return buffers.back().get();
+  }
+
+  // returns the number of microseconds per tick of trace_now()
+  double microseconds_per_tick() {
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start_time;
+    std::uint64_t ticks = trace_now() - start_ticks;
+    return ticks > 0 ? elapsed.count() / ticks : 0.0;
+  }
+};
+
+inline TraceRegistry & trace_registry() {
+  static TraceRegistry registry;
+  return registry;
+}
+
+// the pointer is constant initialized, so that accessing it needs no thread_local initialization guard
+inline thread_local TraceBuffer * trace_thread_buffer = nullptr;
+
+inline TraceBuffer & trace_buffer() {
+  if (trace_thread_buffer == nullptr) [[unlikely]] {
+    trace_thread_buffer = trace_registry().create_buffer();
+  }
+  return *trace_thread_buffer;
+}
+
+// records the time from its construction until its destruction
+class TraceZone {
+  const char * name;
+  std::uint64_t begin;
+public:
+  explicit TraceZone(const char * name) : name(name), begin(trace_now()) { }
+  ~TraceZone() {
+    trace_buffer().add(name, begin, trace_now());
+  }
+  TraceZone(const TraceZone &) = delete;
+  TraceZone & operator=(const TraceZone &) = delete;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define trace_zone(name) TraceZone TRACE_CONCAT(trace_zone_, __LINE__){name}
+
+// returns the number of zones in all buffers
+inline size_t trace_event_count() {
+  TraceRegistry & registry = trace_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t count = 0;
+  for (auto & buffer : registry.buffers) {
+    count += buffer->get_events().size();
+  }
+  return count;
+}
+
+// removes all zones from all buffers, no other thread may trace at the same time
+inline void trace_clear() {
+  TraceRegistry & registry = trace_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto & buffer : registry.buffers) {
+    buffer->clear();
+  }
+}
+
+// writes all zones as complete events ("ph":"X") with timestamps in microseconds since the first traced zone
+// (the first zone begins slightly before the registry is created, so its timestamp may be negative)
+// zones that are completed while writing may be missing or incomplete
+inline void trace_write_chrome_json(std::ostream & out) {
+  TraceRegistry & registry = trace_registry();
+  double microseconds_per_tick = registry.microseconds_per_tick();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision(3);
+  out << std::fixed << "{\"traceEvents\":[";
+  const char * separator = "\n";
+  for (auto & buffer : registry.buffers) {
+    for (const TraceEvent & event : buffer->get_events()) {
+      out << separator << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->get_thread_id()
+          << ",\"ts\":" << static_cast<std::int64_t>(event.begin - registry.start_ticks) * microseconds_per_tick
+          << ",\"dur\":" << (event.end - event.begin) * microseconds_per_tick << "}";
+      separator = ",\n";
+    }
+  }
+  out << "\n]}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+#else
+
+#define trace_zone(name)
+
+inline size_t trace_event_count() {
+  return 0;
+}
+
+inline void trace_clear() { }
+
+inline void trace_write_chrome_json(std::ostream & out) {
+  out << "{\"traceEvents\":[]}\n";
+}
+
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+#define TRACE_ENABLED 1
+#include "trace.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+namespace {
+
+size_t count(const std::string & text, const std::string & pattern) {
+  size_t n = 0;
+  for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+    n++;
+  }
+  return n;
+}
+
+TEST(TRACE, NestedZones) {
+  trace_clear();
+  {
+    trace_zone("outer");
+    {
+      trace_zone("inner");
+    }
+  }
+  ASSERT_EQ(2u, trace_event_count());
+
+  std::vector<TraceEvent> events = trace_buffer().get_events();
+  ASSERT_EQ(2u, events.size());
+  // zones are added when they end
+  EXPECT_STREQ("inner", events[0].name);
+  EXPECT_STREQ("outer", events[1].name);
+  EXPECT_LE(events[1].begin, events[0].begin);
+  EXPECT_LE(events[0].end, events[1].end);
+}
+
+TEST(TRACE, RingBufferKeepsNewestZones) {
+  trace_clear();
+  for (size_t i = 0; i < TRACE_BUFFER_SIZE + 10; i++) {
+    trace_zone("zone");
+  }
+  {
+    trace_zone("last");
+  }
+  std::vector<TraceEvent> events = trace_buffer().get_events();
+  ASSERT_EQ(TRACE_BUFFER_SIZE, events.size());
+  EXPECT_STREQ("last", events.back().name);
+}
+
+TEST(TRACE, ChromeJsonPerThread) {
+  trace_clear();
+  {
+    trace_zone("main thread");
+  }
+  std::thread thread([]() { trace_zone("other thread"); });
+  thread.join();
+
+  std::ostringstream out;
+  trace_write_chrome_json(out);
+  std::string json = out.str();
+  EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+  EXPECT_EQ(1u, count(json, "\"name\":\"main thread\""));
+  EXPECT_EQ(1u, count(json, "\"name\":\"other thread\""));
+  EXPECT_EQ(2u, count(json, "\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, json.find("\"tid\":1"));
+  EXPECT_NE(std::string::npos, json.find("\"tid\":2"));
+}
+
+TEST(TRACE, CostPerZone) {
+  constexpr size_t NO_OF_ZONES = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < NO_OF_ZONES; i++) {
+    trace_zone("zone");
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  double nanoseconds_per_zone = elapsed.count() / NO_OF_ZONES;
+  std::cout << nanoseconds_per_zone << " ns per zone" << std::endl;
+  // generous bound, the tests are built without optimization
+  EXPECT_GT(500.0, nanoseconds_per_zone);
+}
+
+}
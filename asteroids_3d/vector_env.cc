@@ -0,0 +1,134 @@
+#include "vector_env.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+VectorEnv::VectorEnv(size_t no_of_environments, std::uint64_t seed, size_t no_of_nearest_bodies, size_t max_ticks,
+                     size_t no_of_threads, float tick_time)
+  : no_of_nearest_bodies(no_of_nearest_bodies), max_ticks(max_ticks), tick_time(tick_time),
+    environments(no_of_environments), pool(std::max<size_t>(no_of_threads, 1u)) {
+  for (size_t i = 0; i < no_of_environments; i++) {
+    environments[i].seeds = RandomStream(seed, static_cast<std::uint32_t>(i));
+  }
+  size_t no_of_bodies = no_of_environments * no_of_nearest_bodies;
+  observations.body_x.resize(no_of_bodies);
+  observations.body_y.resize(no_of_bodies);
+  observations.body_velocity_x.resize(no_of_bodies);
+  observations.body_velocity_y.resize(no_of_bodies);
+  observations.body_type.resize(no_of_bodies);
+  observations.ship_x.resize(no_of_environments);
+  observations.ship_y.resize(no_of_environments);
+  observations.ship_velocity_x.resize(no_of_environments);
+  observations.ship_velocity_y.resize(no_of_environments);
+  observations.ship_angle.resize(no_of_environments);
+  observations.ship_exists.resize(no_of_environments);
+  observations.score.resize(no_of_environments);
+  observations.lives.resize(no_of_environments);
+  observations.done.resize(no_of_environments);
+  nearest_bodies.resize( pool.get_no_of_threads() );
+  for (auto & nearest : nearest_bodies) {
+    nearest.reserve(no_of_nearest_bodies);
+  }
+  reset();
+}
+
+size_t VectorEnv::get_no_of_environments() const {
+  return environments.size();
+}
+
+size_t VectorEnv::get_no_of_nearest_bodies() const {
+  return no_of_nearest_bodies;
+}
+
+// the game is created anew, for the physics of a game refers to the game
+void VectorEnv::reset(size_t environment) {
+  Environment & env = environments[environment];
+  std::uint64_t seed = env.seeds.next();
+  seed = (seed << 32) | env.seeds.next();
+  env.controller.reset();
+  env.game = std::make_unique<Game>(seed);
+  env.controller = std::make_unique<HeadlessGameController>(*env.game, env.input, tick_time);
+  env.ticks = 0;
+  observations.done[environment] = 0u;
+}
+
+void VectorEnv::observe(size_t environment, std::vector<Body2df *> & nearest) {
+  Game & game = *environments[environment].game;
+  GamePhysics & physics = game.get_physics();
+  Vector2df world_size = physics.get_world_size();
+  Spaceship * ship = game.ship_exists() ? game.get_ship() : nullptr;
+  Vector2df center = ship != nullptr ? ship->get_position() : 0.5f * world_size;
+
+  observations.ship_x[environment] = center[0];
+  observations.ship_y[environment] = center[1];
+  observations.ship_velocity_x[environment] = ship != nullptr ? ship->get_velocity()[0] : 0.0f;
+  observations.ship_velocity_y[environment] = ship != nullptr ? ship->get_velocity()[1] : 0.0f;
+  observations.ship_angle[environment] = ship != nullptr ? ship->get_angle() : 0.0f;
+  observations.ship_exists[environment] = ship != nullptr;
+  observations.score[environment] = game.get_score();
+  observations.lives[environment] = game.get_no_of_ships();
+
+  nearest.clear();
+  physics.query_nearest(center, no_of_nearest_bodies, nearest,
+                        [ship](Body2df * body) { return body != ship && ! body->is_marked_for_deletion(); });
+  size_t first = environment * no_of_nearest_bodies;
+  for (size_t k = 0; k < no_of_nearest_bodies; k++) {
+    size_t i = first + k;
+    if (k >= nearest.size()) {
+      observations.body_x[i] = 0.0f;
+      observations.body_y[i] = 0.0f;
+      observations.body_velocity_x[i] = 0.0f;
+      observations.body_velocity_y[i] = 0.0f;
+      observations.body_type[i] = -1;
+      continue;
+    }
+    // the offset to the nearest image of the body on the torus
+    Vector2df offset = nearest[k]->get_position() - center;
+    for (size_t axis = 0; axis < 2; axis++) {
+      offset[axis] -= world_size[axis] * std::round(offset[axis] / world_size[axis]);
+    }
+    observations.body_x[i] = offset[0];
+    observations.body_y[i] = offset[1];
+    observations.body_velocity_x[i] = nearest[k]->get_velocity()[0];
+    observations.body_velocity_y[i] = nearest[k]->get_velocity()[1];
+    observations.body_type[i] = static_cast<std::int8_t>( static_cast<TypedBody *>(nearest[k])->get_type() );
+  }
+}
+
+void VectorEnv::reset() {
+  pool.run(environments.size(), [this](size_t thread, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      reset(i);
+      observe(i, nearest_bodies[thread]);
+    }
+  });
+}
+
+void VectorEnv::step(std::span<const Input> actions) {
+  if (actions.size() != environments.size()) {
+    throw std::invalid_argument("one action per environment expected");
+  }
+  pool.run(environments.size(), [this, actions](size_t thread, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      Environment & env = environments[i];
+      if (observations.done[i]) {
+        reset(i);
+      }
+      env.input.action = actions[i];
+      env.controller->do_user_interactions();
+      env.controller->do_game_events();
+      env.ticks++;
+      bool game_over = env.game->get_no_of_ships() == 0 && ! env.game->ship_exists();
+      observations.done[i] = game_over || (max_ticks > 0 && env.ticks >= max_ticks);
+      observe(i, nearest_bodies[thread]);
+    }
+  });
+}
+
+const VectorEnvObservations & VectorEnv::get_observations() const {
+  return observations;
+}
+
+Game & VectorEnv::get_game(size_t environment) {
+  return *environments[environment].game;
+}
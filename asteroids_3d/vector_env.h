@@ -0,0 +1,89 @@
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+
+#include "headless_game_controller.h"
+#include "random.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+// the observations of all environments of a VectorEnv as a structure of arrays, so a training framework can use
+// each array as a tensor without copying
+// the arrays about the nearest bodies hold K entries per environment, entry k of environment e is at e * K + k
+struct VectorEnvObservations {
+  // the K bodies nearest to the ship (to the center of the screen if there is no ship), nearest first,
+  // the positions are relative to the ship on the torus, missing bodies have the type -1 and zeros elsewhere
+  std::vector<float> body_x;
+  std::vector<float> body_y;
+  std::vector<float> body_velocity_x;
+  std::vector<float> body_velocity_y;
+  std::vector<std::int8_t> body_type;  // the BodyType or -1
+
+  // one entry per environment, the position of a missing ship is the center of the screen
+  std::vector<float> ship_x;
+  std::vector<float> ship_y;
+  std::vector<float> ship_velocity_x;
+  std::vector<float> ship_velocity_y;
+  std::vector<float> ship_angle;
+  std::vector<std::uint8_t> ship_exists;
+  std::vector<long long> score;
+  std::vector<float> lives;
+  std::vector<std::uint8_t> done;  // 1 if the episode has ended in the last step (game over or the maximum ticks)
+};
+
+// a number of independent games, that are stepped in lockstep, e.g. for training bots
+// each step applies one action (a combination of the GameController's input bits) per environment and writes the
+// observations of all environments into preallocated arrays; the environments are stepped by a ThreadPool
+// an environment is seeded from the seed of the VectorEnv and its index, so the results do not depend on the number
+// of threads; an environment, whose episode is done, is reset with a new seed at the beginning of the next step
+class VectorEnv {
+  struct ActionInputSource : public InputSource {
+    Input action = 0u;
+    virtual Input next_input() { return action; }
+  };
+
+  struct Environment {
+    RandomStream seeds;  // the seeds of the episodes
+    std::unique_ptr<Game> game;
+    ActionInputSource input;
+    std::unique_ptr<HeadlessGameController> controller;
+    size_t ticks = 0;
+  };
+
+  size_t no_of_nearest_bodies;
+  size_t max_ticks;
+  float tick_time;
+  std::vector<Environment> environments;
+  VectorEnvObservations observations;
+  std::vector< std::vector<Body2df *> > nearest_bodies;  // one list per thread, reused in each step
+  ThreadPool pool;
+
+  void reset(size_t environment);
+  void observe(size_t environment, std::vector<Body2df *> & nearest);
+
+public:
+  // no_of_nearest_bodies is the number K of bodies observed per environment, an episode ends after max_ticks ticks
+  // (never if zero) or when the game is over; no_of_threads includes the calling thread
+  VectorEnv(size_t no_of_environments, std::uint64_t seed, size_t no_of_nearest_bodies = 8u, size_t max_ticks = 0u,
+            size_t no_of_threads = std::thread::hardware_concurrency(), float tick_time = 1.0f / 60.0f);
+
+  size_t get_no_of_environments() const;
+
+  size_t get_no_of_nearest_bodies() const;
+
+  // starts a new episode in all environments and observes them
+  void reset();
+
+  // advances each environment by one tick and applies its action, actions.size() must be the number of environments
+  void step(std::span<const Input> actions);
+
+  // the observations after the last reset() or step()
+  const VectorEnvObservations & get_observations() const;
+
+  Game & get_game(size_t environment);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "vector_env.h"
+#include "random.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+// measures the environment steps per second of a VectorEnv (see vector_env.h) with random actions
+// for different numbers of environments and threads
+
+namespace {
+
+constexpr size_t NO_OF_STEPS = 2000;
+
+double steps_per_second(size_t no_of_environments, size_t no_of_threads) {
+  VectorEnv env{no_of_environments, 1u, 8u, 3600u, no_of_threads};
+  RandomStream random{2u};
+  std::vector<Input> actions(no_of_environments);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t step = 0; step < NO_OF_STEPS; step++) {
+    if (step % 20 == 0) {
+      for (Input & action : actions) {
+        action = static_cast<Input>( random.next() % 32u );
+      }
+    }
+    env.step(actions);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return NO_OF_STEPS * no_of_environments / elapsed.count();
+}
+
+}
+
+int main() {
+  const size_t environment_counts[] = { 16u, 256u };
+  const size_t thread_counts[] = { 1u, 2u, 4u, 8u, 16u };
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+  std::cout << std::setw(14) << "environments";
+  for (size_t no_of_threads : thread_counts) {
+    std::cout << std::setw(8) << no_of_threads << " threads";
+  }
+  std::cout << "   (environment steps per second)" << std::endl;
+  for (size_t no_of_environments : environment_counts) {
+    std::cout << std::setw(14) << no_of_environments;
+    for (size_t no_of_threads : thread_counts) {
+      std::cout << std::setw(16) << std::fixed << std::setprecision(0) << steps_per_second(no_of_environments, no_of_threads);
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
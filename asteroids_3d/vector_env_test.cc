@@ -0,0 +1,99 @@
+#include "vector_env.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// the same action sequence for all tests, different per environment
+std::vector<Input> actions_of_step(size_t no_of_environments, size_t step) {
+  std::vector<Input> actions(no_of_environments);
+  for (size_t i = 0; i < no_of_environments; i++) {
+    actions[i] = static_cast<Input>( ((step / 20 + i) * 7) % 32 );
+  }
+  return actions;
+}
+
+TEST(VECTOR_ENV, ObservationsAfterReset) {
+  VectorEnv env{5u, 1u, 4u, 0u, 2u};
+  const VectorEnvObservations & observations = env.get_observations();
+
+  ASSERT_EQ(20u, observations.body_type.size());
+  ASSERT_EQ(20u, observations.body_x.size());
+  ASSERT_EQ(5u, observations.score.size());
+  ASSERT_EQ(5u, observations.done.size());
+  for (size_t i = 0; i < 20u; i++) {
+    EXPECT_EQ(-1, observations.body_type[i]);  // no bodies before the first tick
+  }
+  for (size_t i = 0; i < 5u; i++) {
+    EXPECT_EQ(0, observations.done[i]);
+    EXPECT_EQ(3.0f, observations.lives[i]);
+    EXPECT_EQ(0LL, observations.score[i]);
+  }
+}
+
+TEST(VECTOR_ENV, NearestBodiesAreSortedOffsets) {
+  VectorEnv env{3u, 2u, 6u, 0u, 1u};
+  for (size_t step = 0; step < 200; step++) {
+    env.step( actions_of_step(3u, step) );
+  }
+  const VectorEnvObservations & observations = env.get_observations();
+  for (size_t e = 0; e < 3u; e++) {
+    Vector2df world_size = env.get_game(e).get_physics().get_world_size();
+    float previous_distance = 0.0f;
+    size_t no_of_bodies = 0;
+    for (size_t k = 0; k < 6u; k++) {
+      size_t i = e * 6u + k;
+      if (observations.body_type[i] < 0) {
+        continue;
+      }
+      no_of_bodies++;
+      EXPECT_LE(std::abs(observations.body_x[i]), 0.5f * world_size[0]);
+      EXPECT_LE(std::abs(observations.body_y[i]), 0.5f * world_size[1]);
+      // the order is by the distance of the bounding volumes, so the centers may be slightly out of order
+      float distance = std::hypot(observations.body_x[i], observations.body_y[i]);
+      EXPECT_LE(previous_distance, distance + 40.0f);
+      previous_distance = distance;
+    }
+    EXPECT_LT(0u, no_of_bodies);
+  }
+}
+
+TEST(VECTOR_ENV, ResultsDoNotDependOnTheNumberOfThreads) {
+  constexpr size_t NO_OF_ENVIRONMENTS = 7;
+  VectorEnv single{NO_OF_ENVIRONMENTS, 3u, 4u, 500u, 1u};
+  VectorEnv multi{NO_OF_ENVIRONMENTS, 3u, 4u, 500u, 3u};
+  for (size_t step = 0; step < 1200; step++) {
+    std::vector<Input> actions = actions_of_step(NO_OF_ENVIRONMENTS, step);
+    single.step(actions);
+    multi.step(actions);
+    const VectorEnvObservations & a = single.get_observations();
+    const VectorEnvObservations & b = multi.get_observations();
+    ASSERT_EQ(a.body_x, b.body_x) << step;
+    ASSERT_EQ(a.body_velocity_y, b.body_velocity_y) << step;
+    ASSERT_EQ(a.body_type, b.body_type) << step;
+    ASSERT_EQ(a.ship_angle, b.ship_angle) << step;
+    ASSERT_EQ(a.score, b.score) << step;
+    ASSERT_EQ(a.done, b.done) << step;
+  }
+}
+
+TEST(VECTOR_ENV, EpisodeEndsAfterMaxTicksAndResets) {
+  VectorEnv env{2u, 4u, 4u, 10u, 1u};
+  for (size_t step = 1; step <= 10; step++) {
+    env.step( actions_of_step(2u, step) );
+    EXPECT_EQ(step == 10 ? 1 : 0, env.get_observations().done[0]) << step;
+  }
+  env.step( actions_of_step(2u, 11) );
+  EXPECT_EQ(0, env.get_observations().done[0]);
+  EXPECT_EQ(1u, env.get_game(0).get_physics().get_no_of_ticks());
+}
+
+TEST(VECTOR_ENV, OneActionPerEnvironment) {
+  VectorEnv env{2u, 5u, 4u, 0u, 1u};
+  std::vector<Input> actions(3);
+  EXPECT_THROW(env.step(actions), std::invalid_argument);
+}
+
+}
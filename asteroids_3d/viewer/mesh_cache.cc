@@ -0,0 +1,265 @@
+#include "mesh_cache.h"
+#include "stl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader> && sizeof(MeshCacheHeader) == 120,
+              "the header is written as it is");
+static_assert(sizeof(VertexAttribute) == 16 && sizeof(DrawRange) == 20 && sizeof(MeshLod) == 12 && sizeof(CompactVertex) == 12,
+              "the attributes, draw ranges, levels of detail and vertices are written as they are");
+
+namespace {
+
+std::uint64_t align(std::uint64_t offset) {
+  return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+std::int64_t get_modification_time(const std::filesystem::path & path) {
+  return static_cast<std::int64_t>( std::filesystem::last_write_time(path).time_since_epoch().count() );
+}
+
+}
+
+std::uint64_t content_hash(std::string_view text) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+
+// class MeshCache
+
+MeshCache::MeshCache(const std::string & cache_path) : file(std::make_unique<MappedFile>(cache_path)) {
+  read_header();
+}
+
+MeshCache::MeshCache(std::span<const VertexAttribute> attributes, std::uint32_t vertex_stride,
+                     std::span<const char> vertex_data, std::span<const std::uint32_t> indices,
+                     std::span<const DrawRange> draw_ranges, std::span<const MeshLod> lods) {
+  if (vertex_stride == 0 || vertex_data.size() % vertex_stride != 0) {
+    throw std::invalid_argument("the vertex data is no multiple of the vertex stride");
+  }
+  header = { };
+  std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+  header.version = MESH_CACHE_VERSION;
+  header.vertex_stride = vertex_stride;
+  header.no_of_attributes = static_cast<std::uint32_t>( attributes.size() );
+  header.no_of_draw_ranges = static_cast<std::uint32_t>( draw_ranges.size() );
+  header.no_of_lods = static_cast<std::uint32_t>( lods.size() );
+  header.no_of_vertices = vertex_data.size() / vertex_stride;
+  header.no_of_indices = indices.size();
+  header.draw_range_offset = align( sizeof(MeshCacheHeader) + attributes.size_bytes() );
+  header.lod_offset = align( header.draw_range_offset + draw_ranges.size_bytes() );
+  header.vertex_offset = align( header.lod_offset + lods.size_bytes() );
+  header.index_offset = align( header.vertex_offset + vertex_data.size() );
+
+  // the first attribute is the position
+  if (header.no_of_vertices > 0 && ! attributes.empty() && attributes[0].type == AttributeType::float32) {
+    std::fill(std::begin(header.bounds_min), std::end(header.bounds_min), std::numeric_limits<float>::max());
+    std::fill(std::begin(header.bounds_max), std::end(header.bounds_max), std::numeric_limits<float>::lowest());
+    size_t components = std::min<size_t>(attributes[0].components, 3);
+    for (size_t vertex = 0; vertex < header.no_of_vertices; vertex++) {
+      float position[3];
+      std::memcpy(position, vertex_data.data() + vertex * vertex_stride + attributes[0].offset, components * sizeof(float));
+      for (size_t i = 0; i < components; i++) {
+        header.bounds_min[i] = std::min(header.bounds_min[i], position[i]);
+        header.bounds_max[i] = std::max(header.bounds_max[i], position[i]);
+      }
+    }
+  }
+
+  bytes.assign(header.index_offset + indices.size_bytes(), '\0');
+  store_header();
+  std::copy(attributes.begin(), attributes.end(), reinterpret_cast<VertexAttribute *>(bytes.data() + sizeof(MeshCacheHeader)));
+  std::copy(draw_ranges.begin(), draw_ranges.end(), reinterpret_cast<DrawRange *>(bytes.data() + header.draw_range_offset));
+  std::copy(lods.begin(), lods.end(), reinterpret_cast<MeshLod *>(bytes.data() + header.lod_offset));
+  std::copy(vertex_data.begin(), vertex_data.end(), bytes.data() + header.vertex_offset);
+  std::copy(indices.begin(), indices.end(), reinterpret_cast<std::uint32_t *>(bytes.data() + header.index_offset));
+  this->attributes.assign(attributes.begin(), attributes.end());
+  this->draw_ranges.assign(draw_ranges.begin(), draw_ranges.end());
+  this->lods.assign(lods.begin(), lods.end());
+}
+
+MeshCache::MeshCache(const CompactMesh & mesh)
+  : MeshCache(COMPACT_VERTEX_LAYOUT, sizeof(CompactVertex),
+              std::span<const char>(reinterpret_cast<const char *>(mesh.vertices.data()), mesh.vertices.size() * sizeof(CompactVertex)),
+              mesh.indices, mesh.draw_ranges, mesh.lods) {
+  std::copy(std::begin(mesh.bounds_min), std::end(mesh.bounds_min), header.bounds_min);
+  std::copy(std::begin(mesh.bounds_max), std::end(mesh.bounds_max), header.bounds_max);
+  store_header();
+}
+
+std::string_view MeshCache::get_data() const {
+  return file ? file->get_text() : std::string_view(bytes);
+}
+
+void MeshCache::read_header() {
+  std::string_view data = get_data();
+  if (data.size() < sizeof(MeshCacheHeader)) {
+    throw std::runtime_error("no mesh cache");
+  }
+  std::memcpy(&header, data.data(), sizeof(MeshCacheHeader));
+  if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION) {
+    throw std::runtime_error("no mesh cache of version " + std::to_string(MESH_CACHE_VERSION));
+  }
+  // the sizes are checked by divisions, so large values cannot overflow
+  std::uint64_t size = data.size();
+  bool valid = header.vertex_stride > 0
+               && header.no_of_attributes <= (size - sizeof(MeshCacheHeader)) / sizeof(VertexAttribute)
+               && header.draw_range_offset % MESH_CACHE_ALIGNMENT == 0 && header.draw_range_offset <= size
+               && header.no_of_draw_ranges <= (size - header.draw_range_offset) / sizeof(DrawRange)
+               && header.lod_offset % MESH_CACHE_ALIGNMENT == 0 && header.lod_offset <= size
+               && header.no_of_lods <= (size - header.lod_offset) / sizeof(MeshLod)
+               && header.vertex_offset % MESH_CACHE_ALIGNMENT == 0 && header.vertex_offset <= size
+               && header.no_of_vertices <= (size - header.vertex_offset) / header.vertex_stride
+               && header.index_offset % MESH_CACHE_ALIGNMENT == 0 && header.index_offset <= size
+               && header.no_of_indices <= (size - header.index_offset) / sizeof(std::uint32_t);
+  if ( ! valid ) {
+    throw std::runtime_error("corrupt mesh cache");
+  }
+  attributes.resize(header.no_of_attributes);
+  std::memcpy(attributes.data(), data.data() + sizeof(MeshCacheHeader), attributes.size() * sizeof(VertexAttribute));
+  draw_ranges.resize(header.no_of_draw_ranges);
+  std::memcpy(draw_ranges.data(), data.data() + header.draw_range_offset, draw_ranges.size() * sizeof(DrawRange));
+  lods.resize(header.no_of_lods);
+  std::memcpy(lods.data(), data.data() + header.lod_offset, lods.size() * sizeof(MeshLod));
+
+  // the renderer draws the ranges without checks, so they have to be inside the indices (the vertices of a mesh
+  // without indices), the levels of detail inside the draw ranges and the indices below the number of vertices
+  std::uint64_t no_of_elements = header.no_of_indices > 0 ? header.no_of_indices : header.no_of_vertices;
+  valid = std::all_of(draw_ranges.begin(), draw_ranges.end(), [no_of_elements](const DrawRange & range) {
+            return range.first_index <= no_of_elements && range.no_of_indices <= no_of_elements - range.first_index; })
+          && std::all_of(lods.begin(), lods.end(), [this](const MeshLod & lod) {
+            return lod.first_draw_range <= header.no_of_draw_ranges
+                   && lod.no_of_draw_ranges <= header.no_of_draw_ranges - lod.first_draw_range; });
+  std::span<const std::uint32_t> indices = get_indices();
+  if ( ! valid || (! indices.empty() && *std::max_element(indices.begin(), indices.end()) >= header.no_of_vertices) ) {
+    throw std::runtime_error("corrupt mesh cache");
+  }
+}
+
+// the header of a mesh in memory is kept up to date, the one of a mapped file is written by write()
+void MeshCache::store_header() {
+  if ( ! file ) {
+    std::memcpy(bytes.data(), &header, sizeof(MeshCacheHeader));
+  }
+}
+
+const MeshCacheHeader & MeshCache::get_header() const {
+  return header;
+}
+
+std::span<const VertexAttribute> MeshCache::get_attributes() const {
+  return attributes;
+}
+
+std::span<const DrawRange> MeshCache::get_draw_ranges() const {
+  return draw_ranges;
+}
+
+std::span<const MeshLod> MeshCache::get_lods() const {
+  return lods;
+}
+
+std::span<const char> MeshCache::get_vertex_data() const {
+  return std::span<const char>(get_data().data() + header.vertex_offset, header.no_of_vertices * header.vertex_stride);
+}
+
+// the sections are aligned in the file and in memory (a mapping starts at a page, a string at an allocation)
+std::span<const std::uint32_t> MeshCache::get_indices() const {
+  const char * indices = get_data().data() + header.index_offset;
+  return std::span<const std::uint32_t>(reinterpret_cast<const std::uint32_t *>(indices), header.no_of_indices);
+}
+
+bool MeshCache::is_cache_of(const std::string & source_path) const {
+  std::error_code error;
+  std::uint64_t size = std::filesystem::file_size(source_path, error);
+  if (error || size != header.source_size) {
+    return false;
+  }
+  if (get_modification_time(source_path) == header.source_time) {
+    return true;
+  }
+  MappedFile source(source_path);
+  return content_hash( source.get_text() ) == header.source_hash;
+}
+
+void MeshCache::set_source(const std::string & source_path) {
+  MappedFile source(source_path);
+  header.source_hash = content_hash( source.get_text() );
+  header.source_size = source.get_text().size();
+  header.source_time = get_modification_time(source_path);
+  store_header();
+}
+
+// the cache is written to a temporary file and renamed, so a mapping of the previous cache stays valid
+bool MeshCache::write(const std::string & cache_path) const {
+  std::string temporary_path = cache_path + ".tmp";
+  std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+  std::string_view data = get_data();
+  out.write(reinterpret_cast<const char *>(&header), sizeof(MeshCacheHeader));
+  out.write(data.data() + sizeof(MeshCacheHeader), data.size() - sizeof(MeshCacheHeader));
+  out.close();
+  std::error_code error;
+  if (out.fail()) {
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  std::filesystem::rename(temporary_path, cache_path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  return true;
+}
+
+
+namespace {
+
+// the vertex buffer of a wavefront or stl file
+std::vector<float> import_vertex_buffer(const std::string & source_path) {
+  if (std::filesystem::path(source_path).extension() == ".stl") {
+    StlImporter importer;
+    importer.parse_file(source_path);
+    return std::move(importer.get_vertex_buffer());
+  }
+  WavefrontVertexBufferImporter importer;
+  importer.parse_file(source_path);
+  return std::move(importer.get_vertex_buffer());
+}
+
+}
+
+MeshCache load_mesh(const std::string & source_path) {
+  std::string cache_path = source_path + ".mesh";
+  bool has_source = std::filesystem::exists(source_path);
+  try {
+    MeshCache cache(cache_path);
+    if ( ! has_source || cache.is_cache_of(source_path) ) {
+      return cache;
+    }
+  } catch (const std::runtime_error &) {
+    if ( ! has_source ) {
+      throw;
+    }
+  }
+
+  CompactMesh compact_mesh = create_compact_mesh( import_vertex_buffer(source_path) );
+  create_lods(compact_mesh);
+  MeshCache mesh(compact_mesh);
+  mesh.set_source(source_path);
+  if ( ! mesh.write(cache_path) ) {
+    warning("could not write the mesh cache " + cache_path);
+  }
+  return mesh;
+}
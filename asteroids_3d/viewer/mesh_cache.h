@@ -0,0 +1,127 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "wavefront.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+// binary container of a mesh, that is written once from a wavefront file and later mapped into memory
+// and handed to the GPU without any parsing
+// layout in native byte order: MeshCacheHeader, the vertex attributes, the draw ranges, the levels of detail,
+// the vertex data and the 32 bit index buffer, each section after the header starts at a multiple of MESH_CACHE_ALIGNMENT
+
+constexpr char MESH_CACHE_MAGIC[4] = { 'A', 'M', 'S', 'H' };
+constexpr std::uint32_t MESH_CACHE_VERSION = 3;
+constexpr std::uint64_t MESH_CACHE_ALIGNMENT = 16;
+
+// int16_normalized: GL_SHORT normalized to [-1, 1], int_2_10_10_10_normalized: GL_INT_2_10_10_10_REV normalized
+enum class AttributeType : std::uint32_t { float32 = 0, int16_normalized = 1, int_2_10_10_10_normalized = 2 };
+
+// one input of the vertex shader
+struct VertexAttribute {
+  std::uint32_t location;    // of the input in the shader
+  std::uint32_t components;  // 1 to 4
+  AttributeType type;
+  std::uint32_t offset;      // in bytes from the start of the vertex
+};
+
+// the source_* members identify the wavefront file the cache was created from,
+// size and time of last modification are compared first, the content hash only if they differ
+struct MeshCacheHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t source_hash;
+  std::uint64_t source_size;
+  std::int64_t source_time;
+  std::uint32_t vertex_stride;  // in bytes
+  std::uint32_t no_of_attributes;
+  std::uint32_t no_of_draw_ranges;  // no draw ranges if the colors are vertex attributes
+  std::uint32_t no_of_lods;  // no levels of detail if the draw ranges are the full mesh
+  std::uint64_t no_of_vertices;
+  std::uint64_t no_of_indices;  // no indices if the vertices form a list of triangles
+  float bounds_min[3];
+  float bounds_max[3];
+  std::uint64_t draw_range_offset;  // in bytes from the start of the file
+  std::uint64_t lod_offset;
+  std::uint64_t vertex_offset;
+  std::uint64_t index_offset;
+};
+
+// the layout of the vertex buffer of the WavefrontVertexBufferImporter
+constexpr VertexAttribute WAVEFRONT_VERTEX_LAYOUT[3] = {
+  { 0, 3, AttributeType::float32, 0 },                   // vertice
+  { 2, 3, AttributeType::float32, 3 * sizeof(float) },   // normal
+  { 1, 3, AttributeType::float32, 6 * sizeof(float) }    // color
+};
+
+// the layout of a CompactVertex (see mesh_optimizer.h), the positions are relative to the bounds
+constexpr VertexAttribute COMPACT_VERTEX_LAYOUT[2] = {
+  { 0, 3, AttributeType::int16_normalized, 0 },                                       // vertice
+  { 2, 4, AttributeType::int_2_10_10_10_normalized, offsetof(CompactVertex, normal) }  // normal
+};
+
+// FNV-1a hash of the whole text
+std::uint64_t content_hash(std::string_view text);
+
+// a mesh in the cache format, either a mapped cache file or the bytes of a mesh, whose cache could not be written
+class MeshCache {
+  std::unique_ptr<MappedFile> file;
+  std::string bytes;
+  MeshCacheHeader header;
+  std::vector<VertexAttribute> attributes;
+  std::vector<DrawRange> draw_ranges;
+  std::vector<MeshLod> lods;
+
+  std::string_view get_data() const;
+  void read_header();
+  void store_header();
+public:
+  // maps the cache file into memory
+  // throws std::runtime_error if the file cannot be read or is no cache of the current version
+  explicit MeshCache(const std::string & cache_path);
+
+  // creates the cache format of a mesh in memory, the source stamp of the header is left zero,
+  // the bounds are the ones of the first attribute, if it is a float32 position
+  MeshCache(std::span<const VertexAttribute> attributes, std::uint32_t vertex_stride,
+            std::span<const char> vertex_data, std::span<const std::uint32_t> indices,
+            std::span<const DrawRange> draw_ranges = { }, std::span<const MeshLod> lods = { });
+
+  // creates the cache format of a compact mesh in memory with the COMPACT_VERTEX_LAYOUT
+  explicit MeshCache(const CompactMesh & mesh);
+
+  const MeshCacheHeader & get_header() const;
+  std::span<const VertexAttribute> get_attributes() const;
+  std::span<const DrawRange> get_draw_ranges() const;
+  std::span<const MeshLod> get_lods() const;
+  std::span<const char> get_vertex_data() const;
+  std::span<const std::uint32_t> get_indices() const;
+
+  // true, if the cache was created from the file as it is now
+  bool is_cache_of(const std::string & source_path) const;
+
+  // stores the size, time of last modification and content hash of the source file into the header
+  void set_source(const std::string & source_path);
+
+  // writes the cache to a file, returns false if that is not possible
+  bool write(const std::string & cache_path) const;
+};
+
+// returns the compact mesh of a wavefront file, or a stl file (by the extension ".stl"), with its levels of detail
+// (see create_compact_mesh and create_lods)
+// the cache file next to it (file name with ".mesh" appended) is used if it was created from the same
+// content, otherwise the source file is parsed and the cache file written
+// if the source file is missing, an existing cache file is used as it is,
+// changes of the material libraries are not detected
+// throws std::runtime_error if neither can be read and the exceptions of WavefrontVertexBufferImporter::parse
+// and StlImporter::parse
+MeshCache load_mesh(const std::string & source_path);
+
+#endif
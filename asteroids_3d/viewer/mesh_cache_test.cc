@@ -0,0 +1,201 @@
+#include "mesh_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// a copy of cube.obj in a directory of its own, the material library is read from the working directory
+class MESH_CACHE_FILE : public ::testing::Test {
+protected:
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "mesh_cache_test";
+  std::string source_path = (directory / "cube.obj").string();
+  std::string cache_path = source_path + ".mesh";
+
+  void SetUp() override {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::copy_file("cube.obj", source_path);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(directory);
+  }
+
+};
+
+std::vector<float> as_floats(std::span<const char> data) {
+  std::vector<float> floats(data.size() / sizeof(float));
+  std::memcpy(floats.data(), data.data(), floats.size() * sizeof(float));
+  return floats;
+}
+
+std::vector<char> as_bytes(std::span<const char> data) {
+  return std::vector<char>(data.begin(), data.end());
+}
+
+TEST(MESH_CACHE, CreateInMemoryAndWrite) {
+  const float vertices[2][4] = { {1.0f, -2.0f, 3.0f, 0.5f}, {-1.0f, 4.0f, 2.0f, 0.25f} };
+  const std::vector<std::uint32_t> indices = { 0, 1, 1 };
+  const VertexAttribute layout[2] = { {0, 3, AttributeType::float32, 0}, {1, 1, AttributeType::float32, 12} };
+  const DrawRange draw_ranges[2] = { { {1.0f, 0.0f, 0.0f}, 0, 0 }, { {0.0f, 1.0f, 0.0f}, 0, 3 } };
+  const MeshLod lods[2] = { { 0.0f, 0, 1 }, { 0.5f, 1, 1 } };
+  MeshCache mesh(layout, sizeof(vertices[0]), std::span<const char>(reinterpret_cast<const char *>(vertices), sizeof(vertices)), indices,
+                 draw_ranges, lods);
+
+  const MeshCacheHeader & header = mesh.get_header();
+  EXPECT_EQ(MESH_CACHE_VERSION, header.version);
+  EXPECT_EQ(2u, header.no_of_vertices);
+  EXPECT_EQ(3u, header.no_of_indices);
+  EXPECT_EQ(16u, header.vertex_stride);
+  EXPECT_EQ(0u, header.vertex_offset % MESH_CACHE_ALIGNMENT);
+  EXPECT_EQ(-1.0f, header.bounds_min[0]);
+  EXPECT_EQ(-2.0f, header.bounds_min[1]);
+  EXPECT_EQ(2.0f, header.bounds_min[2]);
+  EXPECT_EQ(1.0f, header.bounds_max[0]);
+  EXPECT_EQ(4.0f, header.bounds_max[1]);
+  EXPECT_EQ(3.0f, header.bounds_max[2]);
+
+  std::string cache_path = (std::filesystem::temp_directory_path() / "mesh_cache_test.mesh").string();
+  ASSERT_TRUE(mesh.write(cache_path));
+  MeshCache mapped(cache_path);
+  EXPECT_EQ(0, std::memcmp(&header, &mapped.get_header(), sizeof(MeshCacheHeader)));
+  ASSERT_EQ(2u, mapped.get_attributes().size());
+  EXPECT_EQ(12u, mapped.get_attributes()[1].offset);
+  EXPECT_EQ(as_floats(mesh.get_vertex_data()), as_floats(mapped.get_vertex_data()));
+  EXPECT_EQ(0.25f, as_floats(mapped.get_vertex_data())[7]);
+  EXPECT_EQ(indices, std::vector<std::uint32_t>(mapped.get_indices().begin(), mapped.get_indices().end()));
+  ASSERT_EQ(2u, mapped.get_draw_ranges().size());
+  EXPECT_EQ(1.0f, mapped.get_draw_ranges()[1].color[1]);
+  EXPECT_EQ(3u, mapped.get_draw_ranges()[1].no_of_indices);
+  ASSERT_EQ(2u, mapped.get_lods().size());
+  EXPECT_EQ(0.5f, mapped.get_lods()[1].error);
+  EXPECT_EQ(1u, mapped.get_lods()[1].first_draw_range);
+  std::filesystem::remove(cache_path);
+}
+
+TEST(MESH_CACHE, RejectsCorruptFiles) {
+  std::string cache_path = (std::filesystem::temp_directory_path() / "mesh_cache_test.mesh").string();
+  std::ofstream(cache_path) << "v 1.0 2.0 3.0\n";
+  EXPECT_THROW(MeshCache{cache_path}, std::runtime_error);
+
+  const float vertices[3] = { 1.0f, 2.0f, 3.0f };
+  MeshCache mesh(std::span<const VertexAttribute>(WAVEFRONT_VERTEX_LAYOUT, 1), sizeof(vertices),
+                 std::span<const char>(reinterpret_cast<const char *>(vertices), sizeof(vertices)), { });
+  ASSERT_TRUE(mesh.write(cache_path));
+  std::filesystem::resize_file(cache_path, std::filesystem::file_size(cache_path) - 1);
+  EXPECT_THROW(MeshCache{cache_path}, std::runtime_error);
+  std::filesystem::remove(cache_path);
+  EXPECT_THROW(MeshCache{cache_path}, std::runtime_error);
+}
+
+// the draw ranges, the levels of detail and the indices are checked, so they can be drawn without checks
+TEST(MESH_CACHE, RejectsRangesOutsideTheMesh) {
+  std::string cache_path = (std::filesystem::temp_directory_path() / "mesh_cache_test.mesh").string();
+  const float vertices[9] = { 0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f, 0.0f };
+  const std::uint32_t indices[3] = { 0, 1, 2 };
+  const DrawRange draw_ranges[1] = { { {1.0f, 1.0f, 1.0f}, 0, 3 } };
+  const MeshLod lods[1] = { { 0.0f, 0, 1 } };
+  MeshCache mesh(std::span<const VertexAttribute>(WAVEFRONT_VERTEX_LAYOUT, 1), 3 * sizeof(float),
+                 std::span<const char>(reinterpret_cast<const char *>(vertices), sizeof(vertices)), indices,
+                 draw_ranges, lods);
+  const MeshCacheHeader & header = mesh.get_header();
+  // writes the cache with one value changed and reads it again
+  auto read_changed = [&](std::uint64_t offset, std::uint32_t value) {
+    ASSERT_TRUE(mesh.write(cache_path));
+    std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    file.close();
+    MeshCache mapped{cache_path};
+  };
+  EXPECT_NO_THROW(read_changed(header.index_offset + 2 * sizeof(std::uint32_t), 2));
+  EXPECT_THROW(read_changed(header.index_offset + 2 * sizeof(std::uint32_t), 3), std::runtime_error);
+  EXPECT_THROW(read_changed(header.draw_range_offset + offsetof(DrawRange, first_index), 1), std::runtime_error);
+  EXPECT_THROW(read_changed(header.draw_range_offset + offsetof(DrawRange, no_of_indices), 0xFFFFFFFFu), std::runtime_error);
+  EXPECT_THROW(read_changed(header.lod_offset + offsetof(MeshLod, first_draw_range), 1), std::runtime_error);
+  EXPECT_THROW(read_changed(header.lod_offset + offsetof(MeshLod, no_of_draw_ranges), 2), std::runtime_error);
+  std::filesystem::remove(cache_path);
+}
+
+// the cube has four vertices per side and two triangles of different sides per material
+TEST_F(MESH_CACHE_FILE, LoadWritesTheCompactMesh) {
+  MeshCache mesh = load_mesh(source_path);
+  EXPECT_TRUE(std::filesystem::exists(cache_path));
+  EXPECT_FALSE(std::filesystem::exists(cache_path + ".tmp"));
+  EXPECT_EQ(24u, mesh.get_header().no_of_vertices);
+  EXPECT_EQ(36u, mesh.get_header().no_of_indices);
+  EXPECT_EQ(sizeof(CompactVertex), mesh.get_header().vertex_stride);
+  ASSERT_EQ(2u, mesh.get_attributes().size());
+  EXPECT_EQ(AttributeType::int_2_10_10_10_normalized, mesh.get_attributes()[1].type);
+  ASSERT_EQ(6u, mesh.get_draw_ranges().size());
+  EXPECT_EQ(1.0f, mesh.get_draw_ranges()[0].color[0]);  // red
+  EXPECT_EQ(0.0f, mesh.get_draw_ranges()[0].color[1]);
+  EXPECT_EQ(30u, mesh.get_draw_ranges()[5].first_index);
+  ASSERT_EQ(1u, mesh.get_lods().size());  // too small for levels of detail
+  EXPECT_EQ(6u, mesh.get_lods()[0].no_of_draw_ranges);
+  EXPECT_EQ(-1.0f, mesh.get_header().bounds_min[0]);
+  EXPECT_NEAR(1.0f, mesh.get_header().bounds_max[2], 1e-5f);
+
+  MeshCache cache(cache_path);
+  EXPECT_TRUE(cache.is_cache_of(source_path));
+  EXPECT_EQ(0, std::memcmp(&mesh.get_header(), &cache.get_header(), sizeof(MeshCacheHeader)));
+  EXPECT_EQ(as_bytes(mesh.get_vertex_data()), as_bytes(cache.get_vertex_data()));
+  EXPECT_TRUE(std::equal(mesh.get_indices().begin(), mesh.get_indices().end(), cache.get_indices().begin()));
+}
+
+TEST_F(MESH_CACHE_FILE, CacheIsKeyedOnTheContent) {
+  load_mesh(source_path);
+  // the same content with another time of modification
+  std::filesystem::last_write_time(source_path, std::filesystem::last_write_time(source_path) + std::chrono::hours(1));
+  EXPECT_TRUE(MeshCache{cache_path}.is_cache_of(source_path));
+
+  std::ofstream(source_path, std::ios::app) << "f 1//1 2//1 3//1\n";
+  EXPECT_FALSE(MeshCache{cache_path}.is_cache_of(source_path));
+  MeshCache mesh = load_mesh(source_path);
+  EXPECT_EQ(39u, mesh.get_header().no_of_indices);
+  EXPECT_TRUE(MeshCache{cache_path}.is_cache_of(source_path));
+}
+
+TEST_F(MESH_CACHE_FILE, CacheWithoutSource) {
+  std::vector<char> expected = as_bytes( load_mesh(source_path).get_vertex_data() );
+  std::filesystem::remove(source_path);
+  EXPECT_EQ(expected, as_bytes(load_mesh(source_path).get_vertex_data()));
+
+  std::filesystem::remove(cache_path);
+  EXPECT_THROW(load_mesh(source_path), std::runtime_error);
+}
+
+// the smooth normals of a stl file are the same at all corners of a vertice, so it stays one vertex
+TEST_F(MESH_CACHE_FILE, LoadsStlFiles) {
+  std::string stl_path = (directory / "tetrahedron.stl").string();
+  {
+    std::ofstream out(stl_path);
+    const char * triangles[4][3] = { {"0 0 0", "0 1 0", "1 0 0"}, {"0 0 0", "1 0 0", "0 0 1"},
+                                     {"0 0 0", "0 0 1", "0 1 0"}, {"1 0 0", "0 1 0", "0 0 1"} };
+    out << "solid tetrahedron\n";
+    for (const auto & triangle : triangles) {
+      out << "facet normal 0 0 0\nouter loop\n";
+      for (const char * vertice : triangle) {
+        out << "vertex " << vertice << "\n";
+      }
+      out << "endloop\nendfacet\n";
+    }
+    out << "endsolid tetrahedron\n";
+  }
+  MeshCache mesh = load_mesh(stl_path);
+  EXPECT_TRUE(std::filesystem::exists(stl_path + ".mesh"));
+  EXPECT_EQ(4u, mesh.get_header().no_of_vertices);
+  EXPECT_EQ(12u, mesh.get_header().no_of_indices);
+  ASSERT_EQ(1u, mesh.get_draw_ranges().size());
+  EXPECT_EQ(1.0f, mesh.get_draw_ranges()[0].color[2]);  // white
+  EXPECT_TRUE(MeshCache{stl_path + ".mesh"}.is_cache_of(stl_path));
+}
+
+}
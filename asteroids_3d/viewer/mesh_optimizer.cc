@@ -0,0 +1,241 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr std::uint32_t NO_VERTEX = std::numeric_limits<std::uint32_t>::max();
+
+std::uint64_t hash_vertex(const float * vertex, size_t floats_per_vertex) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < floats_per_vertex; i++) {
+    std::uint32_t bits;
+    std::memcpy(&bits, vertex + i, sizeof(bits));
+    hash = (hash ^ bits) * 1099511628211ull;
+  }
+  return hash ^ (hash >> 32);
+}
+
+// the value relative to the center of the bounds as a normalized 16 bit integer
+std::int16_t quantize(float value, float center, float half_extent) {
+  if ( ! (half_extent > 0.0f) ) {
+    return 0;
+  }
+  float normalized = std::clamp((value - center) / half_extent, -1.0f, 1.0f);
+  return static_cast<std::int16_t>( std::lround(normalized * 32767.0f) );
+}
+
+}
+
+// bitwise identical vertices are found with a hash table of open addressing, which is at most half full
+IndexedMesh weld_vertices(std::span<const float> vertices, size_t floats_per_vertex) {
+  IndexedMesh mesh;
+  size_t no_of_vertices = vertices.size() / floats_per_vertex;
+  size_t capacity = 16;
+  while (capacity < 2 * no_of_vertices) {
+    capacity *= 2;
+  }
+  std::vector<std::uint32_t> table(capacity, NO_VERTEX);
+  mesh.indices.reserve(no_of_vertices);
+  for (size_t i = 0; i < no_of_vertices; i++) {
+    const float * vertex = vertices.data() + i * floats_per_vertex;
+    size_t slot = hash_vertex(vertex, floats_per_vertex) & (capacity - 1);
+    while (table[slot] != NO_VERTEX
+           && std::memcmp(mesh.vertices.data() + table[slot] * floats_per_vertex, vertex, floats_per_vertex * sizeof(float)) != 0) {
+      slot = (slot + 1) & (capacity - 1);
+    }
+    if (table[slot] == NO_VERTEX) {
+      table[slot] = static_cast<std::uint32_t>( mesh.vertices.size() / floats_per_vertex );
+      mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + floats_per_vertex);
+    }
+    mesh.indices.push_back(table[slot]);
+  }
+  return mesh;
+}
+
+// the triangles around a fanning vertex are emitted, the next fanning vertex is the vertex of these triangles, that stays
+// in the cache while its remaining triangles are emitted and entered it first, without one a vertex of the recently
+// emitted triangles (dead end stack) or the next vertex in order with remaining triangles is taken
+void optimize_vertex_cache(std::span<std::uint32_t> indices, size_t no_of_vertices, size_t cache_size) {
+  size_t no_of_triangles = indices.size() / 3;
+  if (no_of_triangles == 0) {
+    return;
+  }
+  // the triangles of each vertex, the ones of vertex v are triangles[first_triangle[v]] to triangles[first_triangle[v + 1] - 1]
+  std::vector<std::uint32_t> live_triangles(no_of_vertices, 0);
+  for (std::uint32_t index : indices) {
+    live_triangles[index]++;
+  }
+  std::vector<size_t> first_triangle(no_of_vertices + 1, 0);
+  for (size_t v = 0; v < no_of_vertices; v++) {
+    first_triangle[v + 1] = first_triangle[v] + live_triangles[v];
+  }
+  std::vector<std::uint32_t> triangles(3 * no_of_triangles);
+  std::vector<size_t> next_triangle(first_triangle.begin(), first_triangle.end() - 1);
+  for (size_t i = 0; i < 3 * no_of_triangles; i++) {
+    triangles[ next_triangle[indices[i]]++ ] = static_cast<std::uint32_t>(i / 3);
+  }
+
+  std::vector<size_t> cache_time(no_of_vertices, 0);
+  std::vector<bool> emitted(no_of_triangles, false);
+  std::vector<std::uint32_t> dead_ends;
+  std::vector<std::uint32_t> candidates;
+  std::vector<std::uint32_t> output;
+  output.reserve(3 * no_of_triangles);
+  size_t time = cache_size + 1;
+  size_t cursor = 0;  // the vertices before have no remaining triangles
+  std::uint32_t fanning = indices[0];
+  while (fanning != NO_VERTEX) {
+    candidates.clear();
+    for (size_t i = first_triangle[fanning]; i < first_triangle[fanning + 1]; i++) {
+      std::uint32_t triangle = triangles[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+      for (size_t corner = 0; corner < 3; corner++) {
+        std::uint32_t v = indices[3 * triangle + corner];
+        output.push_back(v);
+        dead_ends.push_back(v);
+        candidates.push_back(v);
+        live_triangles[v]--;
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+        }
+      }
+      emitted[triangle] = true;
+    }
+
+    fanning = NO_VERTEX;
+    long best_priority = -1;
+    for (std::uint32_t v : candidates) {
+      if (live_triangles[v] == 0) {
+        continue;
+      }
+      long priority = 0;
+      if (time - cache_time[v] + 2 * live_triangles[v] <= cache_size) {
+        priority = static_cast<long>(time - cache_time[v]);
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning = v;
+      }
+    }
+    while (fanning == NO_VERTEX && ! dead_ends.empty()) {
+      std::uint32_t v = dead_ends.back();
+      dead_ends.pop_back();
+      if (live_triangles[v] > 0) {
+        fanning = v;
+      }
+    }
+    for (; fanning == NO_VERTEX && cursor < no_of_vertices; cursor++) {
+      if (live_triangles[cursor] > 0) {
+        fanning = static_cast<std::uint32_t>(cursor);
+      }
+    }
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+// a vertex is in the cache, if fewer than cache_size vertices entered the cache after it
+size_t count_vertex_shader_invocations(std::span<const std::uint32_t> indices, size_t no_of_vertices, size_t cache_size) {
+  std::vector<size_t> entered(no_of_vertices, 0);  // the number of invocations after the vertex entered, 0 if never
+  size_t invocations = 0;
+  for (std::uint32_t index : indices) {
+    if (entered[index] == 0 || invocations - entered[index] >= cache_size) {
+      entered[index] = ++invocations;
+    }
+  }
+  return invocations;
+}
+
+std::uint32_t pack_normal(const Normal & normal) {
+  std::uint32_t packed = 0;
+  for (size_t i = 0; i < 3; i++) {
+    long component = std::lround( std::clamp(normal[i], -1.0f, 1.0f) * 511.0f );
+    packed |= (static_cast<std::uint32_t>(component) & 0x3ffu) << (10 * i);
+  }
+  return packed;
+}
+
+CompactMesh create_compact_mesh(std::span<const float> vertex_buffer, size_t cache_size) {
+  constexpr size_t FLOATS_PER_CORNER = 9;
+  constexpr size_t FLOATS_PER_TRIANGLE = 3 * FLOATS_PER_CORNER;
+  constexpr size_t FLOATS_PER_VERTEX = 6;  // the position and the normal
+  CompactMesh mesh;
+  size_t no_of_triangles = vertex_buffer.size() / FLOATS_PER_TRIANGLE;
+
+  // the few colors are searched linearly
+  std::vector<std::uint32_t> range_of_triangle(no_of_triangles);
+  for (size_t t = 0; t < no_of_triangles; t++) {
+    const float * color = vertex_buffer.data() + t * FLOATS_PER_TRIANGLE + 6;
+    auto range = std::find_if(mesh.draw_ranges.begin(), mesh.draw_ranges.end(),
+                              [color](const DrawRange & r) { return std::memcmp(r.color, color, sizeof(r.color)) == 0; });
+    if (range == mesh.draw_ranges.end()) {
+      mesh.draw_ranges.push_back( DrawRange{ {color[0], color[1], color[2]}, 0u, 0u } );
+      range = mesh.draw_ranges.end() - 1;
+    }
+    range->no_of_indices += 3;
+    range_of_triangle[t] = static_cast<std::uint32_t>( range - mesh.draw_ranges.begin() );
+  }
+  std::vector<size_t> next_corner(mesh.draw_ranges.size());
+  for (size_t r = 1; r < mesh.draw_ranges.size(); r++) {
+    mesh.draw_ranges[r].first_index = mesh.draw_ranges[r - 1].first_index + mesh.draw_ranges[r - 1].no_of_indices;
+    next_corner[r] = mesh.draw_ranges[r].first_index;
+  }
+
+  // the corners without color sorted by draw range, a vertex may be shared by draw ranges
+  std::vector<float> corners(3 * no_of_triangles * FLOATS_PER_VERTEX);
+  for (size_t t = 0; t < no_of_triangles; t++) {
+    size_t corner = next_corner[ range_of_triangle[t] ];
+    next_corner[ range_of_triangle[t] ] += 3;
+    for (size_t c = 0; c < 3; c++) {
+      const float * source = vertex_buffer.data() + t * FLOATS_PER_TRIANGLE + c * FLOATS_PER_CORNER;
+      std::copy(source, source + FLOATS_PER_VERTEX, corners.begin() + (corner + c) * FLOATS_PER_VERTEX);
+    }
+  }
+  IndexedMesh welded = weld_vertices(corners, FLOATS_PER_VERTEX);
+  size_t no_of_vertices = welded.vertices.size() / FLOATS_PER_VERTEX;
+  for (const DrawRange & range : mesh.draw_ranges) {
+    optimize_vertex_cache(std::span<std::uint32_t>(welded.indices).subspan(range.first_index, range.no_of_indices),
+                          no_of_vertices, cache_size);
+  }
+
+  if (no_of_vertices > 0) {
+    std::copy(welded.vertices.begin(), welded.vertices.begin() + 3, mesh.bounds_min);
+    std::copy(welded.vertices.begin(), welded.vertices.begin() + 3, mesh.bounds_max);
+  }
+  for (size_t v = 0; v < no_of_vertices; v++) {
+    for (size_t i = 0; i < 3; i++) {
+      mesh.bounds_min[i] = std::min(mesh.bounds_min[i], welded.vertices[v * FLOATS_PER_VERTEX + i]);
+      mesh.bounds_max[i] = std::max(mesh.bounds_max[i], welded.vertices[v * FLOATS_PER_VERTEX + i]);
+    }
+  }
+  float center[3], half_extent[3];
+  for (size_t i = 0; i < 3; i++) {
+    center[i] = 0.5f * (mesh.bounds_min[i] + mesh.bounds_max[i]);
+    half_extent[i] = 0.5f * (mesh.bounds_max[i] - mesh.bounds_min[i]);
+  }
+
+  // the vertices in the order of their first use, so they are fetched sequentially
+  std::vector<std::uint32_t> new_index(no_of_vertices, NO_VERTEX);
+  mesh.vertices.reserve(no_of_vertices);
+  mesh.indices = std::move(welded.indices);
+  for (std::uint32_t & index : mesh.indices) {
+    if (new_index[index] == NO_VERTEX) {
+      const float * vertex = welded.vertices.data() + index * FLOATS_PER_VERTEX;
+      CompactVertex compact{};
+      for (size_t i = 0; i < 3; i++) {
+        compact.position[i] = quantize(vertex[i], center[i], half_extent[i]);
+      }
+      compact.normal = pack_normal( Normal{vertex[3], vertex[4], vertex[5]} );
+      new_index[index] = static_cast<std::uint32_t>( mesh.vertices.size() );
+      mesh.vertices.push_back(compact);
+    }
+    index = new_index[index];
+  }
+  mesh.lods.push_back( MeshLod{ 0.0f, 0u, static_cast<std::uint32_t>( mesh.draw_ranges.size() ) } );
+  return mesh;
+}
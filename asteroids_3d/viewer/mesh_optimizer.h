@@ -0,0 +1,78 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "wavefront.h"
+
+// the import stage from the flat vertex buffer of the WavefrontVertexBufferImporter to indexed meshes:
+// identical vertices are welded, the triangles are reordered for the post-transform vertex cache of the GPU
+// and the vertices are stored in a compact format
+
+// a typical size of the post-transform vertex cache
+constexpr size_t DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+// a list of triangles, three indices per triangle
+struct IndexedMesh {
+  std::vector<float> vertices;  // floats_per_vertex floats per vertex
+  std::vector<std::uint32_t> indices;
+};
+
+// 12 bytes instead of the 36 bytes of the flat vertex buffer: the position as normalized 16 bit integers relative
+// to the bounds of the mesh (the fourth is padding), and the normal packed into 10 bits per component
+// (GL_INT_2_10_10_10_REV), the color is a uniform of the draw range
+struct CompactVertex {
+  std::int16_t position[4];
+  std::uint32_t normal;
+};
+
+// the triangles of the index buffer drawn with one material color
+struct DrawRange {
+  float color[3];
+  std::uint32_t first_index;
+  std::uint32_t no_of_indices;
+};
+
+// a level of detail of a mesh: the draw ranges drawn instead of the ones of the full mesh, one per material color
+// of the full mesh, and the largest distance to the surface of the full mesh (see mesh_simplifier.h)
+struct MeshLod {
+  float error;
+  std::uint32_t first_draw_range;
+  std::uint32_t no_of_draw_ranges;
+};
+
+// the positions are quantized relative to the center and the extent of the bounds
+struct CompactMesh {
+  std::vector<CompactVertex> vertices;
+  std::vector<std::uint32_t> indices;
+  std::vector<DrawRange> draw_ranges;
+  std::vector<MeshLod> lods;  // the full mesh first, all levels of detail share the vertices
+  float bounds_min[3] = { };
+  float bounds_max[3] = { };
+};
+
+// returns one index per vertex of the list, bitwise identical vertices are stored once
+IndexedMesh weld_vertices(std::span<const float> vertices, size_t floats_per_vertex);
+
+// reorders the triangles for a post-transform vertex cache of the given size with Tipsify
+// (Sander, Nehab, Barczak: Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007),
+// the corners of each triangle keep their order, so the winding is not changed
+void optimize_vertex_cache(std::span<std::uint32_t> indices, size_t no_of_vertices, size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+// returns the number of vertex shader invocations for the indices with a FIFO post-transform cache of the given size,
+// without a cache (glDrawArrays) it is the number of indices
+size_t count_vertex_shader_invocations(std::span<const std::uint32_t> indices, size_t no_of_vertices,
+                                       size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+// returns the normal packed as GL_INT_2_10_10_10_REV with w = 0, the components are clamped to [-1, 1]
+std::uint32_t pack_normal(const Normal & normal);
+
+// creates the compact mesh of a vertex buffer of the WavefrontVertexBufferImporter (9 floats per corner of a triangle):
+// the triangles are grouped into one draw range per color in the order of their first appearance, vertices with the same
+// position and normal are welded, the triangles of each range are reordered with optimize_vertex_cache and the vertices
+// are stored in the order of their first use, the mesh has the full mesh as its only level of detail
+CompactMesh create_compact_mesh(std::span<const float> vertex_buffer, size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+#endif
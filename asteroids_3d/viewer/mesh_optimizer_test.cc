@@ -0,0 +1,144 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// a grid of size x size vertices, two triangles per cell, the triangles in random order
+std::vector<std::uint32_t> create_shuffled_grid(std::uint32_t size) {
+  std::vector< std::array<std::uint32_t, 3> > triangles;
+  for (std::uint32_t y = 0; y + 1 < size; y++) {
+    for (std::uint32_t x = 0; x + 1 < size; x++) {
+      std::uint32_t a = y * size + x, b = a + 1, c = a + size, d = c + 1;
+      triangles.push_back( {a, b, d} );
+      triangles.push_back( {a, d, c} );
+    }
+  }
+  std::mt19937 generator(1u);
+  std::shuffle(triangles.begin(), triangles.end(), generator);
+  std::vector<std::uint32_t> indices;
+  for (const auto & triangle : triangles) {
+    indices.insert(indices.end(), triangle.begin(), triangle.end());
+  }
+  return indices;
+}
+
+// the triangles with their first corner at the smallest index, so they compare equal if only the corners are rotated
+std::vector< std::array<std::uint32_t, 3> > sorted_triangles(const std::vector<std::uint32_t> & indices) {
+  std::vector< std::array<std::uint32_t, 3> > triangles;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    std::array<std::uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+    std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+float unpack_component(std::uint32_t packed, size_t i) {
+  std::int32_t component = static_cast<std::int32_t>(packed << (22 - 10 * i)) >> 22;  // sign extended
+  return std::max(component / 511.0f, -1.0f);
+}
+
+TEST(MESH_OPTIMIZER, WeldsIdenticalVertices) {
+  const std::vector<float> square = { 0, 0,  1, 0,  1, 1,   0, 0,  1, 1,  0, 1 };
+  IndexedMesh mesh = weld_vertices(square, 2);
+
+  EXPECT_EQ((std::vector<std::uint32_t>{ 0, 1, 2, 0, 2, 3 }), mesh.indices);
+  EXPECT_EQ((std::vector<float>{ 0, 0,  1, 0,  1, 1,  0, 1 }), mesh.vertices);
+  EXPECT_TRUE(weld_vertices({}, 3).indices.empty());
+}
+
+TEST(MESH_OPTIMIZER, CountsInvocationsOfAFifoCache) {
+  const std::vector<std::uint32_t> indices = { 0, 1, 2,  0, 2, 3 };
+  EXPECT_EQ(4u, count_vertex_shader_invocations(indices, 4, 16));
+  EXPECT_EQ(6u, count_vertex_shader_invocations(indices, 4, 0));
+  EXPECT_EQ(5u, count_vertex_shader_invocations(indices, 4, 2));  // 0 is evicted by 2, not by the hit of 2
+}
+
+TEST(MESH_OPTIMIZER, VertexCacheOrderKeepsTheTriangles) {
+  constexpr std::uint32_t SIZE = 64;
+  std::vector<std::uint32_t> indices = create_shuffled_grid(SIZE);
+  std::vector<std::uint32_t> optimized = indices;
+  optimize_vertex_cache(optimized, SIZE * SIZE, 16);
+
+  EXPECT_EQ(sorted_triangles(indices), sorted_triangles(optimized));
+  size_t no_of_triangles = indices.size() / 3;
+  double shuffled_acmr = static_cast<double>( count_vertex_shader_invocations(indices, SIZE * SIZE, 16) ) / no_of_triangles;
+  double optimized_acmr = static_cast<double>( count_vertex_shader_invocations(optimized, SIZE * SIZE, 16) ) / no_of_triangles;
+  EXPECT_LT(2.5, shuffled_acmr);
+  EXPECT_GT(0.8, optimized_acmr);  // 0.5 is the limit for large grids
+}
+
+TEST(MESH_OPTIMIZER, PacksNormals) {
+  std::uint32_t packed = pack_normal( Normal{1.0f, -0.5f, -1.0f} );
+  EXPECT_EQ(0u, packed >> 30);
+  EXPECT_EQ(1.0f, unpack_component(packed, 0));
+  EXPECT_NEAR(-0.5f, unpack_component(packed, 1), 0.5f / 511.0f);
+  EXPECT_EQ(-1.0f, unpack_component(packed, 2));
+  EXPECT_EQ(1.0f, unpack_component(pack_normal( Normal{2.0f, 0.0f, 0.0f} ), 0));
+}
+
+// every triangle of the cube is found in its draw range with the quantized positions and normals
+TEST(MESH_OPTIMIZER, CompactMeshOfTheCube) {
+  WavefrontVertexBufferImporter importer;
+  importer.parse_file("cube.obj");
+  const std::vector<float> & buffer = importer.get_vertex_buffer();
+  CompactMesh mesh = create_compact_mesh(buffer);
+
+  ASSERT_EQ(6u, mesh.draw_ranges.size());
+  EXPECT_EQ(24u, mesh.vertices.size());
+  EXPECT_EQ(36u, mesh.indices.size());
+  EXPECT_EQ(-1.0f, mesh.bounds_min[1]);
+  EXPECT_EQ(1.0f, mesh.bounds_max[0]);
+
+  std::vector<bool> found(buffer.size() / 27, false);
+  for (const DrawRange & range : mesh.draw_ranges) {
+    ASSERT_EQ(6u, range.no_of_indices);
+    for (size_t i = range.first_index; i < range.first_index + range.no_of_indices; i += 3) {
+      float corners[3][6];
+      for (size_t c = 0; c < 3; c++) {
+        const CompactVertex & vertex = mesh.vertices[ mesh.indices[i + c] ];
+        for (size_t k = 0; k < 3; k++) {
+          float center = 0.5f * (mesh.bounds_min[k] + mesh.bounds_max[k]);
+          float half_extent = 0.5f * (mesh.bounds_max[k] - mesh.bounds_min[k]);
+          corners[c][k] = center + half_extent * std::max(vertex.position[k] / 32767.0f, -1.0f);
+          corners[c][3 + k] = unpack_component(vertex.normal, k);
+        }
+      }
+      bool matches = false;
+      for (size_t t = 0; t < found.size() && ! matches; t++) {
+        const float * triangle = buffer.data() + 27 * t;
+        matches = ! found[t] && std::equal(range.color, range.color + 3, triangle + 6);
+        for (size_t c = 0; c < 3 && matches; c++) {
+          for (size_t k = 0; k < 6; k++) {
+            matches = matches && std::abs(corners[c][k] - triangle[9 * c + k]) < 1e-3f;
+          }
+        }
+        if (matches) {
+          found[t] = true;
+        }
+      }
+      EXPECT_TRUE(matches) << i;
+    }
+  }
+}
+
+TEST(MESH_OPTIMIZER, VerticesInTheOrderOfTheirFirstUse) {
+  WavefrontVertexBufferImporter importer;
+  importer.parse_file("cube.obj");
+  CompactMesh mesh = create_compact_mesh(importer.get_vertex_buffer());
+  std::uint32_t next = 0;
+  for (std::uint32_t index : mesh.indices) {
+    ASSERT_LE(index, next);
+    next = std::max(next, index + 1);
+  }
+  EXPECT_EQ(mesh.vertices.size(), next);
+}
+
+}
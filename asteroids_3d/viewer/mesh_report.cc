@@ -0,0 +1,65 @@
+#include "wavefront.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// prints the bytes on the GPU and the vertex shader invocations per frame of each given wavefront file (default cube.obj)
+// for the flat vertex buffer drawn with glDrawArrays, the welded vertices drawn with glDrawElements in the order
+// of the file, and the compact mesh of the import stage (see mesh_optimizer.h) with its levels of detail (see mesh_simplifier.h)
+// the invocations are counted with a FIFO post-transform cache of DEFAULT_VERTEX_CACHE_SIZE vertices
+
+namespace {
+
+void print_row(const std::string & name, size_t bytes, size_t invocations, size_t no_of_triangles) {
+  std::cout << "  " << std::left << std::setw(30) << name << std::right
+            << std::setw(12) << bytes << " bytes"
+            << std::setw(12) << invocations << " invocations"
+            << std::setw(10) << std::fixed << std::setprecision(3)
+            << (no_of_triangles > 0 ? static_cast<double>(invocations) / no_of_triangles : 0.0) << " per triangle" << std::endl;
+}
+
+}
+
+int main(int argc, char * argv[]) {
+  std::vector<std::string> file_paths(argv + 1, argv + argc);
+  if (file_paths.empty()) {
+    file_paths.push_back("cube.obj");
+  }
+  for (const std::string & file_path : file_paths) {
+    WavefrontVertexBufferImporter importer;
+    try {
+      importer.parse_file(file_path);
+    } catch (const std::exception & e) {
+      std::cerr << file_path << ": " << e.what() << std::endl;
+      return 1;
+    }
+    const std::vector<float> & buffer = importer.get_vertex_buffer();
+    size_t no_of_corners = buffer.size() / 9;
+    size_t no_of_triangles = no_of_corners / 3;
+    std::cout << file_path << ": " << no_of_triangles << " triangles" << std::endl;
+    print_row("flat, glDrawArrays", buffer.size() * sizeof(float), no_of_corners, no_of_triangles);
+
+    IndexedMesh welded = weld_vertices(buffer, 9);
+    size_t no_of_vertices = welded.vertices.size() / 9;
+    print_row("welded, glDrawElements", welded.vertices.size() * sizeof(float) + welded.indices.size() * sizeof(std::uint32_t),
+              count_vertex_shader_invocations(welded.indices, no_of_vertices), no_of_triangles);
+
+    CompactMesh mesh = create_compact_mesh(buffer);
+    print_row("compact, vertex cache order", mesh.vertices.size() * sizeof(CompactVertex) + mesh.indices.size() * sizeof(std::uint32_t),
+              count_vertex_shader_invocations(mesh.indices, mesh.vertices.size()), no_of_triangles);
+    std::cout << "  " << no_of_vertices << " welded vertices, " << mesh.vertices.size() << " compact vertices, "
+              << mesh.draw_ranges.size() << " draw ranges" << std::endl;
+
+    create_lods(mesh);
+    for (size_t lod = 1; lod < mesh.lods.size(); lod++) {
+      size_t no_of_indices = 0;
+      for (size_t r = 0; r < mesh.lods[lod].no_of_draw_ranges; r++) {
+        no_of_indices += mesh.draw_ranges[mesh.lods[lod].first_draw_range + r].no_of_indices;
+      }
+      std::cout << "  level of detail " << lod << ": " << no_of_indices / 3 << " triangles, error " << mesh.lods[lod].error << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,351 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+
+// the weight of the planes through boundary edges relative to the area of the triangles, they keep the outline of open meshes
+constexpr double BOUNDARY_WEIGHT = 10.0;
+
+typedef std::array<double, 3> Point;
+
+Point get_point(const std::vector<float> & points, std::uint32_t i) {
+  return { points[3 * i], points[3 * i + 1], points[3 * i + 2] };
+}
+
+Point subtract(const Point & a, const Point & b) {
+  return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+}
+
+Point cross(const Point & a, const Point & b) {
+  return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+double dot(const Point & a, const Point & b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// the weighted sum of the squared distances of a point x to planes: x^T A x + 2 b^T x + c
+struct Quadric {
+  double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+  double b0 = 0.0, b1 = 0.0, b2 = 0.0, c = 0.0;
+  double weight = 0.0;
+
+  // the plane of the points x with n^T x + d = 0, n is a unit vector
+  void add_plane(const Point & n, double d, double w) {
+    a00 += w * n[0] * n[0]; a01 += w * n[0] * n[1]; a02 += w * n[0] * n[2];
+    a11 += w * n[1] * n[1]; a12 += w * n[1] * n[2]; a22 += w * n[2] * n[2];
+    b0 += w * n[0] * d; b1 += w * n[1] * d; b2 += w * n[2] * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  void add(const Quadric & q) {
+    a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+    b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+    weight += q.weight;
+  }
+
+  // the weighted mean of the squared distances
+  double mean_squared_distance(const Point & x) const {
+    double r = a00 * x[0] * x[0] + a11 * x[1] * x[1] + a22 * x[2] * x[2]
+               + 2.0 * (a01 * x[0] * x[1] + a02 * x[0] * x[2] + a12 * x[1] * x[2])
+               + 2.0 * (b0 * x[0] + b1 * x[1] + b2 * x[2]) + c;
+    return weight > 0.0 ? std::max(r, 0.0) / weight : 0.0;
+  }
+};
+
+// the vertex at position from is moved to position to
+struct Collapse {
+  double error;
+  std::uint32_t from;
+  std::uint32_t to;
+  std::uint32_t from_stamp;  // the collapse is outdated, if one of the positions changed after it was queued
+  std::uint32_t to_stamp;
+
+  bool operator>(const Collapse & other) const {
+    return error > other.error;
+  }
+};
+
+// returns the normal in [-1, 1] of a normal packed by pack_normal
+float unpack_normal_component(std::uint32_t packed, size_t i) {
+  std::int32_t component = static_cast<std::int32_t>(packed << (22 - 10 * i)) >> 22;  // sign extended
+  return std::max(component / 511.0f, -1.0f);
+}
+
+}
+
+// the positions are welded, the surface is the list of triangles of each position, the corners keep their vertices
+// until the position of a vertex is collapsed
+std::vector<SimplifiedMesh> simplify_mesh(std::span<const float> vertices, size_t floats_per_vertex,
+                                          std::span<const std::uint32_t> indices, std::span<const size_t> targets) {
+  size_t no_of_vertices = vertices.size() / floats_per_vertex;
+  size_t no_of_triangles = indices.size() / 3;
+  std::vector<float> vertex_positions(3 * no_of_vertices);
+  for (size_t v = 0; v < no_of_vertices; v++) {
+    std::copy(vertices.begin() + v * floats_per_vertex, vertices.begin() + v * floats_per_vertex + 3, vertex_positions.begin() + 3 * v);
+  }
+  IndexedMesh welded = weld_vertices(vertex_positions, 3);
+  const std::vector<float> & points = welded.vertices;
+  const std::vector<std::uint32_t> & position_of = welded.indices;  // of each vertex
+  size_t no_of_positions = points.size() / 3;
+  std::vector< std::vector<std::uint32_t> > vertices_at(no_of_positions);
+  for (size_t v = 0; v < no_of_vertices; v++) {
+    vertices_at[ position_of[v] ].push_back( static_cast<std::uint32_t>(v) );
+  }
+
+  std::vector<std::uint32_t> corners(indices.begin(), indices.end());
+  auto position = [&](std::uint32_t triangle, size_t corner) { return position_of[ corners[3 * triangle + corner] ]; };
+  auto contains = [&](std::uint32_t triangle, std::uint32_t p) {
+    return position(triangle, 0) == p || position(triangle, 1) == p || position(triangle, 2) == p;
+  };
+  auto normal = [&](std::uint32_t triangle, std::uint32_t moved, std::uint32_t to) {
+    Point p[3];
+    for (size_t c = 0; c < 3; c++) {
+      std::uint32_t i = position(triangle, c);
+      p[c] = get_point(points, i == moved ? to : i);
+    }
+    return cross(subtract(p[1], p[0]), subtract(p[2], p[0]));
+  };
+
+  // triangles with two corners at the same position are not drawn and removed
+  std::vector<bool> alive(no_of_triangles, false);
+  std::vector< std::vector<std::uint32_t> > triangles_at(no_of_positions);
+  std::vector<Quadric> quadrics(no_of_positions);
+  size_t no_of_alive = 0;
+  for (std::uint32_t t = 0; t < no_of_triangles; t++) {
+    std::uint32_t p0 = position(t, 0), p1 = position(t, 1), p2 = position(t, 2);
+    if (p0 == p1 || p1 == p2 || p2 == p0) {
+      continue;
+    }
+    alive[t] = true;
+    no_of_alive++;
+    Point n = normal(t, 0, 0);
+    double length = std::sqrt(dot(n, n));
+    for (size_t c = 0; c < 3; c++) {
+      triangles_at[ position(t, c) ].push_back(t);
+    }
+    if (length > 0.0) {
+      n = { n[0] / length, n[1] / length, n[2] / length };
+      for (size_t c = 0; c < 3; c++) {
+        quadrics[ position(t, c) ].add_plane(n, -dot(n, get_point(points, p0)), 0.5 * length);
+      }
+    }
+  }
+
+  // an edge is a boundary, if it is an edge of one triangle only
+  std::vector< std::pair<std::uint64_t, std::uint32_t> > edges;  // the positions of the edge and the triangle
+  for (std::uint32_t t = 0; t < no_of_triangles; t++) {
+    for (size_t c = 0; alive[t] && c < 3; c++) {
+      std::uint64_t a = position(t, c), b = position(t, (c + 1) % 3);
+      edges.emplace_back( std::min(a, b) << 32 | std::max(a, b), t );
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < edges.size(); i++) {
+    bool shared = (i > 0 && edges[i - 1].first == edges[i].first) || (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+    if (shared) {
+      continue;
+    }
+    std::uint32_t a = static_cast<std::uint32_t>(edges[i].first >> 32), b = static_cast<std::uint32_t>(edges[i].first);
+    Point edge = subtract(get_point(points, b), get_point(points, a));
+    Point n = cross(edge, normal(edges[i].second, 0, 0));
+    double length = std::sqrt(dot(n, n));
+    if (length > 0.0) {
+      n = { n[0] / length, n[1] / length, n[2] / length };
+      double d = -dot(n, get_point(points, a));
+      quadrics[a].add_plane(n, d, BOUNDARY_WEIGHT * dot(edge, edge));
+      quadrics[b].add_plane(n, d, BOUNDARY_WEIGHT * dot(edge, edge));
+    }
+  }
+
+  std::vector<std::uint32_t> stamps(no_of_positions, 0);
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > queue;
+  auto collapse_error = [&](std::uint32_t from, std::uint32_t to) {
+    Quadric q = quadrics[from];
+    q.add(quadrics[to]);
+    return q.mean_squared_distance( get_point(points, to) );
+  };
+  auto push_edge = [&](std::uint32_t a, std::uint32_t b) {
+    double a_to_b = collapse_error(a, b), b_to_a = collapse_error(b, a);
+    if (a_to_b <= b_to_a) {
+      queue.push( Collapse{ a_to_b, a, b, stamps[a], stamps[b] } );
+    } else {
+      queue.push( Collapse{ b_to_a, b, a, stamps[b], stamps[a] } );
+    }
+  };
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (i == 0 || edges[i - 1].first != edges[i].first) {
+      push_edge( static_cast<std::uint32_t>(edges[i].first >> 32), static_cast<std::uint32_t>(edges[i].first) );
+    }
+  }
+
+  auto remove_dead = [&](std::uint32_t p) {
+    std::erase_if(triangles_at[p], [&](std::uint32_t t) { return ! alive[t]; });
+  };
+  auto neighbors = [&](std::uint32_t p) {
+    std::vector<std::uint32_t> result;
+    for (std::uint32_t t : triangles_at[p]) {
+      for (size_t c = 0; c < 3; c++) {
+        if (position(t, c) != p) {
+          result.push_back( position(t, c) );
+        }
+      }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase( std::unique(result.begin(), result.end()), result.end() );
+    return result;
+  };
+  // the positions adjacent to both ends of the edge are the third corners of the triangles of the edge (link condition),
+  // and the other triangles of the moved position keep their orientation
+  auto can_collapse = [&](std::uint32_t from, std::uint32_t to) {
+    std::vector<std::uint32_t> from_neighbors = neighbors(from), to_neighbors = neighbors(to), common;
+    std::set_intersection(from_neighbors.begin(), from_neighbors.end(), to_neighbors.begin(), to_neighbors.end(), std::back_inserter(common));
+    size_t shared = std::count_if(triangles_at[from].begin(), triangles_at[from].end(), [&](std::uint32_t t) { return contains(t, to); });
+    if (common.size() != shared) {
+      return false;
+    }
+    for (std::uint32_t t : triangles_at[from]) {
+      if ( ! contains(t, to) && ! (dot(normal(t, from, to), normal(t, from, from)) > 0.0) ) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  std::vector<SimplifiedMesh> meshes;
+  double max_error = 0.0;
+  auto store_mesh = [&]() {
+    SimplifiedMesh mesh;
+    mesh.error = static_cast<float>( std::sqrt(max_error) );
+    for (std::uint32_t t = 0; t < no_of_triangles; t++) {
+      if (alive[t]) {
+        mesh.indices.insert(mesh.indices.end(), corners.begin() + 3 * t, corners.begin() + 3 * t + 3);
+        mesh.triangles.push_back(t);
+      }
+    }
+    meshes.push_back( std::move(mesh) );
+  };
+
+  std::vector<std::uint32_t> replacement(no_of_vertices);
+  while (meshes.size() < targets.size()) {
+    if (no_of_alive <= targets[meshes.size()] || queue.empty()) {
+      store_mesh();
+      continue;
+    }
+    Collapse collapse = queue.top();
+    queue.pop();
+    std::uint32_t from = collapse.from, to = collapse.to;
+    if (stamps[from] != collapse.from_stamp || stamps[to] != collapse.to_stamp || triangles_at[from].empty()) {
+      continue;
+    }
+    remove_dead(from);
+    remove_dead(to);
+    if ( ! can_collapse(from, to) ) {
+      continue;
+    }
+
+    max_error = std::max(max_error, collapse.error);
+    for (std::uint32_t v : vertices_at[from]) {
+      float best_distance = std::numeric_limits<float>::max();
+      for (std::uint32_t w : vertices_at[to]) {
+        float distance = 0.0f;
+        for (size_t i = 3; i < floats_per_vertex; i++) {
+          float difference = vertices[v * floats_per_vertex + i] - vertices[w * floats_per_vertex + i];
+          distance += difference * difference;
+        }
+        if (distance < best_distance) {
+          best_distance = distance;
+          replacement[v] = w;
+        }
+      }
+    }
+    for (std::uint32_t t : triangles_at[from]) {
+      if ( contains(t, to) ) {
+        alive[t] = false;
+        no_of_alive--;
+        continue;
+      }
+      for (size_t c = 0; c < 3; c++) {
+        if (position(t, c) == from) {
+          corners[3 * t + c] = replacement[ corners[3 * t + c] ];
+        }
+      }
+      triangles_at[to].push_back(t);
+    }
+    triangles_at[from].clear();
+    quadrics[to].add(quadrics[from]);
+    stamps[from]++;
+    stamps[to]++;
+    remove_dead(to);
+    for (std::uint32_t p : neighbors(to)) {
+      push_edge(to, p);
+    }
+  }
+  return meshes;
+}
+
+// the simplification works on the positions and normals of the compact vertices, all levels of detail share the vertices,
+// so the materials of a triangle and the seams of normals are the ones of the full mesh
+void create_lods(CompactMesh & mesh, size_t no_of_lods, size_t cache_size) {
+  if (mesh.lods.empty()) {
+    return;
+  }
+  const MeshLod full = mesh.lods[0];
+  if (full.no_of_draw_ranges == 0) {
+    return;
+  }
+  std::uint32_t first_index = mesh.draw_ranges[full.first_draw_range].first_index;
+  std::vector<std::uint32_t> range_of_triangle;
+  for (std::uint32_t r = 0; r < full.no_of_draw_ranges; r++) {
+    range_of_triangle.insert(range_of_triangle.end(), mesh.draw_ranges[full.first_draw_range + r].no_of_indices / 3, r);
+  }
+  std::vector<size_t> targets;
+  for (size_t lod = 1; lod < no_of_lods && (range_of_triangle.size() >> lod) >= MIN_TRIANGLES_PER_LOD; lod++) {
+    targets.push_back( range_of_triangle.size() >> lod );
+  }
+  if (targets.empty()) {
+    return;
+  }
+
+  std::vector<float> vertices(6 * mesh.vertices.size());
+  for (size_t v = 0; v < mesh.vertices.size(); v++) {
+    for (size_t i = 0; i < 3; i++) {
+      float center = 0.5f * (mesh.bounds_min[i] + mesh.bounds_max[i]);
+      float half_extent = 0.5f * (mesh.bounds_max[i] - mesh.bounds_min[i]);
+      vertices[6 * v + i] = center + half_extent * std::max(mesh.vertices[v].position[i] / 32767.0f, -1.0f);
+      vertices[6 * v + 3 + i] = unpack_normal_component(mesh.vertices[v].normal, i);
+    }
+  }
+  std::vector<std::uint32_t> full_indices(mesh.indices.begin() + first_index, mesh.indices.begin() + first_index + 3 * range_of_triangle.size());
+  std::vector<SimplifiedMesh> simplified = simplify_mesh(vertices, 6, full_indices, targets);
+
+  size_t previous_no_of_triangles = range_of_triangle.size();
+  for (const SimplifiedMesh & lod : simplified) {
+    if (lod.triangles.size() >= previous_no_of_triangles) {
+      break;
+    }
+    previous_no_of_triangles = lod.triangles.size();
+    mesh.lods.push_back( MeshLod{ lod.error, static_cast<std::uint32_t>( mesh.draw_ranges.size() ), full.no_of_draw_ranges } );
+    // the triangles are in the order of the full mesh, so they are sorted by draw range
+    for (std::uint32_t r = 0; r < full.no_of_draw_ranges; r++) {
+      const DrawRange range = mesh.draw_ranges[full.first_draw_range + r];  // a copy, the draw ranges grow
+      mesh.draw_ranges.push_back( DrawRange{ {range.color[0], range.color[1], range.color[2]},
+                                             static_cast<std::uint32_t>( mesh.indices.size() ), 0u } );
+      for (size_t t = 0; t < lod.triangles.size(); t++) {
+        if (range_of_triangle[ lod.triangles[t] ] == r) {
+          mesh.indices.insert(mesh.indices.end(), lod.indices.begin() + 3 * t, lod.indices.begin() + 3 * t + 3);
+          mesh.draw_ranges.back().no_of_indices += 3;
+        }
+      }
+      optimize_vertex_cache(std::span<std::uint32_t>(mesh.indices).subspan(mesh.draw_ranges.back().first_index, mesh.draw_ranges.back().no_of_indices),
+                            mesh.vertices.size(), cache_size);
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mesh_optimizer.h"
+
+// levels of detail of the import stage: edges are collapsed in the order of their quadric error
+// (Garland, Heckbert: Surface Simplification Using Quadric Error Metrics, 1997), small or far away objects
+// are drawn with fewer triangles, so the number of triangles per frame does not grow with the number of objects
+
+// the number of levels of detail including the full mesh, each level has half the triangles of the previous one
+constexpr size_t DEFAULT_NO_OF_LODS = 4;
+
+// no levels of detail with fewer triangles are created
+constexpr size_t MIN_TRIANGLES_PER_LOD = 16;
+
+// the triangles left of a mesh, their corners are vertices of the full mesh
+struct SimplifiedMesh {
+  std::vector<std::uint32_t> indices;
+  std::vector<std::uint32_t> triangles;  // the triangle of the full mesh each triangle was, in increasing order
+  float error = 0.0f;  // the largest distance to the full mesh estimated by the quadrics of the collapses
+};
+
+// collapses edges until at most the target number of triangles is left and returns one mesh per target,
+// the targets must be decreasing, a mesh has more triangles if no further edge can be collapsed
+// the first three floats of a vertex are its position, the others are attributes: vertices with the same position
+// are one vertex of the surface, and a vertex moved by a collapse is replaced by the vertex with the most similar
+// attributes at the new position, so seams of normals and materials are kept
+// collapses, which change the topology of the surface or flip triangles, are not made
+std::vector<SimplifiedMesh> simplify_mesh(std::span<const float> vertices, size_t floats_per_vertex,
+                                          std::span<const std::uint32_t> indices, std::span<const size_t> targets);
+
+// appends up to no_of_lods - 1 levels of detail of the first level of detail (the full mesh) to a compact mesh,
+// a level is only created if it has at least MIN_TRIANGLES_PER_LOD triangles and fewer than the previous level
+void create_lods(CompactMesh & mesh, size_t no_of_lods = DEFAULT_NO_OF_LODS, size_t cache_size = DEFAULT_VERTEX_CACHE_SIZE);
+
+#endif
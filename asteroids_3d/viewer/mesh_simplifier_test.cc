@@ -0,0 +1,167 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// a unit sphere of stacks x slices quads, the vertices are positions and normals, the poles are single vertices
+struct Sphere {
+  std::vector<float> vertices;
+  std::vector<std::uint32_t> indices;
+};
+
+Sphere create_sphere(std::uint32_t stacks, std::uint32_t slices) {
+  Sphere sphere;
+  auto add_vertex = [&sphere](float theta, float phi) {
+    float point[3] = { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) };
+    for (size_t i = 0; i < 6; i++) {
+      sphere.vertices.push_back(point[i % 3]);  // the position and the normal
+    }
+  };
+  add_vertex(0.0f, 0.0f);
+  for (std::uint32_t stack = 1; stack < stacks; stack++) {
+    for (std::uint32_t slice = 0; slice < slices; slice++) {
+      add_vertex(std::numbers::pi_v<float> * stack / stacks, 2.0f * std::numbers::pi_v<float> * slice / slices);
+    }
+  }
+  add_vertex(std::numbers::pi_v<float>, 0.0f);
+  std::uint32_t south = 1 + (stacks - 1) * slices;
+  auto ring = [slices](std::uint32_t stack, std::uint32_t slice) { return 1 + (stack - 1) * slices + slice % slices; };
+  for (std::uint32_t slice = 0; slice < slices; slice++) {
+    sphere.indices.insert(sphere.indices.end(), { 0u, ring(1, slice), ring(1, slice + 1) });
+    for (std::uint32_t stack = 1; stack + 1 < stacks; stack++) {
+      std::uint32_t a = ring(stack, slice), b = ring(stack, slice + 1), c = ring(stack + 1, slice), d = ring(stack + 1, slice + 1);
+      sphere.indices.insert(sphere.indices.end(), { a, c, d,  a, d, b });
+    }
+    sphere.indices.insert(sphere.indices.end(), { ring(stacks - 1, slice), south, ring(stacks - 1, slice + 1) });
+  }
+  return sphere;
+}
+
+// the flat vertex buffer of the WavefrontVertexBufferImporter, the northern and southern hemisphere have different colors
+std::vector<float> create_vertex_buffer(const Sphere & sphere) {
+  std::vector<float> buffer;
+  for (size_t i = 0; i < sphere.indices.size(); i++) {
+    const float * vertex = sphere.vertices.data() + 6 * sphere.indices[i];
+    float z = 0.0f;
+    for (size_t c = 0; c < 3; c++) {
+      z += sphere.vertices[6 * sphere.indices[i - i % 3 + c] + 2];
+    }
+    float color[3] = { z > 0.0f ? 1.0f : 0.0f, 0.0f, z > 0.0f ? 0.0f : 1.0f };
+    buffer.insert(buffer.end(), vertex, vertex + 6);
+    buffer.insert(buffer.end(), color, color + 3);
+  }
+  return buffer;
+}
+
+std::array<float, 3> get_normal(const std::vector<float> & vertices, size_t floats_per_vertex, const std::uint32_t * triangle) {
+  const float * a = vertices.data() + floats_per_vertex * triangle[0];
+  const float * b = vertices.data() + floats_per_vertex * triangle[1];
+  const float * c = vertices.data() + floats_per_vertex * triangle[2];
+  float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  return { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+}
+
+TEST(MESH_SIMPLIFIER, SimplifiesASphere) {
+  Sphere sphere = create_sphere(32, 64);
+  size_t no_of_triangles = sphere.indices.size() / 3;
+  const std::vector<size_t> targets = { no_of_triangles / 2, no_of_triangles / 4, no_of_triangles / 8 };
+  std::vector<SimplifiedMesh> meshes = simplify_mesh(sphere.vertices, 6, sphere.indices, targets);
+
+  ASSERT_EQ(3u, meshes.size());
+  float previous_error = 0.0f;
+  for (size_t i = 0; i < meshes.size(); i++) {
+    const SimplifiedMesh & mesh = meshes[i];
+    EXPECT_GE(targets[i], mesh.triangles.size());
+    EXPECT_LE(targets[i] - 2, mesh.triangles.size());  // a collapse removes two triangles
+    ASSERT_EQ(3 * mesh.triangles.size(), mesh.indices.size());
+    EXPECT_TRUE(std::is_sorted(mesh.triangles.begin(), mesh.triangles.end()));
+    EXPECT_LE(previous_error, mesh.error);
+    EXPECT_GT(0.05f, mesh.error);
+    previous_error = mesh.error;
+    // the triangles face outwards
+    for (size_t t = 0; t < mesh.triangles.size(); t++) {
+      std::array<float, 3> normal = get_normal(sphere.vertices, 6, mesh.indices.data() + 3 * t);
+      const float * corner = sphere.vertices.data() + 6 * mesh.indices[3 * t];
+      EXPECT_LT(0.0f, normal[0] * corner[0] + normal[1] * corner[1] + normal[2] * corner[2]) << i << " " << t;
+    }
+  }
+  EXPECT_LT(0.0f, meshes.back().error);
+}
+
+// the triangles of a flat square with a boundary stay flat, keep their orientation and cover the square
+TEST(MESH_SIMPLIFIER, KeepsTheBoundary) {
+  constexpr std::uint32_t SIZE = 17;
+  std::vector<float> vertices;
+  std::vector<std::uint32_t> indices;
+  for (std::uint32_t y = 0; y < SIZE; y++) {
+    for (std::uint32_t x = 0; x < SIZE; x++) {
+      vertices.insert(vertices.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+      if (x + 1 < SIZE && y + 1 < SIZE) {
+        std::uint32_t a = y * SIZE + x, b = a + 1, c = a + SIZE, d = c + 1;
+        indices.insert(indices.end(), { a, b, d,  a, d, c });
+      }
+    }
+  }
+  const std::vector<size_t> targets = { 32 };
+  std::vector<SimplifiedMesh> meshes = simplify_mesh(vertices, 3, indices, targets);
+
+  ASSERT_EQ(1u, meshes.size());
+  EXPECT_GE(32u, meshes[0].triangles.size());
+  EXPECT_NEAR(0.0f, meshes[0].error, 1e-3f);
+  float area = 0.0f;
+  for (size_t t = 0; t < meshes[0].triangles.size(); t++) {
+    std::array<float, 3> normal = get_normal(vertices, 3, meshes[0].indices.data() + 3 * t);
+    EXPECT_LT(0.0f, normal[2]);
+    area += 0.5f * normal[2];
+  }
+  EXPECT_NEAR(static_cast<float>((SIZE - 1) * (SIZE - 1)), area, 1e-3f);
+}
+
+TEST(MESH_SIMPLIFIER, LevelsOfDetailOfACompactMesh) {
+  CompactMesh mesh = create_compact_mesh( create_vertex_buffer( create_sphere(32, 64) ) );
+  size_t no_of_vertices = mesh.vertices.size();
+  ASSERT_EQ(2u, mesh.draw_ranges.size());
+  create_lods(mesh);
+
+  ASSERT_EQ(DEFAULT_NO_OF_LODS, mesh.lods.size());
+  EXPECT_EQ(no_of_vertices, mesh.vertices.size());
+  size_t previous_no_of_indices = 0;
+  for (size_t lod = 0; lod < mesh.lods.size(); lod++) {
+    ASSERT_EQ(2u, mesh.lods[lod].no_of_draw_ranges);
+    ASSERT_EQ(2 * lod, mesh.lods[lod].first_draw_range);
+    size_t no_of_indices = 0;
+    for (size_t r = 0; r < 2; r++) {
+      const DrawRange & range = mesh.draw_ranges[mesh.lods[lod].first_draw_range + r];
+      EXPECT_EQ(mesh.draw_ranges[r].color[0], range.color[0]);
+      EXPECT_EQ(mesh.draw_ranges[r].color[2], range.color[2]);
+      EXPECT_EQ(r == 0 ? previous_no_of_indices : mesh.draw_ranges[mesh.lods[lod].first_draw_range].first_index + no_of_indices,
+                range.first_index);
+      no_of_indices += range.no_of_indices;
+    }
+    if (lod > 0) {
+      EXPECT_NEAR(static_cast<double>(mesh.draw_ranges[0].no_of_indices + mesh.draw_ranges[1].no_of_indices) / (1 << lod),
+                  static_cast<double>(no_of_indices), 6.0);
+      EXPECT_LT(mesh.lods[lod - 1].error, mesh.lods[lod].error);
+    }
+    previous_no_of_indices += no_of_indices;
+  }
+  EXPECT_EQ(previous_no_of_indices, mesh.indices.size());
+  EXPECT_TRUE(std::all_of(mesh.indices.begin(), mesh.indices.end(), [&](std::uint32_t i) { return i < no_of_vertices; }));
+}
+
+TEST(MESH_SIMPLIFIER, NoLevelsOfDetailOfSmallMeshes) {
+  WavefrontVertexBufferImporter importer;
+  importer.parse_file("cube.obj");
+  CompactMesh mesh = create_compact_mesh(importer.get_vertex_buffer());
+  create_lods(mesh);
+  ASSERT_EQ(1u, mesh.lods.size());
+  EXPECT_EQ(0.0f, mesh.lods[0].error);
+  EXPECT_EQ(mesh.draw_ranges.size(), mesh.lods[0].no_of_draw_ranges);
+}
+
+}
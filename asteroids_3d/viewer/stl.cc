@@ -0,0 +1,257 @@
+#include "stl.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 80;
+constexpr size_t RECORD_SIZE = 50;  // a normal, three corners and an attribute byte count
+
+// the floats and counts of binary files are little endian
+float read_float(const char * bytes) {
+  std::uint32_t bits;
+  std::memcpy(&bits, bytes, sizeof(bits));
+  if constexpr (std::endian::native == std::endian::big) {
+    bits = (bits >> 24) | ((bits >> 8) & 0xff00u) | ((bits << 8) & 0xff0000u) | (bits << 24);
+  }
+  return std::bit_cast<float>(bits);
+}
+
+std::uint32_t read_count(const char * bytes) {
+  const unsigned char * b = reinterpret_cast<const unsigned char *>(bytes);
+  return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<std::uint32_t>(b[3]) << 24);
+}
+
+// true if the rest of a seekable stream holds exactly the given number of triangle records
+bool has_binary_size(std::istream & in, std::uint32_t no_of_triangles) {
+  std::istream::pos_type position = in.tellg();
+  if (position == std::istream::pos_type(-1)) {
+    in.clear();
+    return false;
+  }
+  in.seekg(0, std::ios::end);
+  std::istream::pos_type end = in.tellg();
+  in.seekg(position);
+  return end != std::istream::pos_type(-1) &&
+         static_cast<std::uint64_t>(end - position) == static_cast<std::uint64_t>(no_of_triangles) * RECORD_SIZE;
+}
+
+bool is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char * skip_blanks(const char * position, const char * end) {
+  while (position < end && is_blank(*position)) {
+    position++;
+  }
+  return position;
+}
+
+std::string_view parse_word(const char * & position, const char * end) {
+  position = skip_blanks(position, end);
+  const char * start = position;
+  while (position < end && ! is_blank(*position)) {
+    position++;
+  }
+  return std::string_view(start, position - start);
+}
+
+} // namespace
+
+size_t StlImporter::VerticeHash::operator()(const Vertice & vertice) const {
+  size_t hash = 0;
+  for (float f : vertice) {
+    hash = (hash ^ std::bit_cast<std::uint32_t>(f)) * 0x9e3779b97f4a7c15ull;
+  }
+  return hash ^ (hash >> 29);
+}
+
+// returns the index of the vertice, that equals the given one, adding it if it is new
+std::uint32_t StlImporter::weld(Vertice vertice) {
+  for (float & f : vertice) {
+    f += 0.0f;  // -0.0 equals 0.0, so it needs the same hash
+  }
+  auto [found, inserted] = welded.try_emplace(vertice, static_cast<std::uint32_t>(vertices.size()));
+  if (inserted) {
+    vertices.push_back(vertice);
+  }
+  return found->second;
+}
+
+void StlImporter::add_polygon() {
+  if (polygon.size() < 3) {
+    throw std::invalid_argument("a loop needs three vertices in line " + std::to_string(input_line));
+  }
+  std::uint32_t first = weld(polygon[0]);
+  std::uint32_t previous = weld(polygon[1]);
+  for (size_t i = 2; i < polygon.size(); i++) {
+    std::uint32_t next = weld(polygon[i]);
+    indices.insert(indices.end(), { first, previous, next });
+    previous = next;
+  }
+  polygon.clear();
+}
+
+void StlImporter::parse_binary(std::istream & in, std::uint32_t no_of_triangles) {
+  indices.reserve(indices.size() + 3 * static_cast<size_t>(no_of_triangles));
+  // a closed surface has about half as many vertices as triangles
+  vertices.reserve(vertices.size() + no_of_triangles / 2);
+  welded.reserve(welded.size() + no_of_triangles / 2);
+
+  std::vector<char> chunk(CHUNK_SIZE - CHUNK_SIZE % RECORD_SIZE);
+  size_t left = no_of_triangles;
+  while (left > 0) {
+    size_t count = std::min(left, chunk.size() / RECORD_SIZE);
+    in.read(chunk.data(), static_cast<std::streamsize>(count * RECORD_SIZE));
+    if (static_cast<size_t>(in.gcount()) != count * RECORD_SIZE) {
+      throw std::invalid_argument("truncated binary stl file, " + std::to_string(left) + " triangles missing");
+    }
+    for (const char * record = chunk.data(); record < chunk.data() + count * RECORD_SIZE; record += RECORD_SIZE) {
+      for (size_t corner = 0; corner < 3; corner++) {
+        const char * position = record + 12 * (corner + 1);  // after the normal
+        indices.push_back( weld({ read_float(position), read_float(position + 4), read_float(position + 8) }) );
+      }
+    }
+    left -= count;
+  }
+}
+
+// text holds the start of the file already read
+void StlImporter::parse_ascii(std::istream & in, std::string text) {
+  std::vector<char> chunk(CHUNK_SIZE);
+  size_t offset = 0;  // of the first line not parsed yet
+  bool end_of_file = false;
+  while ( ! end_of_file ) {
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    end_of_file = static_cast<size_t>(in.gcount()) < chunk.size();
+    text.erase(0, offset);
+    text.append(chunk.data(), static_cast<size_t>(in.gcount()));
+    offset = 0;
+    // the last line of a chunk may continue in the next one
+    size_t last = end_of_file ? text.size() : text.rfind('\n');
+    while (last != std::string::npos && offset < last) {
+      size_t line_end = std::min(text.find('\n', offset), last);
+      input_line++;
+      parse_line(text.data() + offset, text.data() + line_end);
+      offset = line_end + 1;
+    }
+  }
+  if ( ! polygon.empty() ) {
+    throw std::invalid_argument("endloop missing at the end of the file");
+  }
+}
+
+void StlImporter::parse_line(const char * position, const char * end) {
+  std::string_view keyword = parse_word(position, end);
+  if (keyword == "vertex") {
+    Vertice vertice;
+    for (float & f : vertice) {
+      position = skip_blanks(position, end);
+      if (position < end && *position == '+') {
+        position++;  // not accepted by from_chars
+      }
+      std::from_chars_result result = std::from_chars(position, end, f);
+      if (result.ec != std::errc() || (result.ptr < end && ! is_blank(*result.ptr))) {
+        throw std::invalid_argument("float expected in line " + std::to_string(input_line));
+      }
+      position = result.ptr;
+    }
+    polygon.push_back(vertice);
+  } else if (keyword == "endloop") {
+    add_polygon();
+  } else if ( ! keyword.empty() && keyword != "solid" && keyword != "endsolid" && keyword != "facet" &&
+              keyword != "outer" && keyword != "endfacet" ) {
+    throw std::invalid_argument("unknown keyword " + std::string(keyword) + " in line " + std::to_string(input_line));
+  }
+}
+
+void StlImporter::create_vertex_buffer() {
+  normals.assign(vertices.size(), {0.0f, 0.0f, 0.0f});
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const Vertice & a = vertices[indices[i]], & b = vertices[indices[i + 1]], & c = vertices[indices[i + 2]];
+    float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    // the length of the cross product is twice the area of the triangle
+    Normal normal = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    for (size_t corner = 0; corner < 3; corner++) {
+      Normal & sum = normals[indices[i + corner]];
+      for (size_t k = 0; k < 3; k++) {
+        sum[k] += normal[k];
+      }
+    }
+  }
+  for (Normal & normal : normals) {
+    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (length > 0.0f) {
+      normal = { normal[0] / length, normal[1] / length, normal[2] / length };
+    } else {
+      normal = { 1.0f, 1.0f, 1.0f };  // of degenerated triangles only, like the missing normals of wavefront files
+    }
+  }
+
+  vertex_buffer.resize(9 * indices.size());
+  float * destination = vertex_buffer.data();
+  for (std::uint32_t index : indices) {
+    destination = std::copy(vertices[index].begin(), vertices[index].end(), destination);
+    destination = std::copy(normals[index].begin(), normals[index].end(), destination);
+    destination = std::copy(color.begin(), color.end(), destination);
+  }
+}
+
+void StlImporter::parse(std::istream & in) {
+  char header[HEADER_SIZE + 4];
+  in.read(header, sizeof(header));
+  size_t size = static_cast<size_t>(in.gcount());
+  bool text = size >= 5 && std::string_view(header, 5) == "solid";
+  if (size == sizeof(header)) {
+    std::uint32_t no_of_triangles = read_count(header + HEADER_SIZE);
+    if ( ! text || has_binary_size(in, no_of_triangles) ) {
+      parse_binary(in, no_of_triangles);
+      create_vertex_buffer();
+      return;
+    }
+  }
+  if ( ! text ) {
+    throw std::invalid_argument("no stl file, the header is truncated");
+  }
+  in.clear(in.rdstate() & ~(std::ios::failbit | std::ios::eofbit));
+  parse_ascii(in, std::string(header, size));
+  create_vertex_buffer();
+}
+
+void StlImporter::parse_file(const std::string & file_path) {
+  std::ifstream in(file_path, std::ios::binary);
+  if ( ! in ) {
+    throw std::runtime_error("could not open " + file_path);
+  }
+  parse(in);
+}
+
+std::vector< Vertice > & StlImporter::get_vertices() {
+  return vertices;
+}
+
+std::vector< Normal > & StlImporter::get_normals() {
+  return normals;
+}
+
+std::vector<std::uint32_t> & StlImporter::get_indices() {
+  return indices;
+}
+
+std::vector<float> & StlImporter::get_vertex_buffer() {
+  return vertex_buffer;
+}
+
+void StlImporter::set_color(const Color & color) {
+  this->color = color;
+}
+
+const Color & StlImporter::get_color() const {
+  return color;
+}
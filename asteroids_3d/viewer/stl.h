@@ -0,0 +1,64 @@
+#ifndef STL_H
+#define STL_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wavefront.h"
+
+// an importer for stereolithography files (binary and ASCII), as exported by CAD programs and blender,
+// that creates the vertex buffer of the renderers like the WavefrontVertexBufferImporter:
+// 9 floats per corner of a triangle, the vertice, the normal and the color
+// the files have no materials, all triangles get the color of set_color (white by default)
+// the stream is read in chunks, equal vertices are welded while reading with a hash map, and each welded
+// vertice gets a smooth normal, the area weighted mean of the normals of its triangles
+// the normals of the file are ignored, they are often missing or wrong
+class StlImporter {
+public:
+  // the triangle records of 50 bytes (or the text) read from the stream at once
+  static constexpr size_t CHUNK_SIZE = 8192 * 50;
+private:
+  struct VerticeHash {
+    size_t operator()(const Vertice & vertice) const;
+  };
+
+  std::vector< Vertice > vertices;
+  std::vector< Normal > normals;
+  std::vector<std::uint32_t> indices;
+  std::vector<float> vertex_buffer;
+  std::unordered_map<Vertice, std::uint32_t, VerticeHash> welded;
+  std::vector<Vertice> polygon;  // the corners of the current loop of an ASCII file
+  Color color = {1.0f, 1.0f, 1.0f};
+  size_t input_line = 0;
+
+  std::uint32_t weld(Vertice vertice);
+  void add_polygon();
+  void parse_binary(std::istream & in, std::uint32_t no_of_triangles);
+  void parse_ascii(std::istream & in, std::string text);
+  void parse_line(const char * position, const char * end);
+  void create_vertex_buffer();
+public:
+  // parses a binary or ASCII file and appends its triangles, a file starting with "solid" is an ASCII file unless
+  // the stream is seekable and its size is the one of a binary file with the number of triangles of its header
+  // polygons of an ASCII file are split into a fan of triangles
+  // throws std::invalid_argument if the file is truncated or malformed
+  void parse(std::istream & in);
+
+  // throws std::runtime_error if the file cannot be opened
+  void parse_file(const std::string & file_path);
+
+  // the welded vertices and their normals, the triangles are three indices into them each
+  std::vector< Vertice > & get_vertices();
+  std::vector< Normal > & get_normals();
+  std::vector<std::uint32_t> & get_indices();
+  std::vector<float> & get_vertex_buffer();
+
+  // the color of all triangles, has to be set before parsing
+  void set_color(const Color & color);
+  const Color & get_color() const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "stl.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// measures the triangles per second of the StlImporter on the stl files given as arguments,
+// by default the models shipped in the blender directory,
+// the best of a few runs is reported, so the first touch of the file and the memory is not measured
+
+namespace {
+
+constexpr int NO_OF_RUNS = 5;
+
+}
+
+int main(int argc, char * argv[]) {
+  std::vector<std::string> file_paths(argv + 1, argv + argc);
+  if (file_paths.empty()) {
+    for (const char * name : { "Rocket.stl", "saucer.stl", "ida_m.stl" }) {
+      file_paths.push_back( (std::filesystem::path(BLENDER_DIRECTORY) / name).string() );
+    }
+  }
+
+  std::cout << std::setw(12) << "file" << std::setw(12) << "triangles" << std::setw(12) << "vertices"
+            << std::setw(12) << "ms" << std::setw(16) << "triangles/s" << std::endl;
+  for (const std::string & file_path : file_paths) {
+    size_t no_of_triangles = 0, no_of_vertices = 0;
+    std::chrono::duration<double> time = std::chrono::duration<double>::max();
+    try {
+      for (int run = 0; run < NO_OF_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        StlImporter importer;
+        importer.parse_file(file_path);
+        time = std::min(time, std::chrono::duration<double>(std::chrono::steady_clock::now() - start));
+        no_of_triangles = importer.get_indices().size() / 3;
+        no_of_vertices = importer.get_vertices().size();
+      }
+    } catch (const std::exception & e) {
+      std::cout << file_path << ": " << e.what() << std::endl;
+      return 1;
+    }
+    std::cout << std::setw(12) << std::filesystem::path(file_path).filename().string() << std::setw(12) << no_of_triangles
+              << std::setw(12) << no_of_vertices << std::setw(12) << std::fixed << std::setprecision(2) << time.count() * 1e3
+              << std::setw(16) << std::setprecision(0) << no_of_triangles / time.count() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,184 @@
+#include "stl.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+typedef std::array<Vertice, 3> Triangle;
+
+// a unit cube around the origin, the triangles are counter clock wise seen from outside
+std::vector<Triangle> create_cube() {
+  auto corner = [](int i) { return Vertice{ i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f }; };
+  const int faces[6][4] = { {0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5} };
+  std::vector<Triangle> triangles;
+  for (const int * face : faces) {
+    triangles.push_back({ corner(face[0]), corner(face[1]), corner(face[2]) });
+    triangles.push_back({ corner(face[0]), corner(face[2]), corner(face[3]) });
+  }
+  return triangles;
+}
+
+std::string write_binary(const std::vector<Triangle> & triangles, const std::string & header = "binary test cube") {
+  std::string file(80, '\0');
+  file.replace(0, header.size(), header);
+  std::uint32_t count = static_cast<std::uint32_t>(triangles.size());
+  file.append(reinterpret_cast<const char *>(&count), 4);  // the tests run on little endian machines
+  for (const Triangle & triangle : triangles) {
+    const float normal[3] = { 0.0f, 0.0f, 0.0f };
+    file.append(reinterpret_cast<const char *>(normal), sizeof(normal));
+    for (const Vertice & vertice : triangle) {
+      file.append(reinterpret_cast<const char *>(vertice.data()), 3 * sizeof(float));
+    }
+    file.append(2, '\0');
+  }
+  return file;
+}
+
+std::string write_ascii(const std::vector<Triangle> & triangles) {
+  std::ostringstream out;
+  out << "solid cube\r\n";
+  for (const Triangle & triangle : triangles) {
+    out << "  facet normal 0 0 0\r\n    outer loop\r\n";
+    for (const Vertice & vertice : triangle) {
+      out << "      vertex " << vertice[0] << ' ' << vertice[1] << " +" << vertice[2] << "\r\n";
+    }
+    out << "    endloop\r\n  endfacet\r\n";
+  }
+  out << "endsolid cube\r\n";
+  return out.str();
+}
+
+StlImporter parse(const std::string & file) {
+  std::stringstream ss(file);
+  StlImporter importer;
+  importer.parse(ss);
+  return importer;
+}
+
+TEST(STL_IMPORTER, BinaryCube) {
+  StlImporter importer = parse( write_binary( create_cube() ) );
+
+  ASSERT_EQ(8u, importer.get_vertices().size());
+  ASSERT_EQ(8u, importer.get_normals().size());
+  ASSERT_EQ(36u, importer.get_indices().size());
+  const std::vector<float> & buffer = importer.get_vertex_buffer();
+  ASSERT_EQ(36u * 9u, buffer.size());
+  std::vector<Triangle> cube = create_cube();
+  for (size_t i = 0; i < 36; i++) {
+    const Vertice & vertice = cube[i / 3][i % 3];
+    EXPECT_EQ(vertice, importer.get_vertices()[ importer.get_indices()[i] ]) << i;
+    float length = 0.0f, outwards = 0.0f;
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(vertice[k], buffer[9 * i + k]) << i;
+      length += buffer[9 * i + 3 + k] * buffer[9 * i + 3 + k];
+      outwards += buffer[9 * i + 3 + k] * vertice[k];
+      EXPECT_EQ(1.0f, buffer[9 * i + 6 + k]) << i;  // white
+    }
+    EXPECT_NEAR(1.0f, length, 1e-5f) << i;
+    EXPECT_LT(0.7f, 2.0f * outwards) << i;  // smooth normals point away from the center
+  }
+}
+
+TEST(STL_IMPORTER, AsciiMatchesBinary) {
+  StlImporter binary = parse( write_binary( create_cube() ) );
+  StlImporter ascii = parse( write_ascii( create_cube() ) );
+
+  EXPECT_EQ(binary.get_vertices(), ascii.get_vertices());
+  EXPECT_EQ(binary.get_indices(), ascii.get_indices());
+  EXPECT_EQ(binary.get_vertex_buffer(), ascii.get_vertex_buffer());
+}
+
+// CAD programs write "solid" into the header of binary files too
+TEST(STL_IMPORTER, BinaryFileWithSolidHeader) {
+  StlImporter importer = parse( write_binary(create_cube(), "solid cube exported as binary") );
+  EXPECT_EQ(8u, importer.get_vertices().size());
+  EXPECT_EQ(36u, importer.get_indices().size());
+}
+
+TEST(STL_IMPORTER, PolygonsWeldingAndColor) {
+  StlImporter importer;
+  importer.set_color({1.0f, 0.0f, 0.0f});
+  std::stringstream ss("solid square\n"
+                       "facet normal 0 0 1\n"
+                       "outer loop\n"
+                       "vertex 0 0 0\n"
+                       "vertex 1 0 0\n"
+                       "vertex 1 1 0\n"
+                       "vertex 0 1 0\n"
+                       "endloop\n"
+                       "endfacet\n"
+                       "facet normal 0 0 1\n"
+                       "outer loop\n"
+                       "vertex -0.0 1e0 0\n"
+                       "vertex 1 1 0\n"
+                       "vertex 0.5 2 0\n"
+                       "endloop\n"
+                       "endfacet\n"
+                       "endsolid square");
+  importer.parse(ss);
+
+  ASSERT_EQ(5u, importer.get_vertices().size());
+  const std::vector<std::uint32_t> expected = { 0, 1, 2,  0, 2, 3,  3, 2, 4 };
+  EXPECT_EQ(expected, importer.get_indices());
+  const std::vector<float> & buffer = importer.get_vertex_buffer();
+  ASSERT_EQ(9u * 9u, buffer.size());
+  for (size_t i = 0; i < 9; i++) {
+    EXPECT_EQ(0.0f, buffer[9 * i + 3]) << i;
+    EXPECT_EQ(1.0f, buffer[9 * i + 5]) << i;
+    EXPECT_EQ(1.0f, buffer[9 * i + 6]) << i;
+    EXPECT_EQ(0.0f, buffer[9 * i + 7]) << i;
+  }
+}
+
+// the file is read in chunks, lines and records continue in the next chunk
+TEST(STL_IMPORTER, LargerThanAChunk) {
+  std::vector<Triangle> triangles;
+  for (size_t i = 0; i < 2 * StlImporter::CHUNK_SIZE / 50 + 7; i++) {
+    float x = static_cast<float>(i);
+    triangles.push_back({ Vertice{x, 0.0f, 0.0f}, Vertice{x + 1.0f, 0.0f, 0.0f}, Vertice{x, 1.0f, 0.0f} });
+  }
+  StlImporter binary = parse( write_binary(triangles) );
+  StlImporter ascii = parse( write_ascii(triangles) );
+
+  EXPECT_EQ(2 * triangles.size() + 1, binary.get_vertices().size());
+  EXPECT_EQ(3 * triangles.size(), binary.get_indices().size());
+  EXPECT_EQ(binary.get_indices(), ascii.get_indices());
+  EXPECT_EQ(binary.get_vertex_buffer(), ascii.get_vertex_buffer());
+}
+
+TEST(STL_IMPORTER, MalformedInput) {
+  std::string truncated = write_binary( create_cube() );
+  truncated.resize(truncated.size() - 10);
+  EXPECT_THROW(parse(truncated), std::invalid_argument);
+  EXPECT_THROW(parse("no stl"), std::invalid_argument);
+  EXPECT_THROW(parse("solid a\nouter loop\nvertex 1 2 3\nvertex 1 x 3\n"), std::invalid_argument);
+  EXPECT_THROW(parse("solid a\nouter loop\nvertex 1 2 3\nvertex 1 2 3\nendloop\n"), std::invalid_argument);
+  EXPECT_THROW(parse("solid a\nouter loop\nvertex 1 2 3\nvertex 2 2 3\nvertex 1 3 3\n"), std::invalid_argument);
+  EXPECT_THROW(parse("solid a\nfacet\nvertice 1 2 3\n"), std::invalid_argument);
+  StlImporter importer;
+  EXPECT_THROW(importer.parse_file("no_such_file.stl"), std::runtime_error);
+}
+
+TEST(STL_IMPORTER, ParseFile) {
+  std::filesystem::path file_path = std::filesystem::temp_directory_path() / "stl_test_cube.stl";
+  {
+    std::ofstream out(file_path, std::ios::binary);
+    out << write_binary(create_cube(), "solid cube");
+  }
+  StlImporter from_file;
+  from_file.parse_file(file_path.string());
+  std::filesystem::remove(file_path);
+
+  EXPECT_EQ(36u * 9u, from_file.get_vertex_buffer().size());
+  EXPECT_EQ(parse( write_binary( create_cube() ) ).get_vertex_buffer(), from_file.get_vertex_buffer());
+}
+
+}
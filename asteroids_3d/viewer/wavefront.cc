@@ -3,6 +3,18 @@
 #include <string>
 #include <iostream>
 #include <limits>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 WavefrontImporter::WavefrontImporter(std::istream & in) 
   : counter_clock_wise(true), input_line(0u), in(in), current_material(nullptr) { }
@@ -180,3 +192,329 @@ void WavefrontImporter::parse_material(std::istream & in) {
 }
 
 
+// class MappedFile
+
+#if defined(_WIN32)
+MappedFile::MappedFile(const std::string & file_path) {
+  std::ifstream in(file_path, std::ios::binary);
+  if ( ! in ) {
+    throw std::runtime_error("could not open " + file_path);
+  }
+  copy.assign( std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() );
+  data = copy.data();
+  size = copy.size();
+}
+
+MappedFile::~MappedFile() { }
+#else
+MappedFile::MappedFile(const std::string & file_path) {
+  int file = open(file_path.c_str(), O_RDONLY);
+  if (file < 0) {
+    throw std::runtime_error("could not open " + file_path);
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    close(file);
+    throw std::runtime_error("could not read " + file_path);
+  }
+  size = static_cast<size_t>(status.st_size);
+  if (size > 0) {
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE;  // maps all pages at once instead of faulting them in one by one
+#endif
+    void * mapping = mmap(nullptr, size, PROT_READ, flags, file, 0);
+    if (mapping == MAP_FAILED) {
+      close(file);
+      throw std::runtime_error("could not map " + file_path);
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(mapping);
+  }
+  close(file);  // the mapping stays valid
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) {
+    munmap( const_cast<char *>(data), size );
+  }
+}
+#endif
+
+std::string_view MappedFile::get_text() const {
+  return std::string_view(data, size);
+}
+
+
+// class WavefrontVertexBufferImporter
+
+namespace {
+
+constexpr size_t NO_NORMAL = std::numeric_limits<size_t>::max();
+
+bool is_blank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+const char * skip_blanks(const char * position, const char * end) {
+  while (position < end && is_blank(*position)) {
+    position++;
+  }
+  return position;
+}
+
+// returns true if the line starts with the keyword followed by a blank
+bool starts_with_keyword(const char * position, const char * end, std::string_view keyword) {
+  return static_cast<size_t>(end - position) > keyword.size()
+         && std::memcmp(position, keyword.data(), keyword.size()) == 0 && is_blank(position[keyword.size()]);
+}
+
+enum class LineType { vertice, normal, face, use_material, material_library, other };
+
+// returns the type of the line starting at the position (after the leading blanks)
+LineType get_line_type(const char * position, const char * end) {
+  if (position == end) {
+    return LineType::other;
+  }
+  switch (*position) {
+    case 'v': return starts_with_keyword(position, end, "v") ? LineType::vertice
+                     : starts_with_keyword(position, end, "vn") ? LineType::normal : LineType::other;
+    case 'f': return starts_with_keyword(position, end, "f") ? LineType::face : LineType::other;
+    case 'u': return starts_with_keyword(position, end, "usemtl") ? LineType::use_material : LineType::other;
+    case 'm': return starts_with_keyword(position, end, "mtllib") ? LineType::material_library : LineType::other;
+    default:  return LineType::other;
+  }
+}
+
+const char * end_of_line(const char * position, const char * end) {
+  const char * line_end = static_cast<const char *>( std::memchr(position, '\n', end - position) );
+  return line_end != nullptr ? line_end : end;
+}
+
+// parses [-]digits[.digits] like std::from_chars, if the digits form an integer below 2^24 and there are at most
+// ten digits after the point: the integer and the power of ten are exact floats, so their quotient is
+// correctly rounded (Clinger's fast path), which covers the usual output of exporters with six decimals
+// returns nullptr for other numbers
+const char * parse_simple_float(const char * position, const char * end, float & value) {
+  constexpr std::uint64_t MAX_MANTISSA = std::uint64_t(1) << 24;
+  constexpr float POWERS_OF_TEN[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+  bool negative = position < end && *position == '-';
+  if (negative) {
+    position++;
+  }
+  std::uint64_t mantissa = 0;
+  size_t no_of_digits = 0;
+  while (position < end && *position >= '0' && *position <= '9') {
+    mantissa = 10 * mantissa + static_cast<std::uint64_t>(*position++ - '0');
+    no_of_digits++;
+  }
+  size_t no_of_fraction_digits = 0;
+  if (position < end && *position == '.') {
+    position++;
+    while (position < end && *position >= '0' && *position <= '9') {
+      mantissa = 10 * mantissa + static_cast<std::uint64_t>(*position++ - '0');
+      no_of_fraction_digits++;
+    }
+  }
+  if (no_of_digits + no_of_fraction_digits == 0 || no_of_digits + no_of_fraction_digits > 18
+      || mantissa > MAX_MANTISSA || no_of_fraction_digits > 10 || (position < end && (*position == 'e' || *position == 'E'))) {
+    return nullptr;
+  }
+  value = static_cast<float>(mantissa) / POWERS_OF_TEN[no_of_fraction_digits];
+  if (negative) {
+    value = -value;
+  }
+  return position;
+}
+
+// returns the first word after the keyword
+std::string_view parse_name(const char * position, const char * end) {
+  position = skip_blanks(position, end);
+  const char * name_end = position;
+  while (name_end < end && ! is_blank(*name_end)) {
+    name_end++;
+  }
+  return std::string_view(position, name_end - position);
+}
+
+}
+
+std::vector< Vertice > & WavefrontVertexBufferImporter::get_vertices() {
+  return vertices;
+}
+
+std::vector< Normal > & WavefrontVertexBufferImporter::get_normals() {
+  return normals;
+}
+
+std::vector<float> & WavefrontVertexBufferImporter::get_vertex_buffer() {
+  return vertex_buffer;
+}
+
+void WavefrontVertexBufferImporter::set_materials( std::map<std::string, Material> materials) {
+  this->materials = materials;
+}
+
+std::map<std::string, Material> & WavefrontVertexBufferImporter::get_materials() {
+  return materials;
+}
+
+float WavefrontVertexBufferImporter::parse_float(const char * & position, const char * end) {
+  position = skip_blanks(position, end);
+  if (position < end && *position == '+') {
+    position++;  // not accepted by from_chars
+  }
+  float value = 0.0f;
+  const char * next = parse_simple_float(position, end, value);
+  if (next == nullptr) {
+    std::from_chars_result result = std::from_chars(position, end, value);
+    if (result.ec != std::errc()) {
+      throw std::invalid_argument("float expected in line " + std::to_string(input_line));
+    }
+    next = result.ptr;
+  }
+  position = next;
+  return value;
+}
+
+// returns the zero based index into a list of the given size, the indices in the file start at 1,
+// negative indices count from the end of the list
+size_t WavefrontVertexBufferImporter::parse_index(const char * & position, const char * end, size_t size) {
+  bool negative = position < end && *position == '-';
+  if (negative) {
+    position++;
+  }
+  const char * digits = position;
+  size_t index = 0;
+  while (position < end && *position >= '0' && *position <= '9' && position - digits < 18) {
+    index = 10 * index + static_cast<size_t>(*position++ - '0');
+  }
+  if (position == digits) {
+    throw std::invalid_argument("index expected in line " + std::to_string(input_line));
+  }
+  if (negative) {
+    index = (index <= size ? size + 1 - index : 0);
+  }
+  if (index < 1 || index > size) {
+    throw std::out_of_range("index out of range in line " + std::to_string(input_line));
+  }
+  return index - 1;
+}
+
+void WavefrontVertexBufferImporter::write_corner(float * destination, size_t vertice, size_t normal) const {
+  const Vertice & v = vertices[vertice];
+  Normal n = (normal == NO_NORMAL ? Normal{1.0f, 1.0f, 1.0f} : normals[normal]);
+  const float corner[9] = { v[0], v[1], v[2], n[0], n[1], n[2], color[0], color[1], color[2] };
+  std::memcpy(destination, corner, sizeof(corner));
+}
+
+// f v1 v2 v3 ..., f v1//vn1 v2//vn2 v3//vn3 ... or f v1/vt1/vn1 ..., the corners form a fan of triangles
+void WavefrontVertexBufferImporter::parse_face(const char * position, const char * end) {
+  size_t first_vertice = 0, first_normal = 0, previous_vertice = 0, previous_normal = 0;
+  size_t no_of_corners = 0;
+  while ( (position = skip_blanks(position, end)) < end ) {
+    size_t vertice = parse_index(position, end, vertices.size());
+    size_t normal = NO_NORMAL;
+    if (position < end && *position == '/') {
+      position++;
+      while (position < end && *position != '/' && ! is_blank(*position)) {
+        position++;  // texture coordinates are ignored
+      }
+      if (position < end && *position == '/') {
+        position++;
+        normal = parse_index(position, end, normals.size());
+      }
+    }
+    if (no_of_corners == 0) {
+      first_vertice = vertice;
+      first_normal = normal;
+    } else if (no_of_corners >= 2) {
+      size_t size = vertex_buffer.size();
+      vertex_buffer.resize(size + 3 * 9);
+      float * triangle = vertex_buffer.data() + size;
+      write_corner(triangle, first_vertice, first_normal);
+      write_corner(triangle + 9, previous_vertice, previous_normal);
+      write_corner(triangle + 18, vertice, normal);
+    }
+    previous_vertice = vertice;
+    previous_normal = normal;
+    no_of_corners++;
+  }
+}
+
+void WavefrontVertexBufferImporter::parse(std::string_view text) {
+  const char * begin = text.data();
+  const char * end = begin + text.size();
+
+  size_t no_of_vertices = 0, no_of_normals = 0, no_of_faces = 0;
+  for (const char * line = begin; line < end; line = end_of_line(line, end) + 1) {
+    switch ( get_line_type(skip_blanks(line, end), end) ) {
+      case LineType::vertice: no_of_vertices++;
+                              break;
+      case LineType::normal:  no_of_normals++;
+                              break;
+      case LineType::face:    no_of_faces++;
+                              break;
+      default:                break;
+    }
+  }
+  vertices.reserve(vertices.size() + no_of_vertices);
+  normals.reserve(normals.size() + no_of_normals);
+  vertex_buffer.reserve(vertex_buffer.size() + 3 * 9 * no_of_faces);  // exact for triangles
+
+  color = {1.0f, 1.0f, 1.0f};
+  input_line = 0;
+  for (const char * line = begin, * next_line; line < end; line = next_line) {
+    input_line++;
+    const char * line_end = end_of_line(line, end);
+    next_line = line_end + 1;
+    if (line_end > line && line_end[-1] == '\r') {
+      line_end--;
+    }
+    const char * position = skip_blanks(line, line_end);
+    switch ( get_line_type(position, line_end) ) {
+      case LineType::vertice: {
+        position++;
+        float x = parse_float(position, line_end);
+        float y = parse_float(position, line_end);
+        float z = parse_float(position, line_end);
+        vertices.push_back( {x, y, z} );
+        break;
+      }
+      case LineType::normal: {
+        position += 2;
+        float x = parse_float(position, line_end);
+        float y = parse_float(position, line_end);
+        float z = parse_float(position, line_end);
+        normals.push_back( {x, y, z} );
+        break;
+      }
+      case LineType::face:
+        parse_face(position + 1, line_end);
+        break;
+      case LineType::use_material: {
+        auto material = materials.find( std::string(parse_name(position + 6, line_end)) );
+        if (material != materials.end()) {
+          color = material->second.ambient;
+        }
+        break;
+      }
+      case LineType::material_library: {
+        std::fstream fs( std::string(parse_name(position + 6, line_end)) );
+        WavefrontImporter importer(fs);
+        importer.parse_material(fs);
+        for (auto & [name, material] : importer.get_materials()) {
+          materials[name] = material;
+        }
+        break;
+      }
+      case LineType::other:
+        break;  // comments, texture coordinates, objects, groups, ...
+    }
+  }
+}
+
+void WavefrontVertexBufferImporter::parse_file(const std::string & file_path) {
+  MappedFile file(file_path);
+  parse( file.get_text() );
+}
@@ -5,6 +5,7 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <string_view>
 #include <map>
 
 #include "debug.h"
@@ -27,7 +28,7 @@ struct ReferenceGroup {
 // the form a polygon if the are all oriented clock- or counter-clock-wise
 struct Face {
   std::vector<ReferenceGroup> reference_groups;
-  Material * material; // optional material information
+  Material * material = nullptr; // optional material information
 };
 
 class WavefrontImporter {
@@ -74,5 +75,55 @@ public:
   bool faces_order_is_counter_clock_wise() const;
 };
 
+// a whole file mapped read-only into memory (a copy of the file on systems without mmap)
+// throws std::runtime_error if the file cannot be read
+class MappedFile {
+  const char * data = nullptr;
+  size_t size = 0;
+  std::string copy;
+public:
+  explicit MappedFile(const std::string & file_path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  std::string_view get_text() const;
+};
+
+// a fast importer for large wavefront files, that creates the vertex buffer of the renderers directly:
+// 9 floats per corner of a triangle, the vertice, the normal and the ambient color of the material
+// (white without a material, a normal of {1, 1, 1} if the face gives no normals)
+// the text is parsed with std::from_chars without streams, the vertices, normals and the buffer are reserved
+// after counting their lines, so parsing does not allocate per line
+// faces with more than three corners are split into a fan of triangles, texture coordinates are ignored
+class WavefrontVertexBufferImporter {
+  std::vector< Vertice > vertices;
+  std::vector< Normal > normals;
+  std::vector<float> vertex_buffer;
+  std::map<std::string, Material> materials;
+  Color color;  // of the current material
+  size_t input_line = 0;
+
+  float parse_float(const char * & position, const char * end);
+  size_t parse_index(const char * & position, const char * end, size_t size);
+  void parse_face(const char * position, const char * end);
+  void write_corner(float * destination, size_t vertice, size_t normal) const;
+public:
+  // parses a text forming a wavefront file and appends its triangles to the vertex buffer,
+  // material libraries are read from the working directory
+  // throws std::invalid_argument if a number is malformed and std::out_of_range if a face refers to a missing vertice
+  void parse(std::string_view text);
+
+  // maps the file into memory and parses it, throws std::runtime_error if the file cannot be read
+  void parse_file(const std::string & file_path);
+
+  std::vector< Vertice > & get_vertices();
+  std::vector< Normal > & get_normals();
+  std::vector<float> & get_vertex_buffer();
+
+  void set_materials( std::map<std::string, Material> materials);
+  std::map<std::string, Material> & get_materials();
+};
+
 #endif
 
@@ -0,0 +1,115 @@
+#include "wavefront.h"
+#include "mesh_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+// compares the WavefrontImporter followed by the conversion into a vertex buffer of the renderer
+// with the WavefrontVertexBufferImporter on a synthetic file with about one million triangles,
+// the best of a few runs is reported, so the first touch of the file and the memory is not measured,
+// and the loading of the same file through its mesh cache (see mesh_cache.h), once creating and once mapping it,
+// the mapped cache has to hold the mesh created from the file
+
+namespace {
+
+constexpr int NO_OF_RUNS = 3;
+
+// a wavy grid of size x size vertices with a normal per vertex, two triangles per cell
+void write_grid(const std::filesystem::path & file_path, size_t size) {
+  std::ofstream out(file_path);
+  out << std::fixed << std::setprecision(6);
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      out << "v " << x * 0.01f << ' ' << y * 0.01f << ' ' << 0.1f * std::sin(x * 0.05f) * std::cos(y * 0.05f) << '\n';
+    }
+  }
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      out << "vn " << -0.005f * std::cos(x * 0.05f) << ' ' << 0.005f * std::sin(y * 0.05f) << ' ' << 1.0f << '\n';
+    }
+  }
+  out << "usemtl none\n";
+  for (size_t y = 0; y + 1 < size; y++) {
+    for (size_t x = 0; x + 1 < size; x++) {
+      size_t a = y * size + x + 1, b = a + 1, c = a + size, d = c + 1;
+      out << "f " << a << "//" << a << ' ' << b << "//" << b << ' ' << d << "//" << d << '\n';
+      out << "f " << a << "//" << a << ' ' << d << "//" << d << ' ' << c << "//" << c << '\n';
+    }
+  }
+}
+
+// the conversion of the renderers before the WavefrontVertexBufferImporter
+std::vector<float> create_vertices(WavefrontImporter & importer) {
+  Material default_material = { {1.0f, 1.0f, 1.0f} };
+  std::vector<float> vertices;
+  for (Face face : importer.get_faces() ) {
+    for (ReferenceGroup group : face.reference_groups ) {
+      for (size_t i = 0; i < 3; i++) {
+        vertices.push_back( group.vertice[i]);
+      }
+      for (size_t i = 0; i < 3; i++) {
+        vertices.push_back( group.normal[i] );
+      }
+      if (face.material == nullptr) face.material = &default_material;
+      for (size_t i = 0; i < 3; i++) {
+        vertices.push_back( face.material->ambient[i]);
+      }
+    }
+  }
+  return vertices;
+}
+
+}
+
+int main() {
+  std::filesystem::path file_path = std::filesystem::temp_directory_path() / "wavefront_benchmark.obj";
+  write_grid(file_path, 708);
+  std::cout << "file size: " << std::filesystem::file_size(file_path) / (1024 * 1024) << " MiB" << std::endl;
+
+  std::vector<float> expected;
+  std::vector<float> vertex_buffer;
+  std::chrono::duration<double> stream_time = std::chrono::duration<double>::max();
+  std::chrono::duration<double> mapped_time = std::chrono::duration<double>::max();
+  for (int run = 0; run < NO_OF_RUNS; run++) {
+    auto start = std::chrono::steady_clock::now();
+    std::fstream in(file_path);
+    WavefrontImporter importer(in);
+    importer.parse();
+    expected = create_vertices(importer);
+    stream_time = std::min(stream_time, std::chrono::duration<double>(std::chrono::steady_clock::now() - start));
+
+    start = std::chrono::steady_clock::now();
+    WavefrontVertexBufferImporter fast_importer;
+    fast_importer.parse_file(file_path.string());
+    vertex_buffer = std::move(fast_importer.get_vertex_buffer());
+    mapped_time = std::min(mapped_time, std::chrono::duration<double>(std::chrono::steady_clock::now() - start));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  MeshCache created = load_mesh(file_path.string());
+  std::chrono::duration<double> create_time = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  MeshCache mapped = load_mesh(file_path.string());
+  std::chrono::duration<double> map_time = std::chrono::steady_clock::now() - start;
+  std::filesystem::remove(file_path);
+  std::filesystem::remove(file_path.string() + ".mesh");
+
+  std::cout << "triangles: " << expected.size() / 27 << std::endl;
+  std::cout << "WavefrontImporter + conversion: " << std::setw(8) << std::setprecision(3) << stream_time.count() << " s" << std::endl;
+  std::cout << "WavefrontVertexBufferImporter:  " << std::setw(8) << std::setprecision(3) << mapped_time.count() << " s" << std::endl;
+  std::cout << "speedup: " << std::setprecision(1) << stream_time.count() / mapped_time.count() << std::endl;
+  std::cout << "load_mesh creating the cache:   " << std::setw(8) << std::setprecision(3) << create_time.count() << " s" << std::endl;
+  std::cout << "load_mesh mapping the cache:    " << std::setw(8) << std::setprecision(3) << map_time.count() << " s" << std::endl;
+  std::span<const char> cached = mapped.get_vertex_data();
+  std::span<const std::uint32_t> cached_indices = mapped.get_indices();
+  if (expected != vertex_buffer || ! std::ranges::equal(cached, created.get_vertex_data())
+      || ! std::ranges::equal(cached_indices, created.get_indices())) {
+    std::cout << "the vertex buffers differ" << std::endl;
+    return 1;
+  }
+  return 0;
+}
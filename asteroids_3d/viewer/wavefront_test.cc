@@ -2,6 +2,8 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <filesystem>
+#include <stdexcept>
 
 #include "gtest/gtest.h"
 
@@ -380,7 +382,118 @@ TEST(WAVEFRONT_IMPORTER, ParseFromFile) {
   ASSERT_NEAR(1.0f, color[1], 0.00001f);
   ASSERT_NEAR(1.0f, color[2], 0.00001f);
 }
+
+const char * CUBE_WITH_MATERIALS = "v 1.000000 -1.000000 -1.000000\n"
+                                   "v 1.000000 -1.000000 1.000000\n"
+                                   "v -1.000000 -1.000000 1.000000\n"
+                                   "v -1.000000 -1.000000 -1.000000\n"
+                                   "v 1.000000 1.000000 -1.000000\n"
+                                   "v 1.000000 1.000000 1.000001\n"
+                                   "v -1.000000 1.000000 1.000000\n"
+                                   "v -1.000000 1.000000 -1.000000\n"
+                                   "vn 0.000000 -1.000000 0.000000\n"
+                                   "vn 0.000000 1.000000 0.000000\n"
+                                   "vn 1.000000 -0.000000 0.000000\n"
+                                   "vn -0.000000 -0.000000 1.000000\n"
+                                   "vn -1.000000 -0.000000 -0.000000\n"
+                                   "vn 0.000000 0.000000 -1.000000\n"
+                                   "f 2//1 3//1 4//1\n"
+                                   "f 8//2 7//2 6//2\n"
+                                   "usemtl blue\n"
+                                   "f 1//3 5//3 6//3\n"
+                                   "f 2//4 6//4 7//4\n"
+                                   "usemtl red\n"
+                                   "f 7//5 8//5 4//5\n"
+                                   "f 1//6 4//6 8//6\n"
+                                   "f 1//1 2//1 4//1\n"
+                                   "f 5//2 8//2 6//2\n"
+                                   "f 2//3 1//3 6//3\n"
+                                   "f 3//4 2//4 7//4\n"
+                                   "f 3//5 7//5 4//5\n"
+                                   "f 5//6 1//6 8//6\n";
+
+std::map<std::string, Material> create_materials() {
+  std::map<std::string, Material> materials;
+  materials["red"] = { {1.0f, 0.0f, 0.0f} };
+  materials["blue"] = { {0.0f, 0.0f, 1.0f} };
+  return materials;
+}
+
+TEST(WAVEFRONT_VERTEX_BUFFER_IMPORTER, MatchesWavefrontImporter) {
+  std::stringstream ss(CUBE_WITH_MATERIALS);
+  WavefrontImporter importer(ss);
+  importer.set_materials( create_materials() );
+  importer.parse();
+  std::vector<float> expected;
+  for (Face & face : importer.get_faces()) {
+    for (ReferenceGroup & group : face.reference_groups) {
+      Color color = face.material != nullptr ? face.material->ambient : Color{1.0f, 1.0f, 1.0f};
+      expected.insert(expected.end(), group.vertice.begin(), group.vertice.end());
+      expected.insert(expected.end(), group.normal.begin(), group.normal.end());
+      expected.insert(expected.end(), color.begin(), color.end());
+    }
+  }
+
+  WavefrontVertexBufferImporter fast_importer;
+  fast_importer.set_materials( create_materials() );
+  fast_importer.parse(CUBE_WITH_MATERIALS);
+
+  ASSERT_EQ(12u * 3u * 9u, expected.size());
+  EXPECT_EQ(expected, fast_importer.get_vertex_buffer());
+  EXPECT_EQ(8u, fast_importer.get_vertices().size());
+  EXPECT_EQ(6u, fast_importer.get_normals().size());
 }
 
+TEST(WAVEFRONT_VERTEX_BUFFER_IMPORTER, PolygonsTextureCoordinatesAndNegativeIndices) {
+  WavefrontVertexBufferImporter importer;
+  importer.parse("# a square\r\n"
+                 "v 0 0 0\r\n"
+                 "v 1 0 0\r\n"
+                 "v 1 1 0\r\n"
+                 "v 0 1 +0.5\r\n"
+                 "vt 0.0 0.0\r\n"
+                 "vn 0 0 1\r\n"
+                 "f 1/1/1 2/1/1 3/1/1 4/1/1\r\n"
+                 "f -4 -3 -2");
+  const std::vector<float> & buffer = importer.get_vertex_buffer();
 
+  ASSERT_EQ(3u * 3u * 9u, buffer.size());
+  const float corners[] = { 0.0f, 1.0f, 2.0f, 0.0f, 2.0f, 3.0f, 0.0f, 1.0f, 2.0f };  // the fan and the third face
+  for (size_t i = 0; i < 9; i++) {
+    const Vertice & vertice = importer.get_vertices()[ static_cast<size_t>(corners[i]) ];
+    EXPECT_EQ(vertice[0], buffer[9 * i]) << i;
+    EXPECT_EQ(vertice[1], buffer[9 * i + 1]) << i;
+    EXPECT_EQ(vertice[2], buffer[9 * i + 2]) << i;
+    EXPECT_EQ(i < 6 ? 0.0f : 1.0f, buffer[9 * i + 3]) << i;  // the last face has no normals
+    EXPECT_EQ(1.0f, buffer[9 * i + 5]) << i;
+    EXPECT_EQ(1.0f, buffer[9 * i + 6]) << i;  // white without a material
+  }
+  EXPECT_EQ(0.5f, importer.get_vertices()[3][2]);
+}
+
+TEST(WAVEFRONT_VERTEX_BUFFER_IMPORTER, MalformedInput) {
+  WavefrontVertexBufferImporter importer;
+  EXPECT_THROW(importer.parse("v 1.0 2.0 3.0\nv 1.0 x 2.0\n"), std::invalid_argument);
+  WavefrontVertexBufferImporter importer2;
+  EXPECT_THROW(importer2.parse("v 1 2 3\nv 1 2 3\nv 1 2 3\nf 1 2 4\n"), std::out_of_range);
+  WavefrontVertexBufferImporter importer3;
+  EXPECT_THROW(importer3.parse_file("no_such_file.obj"), std::runtime_error);
+}
 
+TEST(WAVEFRONT_VERTEX_BUFFER_IMPORTER, ParseFile) {
+  std::filesystem::path file_path = std::filesystem::temp_directory_path() / "wavefront_test_cube.obj";
+  {
+    std::ofstream out(file_path);
+    out << CUBE_WITH_MATERIALS;
+  }
+  WavefrontVertexBufferImporter from_file;
+  from_file.parse_file(file_path.string());
+  WavefrontVertexBufferImporter from_text;
+  from_text.parse(CUBE_WITH_MATERIALS);
+  std::filesystem::remove(file_path);
+
+  EXPECT_EQ(12u * 3u * 9u, from_file.get_vertex_buffer().size());
+  EXPECT_EQ(from_text.get_vertex_buffer(), from_file.get_vertex_buffer());
+}
+
+}